@@ -0,0 +1,61 @@
+/**
+ * @file    ConfigSnapshot.cpp
+ *
+ * @brief   The values of the config_* tables at one point in time, read by the nodes
+ *          without going to the database.
+ *
+ */
+
+#include "ConfigSnapshot.hpp"
+#include "../SystemServices/Logger.hpp"
+#include <cstdlib>
+
+double ConfigSnapshot::getDouble(const std::string& table, const std::string& column) const {
+    const ConfigValue* value = find(table, column);
+
+    if (value == NULL) {
+        return 0;
+    }
+    return value->isNumber ? value->number : strtod(value->text.c_str(), NULL);
+}
+
+int ConfigSnapshot::getInt(const std::string& table, const std::string& column) const {
+    const ConfigValue* value = find(table, column);
+
+    if (value == NULL) {
+        return 0;
+    }
+    return value->isNumber ? (int)value->number : strtol(value->text.c_str(), NULL, 10);
+}
+
+std::string ConfigSnapshot::getString(const std::string& table, const std::string& column) const {
+    const ConfigValue* value = find(table, column);
+
+    if (value == NULL) {
+        return "";
+    }
+    return value->text;
+}
+
+bool ConfigSnapshot::has(const std::string& table, const std::string& column) const {
+    auto it = m_Tables.find(table);
+    return it != m_Tables.end() && it->second.count(column) > 0;
+}
+
+void ConfigSnapshot::setTable(const std::string& table, const std::map<std::string, ConfigValue>& values) {
+    m_Tables[table] = values;
+}
+
+const ConfigValue* ConfigSnapshot::find(const std::string& table, const std::string& column) const {
+    auto it = m_Tables.find(table);
+
+    if (it != m_Tables.end()) {
+        auto cell = it->second.find(column);
+        if (cell != it->second.end()) {
+            return &cell->second;
+        }
+    }
+
+    Logger::error("%s No config %s in %s", __PRETTY_FUNCTION__, column.c_str(), table.c_str());
+    return NULL;
+}
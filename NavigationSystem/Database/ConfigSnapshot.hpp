@@ -0,0 +1,56 @@
+/**
+ * @file    ConfigSnapshot.hpp
+ *
+ * @brief   The values of the config_* tables at one point in time, read by the nodes
+ *          without going to the database.
+ *
+ * @details     A snapshot never changes once published by the DBHandler, a change to the
+ *              configuration publishes a new one in its place. A node holding on to a
+ *              snapshot while it reads its settings gets them all from the same version of
+ *              the configuration.
+ *
+ */
+
+#ifndef CONFIGSNAPSHOT_HPP
+#define CONFIGSNAPSHOT_HPP
+
+#include <map>
+#include <string>
+
+///----------------------------------------------------------------------------------
+/// @brief A cell of a config table, with its number when SQLite stored it as one.
+///----------------------------------------------------------------------------------
+struct ConfigValue {
+    ConfigValue() : isNumber(false), number(0) {}
+
+    bool isNumber;
+    double number;
+    std::string text;
+};
+
+class ConfigSnapshot {
+   public:
+    ///----------------------------------------------------------------------------------
+    /// @brief The value of a column of the first row of a config table. A missing value
+    ///         is logged and read as 0 or an empty string, as DBHandler::retrieveCell did.
+    ///----------------------------------------------------------------------------------
+    double getDouble(const std::string& table, const std::string& column) const;
+    int getInt(const std::string& table, const std::string& column) const;
+    std::string getString(const std::string& table, const std::string& column) const;
+
+    bool has(const std::string& table, const std::string& column) const;
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Replaces the values of a table, only while the snapshot is being built.
+    ///----------------------------------------------------------------------------------
+    void setTable(const std::string& table, const std::map<std::string, ConfigValue>& values);
+
+    unsigned int tableCount() const { return m_Tables.size(); }
+
+   private:
+    const ConfigValue* find(const std::string& table, const std::string& column) const;
+
+    std::map<std::string, std::map<std::string, ConfigValue>> m_Tables;
+};
+
+#endif /* CONFIGSNAPSHOT_HPP */
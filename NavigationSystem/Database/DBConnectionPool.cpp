@@ -0,0 +1,243 @@
+/**
+ * @file    DBConnectionPool.cpp
+ *
+ * @brief   Keeps a few connections to the database open, handed out to one thread at a
+ *          time instead of opening and closing the database around every query.
+ *
+ */
+
+#include "DBConnectionPool.hpp"
+#include "../SystemServices/Logger.hpp"
+#include "../SystemServices/ThreadConfig.hpp"
+#include <algorithm>
+#include <chrono>
+
+DBConnectionPool::DBConnectionPool(const std::string& filePath,
+                                   const DBSettings& settings,
+                                   unsigned int maxConnections)
+    : m_FilePath(filePath),
+      m_Settings(settings),
+      m_MaxConnections(std::max(1u, maxConnections)),
+      m_Opened(0),
+      m_Checkpointing(false),
+      m_Checkpoints(0) {}
+
+DBConnectionPool::~DBConnectionPool() {
+    close();
+}
+
+bool DBConnectionPool::open() {
+    sqlite3* connection = acquire();
+
+    if (connection == NULL) {
+        return false;
+    }
+    release(connection);
+
+    if (m_Settings.journal == DBJournal::WAL && m_Settings.checkpointPeriodMs > 0) {
+        startCheckpoints();
+    }
+    return true;
+}
+
+void DBConnectionPool::close() {
+    stopCheckpoints();
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Released.wait(lock, [this] { return m_Idle.size() == m_Opened; });
+
+    for (std::unique_ptr<Connection>& connection : m_Connections) {
+        finalizeStatements(*connection);
+        sqlite3_close(connection->handle);
+    }
+    m_Connections.clear();
+    m_Idle.clear();
+    m_Opened = 0;
+}
+
+sqlite3* DBConnectionPool::acquire() {
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Released.wait(lock, [this] { return not m_Idle.empty() || m_Opened < m_MaxConnections; });
+
+        if (not m_Idle.empty()) {
+            sqlite3* connection = m_Idle.back();
+            m_Idle.pop_back();
+            return connection;
+        }
+        m_Opened++;
+    }
+
+    // Opened without the lock, the other connections stay available meanwhile
+    sqlite3* connection = openConnection();
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (connection == NULL) {
+        m_Opened--;
+        m_Released.notify_all();
+    } else {
+        m_Connections.push_back(std::unique_ptr<Connection>(new Connection()));
+        m_Connections.back()->handle = connection;
+    }
+    return connection;
+}
+
+void DBConnectionPool::release(sqlite3* connection) {
+    if (connection == NULL) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Idle.push_back(connection);
+    m_Released.notify_all();
+}
+
+int DBConnectionPool::prepare(sqlite3* connection, const std::string& sql, sqlite3_stmt** statement) {
+    Connection* owner = NULL;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (std::unique_ptr<Connection>& pooled : m_Connections) {
+            if (pooled->handle == connection) {
+                owner = pooled.get();
+            }
+        }
+    }
+
+    if (owner == NULL) {
+        // Not a connection of the pool
+        *statement = NULL;
+        return SQLITE_MISUSE;
+    }
+
+    auto it = owner->statements.find(sql);
+    if (it != owner->statements.end()) {
+        *statement = it->second;
+        sqlite3_reset(*statement);
+        sqlite3_clear_bindings(*statement);
+        return SQLITE_OK;
+    }
+
+    if (owner->statements.size() >= DB_STATEMENT_CACHE_SIZE) {
+        finalizeStatements(*owner);
+    }
+
+    int resultcode = sqlite3_prepare_v2(connection, sql.c_str(), sql.size(), statement, NULL);
+    if (resultcode != SQLITE_OK) {
+        sqlite3_finalize(*statement);
+        *statement = NULL;
+        return resultcode;
+    }
+
+    owner->statements[sql] = *statement;
+    return SQLITE_OK;
+}
+
+unsigned int DBConnectionPool::openConnections() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Opened;
+}
+
+sqlite3* DBConnectionPool::openConnection() {
+    sqlite3* connection = NULL;
+
+    // Without SQLITE_OPEN_CREATE a missing database is an error rather than an empty file,
+    // a connection is only used by one thread at a time
+    int resultcode = sqlite3_open_v2(m_FilePath.c_str(), &connection,
+                                     SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX, NULL);
+
+    if (resultcode != SQLITE_OK) {
+        Logger::error("%s Failed to open the database %s Error %s", __PRETTY_FUNCTION__,
+                      m_FilePath.c_str(), sqlite3_errstr(resultcode));
+        sqlite3_close(connection);
+        return NULL;
+    }
+
+    sqlite3_busy_timeout(connection, DB_BUSY_TIMEOUT_MS);
+
+    // The journal mode is kept in the database file, setting it again is a no-op
+    sqlite3_stmt* statement = NULL;
+    const char* journal = (m_Settings.journal == DBJournal::WAL) ? "wal" : "delete";
+    std::string sql = std::string("PRAGMA journal_mode=") + journal + ";";
+    if (sqlite3_prepare_v2(connection, sql.c_str(), -1, &statement, NULL) != SQLITE_OK ||
+        sqlite3_step(statement) != SQLITE_ROW ||
+        std::string((const char*)sqlite3_column_text(statement, 0)) != journal) {
+        Logger::warning("%s Could not set the journal mode to %s: %s", __PRETTY_FUNCTION__,
+                        journal, sqlite3_errmsg(connection));
+    }
+    sqlite3_finalize(statement);
+
+    sql = "PRAGMA synchronous=" + std::to_string(m_Settings.synchronous) + ";";
+    if (m_Settings.journal == DBJournal::WAL) {
+        sql += "PRAGMA wal_autocheckpoint=" + std::to_string(DB_WAL_AUTOCHECKPOINT) + ";";
+        sql += "PRAGMA journal_size_limit=" + std::to_string(DB_WAL_SIZE_LIMIT) + ";";
+    }
+    if (sqlite3_exec(connection, sql.c_str(), NULL, NULL, NULL) != SQLITE_OK) {
+        Logger::warning("%s Could not set the durability of the connection: %s",
+                        __PRETTY_FUNCTION__, sqlite3_errmsg(connection));
+    }
+    return connection;
+}
+
+void DBConnectionPool::finalizeStatements(Connection& connection) {
+    for (auto& statement : connection.statements) {
+        sqlite3_finalize(statement.second);
+    }
+    connection.statements.clear();
+}
+
+void DBConnectionPool::startCheckpoints() {
+    std::lock_guard<std::mutex> lock(m_CheckpointMutex);
+
+    if (not m_Checkpointing) {
+        m_Checkpointing = true;
+        m_Checkpointer = std::thread(&DBConnectionPool::checkpointThread, this);
+    }
+}
+
+void DBConnectionPool::stopCheckpoints() {
+    {
+        std::lock_guard<std::mutex> lock(m_CheckpointMutex);
+        m_Checkpointing = false;
+        m_CheckpointWake.notify_all();
+    }
+    if (m_Checkpointer.joinable()) {
+        m_Checkpointer.join();
+    }
+}
+
+void DBConnectionPool::checkpointThread() {
+    ThreadConfig::apply("DBCheckpoint");
+
+    // A connection of its own, a checkpoint never holds up a query waiting for the pool
+    sqlite3* connection = openConnection();
+    if (connection == NULL) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_CheckpointMutex);
+    while (m_Checkpointing) {
+        m_CheckpointWake.wait_for(lock, std::chrono::milliseconds(m_Settings.checkpointPeriodMs));
+        if (not m_Checkpointing) {
+            break;
+        }
+        lock.unlock();
+
+        // Passive, copies the frames no reader still needs and never takes the write lock.
+        // Once all of them are in the database the next writer starts the log over.
+        int logFrames = 0;
+        int checkpointedFrames = 0;
+        int resultcode = sqlite3_wal_checkpoint_v2(connection, NULL, SQLITE_CHECKPOINT_PASSIVE,
+                                                   &logFrames, &checkpointedFrames);
+        if (resultcode == SQLITE_OK) {
+            m_Checkpoints++;
+        } else if (resultcode != SQLITE_BUSY) {
+            Logger::warning("%s Checkpoint failed: %s", __PRETTY_FUNCTION__,
+                            sqlite3_errmsg(connection));
+        }
+
+        lock.lock();
+    }
+    lock.unlock();
+
+    sqlite3_close(connection);
+}
@@ -0,0 +1,150 @@
+/**
+ * @file    DBConnectionPool.hpp
+ *
+ * @brief   Keeps a few connections to the database open, handed out to one thread at a
+ *          time instead of opening and closing the database around every query.
+ *
+ * @details     A connection is opened the first time no idle one is left, up to the size of
+ *              the pool, after which the threads wait for one to be released. Connections
+ *              stay open until the pool is closed, which waits for those in use to be
+ *              released first.
+ *
+ *              Each connection keeps the statements prepared on it, the queries run over and
+ *              over are parsed and planned once per connection rather than once per query.
+ *
+ *              Concurrent connections are arbitrated by SQLite itself, a connection which
+ *              finds the database locked waits for the busy timeout before SQLITE_BUSY is
+ *              returned to the query.
+ *
+ *              The database is journaled with a write-ahead log by default: the readers, like
+ *              the HTTP sync going through the logs, no longer hold back the DB logger's
+ *              inserts and the other way around. The log is checkpointed into the database by
+ *              a thread of the pool on its own connection, the queries never pay for it.
+ *              SQLite's automatic checkpoint is only left as a backstop.
+ *
+ */
+
+#ifndef DBCONNECTIONPOOL_HPP
+#define DBCONNECTIONPOOL_HPP
+
+#include <sqlite3.h>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define DB_POOL_CONNECTIONS     4   // The DB logger, HTTP sync, the waypoints and the configs
+#define DB_BUSY_TIMEOUT_MS      10
+#define DB_STATEMENT_CACHE_SIZE 128 // Per connection, about the config and waypoint queries
+
+#ifndef DB_WAL
+#define DB_WAL                  1
+#endif
+#ifndef DB_SYNCHRONOUS
+#define DB_SYNCHRONOUS          1   // NORMAL, with a WAL a power loss can lose the last commits but never corrupts
+#endif
+#define DB_CHECKPOINT_PERIOD_MS 1000
+#define DB_WAL_AUTOCHECKPOINT   4000    // Pages, should the checkpoint thread fall behind
+#define DB_WAL_SIZE_LIMIT       (4 * 1024 * 1024)   // Bytes the log is cut back to once checkpointed
+
+enum class DBJournal { Rollback, WAL };
+
+///----------------------------------------------------------------------------------
+/// @brief How the connections journal their writes and how far they wait for them to
+///         reach the disk.
+///----------------------------------------------------------------------------------
+struct DBSettings {
+    DBSettings()
+        : journal(DB_WAL ? DBJournal::WAL : DBJournal::Rollback),
+          synchronous(DB_SYNCHRONOUS),
+          checkpointPeriodMs(DB_CHECKPOINT_PERIOD_MS) {}
+
+    DBJournal journal;
+    int synchronous;                    ///< 0 OFF, 1 NORMAL, 2 FULL, 3 EXTRA
+    unsigned int checkpointPeriodMs;    ///< 0 leaves the checkpoints to SQLite
+};
+
+class DBConnectionPool {
+   public:
+    DBConnectionPool(const std::string& filePath,
+                     const DBSettings& settings = DBSettings(),
+                     unsigned int maxConnections = DB_POOL_CONNECTIONS);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Closes the connections, see close().
+    ///----------------------------------------------------------------------------------
+    ~DBConnectionPool();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Opens a first connection, returns false if the database can't be opened.
+    ///         Doesn't need to be called before acquire(), but starts the checkpoint
+    ///         thread when the database uses a write-ahead log.
+    ///----------------------------------------------------------------------------------
+    bool open();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Stops the checkpoint thread, waits for the connections in use to be
+    ///         released and closes all of them. The pool opens new ones if it is used again.
+    ///----------------------------------------------------------------------------------
+    void close();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns a connection for the calling thread only, which has to be released,
+    ///         or NULL if a connection can't be opened. Waits while they are all in use.
+    ///----------------------------------------------------------------------------------
+    sqlite3* acquire();
+
+    void release(sqlite3* connection);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns the statement of the SQL on an acquired connection, prepared the
+    ///         first time and reset with its bindings cleared afterwards. The statement
+    ///         has to be reset once done with, a statement left halfway through its rows
+    ///         keeps the database locked.
+    ///
+    /// @return The SQLite result code of the preparation.
+    ///----------------------------------------------------------------------------------
+    int prepare(sqlite3* connection, const std::string& sql, sqlite3_stmt** statement);
+
+    unsigned int openConnections();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief The number of checkpoints the thread ran, passive ones which never wait for
+    ///         the readers or the writer.
+    ///----------------------------------------------------------------------------------
+    unsigned int checkpoints() const { return m_Checkpoints; }
+
+   private:
+    struct Connection {
+        sqlite3* handle;
+        std::map<std::string, sqlite3_stmt*> statements;    ///< Only used by its holder
+    };
+
+    sqlite3* openConnection();
+    static void finalizeStatements(Connection& connection);
+
+    void startCheckpoints();
+    void stopCheckpoints();
+    void checkpointThread();
+
+    std::string m_FilePath;
+    DBSettings m_Settings;
+    unsigned int m_MaxConnections;
+    unsigned int m_Opened;              ///< Open or being opened
+    std::vector<std::unique_ptr<Connection>> m_Connections;
+    std::vector<sqlite3*> m_Idle;
+    std::mutex m_Mutex;
+    std::condition_variable m_Released;
+
+    std::thread m_Checkpointer;
+    bool m_Checkpointing;
+    std::atomic<unsigned int> m_Checkpoints;
+    std::mutex m_CheckpointMutex;
+    std::condition_variable m_CheckpointWake;
+};
+
+#endif /* DBCONNECTIONPOOL_HPP */
@@ -8,34 +8,113 @@
 #include "DBHandler.hpp"
 #include "../SystemServices/Timer.hpp"
 #include "../Math/Utility.hpp"
+#include <algorithm>
+#include <cctype>
 #include <cstdio>
 #include <cstdlib>
 #include <iomanip>
 #include <string>
-#include <thread>
 #include <stdexcept>
 
-std::mutex DBHandler::m_databaseLock;
+// The tables insertDataLogs() writes a row to for every log, dataLogs_system refers to the others
+static const char* const DATALOG_TABLES[] = {
+    "dataLogs_actuator_feedback", "dataLogs_compass",      "dataLogs_course_calculation",
+    "dataLogs_current_sensors",   "dataLogs_gps",          "dataLogs_marine_sensors",
+    "dataLogs_vessel_state",      "dataLogs_wind_state",   "dataLogs_windsensor",
+    "dataLogs_system"};
 
-DBHandler::DBHandler(std::string filePath) : m_filePath(filePath) {
+DBHandler::DBHandler(std::string filePath, const DBSettings& settings)
+    : m_filePath(filePath), m_connections(filePath, settings) {
     m_latestDataLogId = 0;
+    m_dataLogIdsSeeded = false;
 }
 
 DBHandler::~DBHandler(void) {
-    m_databaseLock.unlock();
+    close();
 }
 
 bool DBHandler::initialise()
 {
-    sqlite3* connection = openDatabase();
+    if (not m_connections.open()) {
+        return false;
+    }
+    // Without configs the nodes read zeros, as they did from a database missing them
+    loadConfigs();
+
+    // Otherwise seeded by the first batch of logs
+    std::lock_guard<std::mutex> lock(m_dataLogLock);
+    sqlite3* db = openDatabase();
+    seedDataLogIds(db);
+    closeDatabase(db);
+    return true;
+}
+
+void DBHandler::close() {
+    m_connections.close();
+}
+
+std::shared_ptr<const ConfigSnapshot> DBHandler::configs() {
+    std::shared_ptr<const ConfigSnapshot> snapshot = std::atomic_load(&m_configs);
     
-    if (connection != 0) {
-        closeDatabase(connection);
-        return true;
-    } else {
-        closeDatabase(connection);
+    // Loaded on first use by a handler which wasn't initialised
+    if (snapshot == nullptr && loadConfigs()) {
+        snapshot = std::atomic_load(&m_configs);
+    }
+    if (snapshot == nullptr) {
+        // An empty snapshot reads as the missing values did from the database
+        return std::make_shared<const ConfigSnapshot>();
+    }
+    return snapshot;
+}
+
+bool DBHandler::loadConfigs() {
+    std::vector<std::string> tables = getTableNames("config_%");
+    std::lock_guard<std::mutex> lock(m_configWriteLock);
+    std::shared_ptr<ConfigSnapshot> snapshot = std::make_shared<ConfigSnapshot>();
+    
+    sqlite3* db = openDatabase();
+    for (const std::string& table : tables) {
+        std::map<std::string, ConfigValue> values;
+        if (readConfigTable(db, table, values)) {
+            snapshot->setTable(table, values);
+        }
+    }
+    closeDatabase(db);
+    
+    if (snapshot->tableCount() == 0) {
+        Logger::error("%s No config read from %s", __PRETTY_FUNCTION__, m_filePath.c_str());
         return false;
     }
+    std::atomic_store(&m_configs, std::shared_ptr<const ConfigSnapshot>(snapshot));
+    return true;
+}
+
+void DBHandler::reloadConfigTable(const std::string& table) {
+    if (table.compare(0, 7, "config_") != 0) {
+        return;
+    }
+    
+    // Without a snapshot yet, loading all the tables reads this one too. Not under the
+    // lock, loadConfigs() takes it.
+    if (std::atomic_load(&m_configs) == nullptr) {
+        loadConfigs();
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_configWriteLock);
+    // Only ever replaced by another snapshot once there is one
+    std::shared_ptr<ConfigSnapshot> snapshot =
+        std::make_shared<ConfigSnapshot>(*std::atomic_load(&m_configs));
+    std::map<std::string, ConfigValue> values;
+    
+    sqlite3* db = openDatabase();
+    bool read = readConfigTable(db, table, values);
+    closeDatabase(db);
+    
+    if (read) {
+        snapshot->setTable(table, values);
+        std::atomic_store(&m_configs, std::shared_ptr<const ConfigSnapshot>(snapshot));
+    }
 }
 
 void DBHandler::getDataAsJson(std::string select,
@@ -101,19 +180,10 @@ void DBHandler::insertDataLogs(std::vector<LogItem>& logs) {
     std::stringstream windsensorValues;
     std::stringstream systemValues;
     std::stringstream ss;
-    int actuatorFeedbackId = 0;
-    int compassModelId = 0;
-    int courceCalculationId = 0;
     int currentMissionId = 0;
-    int currentSensorsId = 0;
-    int gpsId = 0;
-    int marineSensorsId = 0;
-    int vesselStateId = 0;
-    int windStateId = 0;
-    int windsensorId = 0;
-    int logNumber = 0;
     std::string tableId;
     
+    std::lock_guard<std::mutex> lock(m_dataLogLock);
     sqlite3* db = openDatabase();
     
     if (db == NULL) {
@@ -121,48 +191,20 @@ void DBHandler::insertDataLogs(std::vector<LogItem>& logs) {
         closeDatabase(db);
         return;
     }
+    if (not m_dataLogIdsSeeded && not seedDataLogIds(db)) {
+        closeDatabase(db);
+        return;
+    }
     
     if (logs.size() > 0) {
         Logger::info("Writing in the database last value: %s size logs %d",
                      logs[0].m_timestamp_str.c_str(), logs.size());
     }
     
-    tableId = getIdFromTable("dataLogs_actuator_feedback", true, db);
-    if (tableId.size() > 0) {
-        actuatorFeedbackId = (int)strtol(tableId.c_str(), NULL, 10);
-    }
-    tableId = getIdFromTable("dataLogs_compass", true, db);
-    if (tableId.size() > 0) {
-        compassModelId = (int)strtol(tableId.c_str(), NULL, 10);
-    }
-    tableId = getIdFromTable("dataLogs_course_calculation", true, db);
-    if (tableId.size() > 0) {
-        courceCalculationId = (int)strtol(tableId.c_str(), NULL, 10);
-    }
-    tableId = getIdFromTable("dataLogs_current_sensors", true, db);
-    if (tableId.size() > 0) {
-        currentSensorsId = (int)strtol(tableId.c_str(), NULL, 10);
-    }
-    tableId = getIdFromTable("dataLogs_gps", true, db);
-    if (tableId.size() > 0) {
-        gpsId = (int)strtol(tableId.c_str(), NULL, 10);
-    }
-    tableId = getIdFromTable("dataLogs_marine_sensors", true, db);
-    if (tableId.size() > 0) {
-        marineSensorsId = (int)strtol(tableId.c_str(), NULL, 10);
-    }
-    tableId = getIdFromTable("dataLogs_vessel_state", true, db);
-    if (tableId.size() > 0) {
-        vesselStateId = (int)strtol(tableId.c_str(), NULL, 10);
-    }
-    tableId = getIdFromTable("dataLogs_wind_state", true, db);
-    if (tableId.size() > 0) {
-        windStateId = (int)strtol(tableId.c_str(), NULL, 10);
-    }
-    tableId = getIdFromTable("dataLogs_windsensor", true, db);
-    if (tableId.size() > 0) {
-        windsensorId = (int)strtol(tableId.c_str(), NULL, 10);
-    }
+    // The rows get their ids from the sequences rather than the autoincrement, the system row
+    // refers to them without asking the database. The sequences move on once the batch is in.
+    std::map<std::string, int> ids = m_dataLogIds;
+    
     // NOTE : Marc : To update the id of currentMission in the DB
     tableId = getIdFromTable("currentMission", true, db);
     if (tableId.size() > 0) {
@@ -170,7 +212,16 @@ void DBHandler::insertDataLogs(std::vector<LogItem>& logs) {
     }
     
     for (auto log : logs) {
-        logNumber++;
+        int actuatorFeedbackId = ++ids["dataLogs_actuator_feedback"];
+        int compassModelId = ++ids["dataLogs_compass"];
+        int courceCalculationId = ++ids["dataLogs_course_calculation"];
+        int currentSensorsId = ++ids["dataLogs_current_sensors"];
+        int gpsId = ++ids["dataLogs_gps"];
+        int marineSensorsId = ++ids["dataLogs_marine_sensors"];
+        int vesselStateId = ++ids["dataLogs_vessel_state"];
+        int windStateId = ++ids["dataLogs_wind_state"];
+        int windsensorId = ++ids["dataLogs_windsensor"];
+        int systemId = ++ids["dataLogs_system"];
         actuatorFeedbackValues.str("");
         compassModelValues.str("");
         courseCalculationValues.str("");
@@ -183,12 +234,13 @@ void DBHandler::insertDataLogs(std::vector<LogItem>& logs) {
         systemValues.str("");
         
         actuatorFeedbackValues << std::setprecision(10) << log.m_rudderPosition << ", "
-        << log.m_wingsailPosition << ", " << log.m_radioControllerOn << ", "
+        << log.m_wingsailPosition << ", " << log.m_engineThrottle << ", "
+        << log.m_radioControllerOn << ",'"
         << log.m_timestamp_str.c_str();
         
         ss << "INSERT INTO "
         << "dataLogs_actuator_feedback"
-        << " VALUES(NULL, " << actuatorFeedbackValues.str() << "'); \n";
+        << " VALUES(" << actuatorFeedbackId << ", " << actuatorFeedbackValues.str() << "'); \n";
         
         compassModelValues << std::setprecision(10) << log.m_heading << ", "
         << log.m_pitch << ", " << log.m_roll << ",'"
@@ -196,7 +248,7 @@ void DBHandler::insertDataLogs(std::vector<LogItem>& logs) {
         
         ss << "INSERT INTO "
         << "dataLogs_compass"
-        << " VALUES(NULL, " << compassModelValues.str() << "'); \n";
+        << " VALUES(" << compassModelId << ", " << compassModelValues.str() << "'); \n";
         
         courseCalculationValues << std::setprecision(10) << log.m_distanceToWaypoint << ", "
         << log.m_bearingToWaypoint << ", " << log.m_courseToSteer << ", "
@@ -205,16 +257,17 @@ void DBHandler::insertDataLogs(std::vector<LogItem>& logs) {
         
         ss << "INSERT INTO "
         << "dataLogs_course_calculation"
-        << " VALUES(NULL, " << courseCalculationValues.str() << "'); \n";
+        << " VALUES(" << courceCalculationId << ", " << courseCalculationValues.str() << "'); \n";
         
         
         
         marineSensorsValues << std::setprecision(10) << log.m_waterTemperature << ", "
-        << log.m_timestamp_str.c_str();
+        << log.m_outerTemperature << ", " << log.m_ambientLight << ", " << log.m_pressure << ", "
+        << log.m_depth << ",'" << log.m_timestamp_str.c_str();
         
         ss << "INSERT INTO "
         << "dataLogs_marine_sensors"
-        << " VALUES(NULL, " << marineSensorsValues.str() << "'); \n";
+        << " VALUES(" << marineSensorsId << ", " << marineSensorsValues.str() << "'); \n";
         
         vesselStateValues << std::setprecision(10) << log.m_vesselHeading << ", " << log.m_vesselLat
         << ", " << log.m_vesselLon << ", " << log.m_vesselSpeed << ", "
@@ -222,7 +275,7 @@ void DBHandler::insertDataLogs(std::vector<LogItem>& logs) {
         
         ss << "INSERT INTO "
         << "dataLogs_vessel_state"
-        << " VALUES(NULL, " << vesselStateValues.str() << "'); \n";
+        << " VALUES(" << vesselStateId << ", " << vesselStateValues.str() << "'); \n";
         
         windStateValues << std::setprecision(10) << log.m_trueWindSpeed << ", " << log.m_trueWindDir
         << ", " << log.m_apparentWindSpeed << ", " << log.m_apparentWindDir << ",'"
@@ -230,36 +283,34 @@ void DBHandler::insertDataLogs(std::vector<LogItem>& logs) {
         
         ss << "INSERT INTO "
         << "dataLogs_wind_state"
-        << " VALUES(NULL, " << windStateValues.str() << "'); \n";
+        << " VALUES(" << windStateId << ", " << windStateValues.str() << "'); \n";
         
         windsensorValues << std::setprecision(10) << log.m_windDir << ", " << log.m_windSpeed
         << ", " << log.m_windTemp << ",'" << log.m_timestamp_str.c_str();
         
         ss << "INSERT INTO "
         << "dataLogs_windsensor"
-        << " VALUES(NULL, " << windsensorValues.str() << "'); \n";
+        << " VALUES(" << windsensorId << ", " << windsensorValues.str() << "'); \n";
         
-        systemValues << std::setprecision(10) << actuatorFeedbackId + logNumber << ", "
-        << compassModelId + logNumber << ", " << courceCalculationId + logNumber
-        << ", " << currentSensorsId + logNumber << ", " << gpsId + logNumber << ", "
-        << marineSensorsId + logNumber << ", " << vesselStateId + logNumber << ", "
-        << windStateId + logNumber << ", " << windsensorId + logNumber << ", "
-        << currentMissionId;
+        systemValues << actuatorFeedbackId << ", " << compassModelId << ", "
+        << courceCalculationId << ", " << currentSensorsId << ", NULL, " << gpsId << ", "
+        << marineSensorsId << ", " << vesselStateId << ", " << windStateId << ", "
+        << windsensorId << ", " << currentMissionId;
         
         ss << "INSERT INTO "
         << "dataLogs_system"
-        << " VALUES(NULL, " << systemValues.str() << "); \n";
+        << " VALUES(" << systemId << ", " << systemValues.str() << "); \n";
         
         // NEW FEATURE, CAREFUL WITH THE APOSTROPHE (added in dbloggernode.h for now, maybe add it in getelementstr)
         currentSensorsValues << std::setprecision(10) << log.m_current << ", "
         << log.m_voltage << ", "
-        << log.m_element << ", '" //HERE (moved to the m_element_str)
+        << (int)log.m_element << ", '" //HERE (moved to the m_element_str)
         << log.m_element_str.c_str() << "', '" //AND HERE (moved to the m_element_str)
         << log.m_timestamp_str.c_str();
         
         ss << "INSERT INTO "
         << "dataLogs_current_sensors"
-        << " VALUES(NULL, " << currentSensorsValues.str() << "'); \n";
+        << " VALUES(" << currentSensorsId << ", " << currentSensorsValues.str() << "'); \n";
         
         
         
@@ -270,7 +321,7 @@ void DBHandler::insertDataLogs(std::vector<LogItem>& logs) {
         
         ss << "INSERT INTO "
         << "dataLogs_gps"
-        << " VALUES(NULL, " << gpsValues.str() << "'); \n";
+        << " VALUES(" << gpsId << ", " << gpsValues.str() << "'); \n";
         
         //Logger::info("Current sensors database insert command: %s \n", ss);
         //std::cout << "Current sensors database insert command: " << currentSensorsValues.str() << std::endl;
@@ -279,13 +330,12 @@ void DBHandler::insertDataLogs(std::vector<LogItem>& logs) {
     }
     
     if (queryTable(ss.str(), db)) {
-        tableId = getIdFromTable("dataLogs_system", true, db);
-        if (tableId.size() > 0) {
-            m_latestDataLogId = (int)strtol(tableId.c_str(), NULL, 10);
-        } else {
-            m_latestDataLogId = 0;
-        }
+        m_dataLogIds = ids;
+        m_latestDataLogId = ids["dataLogs_system"];
     } else {
+        // Nothing of the batch was kept, the ids are read again in case the tables were
+        // written to from elsewhere
+        m_dataLogIdsSeeded = false;
         m_latestDataLogId = 0;
         Logger::error("%s Error, failed to insert log Request: %s", __PRETTY_FUNCTION__,
                       ss.str().c_str());
@@ -326,6 +376,7 @@ bool DBHandler::updateTableJson(std::string table, std::string data) {
         Logger::error("%s Error: ", __PRETTY_FUNCTION__);
         return false;
     }
+    reloadConfigTable(table);
     return true;
 }
 
@@ -362,6 +413,7 @@ bool DBHandler::updateTableJsonObject(std::string table, Json data) {
         Logger::error("%s Error: ", __PRETTY_FUNCTION__);
         return false;
     }
+    reloadConfigTable(table);
     return true;
 }
 
@@ -374,32 +426,36 @@ bool DBHandler::updateTable(std::string table,
         Logger::error("%s Error updating table", __PRETTY_FUNCTION__);
         return false;
     }
+    reloadConfigTable(table);
     return true;
 }
 
 std::string DBHandler::retrieveCell(std::string table, std::string id, std::string column) {
-    std::string query = "SELECT " + column + " FROM " + table + " WHERE id=" + id + ";";
+    if (not isIdentifier(table) || not isIdentifier(column)) {
+        Logger::error("%s Invalid table or column: %s.%s", __PRETTY_FUNCTION__, table.c_str(),
+                      column.c_str());
+        return "";
+    }
+    std::string query = "SELECT " + column + " FROM " + table + " WHERE id=?;";
     
-    int rows, columns;
+    sqlite3* db = openDatabase();
     std::vector<std::string> results;
-    try {
-        results = retrieveFromTable(query, rows, columns);
-    } catch (const char* error) {
-        rows = 0;
-        columns = 0;
-    }
+    int resultcode = selectColumn(db, query, {id}, results);
+    closeDatabase(db);
     
-    if (columns < 1) {
-        Logger::error("%s No columns from Query: %s", __PRETTY_FUNCTION__, query.c_str());
+    if (resultcode != SQLITE_OK) {
+        Logger::error("%s Query: %s Error: %s", __PRETTY_FUNCTION__, query.c_str(),
+                      sqlite3_errstr(resultcode));
         return "";
     }
     
-    if (rows < 1) {
-        Logger::error("%s No rows from Query: %s", __PRETTY_FUNCTION__, query.c_str());
+    if (results.empty() || results[0].empty()) {
+        Logger::error("%s No rows from Query: %s id %s", __PRETTY_FUNCTION__, query.c_str(),
+                      id.c_str());
         return "";
     }
     
-    return results[1];
+    return results[0];
 }
 
 void DBHandler::updateConfigs(std::string configs) {
@@ -624,98 +680,150 @@ std::string DBHandler::getWaypoints() {  // NOTE : Marc : change this otherwise
 // max = false -> min id
 // max = true -> max id
 std::string DBHandler::getIdFromTable(std::string table, bool max) {
-    int rows, columns;
-    std::vector<std::string> results;
-    try {
-        if (max) {
-            results = retrieveFromTable("SELECT MAX(id) FROM " + table + ";", rows, columns);
-        } else {
-            results = retrieveFromTable("SELECT MIN(id) FROM " + table + ";", rows, columns);
-        }
-    } catch (const char* error) {
-        rows = 0;
-        columns = 0;
-    }
-    
-    if (rows * columns < 1) {
-        return "";
-    }
-    if (results[1] == "\0") {
-        return "";
-    } else {
-        return results[1];
-    }
+    sqlite3* db = openDatabase();
+    std::string id = getIdFromTable(table, max, db);
+    closeDatabase(db);
+    return id;
 }
 
 std::string DBHandler::getIdFromTable(std::string table, bool max, sqlite3* db) {
-    int rows, columns;
-    std::vector<std::string> results;
-    try {
-        if (max) {
-            results = retrieveFromTable("SELECT MAX(id) FROM " + table + ";", rows, columns, db);
-        } else {
-            results = retrieveFromTable("SELECT MIN(id) FROM " + table + ";", rows, columns, db);
-        }
-    } catch (const char* error) {
-        rows = 0;
-        columns = 0;
-    }
-    
-    if (rows * columns < 1) {
+    if (not isIdentifier(table)) {
+        Logger::error("%s Invalid table: %s", __PRETTY_FUNCTION__, table.c_str());
         return "";
     }
-    if (results[1] == "\0") {
+    
+    std::vector<std::string> results;
+    std::string query = std::string(max ? "SELECT MAX(id) FROM " : "SELECT MIN(id) FROM ") + table + ";";
+    
+    if (selectColumn(db, query, {}, results) != SQLITE_OK || results.empty()) {
         return "";
-    } else {
-        return results[1];
     }
+    return results[0];
 }
 
 ////////////////////////////////////////////////////////////////////
 // private helpers
 ////////////////////////////////////////////////////////////////////
 
+bool DBHandler::seedDataLogIds(sqlite3* db) {
+    std::map<std::string, int> ids;
+    
+    for (const char* table : DATALOG_TABLES) {
+        std::vector<std::string> maxId;
+        std::vector<std::string> sequence;
+        
+        // An autoincrement never gives an id out twice, even once the logs are cleared
+        if (selectColumn(db, std::string("SELECT MAX(id) FROM ") + table + ";", {}, maxId) != SQLITE_OK ||
+            selectColumn(db, "SELECT seq FROM sqlite_sequence WHERE name=?;", {table}, sequence) != SQLITE_OK) {
+            Logger::error("%s Could not read the last id of %s", __PRETTY_FUNCTION__, table);
+            return false;
+        }
+        
+        int id = maxId.empty() ? 0 : (int)strtol(maxId[0].c_str(), NULL, 10);
+        if (not sequence.empty()) {
+            id = std::max(id, (int)strtol(sequence[0].c_str(), NULL, 10));
+        }
+        ids[table] = id;
+    }
+    
+    m_dataLogIds = ids;
+    m_dataLogIdsSeeded = true;
+    return true;
+}
+
 sqlite3* DBHandler::openDatabase() {
-    m_databaseLock.lock();
-    sqlite3* connection;
-    int resultcode = 0;
+    return m_connections.acquire();
+}
+
+void DBHandler::closeDatabase(sqlite3* connection) {
+    m_connections.release(connection);
+}
+
+int DBHandler::selectColumn(sqlite3* db,
+                            const std::string& sql,
+                            const std::vector<std::string>& parameters,
+                            std::vector<std::string>& values) {
+    if (db == NULL) {
+        return SQLITE_CANTOPEN;
+    }
     
-    // check if file exists
-    FILE* db_file = fopen(m_filePath.c_str(), "r");
-    if (db_file == NULL) {
-        Logger::error("%s %s not found", __PRETTY_FUNCTION__, m_filePath.c_str());
-        m_databaseLock.unlock();
-        return NULL;
+    sqlite3_stmt* statement = NULL;
+    int resultcode = m_connections.prepare(db, sql, &statement);
+    if (resultcode != SQLITE_OK) {
+        return resultcode;
+    }
+    
+    for (unsigned int i = 0; i < parameters.size(); i++) {
+        // An id is bound as an integer, the column it is compared to
+        char* end = NULL;
+        long long number = strtoll(parameters[i].c_str(), &end, 10);
+        if (not parameters[i].empty() && *end == '\0') {
+            sqlite3_bind_int64(statement, i + 1, number);
+        } else {
+            sqlite3_bind_text(statement, i + 1, parameters[i].c_str(), -1, SQLITE_TRANSIENT);
+        }
     }
-    fclose(db_file);
     
     do {
-        resultcode = sqlite3_open(m_filePath.c_str(), &connection);
+        values.clear();
+        sqlite3_reset(statement);
+        while ((resultcode = sqlite3_step(statement)) == SQLITE_ROW) {
+            const unsigned char* text = sqlite3_column_text(statement, 0);
+            values.emplace_back(text != NULL ? reinterpret_cast<const char*>(text) : "");
+        }
     } while (resultcode == SQLITE_BUSY);
     
-    if (resultcode) {
-        Logger::error("%s Failed to open the database Error %s", __PRETTY_FUNCTION__,
-                      sqlite3_errmsg(connection));
-        m_databaseLock.unlock();
-        return 0;
-    }
+    // Leaves the statement without a read lock on the database
+    sqlite3_reset(statement);
     
-    // set a 10 millisecond timeout
-    sqlite3_busy_timeout(connection, 10);
-    return connection;
+    return (resultcode == SQLITE_DONE) ? SQLITE_OK : resultcode;
 }
 
-void DBHandler::closeDatabase(sqlite3* connection) {
-    if (connection != NULL) {
-        sqlite3_close(connection);
-        connection = NULL;
-        // ENsure it closes properly
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-        m_databaseLock.unlock();
-    } else {
-        m_databaseLock.unlock();
-        //throw std::runtime_error{ "DBHandler::closeDatabase() : connection is already null" };
+bool DBHandler::isIdentifier(const std::string& name) {
+    if (name.empty() || isdigit((unsigned char)name[0])) {
+        return false;
+    }
+    for (char c : name) {
+        if (not isalnum((unsigned char)c) && c != '_') {
+            return false;
+        }
     }
+    return true;
+}
+
+bool DBHandler::readConfigTable(sqlite3* db,
+                                const std::string& table,
+                                std::map<std::string, ConfigValue>& values) {
+    sqlite3_stmt* statement = NULL;
+    
+    if (db == NULL || not isIdentifier(table) ||
+        m_connections.prepare(db, "SELECT * FROM " + table + " WHERE id=1;", &statement) != SQLITE_OK) {
+        return false;
+    }
+    
+    int resultcode;
+    do {
+        sqlite3_reset(statement);
+        resultcode = sqlite3_step(statement);
+    } while (resultcode == SQLITE_BUSY);
+    
+    if (resultcode == SQLITE_ROW) {
+        for (int i = 0; i < sqlite3_column_count(statement); i++) {
+            int type = sqlite3_column_type(statement, i);
+            if (type == SQLITE_NULL) {
+                continue;
+            }
+            
+            ConfigValue value;
+            value.isNumber = (type == SQLITE_INTEGER || type == SQLITE_FLOAT);
+            value.number = sqlite3_column_double(statement, i);
+            value.text = reinterpret_cast<const char*>(sqlite3_column_text(statement, i));
+            values[sqlite3_column_name(statement, i)] = value;
+        }
+    }
+    
+    sqlite3_reset(statement);
+    return resultcode == SQLITE_ROW;
 }
 
 int DBHandler::getTable(sqlite3* db,
@@ -803,23 +911,23 @@ int DBHandler::insertLog(std::string table, std::string values, sqlite3* db) {
 
 bool DBHandler::queryTable(std::string sqlINSERT) {
     sqlite3* db = openDatabase();
-    m_error = NULL;
+    char* error = NULL;
     
     if (db != NULL) {
         int resultcode = 0;
         
         do {
-            if (m_error != NULL) {
-                sqlite3_free(m_error);
-                m_error = NULL;
+            if (error != NULL) {
+                sqlite3_free(error);
+                error = NULL;
             }
             
-            resultcode = sqlite3_exec(db, sqlINSERT.c_str(), NULL, NULL, &m_error);
+            resultcode = sqlite3_exec(db, sqlINSERT.c_str(), NULL, NULL, &error);
         } while (resultcode == SQLITE_BUSY);
-        if (m_error != NULL) {
-            Logger::error("%s Error: %s", __PRETTY_FUNCTION__, sqlite3_errmsg(db));
+        if (error != NULL) {
+            Logger::error("%s Error: %s", __PRETTY_FUNCTION__, error);
             
-            sqlite3_free(m_error);
+            sqlite3_free(error);
             closeDatabase(db);
             return false;
         }
@@ -833,25 +941,32 @@ bool DBHandler::queryTable(std::string sqlINSERT) {
 }
 
 bool DBHandler::queryTable(std::string sqlINSERT, sqlite3* db) {
-    m_error = NULL;
+    char* error = NULL;
     
     if (db != NULL) {
         int resultcode = 0;
         
         do {
-            if (m_error != NULL) {
-                sqlite3_free(m_error);
-                m_error = NULL;
+            if (error != NULL) {
+                sqlite3_free(error);
+                error = NULL;
+            }
+            sqlite3_exec(db, "BEGIN TRANSACTION", NULL, NULL, NULL);
+            resultcode = sqlite3_exec(db, sqlINSERT.c_str(), NULL, NULL, &error);
+            if (resultcode == SQLITE_OK) {
+                resultcode = sqlite3_exec(db, "END TRANSACTION", NULL, NULL, &error);
+            }
+            if (resultcode != SQLITE_OK) {
+                // Another connection holds the database, nothing of the batch is kept before
+                // retrying it
+                sqlite3_exec(db, "ROLLBACK", NULL, NULL, NULL);
             }
-            sqlite3_exec(db, "BEGIN TRANSACTION", NULL, NULL, &m_error);
-            resultcode = sqlite3_exec(db, sqlINSERT.c_str(), NULL, NULL, &m_error);
-            sqlite3_exec(db, "END TRANSACTION", NULL, NULL, &m_error);
         } while (resultcode == SQLITE_BUSY);
         
-        if (m_error != NULL) {
-            Logger::error("%s Error: %s", __PRETTY_FUNCTION__, sqlite3_errmsg(db));
+        if (error != NULL) {
+            Logger::error("%s Error: %s", __PRETTY_FUNCTION__, error);
             
-            sqlite3_free(m_error);
+            sqlite3_free(error);
             return false;
         }
     } else {
@@ -1072,5 +1187,6 @@ bool DBHandler::changeOneValue(std::string table,
         Logger::error("Error %s", __PRETTY_FUNCTION__);
         return false;
     }
+    reloadConfigTable(table);
     return true;
 }
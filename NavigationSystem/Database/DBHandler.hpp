@@ -8,11 +8,15 @@
 #ifndef DBHANDLER_HPP
 #define DBHANDLER_HPP
 
+#include "ConfigSnapshot.hpp"
+#include "DBConnectionPool.hpp"
 #include "../Messages/CurrentSensorDataMsg.hpp"
 #include "../Messages/WindStateMsg.hpp"
 #include "../SystemServices/Logger.hpp"
 #include "../Libs/json/include/nlohmann/json.hpp"
 #include <sqlite3.h>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
@@ -76,11 +80,18 @@ struct LogItem {
 
 class DBHandler {
    private:
-    char* m_error;
     int m_latestDataLogId;
     std::string m_currentWaypointId = "";
     std::string m_filePath;
-    static std::mutex m_databaseLock;
+    DBConnectionPool m_connections;
+    std::shared_ptr<const ConfigSnapshot> m_configs;
+    std::mutex m_configWriteLock;       // one snapshot built at a time, reading needs no lock
+
+    // the last id of each data log table, read from the database once and moved on only when
+    // a batch of logs is committed
+    std::map<std::string, int> m_dataLogIds;
+    bool m_dataLogIdsSeeded;
+    std::mutex m_dataLogLock;           // one batch of logs inserted at a time
 
     // execute INSERT query and add new row into table
     bool queryTable(std::string sqlINSERT);
@@ -95,6 +106,25 @@ class DBHandler {
                                                int& columns,
                                                sqlite3* db);
 
+    // runs a statement from the cache of the connection with the parameters bound in order,
+    // returns the first column of every row, NULL as an empty string
+    int selectColumn(sqlite3* db,
+                     const std::string& sql,
+                     const std::vector<std::string>& parameters,
+                     std::vector<std::string>& values);
+
+    // true for a table or column name, which can't be bound as a parameter
+    static bool isIdentifier(const std::string& name);
+
+    // reads the row with id 1 of a config table, false if it has none
+    bool readConfigTable(sqlite3* db, const std::string& table, std::map<std::string, ConfigValue>& values);
+
+    // publishes a new snapshot of the configs after a change to a config table
+    void reloadConfigTable(const std::string& table);
+
+    // reads the last id of each data log table, the highest an autoincrement ever gave out
+    bool seedDataLogIds(sqlite3* db);
+
     // adds a table row into the json object as a array if array flag is true,
     // otherwise it adds the table row as a json object
     // id field is not obligatory, can be left empty
@@ -125,16 +155,32 @@ class DBHandler {
                  int& rows,
                  int& columns);
 
+    // borrows a connection from the pool, to give back with closeDatabase()
     sqlite3* openDatabase();
 
     void closeDatabase(sqlite3* connection);
 
    public:
-    DBHandler(std::string filePath);
+    // the settings journal the database with a write-ahead log unless the build says otherwise
+    DBHandler(std::string filePath, const DBSettings& settings = DBSettings());
     ~DBHandler(void);
 
     bool initialise();
 
+    // closes the connections once they are all given back, the next query reopens them
+    void close();
+
+    unsigned int openConnections() { return m_connections.openConnections(); }
+
+    unsigned int checkpoints() const { return m_connections.checkpoints(); }
+
+    // the config tables in memory, a new snapshot takes the place of this one when a config
+    // changes through the handler
+    std::shared_ptr<const ConfigSnapshot> configs();
+
+    // reads all the config tables again, false if none could be read
+    bool loadConfigs();
+
     int getRows(std::string table);
 
     void insertDataLogs(std::vector<LogItem>& logs);
@@ -164,8 +210,6 @@ class DBHandler {
     // id
     std::string getLogs(bool onlyLatest);
 
-    void forceUnlock() { m_databaseLock.unlock(); }
-
     void clearLogs();
 
     // get id from table returns either max or min id from table.
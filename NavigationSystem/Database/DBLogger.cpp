@@ -6,6 +6,7 @@
  */
 
 #include "DBLogger.hpp"
+#include "../SystemServices/ThreadConfig.hpp"
 
 DBLogger::DBLogger(unsigned int logBufferSize, DBHandler& dbHandler)
 	:m_dbHandler(dbHandler), m_bufferSize(logBufferSize)
@@ -73,6 +74,8 @@ FloatOrDouble DBLogger::setValue(FloatOrDouble value) //Function to check if val
 
 void DBLogger::workerThread(DBLogger* ptr)
 {
+	ThreadConfig::apply("DBLoggerWriter");
+
 	while(ptr->m_working.load() == true)
 	{
 		std::unique_lock<std::mutex> lk(ptr->m_mutex);
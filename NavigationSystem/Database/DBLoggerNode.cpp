@@ -191,7 +191,8 @@ bool DBLoggerNode::init() {
 ///----------------------------------------------------------------------------------
 void DBLoggerNode::updateConfigsFromDB()
 {
-    m_loopTime = m_db.retrieveCellAsDouble("config_dblogger","1","loop_time");
+    std::shared_ptr<const ConfigSnapshot> configs = m_db.configs();
+    m_loopTime = configs->getDouble("config_dblogger", "loop_time");
 }
 
 ///----------------------------------------------------------------------------------
@@ -201,8 +202,9 @@ void DBLoggerNode::DBLoggerNodeThreadFunc(ActiveNode* nodePtr)
     DBLoggerNode* node = dynamic_cast<DBLoggerNode*> (nodePtr);
     
     std::string timestamp_str;
-    Timer timer;
+    FixedRateTimer timer("DBLogger");
     timer.start();
+    node->watchLoop(node->m_loopTime);
     node->m_dbLogger.startWorkerThread();
 
     while(node->m_Running.load() == true) {
@@ -216,7 +218,7 @@ void DBLoggerNode::DBLoggerNodeThreadFunc(ActiveNode* nodePtr)
         node->m_dbLogger.log(node->item);
         node->m_lock.unlock();
         
-        timer.sleepUntil(node->m_loopTime);
-        timer.reset();
+        node->reportProgress();
+        timer.sleepUntilNext(node->m_loopTime);
     }
 }
@@ -27,13 +27,14 @@ HTTPSyncNode::HTTPSyncNode(MessageBus& msgBus, DBHandler& dbhandler)
 }
 
 bool HTTPSyncNode::init() {
+    std::shared_ptr<const ConfigSnapshot> configs = m_dbHandler.configs();
     m_initialised = false;
     m_reportedConnectError = false;
 
     m_serverURL = "requestbin.fullcontact.com";//m_dbHandler.retrieveCell("config_httpsync", "1", "srv_addr");
     m_endpoint = "/x32mk1x3";
-    m_shipID = m_dbHandler.retrieveCell("config_httpsync", "1", "boat_id");
-    m_shipPWD = m_dbHandler.retrieveCell("config_httpsync", "1", "boat_pwd");
+    m_shipID = configs->getString("config_httpsync", "boat_id");
+    m_shipPWD = configs->getString("config_httpsync", "boat_pwd");
     updateConfigsFromDB();
 
     m_initialised = true;
@@ -58,10 +59,11 @@ void HTTPSyncNode::stop()
 }
 
 void HTTPSyncNode::updateConfigsFromDB() {
-    m_removeLogs = m_dbHandler.retrieveCellAsInt("config_httpsync", "1", "remove_logs");
+    std::shared_ptr<const ConfigSnapshot> configs = m_dbHandler.configs();
+    m_removeLogs = configs->getInt("config_httpsync", "remove_logs");
     m_pushOnlyLatestLogs =
-        m_dbHandler.retrieveCellAsInt("config_httpsync", "1", "push_only_latest_logs");
-    m_LoopTime = m_dbHandler.retrieveCellAsDouble("config_httpsync", "1", "loop_time");
+        configs->getInt("config_httpsync", "push_only_latest_logs");
+    m_LoopTime = configs->getDouble("config_httpsync", "loop_time");
 }
 
 void HTTPSyncNode::processMessage(const Message* msgPtr) {
@@ -91,15 +93,16 @@ void HTTPSyncNode::HTTPSyncThread(ActiveNode* nodePtr) {
     node->pushWaypoints();
     node->pushConfigs();
 
-    Timer timer;
+    FixedRateTimer timer("HTTPSync");
     timer.start();
+    node->watchLoop(node->m_LoopTime);
     while (node->m_Running.load() == true) {
         node->getConfigsFromServer();
         node->getWaypointsFromServer();
         node->pushDatalogs();
 
-        timer.sleepUntil(node->m_LoopTime);
-        timer.reset();
+        node->reportProgress();
+        timer.sleepUntilNext(node->m_LoopTime);
     }
 
     Logger::info("HTTPSync thread has exited");
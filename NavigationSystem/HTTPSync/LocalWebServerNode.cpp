@@ -41,7 +41,8 @@ void LocalWebServerNode::stop() {
 }
 
 void LocalWebServerNode::updateConfigsFromDB() {
-    m_LoopTime = m_dbHandler->retrieveCellAsDouble("config_httpsync", "1", "loop_time");
+    std::shared_ptr<const ConfigSnapshot> configs = m_dbHandler->configs();
+    m_LoopTime = configs->getDouble("config_httpsync", "loop_time");
 }
 
 void LocalWebServerNode::processMessage(const Message* msgPtr) {
@@ -36,7 +36,8 @@ ArduinoNode::ArduinoNode(MessageBus& msgBus,  DBHandler& dbhandler)
 
 void ArduinoNode::updateConfigsFromDB()
 {
-	m_LoopTime = m_db.retrieveCellAsDouble("config_arduino","1","loop_time");
+	std::shared_ptr<const ConfigSnapshot> configs = m_db.configs();
+	m_LoopTime = configs->getDouble("config_arduino", "loop_time");
 }
 
 bool ArduinoNode::init()
@@ -97,8 +98,9 @@ void ArduinoNode::ArduinoThreadFunc(ActiveNode* nodePtr)
 
     Logger::info("Arduino thread started");
 
-		Timer timer;
+		FixedRateTimer timer("Arduino");
 	  timer.start();
+	  node->watchLoop(node->m_LoopTime);
     while(true)
     {
 
@@ -133,7 +135,7 @@ void ArduinoNode::ArduinoThreadFunc(ActiveNode* nodePtr)
         MessagePtr msg = std::make_unique<ArduinoDataMsg>(node->m_pressure, node->m_rudder, node->m_sheet, node->m_battery);
         node->m_MsgBus.sendMessage(std::move(msg));
 
-		timer.sleepUntil(node->m_LoopTime);
-		timer.reset();
+		node->reportProgress();
+		timer.sleepUntilNext(node->m_LoopTime);
     }
 }
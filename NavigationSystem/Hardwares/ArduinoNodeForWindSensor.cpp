@@ -90,11 +90,13 @@ void ArduinoNodeForWindSensor::ArduinoThreadFunc(ActiveNode* nodePtr)
 
 	Logger::info("Arduino thread started");
 
-	Timer timer;
+	FixedRateTimer timer("ArduinoWindSensor");
 	timer.start();
+	node->watchLoop(node->m_LoopTime);
 	while(true)
 	{
-		timer.sleepUntil(node->m_LoopTime);
+		node->reportProgress();
+		timer.sleepUntilNext(node->m_LoopTime);
 		uint8_t block[BLOCK_READ_SIZE],remainder,multiple;
 		//readValues(block)
 
@@ -110,6 +112,5 @@ void ArduinoNodeForWindSensor::ArduinoThreadFunc(ActiveNode* nodePtr)
 		}
 		MessagePtr msg = std::make_unique<WindDataMsg>(node->m_windDirection, 0, 0);
 		node->m_MsgBus.sendMessage(std::move(msg));
-		timer.reset();
 	}
 }
@@ -37,7 +37,8 @@ bool AutopilotReadNode::init()
 
 void AutopilotReadNode::updateConfigsFromDB()
 {
-    m_LoopTime = m_db.retrieveCellAsDouble("config_can_arduino","1","loop_time");
+    std::shared_ptr<const ConfigSnapshot> configs = m_db.configs();
+    m_LoopTime = configs->getDouble("config_can_arduino", "loop_time");
 }
 
 void AutopilotReadNode::processMessage (const Message* message)
@@ -68,8 +69,9 @@ void AutopilotReadNode::AutopilotReadNodeThreadFunc(ActiveNode* nodePtr)
     bool valid;
     mavlink_message_t message;
     
-    Timer timer;
+    FixedRateTimer timer("AutopilotRead");
     timer.start();
+    node->watchLoop(node->m_LoopTime);
     
     while(node->m_Running.load() == true)
     {
@@ -160,7 +162,7 @@ void AutopilotReadNode::AutopilotReadNodeThreadFunc(ActiveNode* nodePtr)
             }
         }
      
-        timer.sleepUntil(node->m_LoopTime);
-        timer.reset();
+        node->reportProgress();
+        timer.sleepUntilNext(node->m_LoopTime);
     }
 }
@@ -42,7 +42,8 @@ void CANAISNode::processMessage(const Message* message) {
 }
 
 void CANAISNode::updateConfigsFromDB(){
-    m_LoopTime = m_db.retrieveCellAsDouble("config_ais","1","loop_time");
+    std::shared_ptr<const ConfigSnapshot> configs = m_db.configs();
+    m_LoopTime = configs->getDouble("config_ais", "loop_time");
 }
 
 void CANAISNode::processPGN(N2kMsg& nMsg) {
@@ -134,8 +135,9 @@ void CANAISNode::start() {
 
 void CANAISNode::CANAISThreadFunc(ActiveNode* nodePtr) {
   CANAISNode* node = dynamic_cast<CANAISNode*> (nodePtr);
-  Timer timer;
+  FixedRateTimer timer("CANAIS");
   timer.start();
+  node->watchLoop(node->m_LoopTime);
 
   while(true) {
 
@@ -150,7 +152,7 @@ void CANAISNode::CANAISThreadFunc(ActiveNode* nodePtr) {
     else {
         node->m_lock.unlock();
     }
-    timer.sleepUntil(node->m_LoopTime);
-    timer.reset();
+    node->reportProgress();
+    timer.sleepUntilNext(node->m_LoopTime);
   }
 }
@@ -42,7 +42,8 @@ bool CANArduinoNode::init() {
 
 void CANArduinoNode::updateConfigsFromDB()
 {
-    m_LoopTime = m_db.retrieveCellAsDouble("config_can_arduino","1","loop_time");
+    std::shared_ptr<const ConfigSnapshot> configs = m_db.configs();
+    m_LoopTime = configs->getDouble("config_can_arduino", "loop_time");
 }
 
 void CANArduinoNode::processMessage (const Message* message){
@@ -83,8 +84,9 @@ void CANArduinoNode::CANArduinoNodeThreadFunc(ActiveNode* nodePtr) {
 
 
 	CANArduinoNode* node = dynamic_cast<CANArduinoNode*> (nodePtr);
-	Timer timer;
+	FixedRateTimer timer("CANArduino");
 	timer.start();
+	node->watchLoop(node->m_LoopTime);
 
 	while(true) {
 
@@ -99,7 +101,7 @@ void CANArduinoNode::CANArduinoNodeThreadFunc(ActiveNode* nodePtr) {
 		}
 		node->m_lock.unlock();
 
-		timer.sleepUntil(node->m_LoopTime);
-		timer.reset();
+		node->reportProgress();
+		timer.sleepUntilNext(node->m_LoopTime);
 	}
 }
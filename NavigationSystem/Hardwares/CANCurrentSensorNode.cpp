@@ -85,8 +85,9 @@ void CANCurrentSensorNode::CANCurrentSensorNodeThreadFunc(ActiveNode* nodePtr) {
 
 
 	CANCurrentSensorNode* node = dynamic_cast<CANCurrentSensorNode*> (nodePtr);
-	Timer timer;
+	FixedRateTimer timer("CANCurrentSensor");
 	timer.start();
+	node->watchLoop(node->m_LoopTime);
 
 	while(true) {
 
@@ -101,7 +102,7 @@ void CANCurrentSensorNode::CANCurrentSensorNodeThreadFunc(ActiveNode* nodePtr) {
 //		}
 		node->m_lock.unlock();
 
-		timer.sleepUntil(node->m_LoopTime);
-		timer.reset();
+		node->reportProgress();
+		timer.sleepUntilNext(node->m_LoopTime);
 	}
 }
@@ -38,7 +38,8 @@ bool CANSolarTrackerNode::init() {
 }
 
 void CANSolarTrackerNode::updateConfigsFromDB(){
-	m_LoopTime = m_db.retrieveCellAsDouble("config_solar_tracker","1","loop_time");
+	std::shared_ptr<const ConfigSnapshot> configs = m_db.configs();
+	m_LoopTime = configs->getDouble("config_solar_tracker", "loop_time");
 }
 
 void CANSolarTrackerNode::processMessage (const Message* message) {
@@ -113,8 +114,9 @@ void CANSolarTrackerNode::CANSolarTrackerThreadFunc(ActiveNode* nodePtr) {
 	node->m_Hour = 0;
 	node->m_Minute = 0;
 
-	Timer timer;
+	FixedRateTimer timer("CANSolarTracker");
 	timer.start();
+	node->watchLoop(node->m_LoopTime);
 
 	while(true) {
 
@@ -128,7 +130,7 @@ void CANSolarTrackerNode::CANSolarTrackerThreadFunc(ActiveNode* nodePtr) {
 
 		node->m_lock.unlock();
 
-		timer.sleepUntil(node->m_LoopTime);
-		timer.reset();
+		node->reportProgress();
+		timer.sleepUntilNext(node->m_LoopTime);
 	}
 }
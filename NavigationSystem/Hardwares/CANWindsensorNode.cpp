@@ -119,7 +119,8 @@ uint8_t &PressureSource, double &Pressure)
 }
 
 void CANWindsensorNode::updateConfigsFromDB() {
-    m_LoopTime = m_db.retrieveCellAsDouble("config_wind_sensor","1","loop_time");
+    std::shared_ptr<const ConfigSnapshot> configs = m_db.configs();
+    m_LoopTime = configs->getDouble("config_wind_sensor", "loop_time");
 }
 
 void CANWindsensorNode::processMessage(const Message* message) {
@@ -149,8 +150,9 @@ void CANWindsensorNode::start()
 void CANWindsensorNode::CANWindSensorNodeThreadFunc(ActiveNode* nodePtr) {
 
   CANWindsensorNode* node = dynamic_cast<CANWindsensorNode*> (nodePtr);
-  Timer timer;
+  FixedRateTimer timer("CANWindsensor");
   timer.start();
+  node->watchLoop(node->m_LoopTime);
 
   while(true)
 	{
@@ -164,7 +166,7 @@ void CANWindsensorNode::CANWindSensorNodeThreadFunc(ActiveNode* nodePtr) {
     }
     node->m_lock.unlock();
 
-    timer.sleepUntil(node->m_LoopTime);
-    timer.reset();
+    node->reportProgress();
+    timer.sleepUntilNext(node->m_LoopTime);
   }
 }
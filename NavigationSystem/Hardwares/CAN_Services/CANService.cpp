@@ -1,5 +1,6 @@
 #include "CANService.h"
 #include "can_rpi_defs.h"
+#include "../../SystemServices/ThreadConfig.hpp"
 
 #include <fstream>
 #include <iostream>
@@ -76,6 +77,8 @@ std::future<void> CANService::start()
 
 void CANService::run()
 {
+  ThreadConfig::apply("CANService");
+
   bool ParsedEntireMessage;
   N2kMsg Nmsg;
   while(m_Running.load() == true)
@@ -118,8 +121,7 @@ void CANService::run()
       }
       else
       {
-        std::cout << "Error: Cmsg.header.ide = " << Cmsg.header.ide;
-        std::cout << " - should be 0 or 1" << std::endl;
+        LOG_LIMITED(LogLevel::Error, "Cmsg.header.ide = %d - should be 0 or 1", Cmsg.header.ide);
       }
     }
 
@@ -42,8 +42,10 @@ CV7Node::CV7Node(MessageBus& msgBus, DBHandler& dbhandler)
 {
 	msgBus.registerNode(*this, MessageType::DataRequest);
 	msgBus.registerNode(*this, MessageType::ServerConfigsReceived);
-	m_BaudRate = m_db.retrieveCellAsInt("config_wind_sensor","1","baud_rate");
-	m_PortName = m_db.retrieveCell("config_wind_sensor","1","port");
+
+	std::shared_ptr<const ConfigSnapshot> configs = m_db.configs();
+	m_BaudRate = configs->getInt("config_wind_sensor", "baud_rate");
+	m_PortName = configs->getString("config_wind_sensor", "port");
 }
 
 CV7Node::~CV7Node()
@@ -84,7 +86,8 @@ void CV7Node::start()
 
 void CV7Node::updateConfigsFromDB()
 {
-	m_LoopTime = m_db.retrieveCellAsDouble("config_wind_sensor","1","loop_time");
+	std::shared_ptr<const ConfigSnapshot> configs = m_db.configs();
+	m_LoopTime = configs->getDouble("config_wind_sensor", "loop_time");
 }
 
 void CV7Node::processMessage(const Message* message)
@@ -129,6 +132,9 @@ void CV7Node::WindSensorThread(ActiveNode* nodePtr)
 	float windSpeed = 0;
 	float windTemp = 0;
 
+	// Progress is data read off the serial line, a silent sensor is reported as well
+	node->watchLoop(node->m_LoopTime);
+
 	while(true)
 	{
     int bytes = 0;
@@ -155,6 +161,7 @@ void CV7Node::WindSensorThread(ActiveNode* nodePtr)
 		// Parse the data and send out messages
 		if(bytes > 0 )
 		{
+			node->reportProgress();
 			buffer_to_parse+=buffer;
 
       //Logger::info("buffer windsensor %s",buffer_to_parse.c_str());
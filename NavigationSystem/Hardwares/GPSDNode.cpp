@@ -13,6 +13,7 @@
 
 #include "GPSDNode.h"
 #include "../SystemServices/Logger.hpp"
+#include "../SystemServices/SysClock.hpp"
 #include "../Messages/GPSDataMsg.hpp"
 #include "../SystemServices/Timer.hpp"
 
@@ -49,7 +50,8 @@ bool GPSDNode::init()
 
 void GPSDNode::updateConfigsFromDB()
 {
-	m_LoopTime = m_db.retrieveCellAsDouble("config_gps","1","loop_time");
+	std::shared_ptr<const ConfigSnapshot> configs = m_db.configs();
+	m_LoopTime = configs->getDouble("config_gps", "loop_time");
 }
 
 void GPSDNode::processMessage(const Message* msgPtr)
@@ -79,8 +81,9 @@ void GPSDNode::GPSThreadFunc(ActiveNode* nodePtr)
 
 	Logger::info("GPSD thread started");
 
-	Timer timer;
+	FixedRateTimer timer("GPSD");
 	timer.start();
+	node->watchLoop(node->m_LoopTime);
 	while(true)
 	{
 		if(not node->m_GpsConnection->waiting(node->GPS_TIMEOUT_MICRO_SECS))
@@ -129,8 +132,8 @@ void GPSDNode::GPSThreadFunc(ActiveNode* nodePtr)
 		node->m_MsgBus.sendMessage(std::move(msg));
 
 		// Controls how often we pump out messages
-		timer.sleepUntil(node->m_LoopTime);
-		timer.reset();
+		node->reportProgress();
+		timer.sleepUntilNext(node->m_LoopTime);
 	}
 }
 */
@@ -110,8 +110,9 @@ void HMC6343Node::start()
 
 void HMC6343Node::updateConfigsFromDB()
 {
-	m_LoopTime = m_db.retrieveCellAsDouble("config_compass","1","loop_time");
-	m_HeadingBufferSize = m_db.retrieveCellAsInt("config_compass","1","heading_buffer_size");
+	std::shared_ptr<const ConfigSnapshot> configs = m_db.configs();
+	m_LoopTime = configs->getDouble("config_compass", "loop_time");
+	m_HeadingBufferSize = configs->getInt("config_compass", "heading_buffer_size");
 }
 
 void HMC6343Node::processMessage(const Message* msg)
@@ -210,8 +211,9 @@ void HMC6343Node::HMC6343ThreadFunc(ActiveNode* nodePtr)
 	std::vector<float> headingData(node->m_HeadingBufferSize);
 	int headingIndex = 0;
 
-	Timer timer;
+	FixedRateTimer timer("Compass");
 	timer.start();
+	node->watchLoop(node->m_LoopTime);
 	while(true)
 	{
 
@@ -250,7 +252,7 @@ void HMC6343Node::HMC6343ThreadFunc(ActiveNode* nodePtr)
 			errorCount++;
 		}
 		// Controls how often we pump out messages
-		timer.sleepUntil(node->m_LoopTime);
-		timer.reset();
+		node->reportProgress();
+		timer.sleepUntilNext(node->m_LoopTime);
 	}
 }
@@ -10,7 +10,7 @@
 
 ///----------------------------------------------------------------------------------
 CourseRegulatorNode::CourseRegulatorNode( MessageBus& msgBus,  DBHandler& dbhandler)
-:ActiveNode(NodeID::CourseRegulatorNode,msgBus), m_db(dbhandler), m_Running(0),
+:ActiveNode(NodeID::CourseRegulatorNode,msgBus), m_db(dbhandler),
 m_LoopTime(0.5), m_MaxRudderAngle(30), m_pGain(1), m_iGain(1), m_dGain(1),
 m_VesselCourse(DATA_OUT_OF_RANGE), m_VesselSpeed(DATA_OUT_OF_RANGE), m_DesiredCourse(DATA_OUT_OF_RANGE)
 {
@@ -32,15 +32,13 @@ bool CourseRegulatorNode::init()
 ///----------------------------------------------------------------------------------
 void CourseRegulatorNode::start()
 {
-    m_Running.store(true);
-    runThread(CourseRegulatorNodeThreadFunc);
+    runPeriodic(CourseRegulatorNodeTick, m_LoopTime, INITIAL_SLEEP / 1000.0);
 }
 
 ///----------------------------------------------------------------------------------
 void CourseRegulatorNode::stop()
 {
-    m_Running.store(false);
-    stopThread(this);
+    stopPeriodic();
 }
 
 ///----------------------------------------------------------------------------------
@@ -65,11 +63,13 @@ void CourseRegulatorNode::processMessage( const Message* msg )
 ///----------------------------------------------------------------------------------
 void CourseRegulatorNode::updateConfigsFromDB()
 {
-    m_LoopTime = m_db.retrieveCellAsDouble("config_course_regulator","1","loop_time");
-    m_MaxRudderAngle = m_db.retrieveCellAsInt("config_course_regulator","1","max_rudder_angle");
-    m_pGain = m_db.retrieveCellAsDouble("config_course_regulator","1","p_gain");
-    m_iGain = m_db.retrieveCellAsDouble("config_course_regulator","1","i_gain");
-    m_dGain = m_db.retrieveCellAsDouble("config_course_regulator","1","d_gain");
+    std::shared_ptr<const ConfigSnapshot> configs = m_db.configs();
+    m_LoopTime = configs->getDouble("config_course_regulator", "loop_time");
+    setPeriod(m_LoopTime);
+    m_MaxRudderAngle = configs->getInt("config_course_regulator", "max_rudder_angle");
+    m_pGain = configs->getDouble("config_course_regulator", "p_gain");
+    m_iGain = configs->getDouble("config_course_regulator", "i_gain");
+    m_dGain = configs->getDouble("config_course_regulator", "d_gain");
 }
 
 ///----------------------------------------------------------------------------------
@@ -79,6 +79,7 @@ void CourseRegulatorNode::processStateMessage(const StateMessage* msg)
 
     m_VesselCourse = msg->course();
     m_VesselSpeed = msg->speed();
+    m_StateTrace = msg->trace();
 }
 
 ///----------------------------------------------------------------------------------
@@ -115,24 +116,18 @@ float CourseRegulatorNode::calculateRudderAngle()
 
 
 ///----------------------------------------------------------------------------------
-void CourseRegulatorNode::CourseRegulatorNodeThreadFunc(ActiveNode* nodePtr)
+void CourseRegulatorNode::CourseRegulatorNodeTick(ActiveNode* nodePtr)
 {
-    Logger::info("CourseRegulatorNode thread has started");
     CourseRegulatorNode* node = dynamic_cast<CourseRegulatorNode*> (nodePtr);
-    std::this_thread::sleep_for(std::chrono::milliseconds(INITIAL_SLEEP));
 
-    Timer timer;
-    timer.start();
-
-    while(node->m_Running.load() == true)
+    float rudderCommand = node->calculateRudderAngle();
+    if (rudderCommand != NO_COMMAND)
     {
-        float rudderCommand = node->calculateRudderAngle();
-        if (rudderCommand != NO_COMMAND)
+        MessagePtr rudderCommandMsg = std::make_unique<RudderCommandMsg>(rudderCommand);
         {
-            MessagePtr rudderCommandMsg = std::make_unique<RudderCommandMsg>(rudderCommand);
-            node->m_MsgBus.sendMessage(std::move(rudderCommandMsg));
+            std::lock_guard<std::mutex> lock_guard(node->m_lock);
+            rudderCommandMsg->setParent(node->m_StateTrace);
         }
-        timer.sleepUntil(node->m_LoopTime);
-        timer.reset();
+        node->m_MsgBus.sendMessage(std::move(rudderCommandMsg));
     }
 }
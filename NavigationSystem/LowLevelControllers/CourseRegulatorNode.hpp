@@ -58,13 +58,12 @@ private:
     float calculateRudderAngle();
     
     ///----------------------------------------------------------------------------------
-    /// @brief Starts the CourseRegulatorNode's thread that pumps out RudderCommandMsg.
+    /// @brief Pumps out a RudderCommandMsg, every loop time.
     ///----------------------------------------------------------------------------------
-    static void CourseRegulatorNodeThreadFunc(ActiveNode* nodePtr);
+    static void CourseRegulatorNodeTick(ActiveNode* nodePtr);
     
     DBHandler& m_db;
     std::mutex m_lock;
-    std::atomic<bool> m_Running;
     
     double m_LoopTime;        // seconds
     double m_MaxRudderAngle;  // degrees
@@ -75,6 +74,7 @@ private:
     
     float m_VesselCourse;  // degree [0, 360[ in North-East reference frame (clockwise)
     float m_VesselSpeed;   // m/s
+    MessageTrace m_StateTrace;  // Latest state message, the parent of the rudder commands
     
     float m_DesiredCourse;  // degree [0, 360[ in North-East reference frame (clockwise)
 };
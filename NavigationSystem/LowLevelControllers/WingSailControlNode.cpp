@@ -8,7 +8,7 @@
  *          - calculateTailAngle(),
  *          - simpleCalculateTailAngle().
  *          You can choose the one you want to use by commenting/uncommenting lines
- *          in WingSailControlNodeThreadFunc().
+ *          in WingSailControlNodeTick().
  */
 
 #include "WingSailControlNode.hpp"
@@ -41,15 +41,13 @@ bool WingSailControlNode::init(){
 ///----------------------------------------------------------------------------------
 void WingSailControlNode::start()
 {
-    m_Running.store(true);
-    runThread(WingSailControlNodeThreadFunc);
+    runPeriodic(WingSailControlNodeTick, m_LoopTime, INITIAL_SLEEP / 1000.0);
 }
 
 ///----------------------------------------------------------------------------------
 void WingSailControlNode::stop()
 {
-    m_Running.store(false);
-    stopThread(this);
+    stopPeriodic();
 }
 
 ///----------------------------------------------------------------------------------
@@ -74,8 +72,10 @@ void WingSailControlNode::processMessage( const Message* msg)
 ///----------------------------------------------------------------------------------
 void WingSailControlNode::updateConfigsFromDB()
 {
-    m_LoopTime = m_db.retrieveCellAsDouble("config_wingsail_control","1","loop_time");
-    m_MaxCommandAngle = m_db.retrieveCellAsDouble("config_wingsail_control","1","max_cmd_angle");
+    std::shared_ptr<const ConfigSnapshot> configs = m_db.configs();
+    m_LoopTime = configs->getDouble("config_wingsail_control", "loop_time");
+    setPeriod(m_LoopTime);
+    m_MaxCommandAngle = configs->getDouble("config_wingsail_control", "max_cmd_angle");
 }
 
 ///----------------------------------------------------------------------------------
@@ -163,25 +163,15 @@ float WingSailControlNode::simpleCalculateTailAngle()
 }
 
 ///----------------------------------------------------------------------------------
-void WingSailControlNode::WingSailControlNodeThreadFunc(ActiveNode* nodePtr)
+void WingSailControlNode::WingSailControlNodeTick(ActiveNode* nodePtr)
 {
-    Logger::info("WingSailControlNode thread has started");
     WingSailControlNode* node = dynamic_cast<WingSailControlNode*> (nodePtr);
-    std::this_thread::sleep_for(std::chrono::milliseconds(INITIAL_SLEEP));
 
-    Timer timer;
-    timer.start();
-
-    while(node->m_Running.load() == true)
+    //float wingSailCommand = (float)node->calculateTailAngle();
+    float wingSailCommand = (float)node->simpleCalculateTailAngle();
+    if (wingSailCommand != NO_COMMAND)
     {
-        //float wingSailCommand = (float)node->calculateTailAngle();
-        float wingSailCommand = (float)node->simpleCalculateTailAngle();
-        if (wingSailCommand != NO_COMMAND)
-        {
-            MessagePtr wingSailCommandMsg = std::make_unique<WingSailCommandMsg>(wingSailCommand);
-            node->m_MsgBus.sendMessage(std::move(wingSailCommandMsg));
-        }
-        timer.sleepUntil(node->m_LoopTime);
-        timer.reset();
+        MessagePtr wingSailCommandMsg = std::make_unique<WingSailCommandMsg>(wingSailCommand);
+        node->m_MsgBus.sendMessage(std::move(wingSailCommandMsg));
     }
 }
@@ -8,7 +8,7 @@
  *          - calculateTailAngle(),
  *          - simpleCalculateTailAngle().
  *          You can choose the one you want to use by commenting/uncommenting lines
- *          in WingSailControlNodeThreadFunc().
+ *          in WingSailControlNodeTick().
  */
 
 #ifndef WINGSAILCONTROLNODE_HPP
@@ -76,13 +76,12 @@ class WingSailControlNode : public ActiveNode {
     float simpleCalculateTailAngle();
 
     ///----------------------------------------------------------------------------------
-    /// @brief Starts the WingSailControlNode's thread that pumps out WingSailCommandMsg.
+    /// @brief Pumps out a WingSailCommandMsg, every loop time.
     ///----------------------------------------------------------------------------------
-    static void WingSailControlNodeThreadFunc(ActiveNode* nodePtr);
+    static void WingSailControlNodeTick(ActiveNode* nodePtr);
 
     DBHandler& m_db;
     std::mutex m_lock;
-    std::atomic<bool> m_Running;
 
     double m_LoopTime;         // seconds
     double m_MaxCommandAngle;  // degrees
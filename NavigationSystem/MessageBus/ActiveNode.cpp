@@ -6,12 +6,27 @@
  */
 
 #include "ActiveNode.hpp"
+#include "NodeWatchdog.hpp"
+#include "../SystemServices/ClockSource.hpp"
+#include "../SystemServices/ThreadConfig.hpp"
+#include "../SystemServices/Timer.hpp"
 #include  <stdexcept>
 
+std::atomic<NodeScheduler*> ActiveNode::m_SharedScheduler(nullptr);
+
+void ActiveNode::useScheduler(NodeScheduler* scheduler)
+{
+    m_SharedScheduler.store(scheduler);
+}
+
 void ActiveNode::runThread(void(*func)(ActiveNode*))
 {
     if(m_Thread == nullptr)
-        m_Thread.reset(new std::thread(func, this));
+        m_Thread.reset(new std::thread([this, func]{
+            // Pinned and prioritised by the settings under the node name
+            ThreadConfig::apply(nodeName());
+            func(this);
+        }));
     else
         throw std::runtime_error("node thread already running");
 
@@ -21,8 +36,106 @@ void ActiveNode::runThread(void(*func)(ActiveNode*))
 
 void ActiveNode::stopThread(ActiveNode* node)
 {
+    NodeWatchdog::unwatch(node->nodeID());
+
     if( node->m_Thread != nullptr && node->m_Thread->joinable() )
         node->m_Thread->join();
     
     node->m_Thread.reset();
 }
+
+void ActiveNode::runPeriodic(void (*tick)(ActiveNode*), double periodS, double initialDelayS)
+{
+    if(m_PeriodicRunning.load())
+        throw std::runtime_error("node ticks already running");
+
+    m_Tick = tick;
+    m_Period.store(periodS);
+    m_InitialDelay = initialDelayS;
+    m_PeriodicRunning.store(true);
+
+    // The watchdog can't watch itself
+    if(nodeID() != NodeID::Watchdog)
+        watchLoop(periodS, initialDelayS);
+
+    std::lock_guard<std::mutex> lock(m_TaskMutex);
+    m_Scheduler = m_SharedScheduler.load();
+
+    // A first tick changing the period waits for the task ID
+    if(m_Scheduler != nullptr)
+        m_TaskID = m_Scheduler->schedule(nodeName(), periodS, [this]{ m_Tick(this); reportProgress(); }, initialDelayS);
+    else
+        runThread(periodicThread);
+}
+
+void ActiveNode::setPeriod(double periodS)
+{
+    m_Period.store(periodS);
+
+    {
+        std::lock_guard<std::mutex> lock(m_TaskMutex);
+        if(m_Scheduler != nullptr && m_TaskID != NO_TASK)
+            m_Scheduler->setPeriod(m_TaskID, periodS);
+    }
+
+    if(m_PeriodicRunning.load() && nodeID() != NodeID::Watchdog)
+        watchLoop(periodS);
+}
+
+void ActiveNode::stopPeriodic()
+{
+    if(not m_PeriodicRunning.exchange(false))
+        return;
+
+    NodeWatchdog::unwatch(nodeID());
+
+    NodeScheduler* scheduler;
+    TaskID taskID;
+    {
+        std::lock_guard<std::mutex> lock(m_TaskMutex);
+        scheduler = m_Scheduler;
+        taskID = m_TaskID;
+        m_Scheduler = nullptr;
+        m_TaskID = NO_TASK;
+    }
+
+    // Cancelling waits for the tick running, which may be calling setPeriod()
+    if(scheduler != nullptr)
+    {
+        scheduler->cancel(taskID);
+    }
+    else
+    {
+        stopThread(this);
+    }
+}
+
+void ActiveNode::periodicThread(ActiveNode* node)
+{
+    ClockSource::current().sleepForUs((uint64_t)(node->m_InitialDelay * 1000000));
+
+    FixedRateTimer timer(node->nodeName());
+    timer.start();
+
+    while(node->m_PeriodicRunning.load())
+    {
+        node->m_Tick(node);
+        node->reportProgress();
+        timer.sleepUntilNext(node->m_Period.load());
+    }
+}
+
+void ActiveNode::watchProgress(double deadlineS, double graceS)
+{
+    NodeWatchdog::watch(nodeID(), deadlineS, graceS);
+}
+
+void ActiveNode::watchLoop(double periodS, double graceS)
+{
+    watchProgress(NodeWatchdog::deadlineForPeriod(periodS), graceS);
+}
+
+void ActiveNode::reportProgress()
+{
+    NodeWatchdog::reportProgress(nodeID());
+}
@@ -9,11 +9,16 @@
 #define ACTIVENODE_HPP
 
 #include "Node.hpp"
+#include "NodeScheduler.hpp"
+#include <atomic>
+#include <mutex>
 #include <thread>
 
 class ActiveNode : public Node {
    public:
-    ActiveNode(NodeID id, MessageBus& msgBus) : Node(id, msgBus), m_Thread(nullptr) {}
+    ActiveNode(NodeID id, MessageBus& msgBus)
+        : Node(id, msgBus), m_Thread(nullptr), m_Scheduler(nullptr), m_TaskID(NO_TASK),
+          m_Tick(nullptr), m_Period(0), m_InitialDelay(0), m_PeriodicRunning(false) {}
 
     ///----------------------------------------------------------------------------------
     /// @brief This function should be used to start the active nodes thread.
@@ -28,14 +33,68 @@ class ActiveNode : public Node {
     ///         or passive.
     ///----------------------------------------------------------------------------------
     bool isActiveNoe() { return true; }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Has the periodic work of the nodes started from now on run on a shared
+    ///         scheduler, NULL goes back to a thread per node.
+    ///----------------------------------------------------------------------------------
+    static void useScheduler(NodeScheduler* scheduler);
     
    protected:
     void runThread(void (*func)(ActiveNode*));
     void stopThread(ActiveNode* node);
 
+    ///----------------------------------------------------------------------------------
+    /// @brief Calls tick at a fixed rate, on the shared scheduler if one is in use or on
+    ///         a thread of the node's own otherwise.
+    ///
+    /// @param periodS 			The period in seconds.
+    /// @param initialDelayS 	How long to wait before the first tick.
+    ///----------------------------------------------------------------------------------
+    void runPeriodic(void (*tick)(ActiveNode*), double periodS, double initialDelayS = 0);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Changes the period of the ticks, from the next one.
+    ///----------------------------------------------------------------------------------
+    void setPeriod(double periodS);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Stops the ticks, waiting for the one running if any.
+    ///----------------------------------------------------------------------------------
+    void stopPeriodic();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Has the watchdog expect progress from the node at least once per deadline,
+    ///         the first time after the grace period on top. The periodic nodes are watched
+    ///         from runPeriodic, the nodes running a loop of their own call this before it.
+    ///----------------------------------------------------------------------------------
+    void watchProgress(double deadlineS, double graceS = 0);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Watches a node looping at a period, it is given a few periods to report
+    ///         its progress in.
+    ///----------------------------------------------------------------------------------
+    void watchLoop(double periodS, double graceS = 0);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Tells the watchdog the node is making progress, once per loop.
+    ///----------------------------------------------------------------------------------
+    void reportProgress();
+
    private:
+    static void periodicThread(ActiveNode* node);
+
     //std::thread* m_Thread;
     std::unique_ptr<std::thread> m_Thread;
+
+    static std::atomic<NodeScheduler*> m_SharedScheduler;
+    std::mutex m_TaskMutex;             ///< Guards the scheduler and the task, setPeriod() can be called from any thread
+    NodeScheduler* m_Scheduler;         ///< The scheduler running the ticks, NULL on a thread
+    TaskID m_TaskID;
+    void (*m_Tick)(ActiveNode*);
+    std::atomic<double> m_Period;
+    double m_InitialDelay;
+    std::atomic<bool> m_PeriodicRunning;
 };
 
 #endif /* ACTIVENODE_HPP */
@@ -0,0 +1,280 @@
+/**
+ * @file    DeliveryPool.cpp
+ *
+ * @brief   A pool of worker threads which deliver messages to nodes through per-node
+ *          mailboxes.
+ *
+ */
+
+#include "DeliveryPool.hpp"
+#include "Node.hpp"
+#include "../SystemServices/Logger.hpp"
+#include "../SystemServices/ThreadConfig.hpp"
+
+// Maximum number of messages a worker processes from one mailbox before giving other
+// mailboxes a turn
+#define MAILBOX_BATCH_SIZE	16
+
+DeliveryPool::DeliveryPool(LatencyTracer& tracer)
+	:m_Tracer(tracer), m_Running(false), m_Capacity(DEFAULT_LANE_CAPACITY), m_Depth(0), m_PeakDepth(0), m_Dropped(0)
+{
+	for(int i = 0; i < MESSAGE_TYPE_COUNT; i++)
+	{
+		m_OverflowPolicies[i].store(defaultOverflowPolicy(static_cast<MessageType>(i)));
+		m_TypeDrops[i].store(0);
+	}
+}
+
+DeliveryPool::~DeliveryPool()
+{
+	stop();
+}
+
+void DeliveryPool::start(unsigned int workerCount)
+{
+	if(m_Running.load())
+	{
+		return;
+	}
+
+	if(workerCount == 0)
+	{
+		workerCount = std::thread::hardware_concurrency();
+		if(workerCount == 0)
+		{
+			workerCount = 1;
+		}
+	}
+
+	m_Running.store(true);
+	for(unsigned int i = 0; i < workerCount; i++)
+	{
+		m_Workers.emplace_back(workerThread, this);
+	}
+
+	Logger::info("Message delivery pool started with %d workers", workerCount);
+}
+
+void DeliveryPool::stop()
+{
+	m_Running.store(false);
+
+	// Wait for the mutex to be unlocked.
+	{
+		std::lock_guard<std::mutex> lock(m_ReadyMutex);
+	}
+	m_MailboxReady.notify_all();
+
+	for(auto& worker : m_Workers)
+	{
+		if(worker.joinable())
+		{
+			worker.join();
+		}
+	}
+	m_Workers.clear();
+
+	// Drop what the workers didn't get to, so the mailboxes are idle again
+	std::lock_guard<std::mutex> lock(m_ReadyMutex);
+	while(not m_ReadyMailboxes.empty())
+	{
+		NodeMailbox* mailbox = m_ReadyMailboxes.front();
+		m_ReadyMailboxes.pop();
+
+		std::lock_guard<std::mutex> mailboxLock(mailbox->mutex);
+		m_Depth -= mailbox->messages.size();
+		mailbox->messages.clear();
+		mailbox->scheduled = false;
+		mailbox->idle.notify_all();
+	}
+}
+
+bool DeliveryPool::post(NodeMailbox& mailbox, SharedMessagePtr msg)
+{
+	{
+		std::lock_guard<std::mutex> lock(mailbox.mutex);
+
+		unsigned long capacity = m_Capacity.load();
+		if(capacity > 0 && mailbox.messages.size() >= capacity && not makeRoom(mailbox, msg->messageType()))
+		{
+			m_TypeDrops[static_cast<int>(msg->messageType())]++;
+			m_Dropped++;
+			return false;
+		}
+
+		mailbox.messages.push_back(std::move(msg));
+		m_Depth++;
+		if(mailbox.messages.size() > m_PeakDepth.load())
+		{
+			m_PeakDepth.store(mailbox.messages.size());
+		}
+
+		// Already waiting for or owned by a worker which will pick up the message
+		if(mailbox.scheduled)
+		{
+			return true;
+		}
+		mailbox.scheduled = true;
+	}
+
+	schedule(&mailbox);
+	return true;
+}
+
+void DeliveryPool::setOverflowPolicy(MessageType msgType, OverflowPolicy policy)
+{
+	int index = static_cast<int>(msgType);
+
+	if(index >= 0 && index < MESSAGE_TYPE_COUNT)
+	{
+		m_OverflowPolicies[index].store(policy);
+	}
+}
+
+DeliveryPool::MailboxStatistics DeliveryPool::statistics() const
+{
+	MailboxStatistics stats;
+	stats.depth = m_Depth.load();
+	stats.peakDepth = m_PeakDepth.load();
+	stats.capacity = m_Capacity.load();
+	stats.dropped = m_Dropped.load();
+	return stats;
+}
+
+unsigned long DeliveryPool::droppedCount(MessageType msgType) const
+{
+	int index = static_cast<int>(msgType);
+
+	if(index < 0 || index >= MESSAGE_TYPE_COUNT)
+	{
+		return 0;
+	}
+	return m_TypeDrops[index].load();
+}
+
+void DeliveryPool::resetStatistics()
+{
+	m_PeakDepth.store(0);
+	m_Dropped.store(0);
+	for(int i = 0; i < MESSAGE_TYPE_COUNT; i++)
+	{
+		m_TypeDrops[i].store(0);
+	}
+}
+
+bool DeliveryPool::makeRoom(NodeMailbox& mailbox, MessageType msgType)
+{
+	switch(m_OverflowPolicies[static_cast<int>(msgType)].load())
+	{
+		case OverflowPolicy::DropOldest:
+		{
+			// Only the oldest message of the same type
+			auto evicted = mailbox.messages.begin();
+			while(evicted != mailbox.messages.end() && (*evicted)->messageType() != msgType)
+			{
+				++evicted;
+			}
+
+			if(evicted != mailbox.messages.end())
+			{
+				m_TypeDrops[static_cast<int>(msgType)]++;
+				mailbox.messages.erase(evicted);
+				m_Depth--;
+				m_Dropped++;
+				return true;
+			}
+			return false;
+		}
+
+		case OverflowPolicy::DropNewest:
+			return false;
+
+		case OverflowPolicy::Block:
+			// Waiting would hold up the dispatch loop and every other node behind this one
+			return true;
+	}
+	return false;
+}
+
+void DeliveryPool::detach(NodeMailbox& mailbox)
+{
+	std::unique_lock<std::mutex> lock(mailbox.mutex);
+	m_Depth -= mailbox.messages.size();
+	mailbox.messages.clear();
+
+	// A worker still owns the mailbox or it is waiting in the ready queue, either way a
+	// worker will find it empty and let go of it.
+	if(m_Running.load())
+	{
+		mailbox.idle.wait(lock, [&mailbox]{ return not mailbox.scheduled; });
+	}
+}
+
+void DeliveryPool::schedule(NodeMailbox* mailbox)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_ReadyMutex);
+		m_ReadyMailboxes.push(mailbox);
+	}
+	m_MailboxReady.notify_one();
+}
+
+bool DeliveryPool::processMailbox(NodeMailbox& mailbox)
+{
+	for(int i = 0; i < MAILBOX_BATCH_SIZE; i++)
+	{
+		SharedMessagePtr msg;
+		{
+			std::lock_guard<std::mutex> lock(mailbox.mutex);
+			if(mailbox.messages.empty())
+			{
+				mailbox.scheduled = false;
+				mailbox.idle.notify_all();
+				return false;
+			}
+			msg = std::move(mailbox.messages.front());
+			mailbox.messages.pop_front();
+			m_Depth--;
+		}
+
+		m_Tracer.consume(mailbox.nodeRef, msg.get());
+	}
+
+	std::lock_guard<std::mutex> lock(mailbox.mutex);
+	if(mailbox.messages.empty())
+	{
+		mailbox.scheduled = false;
+		mailbox.idle.notify_all();
+		return false;
+	}
+	return true;
+}
+
+void DeliveryPool::workerThread(DeliveryPool* pool)
+{
+	ThreadConfig::apply("DeliveryPool");
+
+	while(pool->m_Running.load())
+	{
+		NodeMailbox* mailbox;
+		{
+			std::unique_lock<std::mutex> lock(pool->m_ReadyMutex);
+			pool->m_MailboxReady.wait(lock, [pool]{ return pool->m_ReadyMailboxes.size() > 0 || not pool->m_Running.load(); });
+
+			if(not pool->m_Running.load())
+			{
+				return;
+			}
+
+			mailbox = pool->m_ReadyMailboxes.front();
+			pool->m_ReadyMailboxes.pop();
+		}
+
+		// Keeps ownership of the mailbox, put it at the back of the queue so other
+		// nodes get a turn
+		if(pool->processMailbox(*mailbox))
+		{
+			pool->schedule(mailbox);
+		}
+	}
+}
@@ -0,0 +1,154 @@
+/**
+ * @file    DeliveryPool.hpp
+ *
+ * @brief   A pool of worker threads which deliver messages to nodes through per-node
+ *          mailboxes.
+ *
+ * @details     Each node gets a mailbox which is a FIFO of messages waiting to be processed.
+ *              When a message is posted into an idle mailbox, the mailbox is scheduled onto the
+ *              pool and picked up by the next free worker. A mailbox is only ever owned by one
+ *              worker at a time, so messages are processed by a node in the order they were
+ *              posted, while a slow node only holds up its own mailbox.
+ *
+ *              A mailbox holds a bounded number of messages, like the lanes of the message
+ *              bus, with the same overflow policy for each message type. The dispatch loop
+ *              never waits for a node though, a Block message goes over the capacity of the
+ *              mailbox instead.
+ *
+ */
+
+#ifndef DELIVERYPOOL_HPP
+#define DELIVERYPOOL_HPP
+
+#include "LatencyTracer.hpp"
+#include "Message.hpp"
+#include "MessageLanes.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class Node;
+
+typedef std::shared_ptr<const Message> SharedMessagePtr;
+
+///----------------------------------------------------------------------------------
+/// @brief The messages waiting to be processed by a single node.
+///----------------------------------------------------------------------------------
+struct NodeMailbox {
+    NodeMailbox(Node& node) : nodeRef(node), scheduled(false) {}
+
+    Node& nodeRef;
+    std::mutex mutex;                       ///< Guards the message queue and the scheduled flag
+    std::deque<SharedMessagePtr> messages;  ///< Messages waiting to be processed
+    bool scheduled;                         ///< True while the mailbox is queued on or owned by a worker
+    std::condition_variable idle;           ///< Signalled when the mailbox stops being scheduled
+};
+
+class DeliveryPool {
+   public:
+    ///----------------------------------------------------------------------------------
+    /// @brief The messages waiting in all the mailboxes. The peak depth is that of the
+    ///         fullest mailbox.
+    ///----------------------------------------------------------------------------------
+    struct MailboxStatistics {
+        unsigned long depth;
+        unsigned long peakDepth;
+        unsigned long capacity;  ///< Per mailbox, 0 when unbounded
+        unsigned long dropped;   ///< Messages thrown away because a mailbox was full
+    };
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Default constructor
+    ///
+    /// @param tracer 			Records the latencies of the messages the workers deliver.
+    ///----------------------------------------------------------------------------------
+    DeliveryPool(LatencyTracer& tracer);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Stops the workers if they are still running.
+    ///----------------------------------------------------------------------------------
+    ~DeliveryPool();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Starts the worker threads.
+    ///
+    /// @param workerCount 		The number of worker threads, 0 uses one per core.
+    ///----------------------------------------------------------------------------------
+    void start(unsigned int workerCount);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Stops and joins the worker threads. Messages which have not been processed
+    ///         yet are dropped.
+    ///----------------------------------------------------------------------------------
+    void stop();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Posts a message into a node's mailbox, scheduling the mailbox if it was idle.
+    ///         Returns false if the message was dropped because the mailbox was full.
+    ///----------------------------------------------------------------------------------
+    bool post(NodeMailbox& mailbox, SharedMessagePtr msg);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Sets the maximum number of messages waiting in each mailbox,
+    ///         DEFAULT_LANE_CAPACITY by default, 0 leaves them unbounded.
+    ///----------------------------------------------------------------------------------
+    void setCapacity(unsigned int capacity) { m_Capacity.store(capacity); }
+
+    void setOverflowPolicy(MessageType msgType, OverflowPolicy policy);
+
+    MailboxStatistics statistics() const;
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns the number of messages of a type thrown away because a mailbox was
+    ///         full.
+    ///----------------------------------------------------------------------------------
+    unsigned long droppedCount(MessageType msgType) const;
+
+    void resetStatistics();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Drops the messages waiting in a mailbox and waits until no worker holds on
+    ///         to it anymore, after which the mailbox can be destroyed. Nothing should be
+    ///         posted into the mailbox in the meantime.
+    ///----------------------------------------------------------------------------------
+    void detach(NodeMailbox& mailbox);
+
+    unsigned int workerCount() { return m_Workers.size(); }
+
+   private:
+    static void workerThread(DeliveryPool* pool);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Processes up to MAILBOX_BATCH_SIZE messages from a mailbox, returns true if
+    ///         the mailbox still has messages and needs to be scheduled again.
+    ///----------------------------------------------------------------------------------
+    bool processMailbox(NodeMailbox& mailbox);
+
+    void schedule(NodeMailbox* mailbox);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Applies the overflow policy of a message posted into a full mailbox, as the
+    ///         message bus does for its lanes. The mailbox lock needs to be held.
+    ///----------------------------------------------------------------------------------
+    bool makeRoom(NodeMailbox& mailbox, MessageType msgType);
+
+    LatencyTracer& m_Tracer;
+    std::vector<std::thread> m_Workers;
+    std::queue<NodeMailbox*> m_ReadyMailboxes;  ///< Mailboxes with messages waiting for a worker
+    std::mutex m_ReadyMutex;                    ///< Guards the ready mailbox queue
+    std::condition_variable m_MailboxReady;     ///< Signalled when a mailbox is scheduled
+    std::atomic<bool> m_Running;
+    std::atomic<unsigned long> m_Capacity;
+    std::atomic<OverflowPolicy> m_OverflowPolicies[MESSAGE_TYPE_COUNT];
+    std::atomic<unsigned long> m_Depth;
+    std::atomic<unsigned long> m_PeakDepth;
+    std::atomic<unsigned long> m_Dropped;
+    std::atomic<unsigned long> m_TypeDrops[MESSAGE_TYPE_COUNT];
+};
+
+#endif /* DELIVERYPOOL_HPP */
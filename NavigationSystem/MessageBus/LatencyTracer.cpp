@@ -0,0 +1,204 @@
+/**
+ * @file    LatencyTracer.cpp
+ *
+ * @brief   Aggregates the trace information of the messages going through the message bus
+ *          into latency histograms per message type and per node.
+ *
+ */
+
+#include "LatencyTracer.hpp"
+#include "Node.hpp"
+#include "../SystemServices/Logger.hpp"
+
+LatencyHistogram::LatencyHistogram()
+	:m_Count(0), m_TotalUs(0), m_MaxUs(0)
+{
+	for(int i = 0; i < LATENCY_BUCKET_COUNT; i++)
+	{
+		m_Buckets[i].store(0);
+	}
+}
+
+void LatencyHistogram::record(uint64_t latencyUs)
+{
+	int bucket = 0;
+	while(bucket < LATENCY_BUCKET_COUNT - 1 && latencyUs >= (1ULL << bucket))
+	{
+		bucket++;
+	}
+
+	m_Buckets[bucket]++;
+	m_Count++;
+	m_TotalUs += latencyUs;
+
+	uint64_t max = m_MaxUs.load();
+	while(latencyUs > max && not m_MaxUs.compare_exchange_weak(max, latencyUs))
+	{
+	}
+}
+
+void LatencyHistogram::reset()
+{
+	for(int i = 0; i < LATENCY_BUCKET_COUNT; i++)
+	{
+		m_Buckets[i].store(0);
+	}
+	m_Count.store(0);
+	m_TotalUs.store(0);
+	m_MaxUs.store(0);
+}
+
+double LatencyHistogram::meanUs() const
+{
+	unsigned long count = m_Count.load();
+	return count > 0 ? (double)m_TotalUs.load() / count : 0;
+}
+
+uint64_t LatencyHistogram::percentileUs(double percentile) const
+{
+	unsigned long count = m_Count.load();
+	if(count == 0)
+	{
+		return 0;
+	}
+
+	unsigned long target = (unsigned long)(count * percentile / 100.0);
+	if(target == 0)
+	{
+		target = 1;
+	}
+
+	unsigned long seen = 0;
+	for(int i = 0; i < LATENCY_BUCKET_COUNT; i++)
+	{
+		seen += m_Buckets[i].load();
+		if(seen >= target)
+		{
+			uint64_t upper = 1ULL << i;
+			return upper < m_MaxUs.load() ? upper : m_MaxUs.load();
+		}
+	}
+	return m_MaxUs.load();
+}
+
+LatencyTracer::LatencyTracer()
+	:m_Enabled(true)
+{
+
+}
+
+void LatencyTracer::recordDispatch(const Message& msg)
+{
+	int type = static_cast<int>(msg.messageType());
+	const MessageTrace& trace = msg.trace();
+
+	if(not m_Enabled.load() || type < 0 || type >= MESSAGE_TYPE_COUNT || trace.sentUs == 0)
+	{
+		return;
+	}
+
+	m_QueueLatency[type].record(trace.dispatchedUs - trace.sentUs);
+}
+
+void LatencyTracer::consume(Node& node, const Message* msg)
+{
+	TraceScope scope(msg->trace());
+
+	if(not m_Enabled.load())
+	{
+		node.processMessage(msg);
+		return;
+	}
+
+	uint64_t start = traceTimeUs();
+	node.processMessage(msg);
+	uint64_t end = traceTimeUs();
+
+	const MessageTrace& trace = msg->trace();
+	int type = static_cast<int>(msg->messageType());
+	int id = static_cast<int>(node.nodeID());
+
+	if(type >= 0 && type < MESSAGE_TYPE_COUNT)
+	{
+		m_ChainLatency[type].record(start - trace.originUs);
+	}
+
+	if(id >= 0 && id < NODE_ID_COUNT)
+	{
+		if(trace.sentUs != 0)
+		{
+			m_DeliveryLatency[id].record(start - trace.sentUs);
+		}
+		m_ProcessingTime[id].record(end - start);
+	}
+}
+
+const LatencyHistogram& LatencyTracer::queueLatency(MessageType msgType) const
+{
+	int type = static_cast<int>(msgType);
+	return (type >= 0 && type < MESSAGE_TYPE_COUNT) ? m_QueueLatency[type] : m_Empty;
+}
+
+const LatencyHistogram& LatencyTracer::chainLatency(MessageType msgType) const
+{
+	int type = static_cast<int>(msgType);
+	return (type >= 0 && type < MESSAGE_TYPE_COUNT) ? m_ChainLatency[type] : m_Empty;
+}
+
+const LatencyHistogram& LatencyTracer::deliveryLatency(NodeID nodeID) const
+{
+	int id = static_cast<int>(nodeID);
+	return (id >= 0 && id < NODE_ID_COUNT) ? m_DeliveryLatency[id] : m_Empty;
+}
+
+const LatencyHistogram& LatencyTracer::processingTime(NodeID nodeID) const
+{
+	int id = static_cast<int>(nodeID);
+	return (id >= 0 && id < NODE_ID_COUNT) ? m_ProcessingTime[id] : m_Empty;
+}
+
+void LatencyTracer::reset()
+{
+	for(int i = 0; i < MESSAGE_TYPE_COUNT; i++)
+	{
+		m_QueueLatency[i].reset();
+		m_ChainLatency[i].reset();
+	}
+
+	for(int i = 0; i < NODE_ID_COUNT; i++)
+	{
+		m_DeliveryLatency[i].reset();
+		m_ProcessingTime[i].reset();
+	}
+}
+
+void LatencyTracer::logStatistics() const
+{
+	for(int i = 0; i < MESSAGE_TYPE_COUNT; i++)
+	{
+		const LatencyHistogram& queue = m_QueueLatency[i];
+		const LatencyHistogram& chain = m_ChainLatency[i];
+
+		if(queue.count() > 0 || chain.count() > 0)
+		{
+			Logger::info("%s latency: queue p50 %lu us p99 %lu us max %lu us, chain p50 %lu us p99 %lu us max %lu us",
+				msgToString(static_cast<MessageType>(i)).c_str(),
+				(unsigned long)queue.percentileUs(50), (unsigned long)queue.percentileUs(99), (unsigned long)queue.maxUs(),
+				(unsigned long)chain.percentileUs(50), (unsigned long)chain.percentileUs(99), (unsigned long)chain.maxUs());
+		}
+	}
+
+	for(int i = 0; i < NODE_ID_COUNT; i++)
+	{
+		const LatencyHistogram& delivery = m_DeliveryLatency[i];
+		const LatencyHistogram& processing = m_ProcessingTime[i];
+
+		if(processing.count() > 0)
+		{
+			Logger::info("%s: %lu messages, delivery p50 %lu us p99 %lu us, processing mean %.0f us max %lu us",
+				nodeToString(static_cast<NodeID>(i)).c_str(), processing.count(),
+				(unsigned long)delivery.percentileUs(50), (unsigned long)delivery.percentileUs(99),
+				processing.meanUs(), (unsigned long)processing.maxUs());
+		}
+	}
+}
@@ -0,0 +1,127 @@
+/**
+ * @file    LatencyTracer.hpp
+ *
+ * @brief   Aggregates the trace information of the messages going through the message bus
+ *          into latency histograms per message type and per node.
+ *
+ * @details     For each message type the tracer keeps the queue latency, from the message
+ *              being sent to being dispatched, and the chain latency, from the origin of the
+ *              message chain to a node starting to process the message. The chain latency of
+ *              the rudder commands for example is the time from the sensor reading to the
+ *              actuator receiving the command.
+ *
+ *              For each node it keeps the delivery latency, from a message being sent to the
+ *              node starting to process it, and the time the node spends processing messages.
+ *
+ *              Histograms are recorded without locking so they can be fed by the delivery
+ *              pool workers concurrently.
+ *
+ */
+
+#ifndef LATENCYTRACER_HPP
+#define LATENCYTRACER_HPP
+
+#include "Message.hpp"
+#include "MessageTrace.hpp"
+#include <stdint.h>
+#include <atomic>
+
+#define LATENCY_BUCKET_COUNT 32
+
+class Node;
+
+///----------------------------------------------------------------------------------
+/// @brief A latency histogram with power of two buckets, bucket n counts the latencies
+///         below 2^n microseconds which didn't fit in a previous bucket.
+///----------------------------------------------------------------------------------
+class LatencyHistogram {
+   public:
+    LatencyHistogram();
+
+    void record(uint64_t latencyUs);
+
+    void reset();
+
+    unsigned long count() const { return m_Count.load(); }
+
+    uint64_t maxUs() const { return m_MaxUs.load(); }
+
+    double meanUs() const;
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns an upper bound of the given percentile, the upper limit of the bucket
+    ///         it falls in, capped to the maximum latency recorded.
+    ///
+    /// @param percentile 		Between 0 and 100.
+    ///----------------------------------------------------------------------------------
+    uint64_t percentileUs(double percentile) const;
+
+   private:
+    std::atomic<unsigned long> m_Buckets[LATENCY_BUCKET_COUNT];
+    std::atomic<unsigned long> m_Count;
+    std::atomic<uint64_t> m_TotalUs;
+    std::atomic<uint64_t> m_MaxUs;
+};
+
+class LatencyTracer {
+   public:
+    LatencyTracer();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Switches the recording of the latencies on and off, it is on by default. The
+    ///         messages are linked to each other either way.
+    ///----------------------------------------------------------------------------------
+    void setEnabled(bool enabled) { m_Enabled.store(enabled); }
+
+    bool isEnabled() const { return m_Enabled.load(); }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Records the queue latency of a message which has just been dispatched.
+    ///----------------------------------------------------------------------------------
+    void recordDispatch(const Message& msg);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Has a node process a message, recording the latencies of the message and
+    ///         linking the messages the node creates meanwhile to it.
+    ///----------------------------------------------------------------------------------
+    void consume(Node& node, const Message* msg);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief The time messages of a type spent between being sent and being dispatched.
+    ///----------------------------------------------------------------------------------
+    const LatencyHistogram& queueLatency(MessageType msgType) const;
+
+    ///----------------------------------------------------------------------------------
+    /// @brief The time between the origin of the chain of messages of a type and a node
+    ///         starting to process them.
+    ///----------------------------------------------------------------------------------
+    const LatencyHistogram& chainLatency(MessageType msgType) const;
+
+    ///----------------------------------------------------------------------------------
+    /// @brief The time messages spent between being sent and a node starting to process
+    ///         them.
+    ///----------------------------------------------------------------------------------
+    const LatencyHistogram& deliveryLatency(NodeID nodeID) const;
+
+    ///----------------------------------------------------------------------------------
+    /// @brief The time a node spent in processMessage().
+    ///----------------------------------------------------------------------------------
+    const LatencyHistogram& processingTime(NodeID nodeID) const;
+
+    void reset();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Logs the histograms which recorded something.
+    ///----------------------------------------------------------------------------------
+    void logStatistics() const;
+
+   private:
+    std::atomic<bool> m_Enabled;
+    LatencyHistogram m_QueueLatency[MESSAGE_TYPE_COUNT];
+    LatencyHistogram m_ChainLatency[MESSAGE_TYPE_COUNT];
+    LatencyHistogram m_DeliveryLatency[NODE_ID_COUNT];
+    LatencyHistogram m_ProcessingTime[NODE_ID_COUNT];
+    LatencyHistogram m_Empty;  ///< Returned for out of range types and IDs
+};
+
+#endif /* LATENCYTRACER_HPP */
@@ -9,15 +9,12 @@
 #define MESSAGE_HPP
 
 #include "MessageDeserialiser.hpp"
+#include "MessagePool.hpp"
 #include "MessageSerialiser.hpp"
+#include "MessageTrace.hpp"
 #include "MessageTypes.hpp"
 #include "NodeIDs.hpp"
 
-#define LOG_MESSAGES
-#ifdef LOG_MESSAGES
-    #include "../SystemServices/SysClock.hpp"
-#endif
-
 const int DATA_OUT_OF_RANGE = -2000;
 const float NO_COMMAND = -1000;
 
@@ -32,7 +29,9 @@ class Message {
     ///							NodeIDS::NONE for no specific destination.
     ///----------------------------------------------------------------------------------
     Message(MessageType msgType, NodeID msgSource, NodeID msgDest)
-        : m_valid(true), m_MessageType(msgType), m_SourceID(msgSource), m_DestinationID(msgDest) {}
+        : m_valid(true), m_MessageType(msgType), m_SourceID(msgSource), m_DestinationID(msgDest) {
+        startTrace();
+    }
 
     ///----------------------------------------------------------------------------------
     /// @brief A message with no specific destination.
@@ -44,7 +43,9 @@ class Message {
         : m_valid(true),
           m_MessageType(msgType),
           m_SourceID(msgSource),
-          m_DestinationID(NodeID::None) {}
+          m_DestinationID(NodeID::None) {
+        startTrace();
+    }
 
     ///----------------------------------------------------------------------------------
     /// @brief A message with no specific destination or source.
@@ -52,17 +53,27 @@ class Message {
     /// @param msgType 			The type of message this is.
     ///----------------------------------------------------------------------------------
     Message(MessageType msgType)
-        : m_MessageType(msgType), m_SourceID(NodeID::None), m_DestinationID(NodeID::None) {}
+        : m_MessageType(msgType), m_SourceID(NodeID::None), m_DestinationID(NodeID::None) {
+        startTrace();
+    }
 
     Message(MessageDeserialiser& deserialiser) : m_valid(true) {
         if (!deserialiser.readMessageType(m_MessageType) || !deserialiser.readNodeID(m_SourceID) ||
             !deserialiser.readNodeID(m_DestinationID)) {
             m_valid = false;
         }
+        startTrace();
     }
 
     virtual ~Message() {}
 
+    ///----------------------------------------------------------------------------------
+    /// @brief Messages are allocated from the MessagePool, this keeps MessagePtr and
+    ///         std::make_unique working as they are while recycling message memory.
+    ///----------------------------------------------------------------------------------
+    static void* operator new(std::size_t size) { return MessagePool::allocate(size); }
+    static void operator delete(void* ptr, std::size_t size) { MessagePool::release(ptr, size); }
+
     ///----------------------------------------------------------------------------------
     /// @brief Returns the type of message this is.
     ///
@@ -86,6 +97,38 @@ class Message {
     ///----------------------------------------------------------------------------------
     bool isValid() const { return m_valid; }
 
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns the trace information of the message, see MessageTrace.hpp.
+    ///----------------------------------------------------------------------------------
+    const MessageTrace& trace() const { return m_Trace; }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Links the message to the message which caused it, for messages sent outside
+    ///         of processMessage(). Does nothing if the parent trace is empty.
+    ///----------------------------------------------------------------------------------
+    void setParent(const MessageTrace& parent) {
+        if (parent.id != 0) {
+            m_Trace.parentId = parent.id;
+            m_Trace.originUs = parent.originUs;
+        }
+    }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Used by the message bus to stamp the time the message was sent.
+    ///----------------------------------------------------------------------------------
+    void stampSent() { m_Trace.sentUs = traceTimeUs(); }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Used by the message bus to stamp the time the message was dispatched.
+    ///----------------------------------------------------------------------------------
+    void stampDispatched() { m_Trace.dispatchedUs = traceTimeUs(); }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Used by the MessageReplay to mark the messages it sends, so that the message
+    ///         bus can count them apart from the messages the nodes derive from them.
+    ///----------------------------------------------------------------------------------
+    void markReplayed() { m_Trace.replayed = true; }
+
     ///----------------------------------------------------------------------------------
     /// @brief Serialises the message into a MessageSerialiser
     ///----------------------------------------------------------------------------------
@@ -95,14 +138,26 @@ class Message {
         serialiser.serialise(m_DestinationID);
     }
 
-#ifdef LOG_MESSAGES
-    TimeStamp timeReceived;
-#endif
-
    protected:
     bool m_valid;  ///< Indicates that the message was correctl created
 
    private:
+    ///----------------------------------------------------------------------------------
+    /// @brief Gives the message an id and links it to the message being processed by the
+    ///         calling thread, if any.
+    ///----------------------------------------------------------------------------------
+    void startTrace() {
+        m_Trace.id = nextTraceId();
+        m_Trace.createdUs = traceTimeUs();
+        m_Trace.originUs = m_Trace.createdUs;
+
+        const MessageTrace* parent = currentTrace();
+        if (parent != nullptr) {
+            setParent(*parent);
+        }
+    }
+
+    MessageTrace m_Trace;       ///< Not serialised
     MessageType m_MessageType;  ///< The message type
     NodeID m_SourceID;          ///< Which node generated the message
     NodeID m_DestinationID;     ///< The desintation of the message
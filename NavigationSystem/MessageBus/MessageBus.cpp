@@ -4,28 +4,38 @@
  * @brief   The message bus manages message distribution to nodes allowing nodes to
  *          communicate with one another.
  *
- * @details     Nodes can only be added before the run function is called currently. This is to
- *              reduce the number of thread locks in place and because once the system has
- *              started its very rare that a node should be registered afterwards on the fly.
+ * @details     Before run() is called registrations change the routing tables directly. Once
+ *              the bus is running, registerNode() and unregisterNode() queue a change which
+ *              the dispatch loop applies between two messages, see applyPendingChanges(). The
+ *              caller waits until its change is applied, unless it is a node calling from the
+ *              dispatch thread itself. The routing tables are therefore only read and written
+ *              by the dispatch thread and the distribution of a message takes no lock for them.
  *
  */
 
 #include "MessageBus.hpp"
 #include "../SystemServices/Logger.hpp"
-#include "../SystemServices/SysClock.hpp"
+#include "../SystemServices/ThreadConfig.hpp"
 #include "../Libs/termcolor/termcolor.hpp"
-#include <sys/time.h>
 #include <chrono>
 #include <thread>
+#include <algorithm>
 #include <iostream>
 
-#define SLEEP_TIME_MS	50
+// Maximum number of bulk messages distributed in one pass of the dispatch loop before the
+// other lanes are checked again
+#define BULK_MESSAGES_PER_PASS	8
 
 MessageBus::MessageBus()
-	:m_Running(false)
+	:m_FrontQueueSize(0), m_ControlPending(false), m_BlockedSenders(0), m_ChangesPending(false),
+	 m_Dispatching(false), m_Running(false), m_DistributedCount(0), m_ReplayedHandled(0),
+	 m_ParallelDelivery(false), m_WorkerCount(0), m_DeliveryPool(m_Tracer)
 {
-	m_FrontMessages = new std::queue<MessagePtr>();
-	m_BackMessages = new std::queue<MessagePtr>();
+	for(int i = 0; i < MESSAGE_TYPE_COUNT; i++)
+	{
+		m_OverflowPolicies[i] = defaultOverflowPolicy(static_cast<MessageType>(i));
+		m_TypeDrops[i].store(0);
+	}
 }
 
 MessageBus::~MessageBus()
@@ -33,54 +43,153 @@ MessageBus::~MessageBus()
 	for (auto it = m_RegisteredNodes.begin(); it != m_RegisteredNodes.end(); ++it) {
     	delete *it;
 	}
-
-	delete m_FrontMessages;
-	delete m_BackMessages;
 }
 
 bool MessageBus::registerNode(Node& node)
 {
-	if(not m_Running)
+	return changeRegistration(std::make_shared<RegistrationChange>(RegistrationChange::Register, node, MessageType::DataRequest));
+}
+
+bool MessageBus::registerNode(Node& node, MessageType msgType)
+{
+	return changeRegistration(std::make_shared<RegistrationChange>(RegistrationChange::Subscribe, node, msgType));
+}
+
+bool MessageBus::unregisterNode(Node& node)
+{
+	return changeRegistration(std::make_shared<RegistrationChange>(RegistrationChange::Unregister, node, MessageType::DataRequest));
+}
+
+void MessageBus::sendMessage(MessagePtr msg)
+{
+	if(msg != NULL)
 	{
-		// Don't care about the return type, only want to register the node.
-		getRegisteredNode(node);
-		return true;
+		MessageType msgType = msg->messageType();
+		MessageLane lane = messageLane(msgType);
+		LaneCounters& counters = m_LaneCounters[static_cast<int>(lane)];
+		msg->stampSent();
+
+		std::unique_lock<std::mutex> lock(m_FrontQueueMutex);
+
+		unsigned long capacity = counters.capacity.load();
+		if(capacity > 0 && counters.depth.load() >= capacity && not makeRoom(lane, msgType, lock))
+		{
+			if(msg->trace().replayed)
+			{
+				m_ReplayedHandled++;
+			}
+			return;
+		}
+
+		m_FrontQueues[static_cast<int>(lane)].emplace_back(std::move(msg));
+		m_FrontQueueSize++;
+		unsigned long depth = ++counters.depth;
+		if(depth > counters.peakDepth.load())
+		{
+			counters.peakDepth.store(depth);
+		}
+		if(lane == MessageLane::Control)
+		{
+			m_ControlPending.store(true);
+		}
+		lock.unlock();
+
+		// Wake up the dispatch loop
+		m_MessagesPending.notify_one();
 	}
-    
-    Logger::warning("A node tried registering after start");
-	return false;
 }
 
-bool MessageBus::registerNode(Node& node, MessageType msgType)
+bool MessageBus::makeRoom(MessageLane lane, MessageType msgType, std::unique_lock<std::mutex>& lock)
 {
-	if(not m_Running)
+	LaneCounters& counters = m_LaneCounters[static_cast<int>(lane)];
+
+	switch(m_OverflowPolicies[static_cast<int>(msgType)])
 	{
-		RegisteredNode* regNode = getRegisteredNode(node);
-		regNode->subscribe(msgType);
-		return true;
+		case OverflowPolicy::DropOldest:
+		{
+			// The depth of a lane counts both its queues, the oldest messages are in the back
+			// one. Only a message of the same type is given up, without one the new message
+			// goes instead.
+			MessageQueue* queues[] = { &m_BackQueues[static_cast<int>(lane)], &m_FrontQueues[static_cast<int>(lane)] };
+			for(MessageQueue* queue : queues)
+			{
+				for(MessageQueue::iterator it = queue->begin(); it != queue->end(); ++it)
+				{
+					if(it->msg->messageType() == msgType)
+					{
+						if(queue == queues[1])
+						{
+							m_FrontQueueSize--;
+						}
+						if(it->msg->trace().replayed)
+						{
+							m_ReplayedHandled++;
+						}
+						queue->erase(it);
+						m_TypeDrops[static_cast<int>(msgType)]++;
+						counters.depth--;
+						counters.dropped++;
+						return true;
+					}
+				}
+			}
+			break;
+		}
+
+		case OverflowPolicy::DropNewest:
+			break;
+
+		case OverflowPolicy::Block:
+			// Nothing would make room for the message
+			if(not m_Running.load() || std::this_thread::get_id() == m_DispatchThread.load())
+			{
+				return true;
+			}
+
+			counters.blocked++;
+			m_BlockedSenders++;
+			m_RoomAvailable.wait(lock, [this, &counters]{
+				return counters.capacity.load() == 0 || counters.depth.load() < counters.capacity.load() || not m_Running.load();
+			});
+			m_BlockedSenders--;
+			return true;
 	}
-    
-    Logger::warning("A node tried registering after start");
-    return false;
+
+	m_TypeDrops[static_cast<int>(msgType)]++;
+	counters.dropped++;
+	return false;
 }
 
-void MessageBus::sendMessage(MessagePtr msg)
+void MessageBus::enableParallelDelivery(unsigned int workerCount)
 {
-	if(msg != NULL)
+	if(not m_Running)
+	{
+		m_ParallelDelivery = true;
+		m_WorkerCount = workerCount;
+	}
+	else
 	{
-		m_FrontQueueMutex.lock();
-		Message* logMsg = msg.get();
-		m_FrontMessages->push(std::move(msg));
-		logMessageReceived(logMsg);
-		m_FrontQueueMutex.unlock();
+		Logger::warning("Parallel delivery can only be enabled before the message bus runs");
 	}
 }
 
 void MessageBus::run()
 {
-	// Prevent nodes from being registered now
-	m_Running.store(true);
-	startMessageLog();
+	// From now on the routing tables are only changed by this thread
+	{
+		std::lock_guard<std::mutex> lock(m_ChangeMutex);
+		m_Running.store(true);
+		m_Dispatching = true;
+		m_DispatchThread.store(std::this_thread::get_id());
+	}
+
+	if(m_ParallelDelivery)
+	{
+		m_DeliveryPool.start(m_WorkerCount);
+	}
+
+	// Only once the delivery workers are started, so they don't inherit the settings
+	ThreadConfig::apply("MessageBus");
 
     // All Systems Online
     //-------------------------------------------------------------------------------
@@ -88,159 +197,445 @@ void MessageBus::run()
 
     while(m_Running.load() == true)
 	{
-		// TODO - Jordan: Wake up only when messages have been pushed into the queue.
+		{
+			std::unique_lock<std::mutex> lock(m_FrontQueueMutex);
 
-		std::this_thread::sleep_for(std::chrono::milliseconds(SLEEP_TIME_MS));
+			// Sleep until a message has been pushed into a queue or the bus is stopped, bulk
+			// messages left over from the last pass don't need to wait.
+			m_MessagesPending.wait(lock, [this]{ return m_FrontQueueSize > 0 || hasBacklog() || m_ChangesPending.load() || not m_Running.load(); });
 
-		// If we have messages, flip the two queues and begin processing messages
-		if(m_FrontMessages->size() > 0)
-		{
-			std::queue<MessagePtr>* tmpPtr;
+			takeFrontMessages();
+		}
 
-			m_FrontQueueMutex.lock();
+		processMessages();
+	}
 
-			tmpPtr = m_FrontMessages;
-			m_FrontMessages = m_BackMessages;
-			m_FrontQueueMutex.unlock();
+	m_DeliveryPool.stop();
 
-			m_BackMessages = tmpPtr;
-			processMessages();
-		}
+	// Hand the routing tables back, applying any changes that came in while stopping
+	std::lock_guard<std::mutex> lock(m_ChangeMutex);
+	m_Dispatching = false;
+	for(auto& change : m_PendingChanges)
+	{
+		change->result = applyChange(*change);
+		change->applied = true;
 	}
+	m_PendingChanges.clear();
+	m_ChangesPending.store(false);
+	m_ChangesApplied.notify_all();
 }
 
 void MessageBus::stop()
 {
 	m_Running.store(false);
+
+	// Wait for the mutex to be unlocked so the dispatch loop can't miss the wake up.
+	{
+		std::lock_guard<std::mutex> lock(m_FrontQueueMutex);
+	}
+	m_MessagesPending.notify_all();
+	m_RoomAvailable.notify_all();
 }
 
 MessageBus::RegisteredNode* MessageBus::getRegisteredNode(Node& node)
 {
-	for(auto regNode : m_RegisteredNodes)
+	auto it = m_NodeLookup.find(node.nodeID());
+	if(it != m_NodeLookup.end())
 	{
-		if(regNode->nodeRef.nodeID() == node.nodeID())
-		{
-			return regNode;
-		}
+		return it->second;
 	}
 
     Logger::info("New node registered: %s", node.nodeName().c_str());
                  
 	RegisteredNode* newRegNode = new RegisteredNode(node);
 	m_RegisteredNodes.push_back(newRegNode);
+	m_NodeLookup[node.nodeID()] = newRegNode;
     
 	return newRegNode;
 }
 
-void MessageBus::processMessages()
+bool MessageBus::changeRegistration(RegistrationChangePtr change)
 {
-	while(m_BackMessages->size() > 0)
+	std::unique_lock<std::mutex> lock(m_ChangeMutex);
+
+	if(not m_Dispatching)
 	{
-		// std::cout << "/* Size back message queue " << m_BackMessages->size() << " */" << '\n';
-		MessagePtr msgPtr = std::move(m_BackMessages->front());
-		Message* msg = msgPtr.get();
+		return applyChange(*change);
+	}
+
+	bool onDispatchThread = (std::this_thread::get_id() == m_DispatchThread.load());
+	m_PendingChanges.push_back(change);
+	m_ChangesPending.store(true);
+	lock.unlock();
+
+	// Wake up the dispatch loop, waiting for the mutex so it can't miss the wake up.
+	{
+		std::lock_guard<std::mutex> queueLock(m_FrontQueueMutex);
+	}
+	m_MessagesPending.notify_one();
+
+	// The dispatch loop applies the change once it is done with the current message
+	if(onDispatchThread)
+	{
+		return true;
+	}
 
-		logMessage(msg);
+	lock.lock();
+	m_ChangesApplied.wait(lock, [&change]{ return change->applied; });
+	return change->result;
+}
 
-		for(auto node : m_RegisteredNodes)
+bool MessageBus::applyChange(RegistrationChange& change)
+{
+	switch(change.action)
+	{
+		case RegistrationChange::Register:
+			// Don't care about the return type, only want to register the node.
+			getRegisteredNode(change.node);
+			return true;
+
+		case RegistrationChange::Subscribe:
 		{
-			// Distribute to everyone interested
-			if(msg->destinationID() == NodeID::None)
+			RegisteredNode* regNode = getRegisteredNode(change.node);
+			std::vector<RegisteredNode*>* consumers = subscribers(change.msgType);
+
+			if(consumers == NULL)
 			{
-				if(node->isInterested( msg->messageType() ))
-				{
-					// std::cout << std::endl << "## Before processing " << nodeToString(node->nodeRef.nodeID()) << " Message : " << msgToString(msg->messageType()) << std::endl;
-					node->nodeRef.processMessage(msg);
-					logMessageConsumer(node->nodeRef.nodeID());
+				Logger::warning("%s tried subscribing to an unknown message type", change.node.nodeName().c_str());
+				return false;
+			}
 
-				}
+			if(regNode->subscribe(change.msgType))
+			{
+				consumers->push_back(regNode);
 			}
-			// Distribute to the node the message is directed at then move onto the next message
-			else
+			return true;
+		}
+
+		case RegistrationChange::Unregister:
+			return removeRegisteredNode(change.node);
+	}
+	return false;
+}
+
+void MessageBus::applyPendingChanges()
+{
+	std::vector<RegistrationChangePtr> changes;
+	{
+		std::lock_guard<std::mutex> lock(m_ChangeMutex);
+		changes.swap(m_PendingChanges);
+		m_ChangesPending.store(false);
+	}
+
+	for(auto& change : changes)
+	{
+		change->result = applyChange(*change);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_ChangeMutex);
+		for(auto& change : changes)
+		{
+			change->applied = true;
+		}
+	}
+	m_ChangesApplied.notify_all();
+}
+
+bool MessageBus::removeRegisteredNode(Node& node)
+{
+	auto it = m_NodeLookup.find(node.nodeID());
+
+	// Another node with the same ID may own the registration
+	if(it == m_NodeLookup.end() || &it->second->nodeRef != &node)
+	{
+		Logger::warning("%s %s is not registered", __PRETTY_FUNCTION__, node.nodeName().c_str());
+		return false;
+	}
+
+	RegisteredNode* regNode = it->second;
+
+	for(auto msgType : regNode->interests())
+	{
+		std::vector<RegisteredNode*>* consumers = subscribers(msgType);
+		consumers->erase(std::remove(consumers->begin(), consumers->end(), regNode), consumers->end());
+	}
+
+	m_NodeLookup.erase(it);
+	m_RegisteredNodes.erase(std::remove(m_RegisteredNodes.begin(), m_RegisteredNodes.end(), regNode), m_RegisteredNodes.end());
+
+	// Make sure no worker is still delivering to the node before it goes away
+	if(m_ParallelDelivery)
+	{
+		m_DeliveryPool.detach(regNode->mailbox);
+	}
+
+	Logger::info("Node unregistered: %s", node.nodeName().c_str());
+	delete regNode;
+	return true;
+}
+
+std::vector<MessageBus::RegisteredNode*>* MessageBus::subscribers(MessageType type)
+{
+	int index = static_cast<int>(type);
+
+	if(index < 0 || index >= MESSAGE_TYPE_COUNT)
+	{
+		return NULL;
+	}
+	return &m_Subscribers[index];
+}
+
+void MessageBus::takeFrontMessages()
+{
+	for(int i = 0; i < MESSAGE_LANE_COUNT; i++)
+	{
+		MessageQueue& front = m_FrontQueues[i];
+		MessageQueue& back = m_BackQueues[i];
+
+		if(back.empty())
+		{
+			std::swap(front, back);
+		}
+		else
+		{
+			while(not front.empty())
 			{
-				if(node->nodeRef.nodeID() == msg->destinationID())
-				{
-					node->nodeRef.processMessage(msg);
-					logMessageConsumer(node->nodeRef.nodeID());
+				back.push_back(std::move(front.front()));
+				front.pop_front();
+			}
+		}
+	}
 
-					continue;
-				}
+	m_FrontQueueSize = 0;
+	m_ControlPending.store(false);
+}
+
+bool MessageBus::hasBacklog() const
+{
+	for(int i = 0; i < MESSAGE_LANE_COUNT; i++)
+	{
+		if(not m_BackQueues[i].empty())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void MessageBus::processMessages()
+{
+	MessageQueue& control = m_BackQueues[static_cast<int>(MessageLane::Control)];
+	MessageQueue& normal = m_BackQueues[static_cast<int>(MessageLane::Normal)];
+	MessageQueue& bulk = m_BackQueues[static_cast<int>(MessageLane::Bulk)];
+	int bulkServed = 0;
+
+	while(true)
+	{
+		if(m_ChangesPending.load())
+		{
+			applyPendingChanges();
+		}
+
+		// The back queues are shared with the senders making room in a full lane, the
+		// message is taken off its queue under the lock and distributed outside of it
+		QueuedMessage queued(NULL);
+		MessageLane lane;
+		{
+			std::lock_guard<std::mutex> lock(m_FrontQueueMutex);
+
+			// Don't let a control message wait behind the rest of the pass
+			if(m_ControlPending.load())
+			{
+				takeFrontMessages();
 			}
+
+			if(not control.empty())
+			{
+				lane = MessageLane::Control;
+			}
+			else if(not normal.empty())
+			{
+				lane = MessageLane::Normal;
+			}
+			else if(not bulk.empty() && bulkServed < BULK_MESSAGES_PER_PASS)
+			{
+				lane = MessageLane::Bulk;
+				bulkServed++;
+			}
+			else
+			{
+				break;
+			}
+
+			MessageQueue& queue = m_BackQueues[static_cast<int>(lane)];
+			queued = std::move(queue.front());
+			queue.pop_front();
+			m_LaneCounters[static_cast<int>(lane)].depth--;
 		}
 
-		m_BackMessages->pop();
+		if(m_BlockedSenders.load() > 0)
+		{
+			m_RoomAvailable.notify_all();
+		}
 
-		// delete msg; Don't need for unique pointers
+		bool replayed = queued.msg->trace().replayed;
+		distributeMessage(queued, lane);
+		m_DistributedCount++;
+		if(replayed)
+		{
+			m_ReplayedHandled++;
+		}
 	}
 }
 
-void MessageBus::startMessageLog()
+void MessageBus::distributeMessage(QueuedMessage& queued, MessageLane lane)
 {
-#ifdef LOG_MESSAGES
-	m_LogFile = new std::ofstream("./Messages.log", std::ios::out | std::ios::trunc);
-	if(m_LogFile->is_open())
+	Message* msg = queued.msg.get();
+	SharedMessagePtr sharedMsg;
+
+	LaneCounters& counters = m_LaneCounters[static_cast<int>(lane)];
+	unsigned long delayUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - queued.enqueued).count();
+	counters.messageCount++;
+	counters.totalDelayUs += delayUs;
+	if(delayUs > counters.maxDelayUs.load())
 	{
-		Logger::info("Message log file created!");
+		counters.maxDelayUs.store(delayUs);
 	}
+
+	msg->stampDispatched();
+	m_Tracer.recordDispatch(*msg);
+	m_Journal.record(*msg);
+
+	// Distribute to everyone interested
+	if(msg->destinationID() == NodeID::None)
+	{
+		std::vector<RegisteredNode*>* consumers = subscribers(msg->messageType());
+
+		if(consumers != NULL)
+		{
+			for(auto node : *consumers)
+			{
+				deliverMessage(*node, queued.msg, sharedMsg);
+			}
+		}
+	}
+	// Distribute to the node the message is directed at
 	else
 	{
-		Logger::error("Message log file not created!");
-		delete m_LogFile;
-		m_LogFile = NULL;
+		auto it = m_NodeLookup.find(msg->destinationID());
+		if(it != m_NodeLookup.end())
+		{
+			deliverMessage(*it->second, queued.msg, sharedMsg);
+		}
 	}
-#endif
 }
 
-void MessageBus::logMessageReceived(Message* msg)
+MessageBus::LaneStatistics MessageBus::laneStatistics(MessageLane lane) const
+{
+	const LaneCounters& counters = m_LaneCounters[static_cast<int>(lane)];
+
+	LaneStatistics stats;
+	stats.messageCount = counters.messageCount.load();
+	stats.totalDelayUs = counters.totalDelayUs.load();
+	stats.maxDelayUs = counters.maxDelayUs.load();
+	stats.depth = counters.depth.load();
+	stats.peakDepth = counters.peakDepth.load();
+	stats.capacity = counters.capacity.load();
+	stats.dropped = counters.dropped.load();
+	stats.blocked = counters.blocked.load();
+	return stats;
+}
+
+unsigned long MessageBus::droppedCount(MessageType msgType) const
 {
-#ifdef LOG_MESSAGES
-	msg->timeReceived = SysClock::timeStamp();
-#endif
+	int index = static_cast<int>(msgType);
+
+	if(index < 0 || index >= MESSAGE_TYPE_COUNT)
+	{
+		return 0;
+	}
+	return m_TypeDrops[index].load() + m_DeliveryPool.droppedCount(msgType);
 }
 
-void MessageBus::logMessage(Message* msg)
+void MessageBus::setLaneCapacity(MessageLane lane, unsigned int capacity)
 {
-#ifdef LOG_MESSAGES
-	if(m_LogFile != NULL)
 	{
-		char buff[256];
+		std::lock_guard<std::mutex> lock(m_FrontQueueMutex);
+		m_LaneCounters[static_cast<int>(lane)].capacity.store(capacity);
+	}
+	m_RoomAvailable.notify_all();
+}
 
-		snprintf(buff, 256, "[%s] Type=%s(%d) SourceID=%d Destination=%d Received=%s", 	SysClock::hh_mm_ss_ms().c_str(),
-																						msgToString(msg->messageType()).c_str(),
-																						(int) msg->messageType(), (int) msg->sourceID(),
-																						(int) msg->destinationID(),
-																						SysClock::hh_mm_ss_ms(msg->timeReceived).c_str());
-		*m_LogFile << buff << "\n";
-		m_LogFile->flush();
+void MessageBus::setOverflowPolicy(MessageType msgType, OverflowPolicy policy)
+{
+	int index = static_cast<int>(msgType);
+
+	if(index < 0 || index >= MESSAGE_TYPE_COUNT)
+	{
+		Logger::warning("%s Unknown message type", __PRETTY_FUNCTION__);
+		return;
 	}
-#endif
+
+	std::lock_guard<std::mutex> lock(m_FrontQueueMutex);
+	m_OverflowPolicies[index] = policy;
+	m_DeliveryPool.setOverflowPolicy(msgType, policy);
 }
 
-void MessageBus::logMessageConsumer(NodeID id)
+void MessageBus::resetLaneStatistics()
 {
-#ifdef LOG_MESSAGES
-	if(m_LogFile != NULL)
+	for(int i = 0; i < MESSAGE_LANE_COUNT; i++)
 	{
-		char buff[256];
+		m_LaneCounters[i].messageCount.store(0);
+		m_LaneCounters[i].totalDelayUs.store(0);
+		m_LaneCounters[i].maxDelayUs.store(0);
+		m_LaneCounters[i].peakDepth.store(m_LaneCounters[i].depth.load());
+		m_LaneCounters[i].dropped.store(0);
+		m_LaneCounters[i].blocked.store(0);
+	}
 
-		snprintf(buff, 256, "\t%s Consumed by Node: %s(%d)", SysClock::hh_mm_ss_ms().c_str(), nodeToString(id).c_str(), (int) id);
-		*m_LogFile << buff << "\n";
-		m_LogFile->flush();
+	for(int i = 0; i < MESSAGE_TYPE_COUNT; i++)
+	{
+		m_TypeDrops[i].store(0);
 	}
-#endif
+	m_DeliveryPool.resetStatistics();
 }
 
-void MessageBus::messageTimeStamp(unsigned long unixTime, char* buffer)
+void MessageBus::logStatistics() const
 {
-	char buff[9];
-	time_t unix_time = (time_t)unixTime;
-	strftime(buff, 9, "%H:%M:%S", gmtime(&unix_time));
+	for(int i = 0; i < MESSAGE_LANE_COUNT; i++)
+	{
+		MessageLane lane = static_cast<MessageLane>(i);
+		LaneStatistics stats = laneStatistics(lane);
 
-	// Get Milliseconds
-	timeval curTime;
-	gettimeofday(&curTime, NULL);
-	int milli = curTime.tv_usec / 1000;
+		Logger::info("%s lane: depth %lu/%lu peak %lu, dropped %lu, blocked %lu, queue delay mean %.0f us max %lu us",
+			laneToString(lane).c_str(), stats.depth, stats.capacity, stats.peakDepth, stats.dropped, stats.blocked,
+			stats.meanDelayUs(), stats.maxDelayUs);
+	}
 
-	sprintf(buffer, "%s:%d", buff, milli);
+	if(m_ParallelDelivery)
+	{
+		DeliveryPool::MailboxStatistics stats = mailboxStatistics();
+		Logger::info("Node mailboxes: depth %lu, fullest %lu/%lu, dropped %lu",
+			stats.depth, stats.peakDepth, stats.capacity, stats.dropped);
+	}
 
+	m_Tracer.logStatistics();
+}
+
+void MessageBus::deliverMessage(RegisteredNode& node, MessagePtr& msgPtr, SharedMessagePtr& sharedMsg)
+{
+	if(m_ParallelDelivery)
+	{
+		// The nodes process the message at different times, so they share its ownership
+		if(sharedMsg == nullptr)
+		{
+			sharedMsg.reset(msgPtr.release(), std::default_delete<const Message>(), MessagePoolAllocator<Message>());
+		}
+		m_DeliveryPool.post(node.mailbox, sharedMsg);
+	}
+	else
+	{
+		m_Tracer.consume(node.nodeRef, msgPtr.get());
+	}
 }
@@ -4,23 +4,47 @@
  * @brief   The message bus manages message distribution to nodes allowing nodes to
  *          communicate with one another.
  *
- * @details     Nodes can only be added before the run function is called currently. This is to
- *              reduce the number of thread locks in place and because once the system has
- *              started its very rare that a node should be registered afterwards on the fly.
+ * @details     Nodes can be registered and unregistered at any time. Once the message bus is
+ *              running the change is handed to the dispatch loop, which applies it between two
+ *              messages, so the routing tables are only ever touched by one thread and
+ *              distributing a message needs no extra locking.
+ *
+ *              By default messages are delivered on the message bus thread. With parallel
+ *              delivery enabled each node gets a mailbox which is processed by a pool of
+ *              worker threads, so a slow node no longer holds up the delivery to other nodes.
+ *
+ *              Messages are queued into priority lanes, see MessageLanes.hpp. Control messages
+ *              are distributed before anything else and bulk messages only get a bounded share
+ *              of each pass of the dispatch loop. Messages in the same lane are distributed in
+ *              the order they were sent.
+ *
+ *              Every message distributed can be recorded into a binary MessageJournal, see
+ *              journal().
+ *
+ *              The message bus stamps the trace of each message when it is sent, dispatched
+ *              and consumed, and aggregates the latencies in a LatencyTracer, see tracer().
  *
  */
 
 #ifndef MESSAGEBUS_HPP
 #define MESSAGEBUS_HPP
 
+#include "DeliveryPool.hpp"
+#include "LatencyTracer.hpp"
 #include "Message.hpp"
+#include "MessageJournal.hpp"
+#include "MessageLanes.hpp"
 #include "Node.hpp"
 #include <atomic>
-#include <fstream>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <thread>
 #include <vector>
 
 typedef std::unique_ptr<Message> MessagePtr;
@@ -29,6 +53,26 @@ class Node;
 
 class MessageBus {
    public:
+    ///----------------------------------------------------------------------------------
+    /// @brief Statistics of a priority lane. The queue delay is the time messages spent
+    ///         waiting between being sent and being distributed, the depth is the number of
+    ///         messages waiting in the lane.
+    ///----------------------------------------------------------------------------------
+    struct LaneStatistics {
+        unsigned long messageCount;
+        unsigned long totalDelayUs;
+        unsigned long maxDelayUs;
+        unsigned long depth;
+        unsigned long peakDepth;
+        unsigned long capacity;  ///< 0 when the lane is unbounded
+        unsigned long dropped;   ///< Messages thrown away because the lane was full
+        unsigned long blocked;   ///< Number of times a sender had to wait for room
+
+        double meanDelayUs() const {
+            return messageCount > 0 ? (double)totalDelayUs / messageCount : 0;
+        }
+    };
+
     ///----------------------------------------------------------------------------------
     /// @brief Default constructor
     ///----------------------------------------------------------------------------------
@@ -43,7 +87,9 @@ class MessageBus {
 
     ///----------------------------------------------------------------------------------
     /// @brief Registers a node onto the message bus allowing it receive direct messages. The
-    ///         message bus does not own the node.
+    ///         message bus does not own the node. On a running message bus this waits until
+    ///         the dispatch loop has added the node, unless called from the dispatch loop
+    ///         itself, in which case the node is added after the current message.
     ///
     /// @param node 			Pointer to the node that should be registered.
     ///----------------------------------------------------------------------------------
@@ -58,6 +104,19 @@ class MessageBus {
     ///----------------------------------------------------------------------------------
     bool registerNode(Node& node, MessageType msgType);
 
+    ///----------------------------------------------------------------------------------
+    /// @brief Removes a node and its subscriptions from the message bus. Once this returns
+    ///         the node receives no more messages and can be destroyed, messages still
+    ///         waiting in its mailbox are dropped. When called from the dispatch loop the
+    ///         node is removed after the current message instead.
+    ///
+    ///         With parallel delivery a node must not unregister itself from within
+    ///         processMessage(), as its mailbox has to finish before it can be removed.
+    ///
+    /// @param node 			The node to remove.
+    ///----------------------------------------------------------------------------------
+    bool unregisterNode(Node& node);
+
     ///----------------------------------------------------------------------------------
     /// @brief Enqueues a message onto the message queue for distribution through the message
     ///         bus.
@@ -67,23 +126,149 @@ class MessageBus {
     ///----------------------------------------------------------------------------------
     void sendMessage(MessagePtr msg);
 
+    ///----------------------------------------------------------------------------------
+    /// @brief Delivers messages through per-node mailboxes processed by a pool of worker
+    ///         threads instead of on the message bus thread. Messages are still processed
+    ///         by a node in the order they were sent, but different nodes process messages
+    ///         concurrently. Needs to be called before run().
+    ///
+    /// @param workerCount 		The number of worker threads, 0 uses one per core.
+    ///----------------------------------------------------------------------------------
+    void enableParallelDelivery(unsigned int workerCount = 0);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns the journal the distributed messages are recorded into. The journal
+    ///         records nothing until it is opened, and can be switched on and off at any time.
+    ///----------------------------------------------------------------------------------
+    MessageJournal& journal() { return m_Journal; }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns the number of messages the dispatch loop has distributed so far.
+    ///----------------------------------------------------------------------------------
+    unsigned long distributedCount() const { return m_DistributedCount.load(); }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns the number of messages sent by a MessageReplay which have left the
+    ///         queues so far, either distributed or dropped.
+    ///----------------------------------------------------------------------------------
+    unsigned long replayedHandledCount() const { return m_ReplayedHandled.load(); }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns the latency histograms of the messages distributed, per message type
+    ///         and per node.
+    ///----------------------------------------------------------------------------------
+    LatencyTracer& tracer() { return m_Tracer; }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Sets the maximum number of messages waiting in a lane, DEFAULT_LANE_CAPACITY
+    ///         by default.
+    ///
+    /// @param lane 			The lane to bound.
+    /// @param capacity 		The number of messages, 0 leaves the lane unbounded.
+    ///----------------------------------------------------------------------------------
+    void setLaneCapacity(MessageLane lane, unsigned int capacity);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Sets what happens to a message of the given type sent into a full lane, see
+    ///         defaultOverflowPolicy() for the defaults. Block never blocks the dispatch
+    ///         loop itself, or before the message bus runs, instead the lane goes over its
+    ///         capacity.
+    ///----------------------------------------------------------------------------------
+    void setOverflowPolicy(MessageType msgType, OverflowPolicy policy);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Sets the maximum number of messages waiting in the mailbox of each node with
+    ///         parallel delivery, DEFAULT_LANE_CAPACITY by default. The overflow policies
+    ///         apply as they do to the lanes, but a Block message never waits for room.
+    ///
+    /// @param capacity 		The number of messages, 0 leaves the mailboxes unbounded.
+    ///----------------------------------------------------------------------------------
+    void setMailboxCapacity(unsigned int capacity) { m_DeliveryPool.setCapacity(capacity); }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns the queue depth, drop and queue delay statistics of a priority lane.
+    ///----------------------------------------------------------------------------------
+    LaneStatistics laneStatistics(MessageLane lane) const;
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns the depth and drops of the node mailboxes with parallel delivery.
+    ///----------------------------------------------------------------------------------
+    DeliveryPool::MailboxStatistics mailboxStatistics() const { return m_DeliveryPool.statistics(); }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns the number of messages of a type thrown away because their lane, or
+    ///         the mailbox of a node, was full.
+    ///----------------------------------------------------------------------------------
+    unsigned long droppedCount(MessageType msgType) const;
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Clears the statistics of all the lanes and mailboxes, apart from their
+    ///         current depth.
+    ///----------------------------------------------------------------------------------
+    void resetLaneStatistics();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Logs the statistics of every lane and the message latencies.
+    ///----------------------------------------------------------------------------------
+    void logStatistics() const;
+
     ///----------------------------------------------------------------------------------
     /// @brief Begins running the message bus and distributing messages to nodes that have been
-    ///         registered. This function won't ever return.
+    ///         registered. The dispatch loop sleeps until a message is sent and only returns
+    ///         once stop() has been called.
     ///----------------------------------------------------------------------------------
     void run();
 
+    ///----------------------------------------------------------------------------------
+    /// @brief Stops the dispatch loop, waking it up if it is waiting for messages.
+    ///----------------------------------------------------------------------------------
     void stop();
 
    private:
+    ///----------------------------------------------------------------------------------
+    /// @brief A message waiting in a lane, with the time it was sent.
+    ///----------------------------------------------------------------------------------
+    struct QueuedMessage {
+        QueuedMessage(MessagePtr message)
+            : msg(std::move(message)), enqueued(std::chrono::steady_clock::now()) {}
+
+        MessagePtr msg;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    // A deque, a full lane gives up a message from the middle of its queue
+    typedef std::deque<QueuedMessage> MessageQueue;
+
+    struct LaneCounters {
+        LaneCounters()
+            : messageCount(0),
+              totalDelayUs(0),
+              maxDelayUs(0),
+              depth(0),
+              peakDepth(0),
+              capacity(DEFAULT_LANE_CAPACITY),
+              dropped(0),
+              blocked(0) {}
+
+        std::atomic<unsigned long> messageCount;
+        std::atomic<unsigned long> totalDelayUs;
+        std::atomic<unsigned long> maxDelayUs;
+        std::atomic<unsigned long> depth;      ///< Messages in the front and back queues of the lane
+        std::atomic<unsigned long> peakDepth;
+        std::atomic<unsigned long> capacity;
+        std::atomic<unsigned long> dropped;
+        std::atomic<unsigned long> blocked;
+    };
+
     ///----------------------------------------------------------------------------------
     /// @brief Stores information about a registered node and the message types it is interested
     ///         in.
     ///----------------------------------------------------------------------------------
     struct RegisteredNode {
-        RegisteredNode(Node& node) : nodeRef(node) {}
+        RegisteredNode(Node& node) : nodeRef(node), mailbox(node) {}
 
         Node& nodeRef;
+        NodeMailbox mailbox;  ///< Used when parallel delivery is enabled
 
         ///------------------------------------------------------------------------------
         /// @brief Returns true if a registered node is interested in a message type.
@@ -100,21 +285,47 @@ class MessageBus {
         }
 
         ///------------------------------------------------------------------------------
-        /// @brief Subscribes the registered node for a particular type of message
+        /// @brief Subscribes the registered node for a particular type of message. Returns
+        ///         false if the node was already subscribed to it.
         ///
         /// @param type 		The message type to subscribe this registered node to.
         ///------------------------------------------------------------------------------
-        void subscribe(MessageType type) {
+        bool subscribe(MessageType type) {
             // Maintain only one copy of each interested type.
             if (not isInterested(type)) {
                 interestedList.push_back(type);
+                return true;
             }
+            return false;
         }
 
+        ///------------------------------------------------------------------------------
+        /// @brief Returns the message types the registered node is subscribed to.
+        ///------------------------------------------------------------------------------
+        const std::vector<MessageType>& interests() const { return interestedList; }
+
        private:
         std::vector<MessageType> interestedList;
     };
 
+    ///----------------------------------------------------------------------------------
+    /// @brief A registration change waiting to be applied by the dispatch loop.
+    ///----------------------------------------------------------------------------------
+    struct RegistrationChange {
+        enum Action { Register, Subscribe, Unregister };
+
+        RegistrationChange(Action changeAction, Node& changeNode, MessageType type)
+            : action(changeAction), node(changeNode), msgType(type), applied(false), result(false) {}
+
+        Action action;
+        Node& node;
+        MessageType msgType;  ///< Only used by Subscribe
+        bool applied;
+        bool result;
+    };
+
+    typedef std::shared_ptr<RegistrationChange> RegistrationChangePtr;
+
     ///----------------------------------------------------------------------------------
     /// @brief Looks for existing registered node for a given node pointer and returns a pointer
     ///         to it. If the node has not yet been registered, it is then registered and a
@@ -123,51 +334,104 @@ class MessageBus {
     RegisteredNode* getRegisteredNode(Node& node);
 
     ///----------------------------------------------------------------------------------
-    /// @brief Goes through the back message queue and distributes messages, calling
-    ///         Node::processMessage(Message*) on nodes that are interested in any given message.
+    /// @brief Applies a registration change straight away if the dispatch loop isn't
+    ///         running, otherwise hands it to the dispatch loop.
     ///----------------------------------------------------------------------------------
-    void processMessages();
+    bool changeRegistration(RegistrationChangePtr change);
 
     ///----------------------------------------------------------------------------------
-    /// @brief Creates a log file for the messages.
+    /// @brief Updates the routing tables for a registration change, only ever called by
+    ///         the thread running the dispatch loop or when the loop isn't running.
     ///----------------------------------------------------------------------------------
-    void startMessageLog();
+    bool applyChange(RegistrationChange& change);
 
     ///----------------------------------------------------------------------------------
-    /// @brief Logs that a message was received.
+    /// @brief Applies the registration changes handed to the dispatch loop and wakes up
+    ///         the threads waiting on them.
     ///----------------------------------------------------------------------------------
-    void logMessageReceived(Message* msg);
+    void applyPendingChanges();
 
     ///----------------------------------------------------------------------------------
-    /// @brief Logs a message that is being processed.
+    /// @brief Removes a node from the routing tables and deletes its RegisteredNode.
     ///----------------------------------------------------------------------------------
-    void logMessage(Message* msg);
+    bool removeRegisteredNode(Node& node);
 
     ///----------------------------------------------------------------------------------
-    /// @brief Logs that a node consumed the current message being processed.
+    /// @brief Applies the overflow policy of a message sent into a full lane, returns false
+    ///         if the message should be dropped. The front queue lock needs to be held and
+    ///         is released while waiting for room.
+    ///
+    ///         A DropOldest message only ever takes the place of the oldest waiting message
+    ///         of its own type, in the back or the front queue of the lane. Without one it
+    ///         is dropped instead, as DropNewest.
     ///----------------------------------------------------------------------------------
-    void logMessageConsumer(NodeID id);
+    bool makeRoom(MessageLane lane, MessageType msgType, std::unique_lock<std::mutex>& lock);
 
     ///----------------------------------------------------------------------------------
-    /// @brief Logs that the current message being processed has finished being processed.
+    /// @brief Moves the messages of the front queues onto the back queues of their lanes.
+    ///         The front queue mutex needs to be held.
     ///----------------------------------------------------------------------------------
-    // void logMessageProcessed(Message* msg);
+    void takeFrontMessages();
 
     ///----------------------------------------------------------------------------------
-    /// @brief Returns a message time stamp in the format HH:MM:SS:MS, a char buffer of 14
-    ///         characters needs to be provided.
+    /// @brief Returns true if messages are waiting in the back queues.
     ///----------------------------------------------------------------------------------
-    void messageTimeStamp(unsigned long unixTime, char* buffer);
+    bool hasBacklog() const;
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Goes through the back queues and distributes messages, control messages
+    ///         first, then normal messages and then up to BULK_MESSAGES_PER_PASS bulk
+    ///         messages. Control messages sent in the meantime are taken straight away.
+    ///----------------------------------------------------------------------------------
+    void processMessages();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Calls Node::processMessage(Message*) on the nodes that are interested in a
+    ///         message, or on the node it is directed at.
+    ///----------------------------------------------------------------------------------
+    void distributeMessage(QueuedMessage& queued, MessageLane lane);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns the nodes subscribed to a message type, or NULL if the message type
+    ///         is out of range.
+    ///----------------------------------------------------------------------------------
+    std::vector<RegisteredNode*>* subscribers(MessageType type);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Hands a message to a node, either directly or through its mailbox when
+    ///         parallel delivery is enabled. In that case ownership of the message is moved
+    ///         from msgPtr into sharedMsg the first time it is posted.
+    ///----------------------------------------------------------------------------------
+    void deliverMessage(RegisteredNode& node, MessagePtr& msgPtr, SharedMessagePtr& sharedMsg);
 
     std::vector<RegisteredNode*> m_RegisteredNodes; ///< A list with the subscribed nodes.
-    std::queue<MessagePtr>* m_FrontMessages;    ///< The forward facing message queue which messages are append to.
-    std::queue<MessagePtr>* m_BackMessages; ///< The backend message queue which contains messages to distribute.
-    std::mutex m_FrontQueueMutex;   ///< Guards the front message queue.
+    std::map<NodeID, RegisteredNode*> m_NodeLookup; ///< Registered nodes by ID, used to route direct messages.
+    std::vector<RegisteredNode*> m_Subscribers[MESSAGE_TYPE_COUNT]; ///< Routing table, the consumers of each message type.
+    MessageQueue m_FrontQueues[MESSAGE_LANE_COUNT];  ///< The forward facing queue of each lane which messages are appended to.
+    MessageQueue m_BackQueues[MESSAGE_LANE_COUNT];   ///< The backend queue of each lane which contains messages to distribute, guarded by the front queue mutex.
+    unsigned int m_FrontQueueSize;  ///< Number of messages in all the front queues.
+    std::mutex m_FrontQueueMutex;   ///< Guards the front queues.
+    std::condition_variable m_MessagesPending;  ///< Signalled when messages are pushed onto the front queues.
+    std::atomic<bool> m_ControlPending; ///< A control message is waiting in the front queues.
+    std::condition_variable m_RoomAvailable;    ///< Signalled when messages leave a lane while senders are blocked.
+    std::atomic<unsigned int> m_BlockedSenders; ///< Senders waiting for room in a lane.
+    LaneCounters m_LaneCounters[MESSAGE_LANE_COUNT];    ///< Queue depth and delay statistics of each lane
+    OverflowPolicy m_OverflowPolicies[MESSAGE_TYPE_COUNT];  ///< Guarded by the front queue mutex
+    std::atomic<unsigned long> m_TypeDrops[MESSAGE_TYPE_COUNT];  ///< Dropped messages of each type
+    std::vector<RegistrationChangePtr> m_PendingChanges;    ///< Changes waiting for the dispatch loop
+    std::mutex m_ChangeMutex;       ///< Guards the pending changes and the dispatching flag
+    std::condition_variable m_ChangesApplied;   ///< Signalled when the dispatch loop applied changes
+    std::atomic<bool> m_ChangesPending; ///< Registration changes are waiting for the dispatch loop
+    bool m_Dispatching;             ///< The dispatch loop owns the routing tables
+    std::atomic<std::thread::id> m_DispatchThread;  ///< The thread running the dispatch loop
     std::atomic<bool> m_Running;    ///< Active flag
-
-#ifdef LOG_MESSAGES
-    std::ofstream* m_LogFile;
-#endif
+    std::atomic<unsigned long> m_DistributedCount;  ///< Messages distributed by the dispatch loop
+    std::atomic<unsigned long> m_ReplayedHandled;   ///< Replayed messages distributed or dropped
+    bool m_ParallelDelivery;        ///< Deliver messages through the delivery pool
+    unsigned int m_WorkerCount;     ///< Number of delivery pool workers, 0 for one per core
+    LatencyTracer m_Tracer;         ///< Aggregates the message latencies
+    DeliveryPool m_DeliveryPool;    ///< Processes the node mailboxes in parallel delivery mode
+    MessageJournal m_Journal;       ///< Records the distributed messages
 };
 
 #endif /* MESSAGEBUS_HPP */
@@ -0,0 +1,251 @@
+/**
+ * @file    MessageJournal.cpp
+ *
+ * @brief   Records the messages distributed by the message bus into a binary journal file,
+ *          the file writes happen on a background thread.
+ *
+ */
+
+#include "MessageJournal.hpp"
+#include "../SystemServices/Logger.hpp"
+#include <chrono>
+#include <cstring>
+
+// 64 MB segments, at least every 6 hours, 1 GB kept in all
+static const RotationPolicy DEFAULT_JOURNAL_ROTATION = { 64 * 1024 * 1024, 6 * 60 * 60, 1024 * 1024 * 1024, true };
+
+MessageJournal::MessageJournal(unsigned int bufferSize)
+	:m_File(NULL), m_FileBytes(0), m_Rotator(DEFAULT_JOURNAL_ROTATION), m_BufferSize(bufferSize), m_Writing(false), m_FlushRequested(false), m_Running(false),
+	 m_Enabled(false), m_Recorded(0), m_Dropped(0), m_BytesWritten(0)
+{
+	m_FrontBuffer.reserve(m_BufferSize);
+	m_BackBuffer.reserve(m_BufferSize);
+}
+
+MessageJournal::~MessageJournal()
+{
+	close();
+}
+
+bool MessageJournal::open(const std::string& filePath)
+{
+	if(m_File != NULL)
+	{
+		Logger::warning("%s The message journal is already open", __PRETTY_FUNCTION__);
+		return false;
+	}
+
+	m_FilePath = filePath;
+	if(not createFile(true))
+	{
+		return false;
+	}
+	m_Rotator.opened(m_FilePath);
+
+	m_Running = true;
+	m_Writer = std::thread(writerThread, this);
+	m_Enabled.store(true);
+
+	Logger::info("Message journal created: %s", filePath.c_str());
+	return true;
+}
+
+void MessageJournal::close()
+{
+	// The file can be missing while the writer runs if a rotation failed
+	if(m_File == NULL && not m_Writer.joinable())
+	{
+		return;
+	}
+
+	m_Enabled.store(false);
+	{
+		std::lock_guard<std::mutex> lock(m_BufferMutex);
+		m_Running = false;
+	}
+	m_WriteNeeded.notify_one();
+
+	if(m_Writer.joinable())
+	{
+		m_Writer.join();
+	}
+
+	if(m_File != NULL)
+	{
+		fclose(m_File);
+		m_File = NULL;
+	}
+
+	// Rotated segments not compressed yet are picked up the next time the journal opens
+	m_Rotator.stop();
+}
+
+bool MessageJournal::createFile(bool truncate)
+{
+	FILE* file = fopen(m_FilePath.c_str(), truncate ? "wb" : "ab");
+	if(file == NULL)
+	{
+		Logger::error("%s Failed to create the message journal %s", __PRETTY_FUNCTION__, m_FilePath.c_str());
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	if(size <= 0)
+	{
+		if(fwrite(JOURNAL_MAGIC, 1, JOURNAL_MAGIC_SIZE, file) != JOURNAL_MAGIC_SIZE)
+		{
+			Logger::error("%s Failed to write the message journal header", __PRETTY_FUNCTION__);
+			fclose(file);
+			return false;
+		}
+		size = JOURNAL_MAGIC_SIZE;
+	}
+
+	m_FileBytes = size;
+	m_File = file;
+	return true;
+}
+
+void MessageJournal::rotateFile()
+{
+	if(m_File == NULL)
+	{
+		return;
+	}
+
+	fclose(m_File);
+	m_File = NULL;
+
+	if(not m_Rotator.rotate())
+	{
+		Logger::error("%s Failed to rotate the message journal %s", __PRETTY_FUNCTION__, m_FilePath.c_str());
+	}
+
+	// Carries on at the end of the same file if it couldn't be rotated, rather than lose
+	// the journal. Logs its own error, the writer tries again with the next batch.
+	createFile(false);
+}
+
+void MessageJournal::record(const Message& msg)
+{
+	if(not m_Enabled.load())
+	{
+		return;
+	}
+
+	MessageSerialiser serialiser;
+	msg.Serialise(serialiser);
+
+	uint64_t timeStamp = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+
+	uint8_t header[JOURNAL_RECORD_HEADER_SIZE];
+	for(int i = 0; i < 8; i++)
+	{
+		header[i] = (timeStamp >> (i * 8)) & 0xFF;
+	}
+	header[8] = serialiser.size();
+
+	bool wakeWriter = false;
+	{
+		std::lock_guard<std::mutex> lock(m_BufferMutex);
+
+		if(not m_Running)
+		{
+			return;
+		}
+
+		// Never wait on the disk, drop the message instead
+		if(m_FrontBuffer.size() + JOURNAL_RECORD_HEADER_SIZE + serialiser.size() > m_BufferSize)
+		{
+			m_Dropped++;
+			return;
+		}
+
+		m_FrontBuffer.insert(m_FrontBuffer.end(), header, header + JOURNAL_RECORD_HEADER_SIZE);
+		m_FrontBuffer.insert(m_FrontBuffer.end(), serialiser.data(), serialiser.data() + serialiser.size());
+		m_Recorded++;
+
+		wakeWriter = (m_FrontBuffer.size() >= m_BufferSize / 2);
+	}
+
+	if(wakeWriter)
+	{
+		m_WriteNeeded.notify_one();
+	}
+}
+
+void MessageJournal::flush()
+{
+	std::unique_lock<std::mutex> lock(m_BufferMutex);
+
+	if(not m_Running)
+	{
+		return;
+	}
+
+	m_FlushRequested = true;
+	m_WriteNeeded.notify_one();
+	m_WriteDone.wait(lock, [this]{ return (m_FrontBuffer.empty() && not m_Writing) || not m_Running; });
+}
+
+void MessageJournal::writerThread(MessageJournal* journal)
+{
+	std::unique_lock<std::mutex> lock(journal->m_BufferMutex);
+
+	while(true)
+	{
+		journal->m_WriteNeeded.wait_for(lock, std::chrono::milliseconds(JOURNAL_FLUSH_INTERVAL_MS), [journal]{
+			return journal->m_FrontBuffer.size() >= journal->m_BufferSize / 2 || journal->m_FlushRequested || not journal->m_Running;
+		});
+
+		// Nothing can be recorded once the journal stops running, so this is the last batch
+		bool running = journal->m_Running;
+		journal->m_FlushRequested = false;
+
+		if(journal->m_FrontBuffer.size() > 0)
+		{
+			std::swap(journal->m_FrontBuffer, journal->m_BackBuffer);
+			journal->m_Writing = true;
+			lock.unlock();
+
+			std::vector<uint8_t>& batch = journal->m_BackBuffer;
+			size_t written = 0;
+			// The file may not have been rotated, so it mustn't be truncated
+			if(journal->m_File == NULL)
+			{
+				journal->createFile(false);
+			}
+			if(journal->m_File != NULL)
+			{
+				written = fwrite(batch.data(), 1, batch.size(), journal->m_File);
+				fflush(journal->m_File);
+			}
+
+			if(written != batch.size())
+			{
+				Logger::error("%s Failed writing to the message journal", __PRETTY_FUNCTION__);
+			}
+			journal->m_BytesWritten += written;
+			journal->m_FileBytes += written;
+			batch.clear();
+
+			// Only between batches, so records never straddle two segments
+			if(journal->m_Rotator.needsRotation(journal->m_FileBytes))
+			{
+				journal->rotateFile();
+			}
+
+			lock.lock();
+			journal->m_Writing = false;
+		}
+
+		journal->m_WriteDone.notify_all();
+
+		if(not running)
+		{
+			return;
+		}
+	}
+}
@@ -0,0 +1,156 @@
+/**
+ * @file    MessageJournal.hpp
+ *
+ * @brief   Records the messages distributed by the message bus into a binary journal file,
+ *          the file writes happen on a background thread.
+ *
+ * @details     Messages are serialised with the MessageSerialiser into an in-memory buffer
+ *              which a writer thread flushes to disk in batches, either once the buffer is
+ *              half full or every JOURNAL_FLUSH_INTERVAL_MS. The buffer has a fixed size, if
+ *              the disk can't keep up messages are dropped from the journal and counted rather
+ *              than slowing down the message bus.
+ *
+ *              Journal file layout, all integers are little endian:
+ *
+ *                  Header:     "SWJ1"
+ *                  Record:     uint64 timestamp (microseconds since the unix epoch)
+ *                              uint8  size of the serialised message
+ *                              size bytes of MessageSerialiser data
+ *
+ *              The journal file is rotated by size and age between batches, each segment
+ *              is a complete journal on its own. Segments get gzipped in the background and
+ *              need to be decompressed before MessageReplay can open them, see
+ *              LogRotator.hpp.
+ *
+ */
+
+#ifndef MESSAGEJOURNAL_HPP
+#define MESSAGEJOURNAL_HPP
+
+#include "Message.hpp"
+#include "../SystemServices/LogRotator.hpp"
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define JOURNAL_MAGIC "SWJ1"
+#define JOURNAL_MAGIC_SIZE 4
+#define JOURNAL_RECORD_HEADER_SIZE 9
+#define JOURNAL_BUFFER_SIZE (64 * 1024)
+#define JOURNAL_FLUSH_INTERVAL_MS 500
+
+class MessageJournal {
+   public:
+    ///----------------------------------------------------------------------------------
+    /// @brief Default constructor
+    ///
+    /// @param bufferSize 		The number of bytes which can be waiting to be written
+    ///							before messages are dropped.
+    ///----------------------------------------------------------------------------------
+    MessageJournal(unsigned int bufferSize = JOURNAL_BUFFER_SIZE);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Writes out any buffered messages and closes the journal.
+    ///----------------------------------------------------------------------------------
+    ~MessageJournal();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Creates the journal file and starts the writer thread. The journal is
+    ///         enabled once opened.
+    ///----------------------------------------------------------------------------------
+    bool open(const std::string& filePath);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Writes out any buffered messages, stops the writer thread and closes the file.
+    ///----------------------------------------------------------------------------------
+    void close();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Sets when the journal file is rotated and how much of the journal is kept.
+    ///----------------------------------------------------------------------------------
+    void setRotation(const RotationPolicy& policy) { m_Rotator.setPolicy(policy); }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Switches recording on or off, this can be done at any time.
+    ///----------------------------------------------------------------------------------
+    void setEnabled(bool enabled) { m_Enabled.store(enabled); }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns true if the journal is open and recording messages.
+    ///----------------------------------------------------------------------------------
+    bool isEnabled() const { return m_Enabled.load() && m_File != NULL; }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Serialises a message into the journal buffer, does nothing if the journal
+    ///         is disabled. Never waits on disk I/O.
+    ///----------------------------------------------------------------------------------
+    void record(const Message& msg);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Blocks until everything recorded so far has been written to the file.
+    ///----------------------------------------------------------------------------------
+    void flush();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns the number of messages added to the journal.
+    ///----------------------------------------------------------------------------------
+    unsigned long recordedCount() const { return m_Recorded.load(); }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns the number of messages dropped because the buffer was full.
+    ///----------------------------------------------------------------------------------
+    unsigned long droppedCount() const { return m_Dropped.load(); }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns the number of bytes written to the journal file.
+    ///----------------------------------------------------------------------------------
+    unsigned long bytesWritten() const { return m_BytesWritten.load(); }
+
+   private:
+    ///----------------------------------------------------------------------------------
+    /// @brief Swaps the buffers and writes out the one containing records until the
+    ///         journal is closed.
+    ///----------------------------------------------------------------------------------
+    static void writerThread(MessageJournal* journal);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Moves the journal file into a segment and starts a new one, only called
+    ///         by the writer thread.
+    ///----------------------------------------------------------------------------------
+    void rotateFile();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Opens the journal file and writes its header if the file is empty.
+    ///
+    /// @param truncate 		Starts the file over, otherwise the records are appended
+    ///							to what the file already holds.
+    ///----------------------------------------------------------------------------------
+    bool createFile(bool truncate);
+
+    std::atomic<FILE*> m_File;  ///< Read by isEnabled() from any thread
+    std::string m_FilePath;
+    unsigned long m_FileBytes;  ///< Bytes in the current file, only used by the writer thread
+    LogRotator m_Rotator;
+    unsigned int m_BufferSize;
+    std::vector<uint8_t> m_FrontBuffer;  ///< Records are appended to this buffer
+    std::vector<uint8_t> m_BackBuffer;   ///< Buffer being written out by the writer thread
+    std::mutex m_BufferMutex;            ///< Guards the front buffer and the flags below
+    std::condition_variable m_WriteNeeded;
+    std::condition_variable m_WriteDone;
+    bool m_Writing;         ///< The writer thread is writing out the back buffer
+    bool m_FlushRequested;  ///< Write out the front buffer straight away
+    bool m_Running;
+    std::thread m_Writer;
+
+    std::atomic<bool> m_Enabled;
+    std::atomic<unsigned long> m_Recorded;
+    std::atomic<unsigned long> m_Dropped;
+    std::atomic<unsigned long> m_BytesWritten;
+};
+
+#endif /* MESSAGEJOURNAL_HPP */
@@ -0,0 +1,92 @@
+/**
+ * @file    MessageLanes.hpp
+ *
+ * @brief   The priority lanes the message bus queues messages into, and which lane each
+ *          message type belongs to.
+ *
+ * @details     Control messages are always distributed first, then normal messages. Bulk
+ *              messages, telemetry and AIS data, only get a bounded share of each pass of the
+ *              dispatch loop so that a burst of them can't delay the control of the vessel.
+ *
+ *              Each lane holds at most a fixed number of messages. What happens to a message
+ *              sent into a full lane depends on the overflow policy of its type.
+ *
+ */
+
+#ifndef MESSAGELANES_HPP
+#define MESSAGELANES_HPP
+
+#include "MessageTypes.hpp"
+#include <string>
+
+enum class MessageLane { Control = 0, Normal, Bulk };
+
+const int MESSAGE_LANE_COUNT = static_cast<int>(MessageLane::Bulk) + 1;
+
+const unsigned int DEFAULT_LANE_CAPACITY = 4096;
+
+///----------------------------------------------------------------------------------
+/// @brief What to do with a message sent into a full lane. DropOldest throws away the
+///         oldest message of the same type waiting in the lane, or the message being sent
+///         if there is none, DropNewest throws away the message being sent and Block makes
+///         the sender wait for room.
+///----------------------------------------------------------------------------------
+enum class OverflowPolicy { DropOldest, DropNewest, Block };
+
+inline MessageLane messageLane(MessageType msgType) {
+    switch (msgType) {
+        case MessageType::RudderCommand:
+        case MessageType::WingSailCommand:
+        case MessageType::SailCommand:
+        case MessageType::LocalNavigation:
+        case MessageType::ExternalControl:
+        case MessageType::ObstacleVector:
+        case MessageType::PowerOffCommand:
+        case MessageType::NodeStalled:
+            return MessageLane::Control;
+        case MessageType::DataRequest:
+        case MessageType::AISData:
+        case MessageType::LidarData:
+        case MessageType::MarineSensorData:
+        case MessageType::CurrentSensorData:
+        case MessageType::PowerTrackMsg:
+        case MessageType::DataCollectionStart:
+        case MessageType::DataCollectionStop:
+        case MessageType::ServerConfigsReceived:
+        case MessageType::ServerWaypointsReceived:
+            return MessageLane::Bulk;
+        default:
+            return MessageLane::Normal;
+    }
+}
+
+///----------------------------------------------------------------------------------
+/// @brief Newer data makes older data useless for most messages, but configuration and
+///         waypoint changes must never be lost.
+///----------------------------------------------------------------------------------
+inline OverflowPolicy defaultOverflowPolicy(MessageType msgType) {
+    switch (msgType) {
+        case MessageType::LocalConfigChange:
+        case MessageType::LocalWaypointChange:
+        case MessageType::ServerConfigsReceived:
+        case MessageType::ServerWaypointsReceived:
+        case MessageType::PowerOffCommand:
+            return OverflowPolicy::Block;
+        default:
+            return OverflowPolicy::DropOldest;
+    }
+}
+
+inline std::string laneToString(MessageLane lane) {
+    switch (lane) {
+        case MessageLane::Control:
+            return "Control";
+        case MessageLane::Normal:
+            return "Normal";
+        case MessageLane::Bulk:
+            return "Bulk";
+    }
+    return "";
+}
+
+#endif /* MESSAGELANES_HPP */
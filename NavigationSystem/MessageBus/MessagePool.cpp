@@ -0,0 +1,89 @@
+/**
+ * @file    MessagePool.cpp
+ *
+ * @brief   Recycles the memory of messages so that steady state messaging does not go
+ *          through the heap.
+ *
+ */
+
+#include "MessagePool.hpp"
+#include <new>
+
+MessagePool::SizeClass		MessagePool::m_SizeClasses[MESSAGE_POOL_CLASSES];
+std::atomic<unsigned long>	MessagePool::m_HeapAllocations(0);
+std::atomic<unsigned long>	MessagePool::m_PooledAllocations(0);
+
+int MessagePool::sizeClass(std::size_t size)
+{
+	if(size == 0 || size > MESSAGE_POOL_MAX_SIZE)
+	{
+		return -1;
+	}
+	return (size - 1) / MESSAGE_POOL_GRANULARITY;
+}
+
+void* MessagePool::allocate(std::size_t size)
+{
+	int index = sizeClass(size);
+
+	if(index < 0)
+	{
+		m_HeapAllocations++;
+		return ::operator new(size);
+	}
+
+	SizeClass& pool = m_SizeClasses[index];
+	{
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		FreeBlock* block = pool.freeList;
+		if(block != nullptr)
+		{
+			pool.freeList = block->next;
+			m_PooledAllocations++;
+			return block;
+		}
+	}
+
+	// Always allocate the full size class so the block can be reused by any message of the class
+	m_HeapAllocations++;
+	return ::operator new((index + 1) * MESSAGE_POOL_GRANULARITY);
+}
+
+void MessagePool::release(void* ptr, std::size_t size)
+{
+	if(ptr == nullptr)
+	{
+		return;
+	}
+
+	int index = sizeClass(size);
+
+	if(index < 0)
+	{
+		::operator delete(ptr);
+		return;
+	}
+
+	SizeClass& pool = m_SizeClasses[index];
+	FreeBlock* block = static_cast<FreeBlock*>(ptr);
+
+	std::lock_guard<std::mutex> lock(pool.mutex);
+	block->next = pool.freeList;
+	pool.freeList = block;
+}
+
+void MessagePool::reserve(std::size_t size, unsigned int count)
+{
+	int index = sizeClass(size);
+
+	if(index < 0)
+	{
+		return;
+	}
+
+	for(unsigned int i = 0; i < count; i++)
+	{
+		m_HeapAllocations++;
+		release(::operator new((index + 1) * MESSAGE_POOL_GRANULARITY), size);
+	}
+}
@@ -0,0 +1,111 @@
+/**
+ * @file    MessagePool.hpp
+ *
+ * @brief   Recycles the memory of messages so that steady state messaging does not go
+ *          through the heap.
+ *
+ * @details     Message overrides operator new and delete to go through this pool. Memory is
+ *              handed out in size classes of MESSAGE_POOL_GRANULARITY bytes, each with its own
+ *              free list. When a message is deleted its block goes back onto the free list of
+ *              its size class instead of being freed, and is reused by the next message of a
+ *              similar size. Blocks are only requested from the heap when a free list is
+ *              empty, so once the pool has grown to the peak number of messages in flight no
+ *              more heap allocations are made.
+ *
+ *              Messages bigger than MESSAGE_POOL_MAX_SIZE bypass the pool.
+ *
+ *              In parallel delivery the nodes share the ownership of a message, the control
+ *              block of the shared pointer comes from the pool too, through
+ *              MessagePoolAllocator. The queues the messages wait in still grow and shrink
+ *              by blocks on the heap, once every few dozen messages.
+ *
+ */
+
+#ifndef MESSAGEPOOL_HPP
+#define MESSAGEPOOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+#define MESSAGE_POOL_GRANULARITY 32
+#define MESSAGE_POOL_MAX_SIZE 512
+#define MESSAGE_POOL_CLASSES (MESSAGE_POOL_MAX_SIZE / MESSAGE_POOL_GRANULARITY)
+
+class MessagePool {
+   public:
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns a block of at least size bytes, reusing a free block if possible.
+    ///----------------------------------------------------------------------------------
+    static void* allocate(std::size_t size);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns a block to the pool, size must be the size it was allocated with.
+    ///----------------------------------------------------------------------------------
+    static void release(void* ptr, std::size_t size);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Pre-allocates count blocks able to hold size bytes, so that the pool does not
+    ///         need to grow once the system is running.
+    ///----------------------------------------------------------------------------------
+    static void reserve(std::size_t size, unsigned int count);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns the number of blocks that were requested from the heap.
+    ///----------------------------------------------------------------------------------
+    static unsigned long heapAllocations() { return m_HeapAllocations.load(); }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns the number of allocations served from a free list.
+    ///----------------------------------------------------------------------------------
+    static unsigned long pooledAllocations() { return m_PooledAllocations.load(); }
+
+   private:
+    ///----------------------------------------------------------------------------------
+    /// @brief A free block, the next pointer is stored inside the unused memory.
+    ///----------------------------------------------------------------------------------
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct SizeClass {
+        SizeClass() : freeList(nullptr) {}
+
+        std::mutex mutex;
+        FreeBlock* freeList;
+    };
+
+    static int sizeClass(std::size_t size);
+
+    static SizeClass m_SizeClasses[MESSAGE_POOL_CLASSES];
+    static std::atomic<unsigned long> m_HeapAllocations;
+    static std::atomic<unsigned long> m_PooledAllocations;
+};
+
+///----------------------------------------------------------------------------------
+/// @brief A standard allocator going through the MessagePool, for the shared pointers
+///         which hold messages.
+///----------------------------------------------------------------------------------
+template <typename T>
+struct MessagePoolAllocator {
+    typedef T value_type;
+
+    MessagePoolAllocator() {}
+    template <typename U>
+    MessagePoolAllocator(const MessagePoolAllocator<U>&) {}
+
+    T* allocate(std::size_t count) { return static_cast<T*>(MessagePool::allocate(count * sizeof(T))); }
+    void deallocate(T* ptr, std::size_t count) { MessagePool::release(ptr, count * sizeof(T)); }
+};
+
+template <typename T, typename U>
+bool operator==(const MessagePoolAllocator<T>&, const MessagePoolAllocator<U>&) {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const MessagePoolAllocator<T>&, const MessagePoolAllocator<U>&) {
+    return false;
+}
+
+#endif /* MESSAGEPOOL_HPP */
@@ -0,0 +1,339 @@
+/**
+ * @file    MessageReplay.cpp
+ *
+ * @brief   Feeds the messages recorded in a MessageJournal back into a message bus.
+ *
+ */
+
+#include "MessageReplay.hpp"
+#include "MessageJournal.hpp"
+#include "../Messages/AISDataMsg.hpp"
+#include "../Messages/ArduinoDataMsg.h"
+#include "../Messages/CompassDataMsg.h"
+#include "../Messages/CourseDataMsg.hpp"
+#include "../Messages/CurrentSensorDataMsg.hpp"
+#include "../Messages/ExternalControlMsg.hpp"
+#include "../Messages/GPSDataMsg.hpp"
+#include "../Messages/LidarMsg.h"
+#include "../Messages/LocalConfigChangeMsg.h"
+#include "../Messages/LocalNavigationMsg.h"
+#include "../Messages/LocalWaypointChangeMsg.h"
+#include "../Messages/MarineSensorDataMsg.h"
+#include "../Messages/NodeStalledMsg.hpp"
+#include "../Messages/PowerOffCommand.hpp"
+#include "../Messages/PowerTrackMsg.hpp"
+#include "../Messages/RequestCourseMsg.h"
+#include "../Messages/RudderCommandMsg.hpp"
+#include "../Messages/SailCommandMsg.h"
+#include "../Messages/ServerConfigsReceivedMsg.hpp"
+#include "../Messages/ServerWaypointsReceivedMsg.hpp"
+#include "../Messages/StateMessage.h"
+#include "../Messages/VesselStateMsg.h"
+#include "../Messages/WaypointDataMsg.hpp"
+#include "../Messages/WindDataMsg.hpp"
+#include "../Messages/WindStateMsg.hpp"
+#include "../Messages/WingSailCommandMsg.hpp"
+#include "../SystemServices/Logger.hpp"
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+// The messages coming from outside the nodes, everything else is derived from them
+static const MessageType INPUT_MESSAGE_TYPES[] = {
+	MessageType::WindData,
+	MessageType::CompassData,
+	MessageType::GPSData,
+	MessageType::PowerTrackMsg,
+	MessageType::ServerConfigsReceived,
+	MessageType::ServerWaypointsReceived,
+	MessageType::ArduinoData,
+	MessageType::LidarData,
+	MessageType::ExternalControl,
+	MessageType::MarineSensorData,
+	MessageType::AISData,
+	MessageType::CurrentSensorData
+};
+
+MessageReplay::MessageReplay(MessageBus& msgBus)
+	:m_MsgBus(msgBus), m_File(NULL), m_Running(false), m_Replayed(0), m_Skipped(0), m_Filtered(0), m_ElapsedSeconds(0)
+{
+	for(int i = 0; i < MESSAGE_TYPE_COUNT; i++)
+	{
+		m_ReplayedTypes[i] = false;
+	}
+	for(MessageType type : INPUT_MESSAGE_TYPES)
+	{
+		m_ReplayedTypes[static_cast<int>(type)] = true;
+	}
+}
+
+MessageReplay::~MessageReplay()
+{
+	close();
+}
+
+bool MessageReplay::open(const std::string& journalPath)
+{
+	close();
+
+	m_File = fopen(journalPath.c_str(), "rb");
+	if(m_File == NULL)
+	{
+		Logger::error("%s Failed to open the message journal %s", __PRETTY_FUNCTION__, journalPath.c_str());
+		return false;
+	}
+
+	char magic[JOURNAL_MAGIC_SIZE];
+	if(fread(magic, 1, JOURNAL_MAGIC_SIZE, m_File) != JOURNAL_MAGIC_SIZE || memcmp(magic, JOURNAL_MAGIC, JOURNAL_MAGIC_SIZE) != 0)
+	{
+		Logger::error("%s %s is not a message journal", __PRETTY_FUNCTION__, journalPath.c_str());
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void MessageReplay::close()
+{
+	if(m_File != NULL)
+	{
+		fclose(m_File);
+		m_File = NULL;
+	}
+}
+
+void MessageReplay::setTypeReplayed(MessageType type, bool replayed)
+{
+	int index = static_cast<int>(type);
+	if(index >= 0 && index < MESSAGE_TYPE_COUNT)
+	{
+		m_ReplayedTypes[index] = replayed;
+	}
+}
+
+bool MessageReplay::isTypeReplayed(MessageType type) const
+{
+	int index = static_cast<int>(type);
+	return index >= 0 && index < MESSAGE_TYPE_COUNT && m_ReplayedTypes[index];
+}
+
+void MessageReplay::replayAllTypes()
+{
+	for(int i = 0; i < MESSAGE_TYPE_COUNT; i++)
+	{
+		m_ReplayedTypes[i] = true;
+	}
+}
+
+unsigned long MessageReplay::run(double speed)
+{
+	m_Replayed.store(0);
+	m_Skipped.store(0);
+	m_Filtered.store(0);
+	m_ElapsedSeconds = 0;
+
+	if(m_File == NULL)
+	{
+		Logger::error("%s No message journal open", __PRETTY_FUNCTION__);
+		return 0;
+	}
+
+	fseek(m_File, JOURNAL_MAGIC_SIZE, SEEK_SET);
+	m_Running.store(true);
+
+	unsigned long startCount = m_MsgBus.replayedHandledCount();
+	auto startTime = std::chrono::steady_clock::now();
+	uint64_t firstTimeStamp = 0;
+	bool first = true;
+
+	uint64_t timeStamp;
+	uint8_t data[MAX_MESSAGE_SIZE];
+	uint8_t size;
+
+	while(m_Running.load() && readRecord(timeStamp, data, size))
+	{
+		// Filtered before the message is deserialised
+		MessageDeserialiser deserialiser(data, size);
+		MessageType type;
+		if(deserialiser.readMessageType(type) && not isTypeReplayed(type))
+		{
+			m_Filtered++;
+			continue;
+		}
+
+		MessagePtr msg = createMessage(data, size);
+		if(msg == NULL)
+		{
+			m_Skipped++;
+			continue;
+		}
+
+		if(first)
+		{
+			firstTimeStamp = timeStamp;
+			first = false;
+		}
+
+		// Keep the same spacing between the messages as when they were recorded
+		if(speed > REPLAY_AS_FAST_AS_POSSIBLE && timeStamp > firstTimeStamp)
+		{
+			std::chrono::duration<double, std::micro> offset((timeStamp - firstTimeStamp) / speed);
+			std::this_thread::sleep_until(startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset));
+		}
+
+		msg->markReplayed();
+		waitForRoom(messageLane(msg->messageType()));
+		m_MsgBus.sendMessage(std::move(msg));
+		m_Replayed++;
+	}
+
+	waitForDistribution(startCount, m_Replayed.load());
+	m_Running.store(false);
+
+	m_ElapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	Logger::info("Replayed %lu messages in %.3f seconds, %.0f messages per second, %lu skipped, %lu filtered",
+		m_Replayed.load(), m_ElapsedSeconds, messagesPerSecond(), m_Skipped.load(), m_Filtered.load());
+
+	return m_Replayed.load();
+}
+
+double MessageReplay::messagesPerSecond() const
+{
+	if(m_ElapsedSeconds <= 0)
+	{
+		return 0;
+	}
+	return m_Replayed.load() / m_ElapsedSeconds;
+}
+
+bool MessageReplay::readRecord(uint64_t& timeStamp, uint8_t* data, uint8_t& size)
+{
+	uint8_t header[JOURNAL_RECORD_HEADER_SIZE];
+
+	if(fread(header, 1, JOURNAL_RECORD_HEADER_SIZE, m_File) != JOURNAL_RECORD_HEADER_SIZE)
+	{
+		return false;
+	}
+
+	timeStamp = 0;
+	for(int i = 0; i < 8; i++)
+	{
+		timeStamp |= (uint64_t)header[i] << (i * 8);
+	}
+	size = header[8];
+
+	// A truncated record at the end of the journal, the recording was cut off
+	if(fread(data, 1, size, m_File) != size)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+void MessageReplay::waitForRoom(MessageLane lane)
+{
+	MessageBus::LaneStatistics stats = m_MsgBus.laneStatistics(lane);
+
+	while(m_Running.load() && stats.capacity > 0 && stats.depth >= stats.capacity)
+	{
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+		stats = m_MsgBus.laneStatistics(lane);
+	}
+}
+
+void MessageReplay::waitForDistribution(unsigned long startCount, unsigned long count)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	while(m_MsgBus.replayedHandledCount() - startCount < count)
+	{
+		if(std::chrono::steady_clock::now() - start > std::chrono::milliseconds(REPLAY_DRAIN_TIMEOUT_MS))
+		{
+			Logger::warning("%s Timed out waiting for the message bus to distribute the replayed messages", __PRETTY_FUNCTION__);
+			return;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+MessagePtr MessageReplay::createMessage(uint8_t* data, uint8_t size)
+{
+	MessageDeserialiser deserialiser(data, size);
+	MessageType type;
+
+	if(not deserialiser.readMessageType(type))
+	{
+		return NULL;
+	}
+	deserialiser.resetInternalPtr();
+
+	MessagePtr msg;
+
+	switch(type)
+	{
+		case MessageType::WindData:
+			msg = std::make_unique<WindDataMsg>(deserialiser); break;
+		case MessageType::CompassData:
+			msg = std::make_unique<CompassDataMsg>(deserialiser); break;
+		case MessageType::GPSData:
+			msg = std::make_unique<GPSDataMsg>(deserialiser); break;
+		case MessageType::PowerTrackMsg:
+			msg = std::make_unique<PowerTrackMsg>(deserialiser); break;
+		case MessageType::ServerConfigsReceived:
+			msg = std::make_unique<ServerConfigsReceivedMsg>(deserialiser); break;
+		case MessageType::ServerWaypointsReceived:
+			msg = std::make_unique<ServerWaypointsReceivedMsg>(deserialiser); break;
+		case MessageType::LocalConfigChange:
+			msg = std::make_unique<LocalConfigChangeMsg>(deserialiser); break;
+		case MessageType::LocalWaypointChange:
+			msg = std::make_unique<LocalWaypointChangeMsg>(deserialiser); break;
+		case MessageType::ArduinoData:
+			msg = std::make_unique<ArduinoDataMsg>(deserialiser); break;
+		case MessageType::VesselState:
+			msg = std::make_unique<VesselStateMsg>(deserialiser); break;
+		case MessageType::WaypointData:
+			msg = std::make_unique<WaypointDataMsg>(deserialiser); break;
+		case MessageType::LidarData:
+			msg = std::make_unique<LidarMsg>(deserialiser); break;
+		case MessageType::CourseData:
+			msg = std::make_unique<CourseDataMsg>(deserialiser); break;
+		case MessageType::ExternalControl:
+			msg = std::make_unique<ExternalControlMsg>(deserialiser); break;
+		case MessageType::RequestCourse:
+			msg = std::make_unique<RequestCourseMsg>(deserialiser); break;
+		case MessageType::StateMessage:
+			msg = std::make_unique<StateMessage>(deserialiser); break;
+		case MessageType::WindState:
+			msg = std::make_unique<WindStateMsg>(deserialiser); break;
+		case MessageType::LocalNavigation:
+			msg = std::make_unique<LocalNavigationMsg>(deserialiser); break;
+		case MessageType::MarineSensorData:
+			msg = std::make_unique<MarineSensorDataMsg>(deserialiser); break;
+		case MessageType::AISData:
+			msg = std::make_unique<AISDataMsg>(deserialiser); break;
+		case MessageType::WingSailCommand:
+			msg = std::make_unique<WingSailCommandMsg>(deserialiser); break;
+		case MessageType::RudderCommand:
+			msg = std::make_unique<RudderCommandMsg>(deserialiser); break;
+		case MessageType::SailCommand:
+			msg = std::make_unique<SailCommandMsg>(deserialiser); break;
+		case MessageType::CurrentSensorData:
+			msg = std::make_unique<CurrentSensorDataMsg>(deserialiser); break;
+		case MessageType::PowerOffCommand:
+			msg = std::make_unique<PowerOffCommand>(deserialiser); break;
+		case MessageType::NodeStalled:
+			msg = std::make_unique<NodeStalledMsg>(deserialiser); break;
+		// These messages have no deserialising constructor
+		default:
+			return NULL;
+	}
+
+	if(not msg->isValid())
+	{
+		return NULL;
+	}
+	return msg;
+}
@@ -0,0 +1,145 @@
+/**
+ * @file    MessageReplay.hpp
+ *
+ * @brief   Feeds the messages recorded in a MessageJournal back into a message bus.
+ *
+ * @details     The recorded messages are deserialised and sent on the message bus in the order
+ *              they were recorded, either with their original timing, with the timing scaled by
+ *              a speed factor, or as fast as possible. This allows the behaviour of the nodes
+ *              during a sea trial to be reproduced, and benchmarked, without the hardware or
+ *              running the simulator in real time.
+ *
+ *              Messages which can't be deserialised, either because their type has no
+ *              deserialising constructor or because the record is corrupt, are skipped.
+ *
+ *              The journal records every message distributed, including the ones the nodes
+ *              derive from their inputs, such as RudderCommand or StateMessage. The nodes
+ *              send those again while the journal is replayed, so by default only the sensor
+ *              and server inputs are replayed, see setTypeReplayed().
+ *
+ */
+
+#ifndef MESSAGEREPLAY_HPP
+#define MESSAGEREPLAY_HPP
+
+#include "MessageBus.hpp"
+#include <stdint.h>
+#include <atomic>
+#include <cstdio>
+#include <string>
+
+#define REPLAY_AS_FAST_AS_POSSIBLE 0
+#define REPLAY_DRAIN_TIMEOUT_MS 10000
+
+class MessageReplay {
+   public:
+    ///----------------------------------------------------------------------------------
+    /// @brief Default constructor
+    ///
+    /// @param msgBus 			The message bus the recorded messages are sent on.
+    ///----------------------------------------------------------------------------------
+    MessageReplay(MessageBus& msgBus);
+
+    ~MessageReplay();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Opens a journal written by the MessageJournal, returns false if the file
+    ///         doesn't exist or isn't a message journal.
+    ///----------------------------------------------------------------------------------
+    bool open(const std::string& journalPath);
+
+    void close();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Sends every message in the journal on the message bus, from the start of the
+    ///         journal. Blocks until all the messages have been sent and distributed by
+    ///         the message bus, or until stop() is called. Returns the number of messages
+    ///         replayed.
+    ///
+    /// @param speed 			1.0 keeps the original timing, 2.0 replays twice as fast
+    ///							and so on. REPLAY_AS_FAST_AS_POSSIBLE sends the messages
+    ///							without waiting between them.
+    ///----------------------------------------------------------------------------------
+    unsigned long run(double speed = 1.0);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Sets whether the recorded messages of a type are replayed, the records of the
+    ///         types left out are filtered. Only takes effect on the next run.
+    ///----------------------------------------------------------------------------------
+    void setTypeReplayed(MessageType type, bool replayed);
+    bool isTypeReplayed(MessageType type) const;
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Replays every type of message, derived ones included, for when the nodes
+    ///         deriving them aren't running.
+    ///----------------------------------------------------------------------------------
+    void replayAllTypes();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Stops a replay that is running on another thread.
+    ///----------------------------------------------------------------------------------
+    void stop() { m_Running.store(false); }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns the number of messages sent by the last run.
+    ///----------------------------------------------------------------------------------
+    unsigned long replayedCount() const { return m_Replayed.load(); }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns the number of records skipped by the last run.
+    ///----------------------------------------------------------------------------------
+    unsigned long skippedCount() const { return m_Skipped.load(); }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns the number of records of types which aren't replayed in the last run.
+    ///----------------------------------------------------------------------------------
+    unsigned long filteredCount() const { return m_Filtered.load(); }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns how long the last run took, until its messages were distributed.
+    ///----------------------------------------------------------------------------------
+    double elapsedSeconds() const { return m_ElapsedSeconds; }
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Returns the throughput of the last run in messages per second.
+    ///----------------------------------------------------------------------------------
+    double messagesPerSecond() const;
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Rebuilds a message from its serialised form, returns NULL if the message type
+    ///         can't be deserialised or the data is invalid.
+    ///----------------------------------------------------------------------------------
+    static MessagePtr createMessage(uint8_t* data, uint8_t size);
+
+   private:
+    ///----------------------------------------------------------------------------------
+    /// @brief Reads the next record of the journal, data needs to hold MAX_MESSAGE_SIZE
+    ///         bytes. Returns false at the end of the journal.
+    ///----------------------------------------------------------------------------------
+    bool readRecord(uint64_t& timeStamp, uint8_t* data, uint8_t& size);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Waits until a lane of the message bus has room, so that replaying as fast as
+    ///         possible doesn't make the message bus drop messages.
+    ///----------------------------------------------------------------------------------
+    void waitForRoom(MessageLane lane);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Waits until count more replayed messages have left the message bus queues
+    ///         than when the run began. Only the messages sent by the replay are counted,
+    ///         the ones the nodes derive from them aren't, and the ones the message bus
+    ///         dropped are counted as soon as they are dropped.
+    ///----------------------------------------------------------------------------------
+    void waitForDistribution(unsigned long startCount, unsigned long count);
+
+    MessageBus& m_MsgBus;
+    FILE* m_File;
+    std::atomic<bool> m_Running;
+    std::atomic<unsigned long> m_Replayed;
+    std::atomic<unsigned long> m_Skipped;
+    std::atomic<unsigned long> m_Filtered;
+    bool m_ReplayedTypes[MESSAGE_TYPE_COUNT];
+    double m_ElapsedSeconds;
+};
+
+#endif /* MESSAGEREPLAY_HPP */
@@ -0,0 +1,79 @@
+/**
+ * @file    MessageTrace.hpp
+ *
+ * @brief   The trace information carried by every message, used to measure how long data
+ *          takes to travel through a chain of nodes.
+ *
+ * @details     Each message gets a unique id and the time it was created. A message created
+ *              while a node processes another message, on the same thread, records that
+ *              message as its parent and inherits the creation time of the first message of
+ *              the chain, its origin. Nodes which send their messages from their own thread
+ *              loop link them with Message::setParent() instead.
+ *
+ *              The message bus stamps the time a message is sent and dispatched, the time it
+ *              is consumed by each node is recorded by the LatencyTracer.
+ *
+ *              All the times are in microseconds of a monotonic clock, they can only be
+ *              compared with each other.
+ *
+ */
+
+#ifndef MESSAGETRACE_HPP
+#define MESSAGETRACE_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+
+struct MessageTrace {
+    MessageTrace() : id(0), parentId(0), originUs(0), createdUs(0), sentUs(0), dispatchedUs(0), replayed(false) {}
+
+    uint64_t id;            ///< Unique id of the message
+    uint64_t parentId;      ///< Id of the message which caused this one, 0 for none
+    uint64_t originUs;      ///< Creation time of the first message of the chain
+    uint64_t createdUs;
+    uint64_t sentUs;        ///< 0 until the message is sent
+    uint64_t dispatchedUs;  ///< 0 until the dispatch loop distributes the message
+    bool replayed;          ///< Sent by a MessageReplay rather than a node
+};
+
+///----------------------------------------------------------------------------------
+/// @brief Returns the current time of the trace clock in microseconds.
+///----------------------------------------------------------------------------------
+inline uint64_t traceTimeUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+///----------------------------------------------------------------------------------
+/// @brief Returns a new message id, ids start at 1.
+///----------------------------------------------------------------------------------
+inline uint64_t nextTraceId() {
+    static std::atomic<uint64_t> s_NextId(1);
+    return s_NextId++;
+}
+
+///----------------------------------------------------------------------------------
+/// @brief Returns the trace of the message the calling thread is processing, NULL when
+///         it isn't processing one.
+///----------------------------------------------------------------------------------
+inline const MessageTrace*& currentTrace() {
+    static thread_local const MessageTrace* s_Current = nullptr;
+    return s_Current;
+}
+
+///----------------------------------------------------------------------------------
+/// @brief Marks a message as being processed by the calling thread for the lifetime of
+///         the scope, so that the messages created meanwhile are linked to it.
+///----------------------------------------------------------------------------------
+class TraceScope {
+   public:
+    TraceScope(const MessageTrace& trace) : m_Previous(currentTrace()) { currentTrace() = &trace; }
+    ~TraceScope() { currentTrace() = m_Previous; }
+
+   private:
+    const MessageTrace* m_Previous;
+};
+
+#endif /* MESSAGETRACE_HPP */
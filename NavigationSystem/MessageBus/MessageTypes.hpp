@@ -45,13 +45,19 @@ enum class MessageType {
     DataCollectionStart,
     DataCollectionStop,
     CurrentSensorData,
-    PowerOffCommand
+    PowerOffCommand,
+    NodeStalled
 };
 
+// Number of message types, keep in sync with the last entry of MessageType
+const int MESSAGE_TYPE_COUNT = static_cast<int>(MessageType::NodeStalled) + 1;
+
 inline std::string msgToString(MessageType msgType) {
     switch (msgType) {
         case MessageType::PowerOffCommand:
             return "PowerOffCommand";
+        case MessageType::NodeStalled:
+            return "NodeStalled";
         case MessageType::DataRequest:
             return "DataRequest";
         case MessageType::WindData:
@@ -54,9 +54,13 @@ enum class NodeID {
     CANAIS,
     AISProcessing,
     MarineSensorCANTransmission,
-    CANCurrentSensor
+    CANCurrentSensor,
+    Watchdog
 };
 
+// Number of node IDs, keep in sync with the last entry of NodeID
+const int NODE_ID_COUNT = static_cast<int>(NodeID::Watchdog) + 1;
+
 inline std::string nodeToString(NodeID id) {
     switch (id) {
         case NodeID::None:
@@ -131,6 +135,8 @@ inline std::string nodeToString(NodeID id) {
         case NodeID::CANArduino:
             return "CANArduino";
             break;
+        case NodeID::Watchdog:
+            return "Watchdog";
     }
     return "";
 }
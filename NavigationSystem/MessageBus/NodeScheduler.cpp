@@ -0,0 +1,368 @@
+/**
+ * @file    NodeScheduler.cpp
+ *
+ * @brief   Runs the periodic work of active nodes on a small pool of worker threads,
+ *          instead of every node sleeping on a thread of its own.
+ *
+ */
+
+#include "NodeScheduler.hpp"
+#include "../SystemServices/ClockSource.hpp"
+#include "../SystemServices/Logger.hpp"
+#include "../SystemServices/ThreadConfig.hpp"
+#include <algorithm>
+#include <limits>
+
+#define NO_DEADLINE std::numeric_limits<uint64_t>::max()
+
+
+NodeScheduler::NodeScheduler()
+	:m_CollectedTick(0), m_NextWakeUs(NO_DEADLINE), m_NextID(NO_TASK + 1), m_Running(false)
+{
+}
+
+NodeScheduler::~NodeScheduler()
+{
+	stop();
+}
+
+void NodeScheduler::start(unsigned int workerCount)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	if(m_Running)
+	{
+		return;
+	}
+
+	if(workerCount == 0)
+	{
+		workerCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	// Whatever fell due while the scheduler was stopped runs straight away
+	uint64_t now = ClockSource::current().steadyUs();
+	m_CollectedTick = std::max((uint64_t)1, now / SCHEDULER_TICK_US) - 1;
+	for(auto& slot : m_Wheel)
+	{
+		for(TaskPtr& task : slot)
+		{
+			if(task->deadlineUs <= now && not task->cancelled)
+			{
+				m_RunQueue.push_back(task);
+			}
+		}
+		slot.erase(std::remove_if(slot.begin(), slot.end(), [now](const TaskPtr& task) {
+			return task->cancelled || task->deadlineUs <= now;
+		}), slot.end());
+	}
+
+	m_Running = true;
+	m_Threads.push_back(std::thread(&NodeScheduler::timerThread, this));
+	for(unsigned int i = 0; i < workerCount; i++)
+	{
+		m_Threads.push_back(std::thread(&NodeScheduler::workerThread, this));
+	}
+}
+
+void NodeScheduler::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Running = false;
+	}
+	m_TimerWake.notify_all();
+	m_WorkReady.notify_all();
+
+	for(std::thread& thread : m_Threads)
+	{
+		thread.join();
+	}
+	m_Threads.clear();
+}
+
+TaskID NodeScheduler::schedule(const std::string& name, double periodS, std::function<void()> work,
+                               double initialDelayS)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	TaskPtr task = std::make_shared<Task>();
+	task->id = m_NextID++;
+	task->work = work;
+	task->periodUs = toMicroseconds(periodS);
+	task->deadlineUs = ClockSource::current().steadyUs() + (initialDelayS > 0 ? toMicroseconds(initialDelayS) : 0);
+	task->running = false;
+	task->cancelled = false;
+	task->statistics = LoopStatistics();
+	task->statistics.name = name;
+	task->statistics.periodS = periodS;
+
+	m_Tasks[task->id] = task;
+	insert(task);
+	return task->id;
+}
+
+void NodeScheduler::setPeriod(TaskID id, double periodS)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	auto it = m_Tasks.find(id);
+	if(it != m_Tasks.end())
+	{
+		it->second->periodUs = toMicroseconds(periodS);
+		it->second->statistics.periodS = periodS;
+	}
+}
+
+void NodeScheduler::cancel(TaskID id)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	auto it = m_Tasks.find(id);
+	if(it == m_Tasks.end())
+	{
+		return;
+	}
+
+	// Left in the wheel or the run queue, it is dropped once it comes up
+	TaskPtr task = it->second;
+	task->cancelled = true;
+	m_Tasks.erase(it);
+
+	if(task->runner != std::this_thread::get_id())
+	{
+		m_TaskDone.wait(lock, [&task]{ return not task->running; });
+	}
+	m_Retired.push_back(task->statistics);
+}
+
+unsigned int NodeScheduler::taskCount()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Tasks.size();
+}
+
+unsigned int NodeScheduler::threadCount()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Threads.size();
+}
+
+std::vector<LoopStatistics> NodeScheduler::statistics()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	std::vector<LoopStatistics> statistics(m_Retired);
+
+	for(auto& entry : m_Tasks)
+	{
+		statistics.push_back(entry.second->statistics);
+	}
+	return statistics;
+}
+
+void NodeScheduler::logStatistics()
+{
+	for(const LoopStatistics& task : statistics())
+	{
+		Logger::info("%s task: period %.0f ms, %lu runs, %lu overruns, %lu periods skipped, lateness mean %.0f us max %lu us, busy mean %.0f us max %lu us",
+			task.name.c_str(), task.periodS * 1000, (unsigned long)task.loops, (unsigned long)task.overruns,
+			(unsigned long)task.skipped, task.meanLatenessUs(), (unsigned long)task.maxLatenessUs,
+			task.meanBusyUs(), (unsigned long)task.maxBusyUs);
+	}
+}
+
+void NodeScheduler::insert(const TaskPtr& task)
+{
+	uint64_t tick = task->deadlineUs / SCHEDULER_TICK_US;
+
+	// The wheel has already gone past that slot
+	if(tick <= m_CollectedTick)
+	{
+		m_RunQueue.push_back(task);
+		m_WorkReady.notify_one();
+		return;
+	}
+
+	m_Wheel[tick % SCHEDULER_WHEEL_SLOTS].push_back(task);
+
+	if(task->deadlineUs < m_NextWakeUs)
+	{
+		m_NextWakeUs = task->deadlineUs;
+		m_TimerWake.notify_one();
+	}
+}
+
+uint64_t NodeScheduler::collectDue(uint64_t nowUs)
+{
+	uint64_t nowTick = nowUs / SCHEDULER_TICK_US;
+
+	// Past a whole turn every slot needs looking at, but only once
+	uint64_t firstTick = m_CollectedTick + 1;
+	if(nowTick >= firstTick + SCHEDULER_WHEEL_SLOTS)
+	{
+		firstTick = nowTick - SCHEDULER_WHEEL_SLOTS + 1;
+	}
+
+	for(uint64_t tick = firstTick; tick <= nowTick; tick++)
+	{
+		std::vector<TaskPtr>& slot = m_Wheel[tick % SCHEDULER_WHEEL_SLOTS];
+
+		for(size_t i = 0; i < slot.size();)
+		{
+			if(slot[i]->cancelled)
+			{
+				slot[i] = slot.back();
+				slot.pop_back();
+			}
+			else if(slot[i]->deadlineUs <= nowUs)
+			{
+				m_RunQueue.push_back(slot[i]);
+				slot[i] = slot.back();
+				slot.pop_back();
+			}
+			else
+			{
+				i++;
+			}
+		}
+	}
+
+	// The current tick isn't over, tasks due later in it are collected next time
+	if(nowTick > 0 && nowTick - 1 > m_CollectedTick)
+	{
+		m_CollectedTick = nowTick - 1;
+	}
+
+	// The first slot ahead holding a task of this turn has the earliest deadline
+	for(uint64_t tick = nowTick; tick < nowTick + SCHEDULER_WHEEL_SLOTS; tick++)
+	{
+		uint64_t earliest = NO_DEADLINE;
+		for(const TaskPtr& task : m_Wheel[tick % SCHEDULER_WHEEL_SLOTS])
+		{
+			if(task->deadlineUs / SCHEDULER_TICK_US == tick && task->deadlineUs < earliest)
+			{
+				earliest = task->deadlineUs;
+			}
+		}
+		if(earliest != NO_DEADLINE)
+		{
+			return earliest;
+		}
+	}
+
+	// Nothing due within a turn
+	uint64_t earliest = NO_DEADLINE;
+	for(auto& slot : m_Wheel)
+	{
+		for(const TaskPtr& task : slot)
+		{
+			earliest = std::min(earliest, task->deadlineUs);
+		}
+	}
+	return earliest;
+}
+
+void NodeScheduler::run(std::unique_lock<std::mutex>& lock, const TaskPtr& task)
+{
+	ClockSource& clock = ClockSource::current();
+
+	task->running = true;
+	task->runner = std::this_thread::get_id();
+
+	uint64_t startUs = clock.steadyUs();
+	uint64_t lateness = (startUs > task->deadlineUs) ? startUs - task->deadlineUs : 0;
+
+	lock.unlock();
+	task->work();
+	lock.lock();
+
+	uint64_t endUs = clock.steadyUs();
+	uint64_t busy = endUs - startUs;
+
+	task->running = false;
+	task->runner = std::thread::id();
+
+	LoopStatistics& statistics = task->statistics;
+	statistics.loops++;
+	statistics.totalLatenessUs += lateness;
+	statistics.totalBusyUs += busy;
+	statistics.maxLatenessUs = std::max(statistics.maxLatenessUs, lateness);
+	statistics.maxBusyUs = std::max(statistics.maxBusyUs, busy);
+
+	// Stay in phase, skipping the periods the run went over entirely
+	uint64_t next = task->deadlineUs + task->periodUs;
+	if(endUs > next)
+	{
+		uint64_t skipped = (endUs - next) / task->periodUs;
+		statistics.overruns++;
+		statistics.skipped += skipped;
+		next += skipped * task->periodUs;
+	}
+	task->deadlineUs = next;
+
+	m_TaskDone.notify_all();
+
+	if(not task->cancelled)
+	{
+		insert(task);
+	}
+}
+
+uint64_t NodeScheduler::toMicroseconds(double seconds)
+{
+	return (seconds > 0) ? std::max((uint64_t)1, (uint64_t)(seconds * 1000000)) : 1;
+}
+
+void NodeScheduler::timerThread()
+{
+	ThreadConfig::apply("SchedulerTimer");
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	while(m_Running)
+	{
+		ClockSource& clock = ClockSource::current();
+		uint64_t now = clock.steadyUs();
+
+		m_NextWakeUs = collectDue(now);
+		if(not m_RunQueue.empty())
+		{
+			m_WorkReady.notify_all();
+		}
+
+		if(m_NextWakeUs == NO_DEADLINE)
+		{
+			m_TimerWake.wait(lock);
+		}
+		else if(m_NextWakeUs > now)
+		{
+			clock.waitUntilUs(lock, m_TimerWake, m_NextWakeUs);
+		}
+	}
+}
+
+void NodeScheduler::workerThread()
+{
+	ThreadConfig::apply("Scheduler");
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	while(true)
+	{
+		m_WorkReady.wait(lock, [this]{ return not m_RunQueue.empty() || not m_Running; });
+
+		if(not m_Running)
+		{
+			break;
+		}
+
+		TaskPtr task = m_RunQueue.front();
+		m_RunQueue.pop_front();
+
+		if(not task->cancelled)
+		{
+			run(lock, task);
+		}
+	}
+}
@@ -0,0 +1,148 @@
+/**
+ * @file    NodeScheduler.hpp
+ *
+ * @brief   Runs the periodic work of active nodes on a small pool of worker threads,
+ *          instead of every node sleeping on a thread of its own.
+ *
+ * @details     The tasks wait in a hashed timer wheel, a ring of slots each covering one
+ *              tick, a task sitting in the slot of its deadline. The timer thread sleeps until
+ *              the earliest deadline, hands the tasks which are due to the workers and goes
+ *              back to sleep, so the scheduler wakes up once for all the tasks due at the same
+ *              tick rather than once per node.
+ *
+ *              The deadlines of a task are multiples of its period from the time it was
+ *              scheduled, like those of a FixedRateTimer. A task is never run by two workers at
+ *              once, it only goes back in the wheel once it is done. A run ending past the next
+ *              deadline is an overrun, the task is then due straight away and the periods it
+ *              missed entirely are skipped.
+ *
+ *              The time is read from the ClockSource, a simulation can run the scheduler on a
+ *              scaled or a manual clock.
+ *
+ */
+
+#ifndef NODESCHEDULER_HPP
+#define NODESCHEDULER_HPP
+
+#include "../SystemServices/Timer.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define SCHEDULER_TICK_US       5000
+#define SCHEDULER_WHEEL_SLOTS   512     // Covers about 2.5 seconds of deadlines per turn
+#define SCHEDULER_WORKERS       2       // Enough for the periodic nodes of a build
+
+typedef unsigned int TaskID;
+
+#define NO_TASK 0
+
+class NodeScheduler {
+   public:
+    NodeScheduler();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Stops the threads if they are still running.
+    ///----------------------------------------------------------------------------------
+    ~NodeScheduler();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Starts the timer thread and the workers.
+    ///
+    /// @param workerCount 		The number of worker threads, 0 uses one per core.
+    ///----------------------------------------------------------------------------------
+    void start(unsigned int workerCount);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Waits for the tasks being run and stops the threads, the tasks stay
+    ///         scheduled until the scheduler is started again.
+    ///----------------------------------------------------------------------------------
+    void stop();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Schedules a task to run every period, the first run is after the initial
+    ///         delay. Returns the ID to change or cancel the task with.
+    ///
+    /// @param name 			Names the statistics of the task.
+    ///----------------------------------------------------------------------------------
+    TaskID schedule(const std::string& name, double periodS, std::function<void()> work,
+                    double initialDelayS = 0);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Changes the period of a task, from its next deadline.
+    ///----------------------------------------------------------------------------------
+    void setPeriod(TaskID id, double periodS);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Removes a task, waiting for it to finish if it is running. A task can
+    ///         cancel itself, in which case the call returns straight away.
+    ///----------------------------------------------------------------------------------
+    void cancel(TaskID id);
+
+    unsigned int taskCount();
+    unsigned int threadCount();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief How well each task kept to its period, cancelled ones included. The busy
+    ///         time is the time a run took.
+    ///----------------------------------------------------------------------------------
+    std::vector<LoopStatistics> statistics();
+    void logStatistics();
+
+   private:
+    struct Task {
+        TaskID id;
+        std::function<void()> work;
+        uint64_t periodUs;
+        uint64_t deadlineUs;
+        bool running;
+        bool cancelled;
+        std::thread::id runner;     ///< The worker running the task
+        LoopStatistics statistics;
+    };
+    typedef std::shared_ptr<Task> TaskPtr;
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Puts a task in the slot of its deadline, the mutex needs to be held.
+    ///----------------------------------------------------------------------------------
+    void insert(const TaskPtr& task);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Moves the tasks due by now to the run queue and returns the time of the
+    ///         next deadline, the mutex needs to be held.
+    ///----------------------------------------------------------------------------------
+    uint64_t collectDue(uint64_t nowUs);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Runs a task and puts it back in the wheel, the mutex is released while the
+    ///         task runs.
+    ///----------------------------------------------------------------------------------
+    void run(std::unique_lock<std::mutex>& lock, const TaskPtr& task);
+
+    static uint64_t toMicroseconds(double seconds);
+
+    void timerThread();
+    void workerThread();
+
+    std::mutex m_Mutex;                             ///< Guards everything below
+    std::condition_variable m_TimerWake;            ///< Signalled when a deadline is brought forward
+    std::condition_variable m_WorkReady;
+    std::condition_variable m_TaskDone;
+    std::vector<TaskPtr> m_Wheel[SCHEDULER_WHEEL_SLOTS];
+    uint64_t m_CollectedTick;                       ///< The last tick the wheel was collected up to
+    uint64_t m_NextWakeUs;                          ///< When the timer thread is due to wake up
+    std::deque<TaskPtr> m_RunQueue;
+    std::map<TaskID, TaskPtr> m_Tasks;
+    std::vector<LoopStatistics> m_Retired;          ///< The statistics of the cancelled tasks
+    TaskID m_NextID;
+    bool m_Running;
+    std::vector<std::thread> m_Threads;
+};
+
+#endif /* NODESCHEDULER_HPP */
@@ -0,0 +1,241 @@
+/**
+ * @file    NodeWatchdog.cpp
+ *
+ * @brief   Notices the active nodes which have stopped making progress and publishes it
+ *          on the message bus.
+ *
+ */
+
+#include "NodeWatchdog.hpp"
+#include "../Messages/NodeStalledMsg.hpp"
+#include "../SystemServices/ClockSource.hpp"
+#include "../SystemServices/Logger.hpp"
+#include <algorithm>
+#include <mutex>
+
+#define MICRO_PER_SECOND 1000000
+
+
+struct NodeWatchdog::Entry {
+	bool used;						///< Watched or reported progress at least once
+	bool watched;
+	uint64_t deadlineUs;
+	uint64_t dueUs;					///< When the next progress is expected by
+	uint64_t lastProgressUs;
+	uint64_t recoveredAfterUs;		///< The length of a stall which just ended, 0 otherwise
+	LivenessStatistics statistics;
+};
+
+static std::mutex watchdogMutex;
+
+///----------------------------------------------------------------------------------
+/// The entry of every node by ID, guarded by watchdogMutex
+///----------------------------------------------------------------------------------
+static NodeWatchdog::Entry* entries()
+{
+	static NodeWatchdog::Entry table[NODE_ID_COUNT] = {};
+	return table;
+}
+
+static NodeWatchdog::Entry& entryOf(NodeID id)
+{
+	NodeWatchdog::Entry& entry = entries()[static_cast<int>(id)];
+
+	if(not entry.used)
+	{
+		entry.used = true;
+		entry.statistics = LivenessStatistics();
+		entry.statistics.name = nodeToString(id);
+	}
+	return entry;
+}
+
+static uint64_t toMicroseconds(double seconds)
+{
+	return (seconds > 0) ? (uint64_t)(seconds * MICRO_PER_SECOND) : 0;
+}
+
+
+NodeWatchdog::NodeWatchdog(MessageBus& msgBus, double checkPeriodS)
+	:ActiveNode(NodeID::Watchdog, msgBus), m_CheckPeriod(checkPeriodS)
+{
+}
+
+bool NodeWatchdog::init()
+{
+	return true;
+}
+
+void NodeWatchdog::start()
+{
+	runPeriodic(checkTick, m_CheckPeriod);
+}
+
+void NodeWatchdog::stop()
+{
+	stopPeriodic();
+}
+
+void NodeWatchdog::checkTick(ActiveNode* nodePtr)
+{
+	static_cast<NodeWatchdog*>(nodePtr)->checkProgress();
+}
+
+unsigned int NodeWatchdog::checkProgress()
+{
+	struct Event {
+		NodeID id;
+		uint64_t silentUs;
+		uint64_t deadlineUs;
+		bool recovered;
+	};
+	std::vector<Event> events;
+
+	{
+		std::lock_guard<std::mutex> lock(watchdogMutex);
+		uint64_t now = ClockSource::current().steadyUs();
+
+		for(int i = 0; i < NODE_ID_COUNT; i++)
+		{
+			Entry& entry = entries()[i];
+			NodeID id = static_cast<NodeID>(i);
+
+			if(not entry.watched)
+			{
+				continue;
+			}
+
+			if(entry.recoveredAfterUs > 0)
+			{
+				events.push_back({ id, entry.recoveredAfterUs, entry.deadlineUs, true });
+				entry.recoveredAfterUs = 0;
+			}
+
+			if(not entry.statistics.stalled && now > entry.dueUs)
+			{
+				entry.statistics.stalled = true;
+				entry.statistics.stalls++;
+				events.push_back({ id, now - entry.lastProgressUs, entry.deadlineUs, false });
+			}
+		}
+	}
+
+	// Sent without the lock, a node can report progress in the meantime
+	unsigned int stalled = 0;
+	for(const Event& event : events)
+	{
+		std::string name = nodeToString(event.id);
+
+		if(event.recovered)
+		{
+			Logger::info("%s has recovered after %lu ms without progress", name.c_str(),
+				(unsigned long)(event.silentUs / 1000));
+		}
+		else
+		{
+			Logger::warning("%s has made no progress for %lu ms, over its deadline of %lu ms", name.c_str(),
+				(unsigned long)(event.silentUs / 1000), (unsigned long)(event.deadlineUs / 1000));
+			stalled++;
+		}
+
+		m_MsgBus.sendMessage(std::make_unique<NodeStalledMsg>(event.id, event.silentUs / 1000,
+			event.deadlineUs / 1000, event.recovered));
+	}
+	return stalled;
+}
+
+void NodeWatchdog::watch(NodeID id, double deadlineS, double graceS)
+{
+	std::lock_guard<std::mutex> lock(watchdogMutex);
+	Entry& entry = entryOf(id);
+
+	entry.deadlineUs = toMicroseconds(deadlineS);
+	entry.statistics.deadlineS = deadlineS;
+
+	if(not entry.watched)
+	{
+		uint64_t now = ClockSource::current().steadyUs();
+
+		entry.watched = true;
+		entry.lastProgressUs = now;
+		entry.dueUs = now + toMicroseconds(graceS) + entry.deadlineUs;
+		entry.recoveredAfterUs = 0;
+		entry.statistics.stalled = false;
+	}
+}
+
+void NodeWatchdog::unwatch(NodeID id)
+{
+	std::lock_guard<std::mutex> lock(watchdogMutex);
+	Entry& entry = entries()[static_cast<int>(id)];
+
+	entry.watched = false;
+	entry.statistics.stalled = false;
+}
+
+void NodeWatchdog::reportProgress(NodeID id)
+{
+	std::lock_guard<std::mutex> lock(watchdogMutex);
+	Entry& entry = entryOf(id);
+	LivenessStatistics& statistics = entry.statistics;
+	uint64_t now = ClockSource::current().steadyUs();
+
+	if(statistics.reports > 0)
+	{
+		uint64_t interval = now - entry.lastProgressUs;
+		statistics.totalIntervalUs += interval;
+		statistics.maxIntervalUs = std::max(statistics.maxIntervalUs, interval);
+	}
+	statistics.reports++;
+
+	if(statistics.stalled)
+	{
+		// The next check publishes the recovery
+		entry.recoveredAfterUs = std::max((uint64_t)1, now - entry.lastProgressUs);
+		statistics.longestStallUs = std::max(statistics.longestStallUs, entry.recoveredAfterUs);
+		statistics.stalled = false;
+	}
+
+	entry.lastProgressUs = now;
+	entry.dueUs = now + entry.deadlineUs;
+}
+
+double NodeWatchdog::deadlineForPeriod(double periodS)
+{
+	return std::max(WATCHDOG_MISSED_PERIODS * periodS, WATCHDOG_MIN_DEADLINE);
+}
+
+std::vector<LivenessStatistics> NodeWatchdog::statistics()
+{
+	std::vector<LivenessStatistics> statistics;
+	std::lock_guard<std::mutex> lock(watchdogMutex);
+
+	for(int i = 0; i < NODE_ID_COUNT; i++)
+	{
+		if(entries()[i].used)
+		{
+			statistics.push_back(entries()[i].statistics);
+		}
+	}
+	return statistics;
+}
+
+void NodeWatchdog::reset()
+{
+	std::lock_guard<std::mutex> lock(watchdogMutex);
+
+	for(int i = 0; i < NODE_ID_COUNT; i++)
+	{
+		entries()[i] = Entry();
+	}
+}
+
+void NodeWatchdog::logStatistics()
+{
+	for(const LivenessStatistics& node : statistics())
+	{
+		Logger::info("%s progress: deadline %.0f ms, %lu reports, interval mean %.0f us max %lu us, %lu stalls, longest %lu ms",
+			node.name.c_str(), node.deadlineS * 1000, (unsigned long)node.reports, node.meanIntervalUs(),
+			(unsigned long)node.maxIntervalUs, (unsigned long)node.stalls, (unsigned long)(node.longestStallUs / 1000));
+	}
+}
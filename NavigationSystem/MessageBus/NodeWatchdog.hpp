@@ -0,0 +1,105 @@
+/**
+ * @file    NodeWatchdog.hpp
+ *
+ * @brief   Notices the active nodes which have stopped making progress, a thread blocked
+ *          on a device or a socket for instance, and publishes it on the message bus.
+ *
+ * @details     A watched node reports its progress once per loop and is given a deadline
+ *              to do it by. The watchdog checks the nodes at a fixed rate, a node gone
+ *              silent for longer than its deadline is stalled: a NodeStalled message is sent
+ *              and a warning logged, once per stall. Once the node reports progress again a
+ *              second NodeStalled message, marked as recovered, gives how long the stall
+ *              lasted.
+ *
+ *              The periodic nodes are watched and report their progress from runPeriodic,
+ *              the nodes running a loop of their own do it through watchProgress() and
+ *              reportProgress(). Stopping a node stops watching it.
+ *
+ *              The time between two reports is kept per node, the loop timings are logged
+ *              with logStatistics().
+ *
+ */
+
+#ifndef NODEWATCHDOG_HPP
+#define NODEWATCHDOG_HPP
+
+#include "ActiveNode.hpp"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define WATCHDOG_CHECK_PERIOD       0.1     // seconds
+#define WATCHDOG_MISSED_PERIODS     5       // Periods without progress before a node is stalled
+#define WATCHDOG_MIN_DEADLINE       1.0     // seconds
+
+///----------------------------------------------------------------------------------
+/// @brief How regularly a node reported its progress, the interval being the time
+///         between two reports.
+///----------------------------------------------------------------------------------
+struct LivenessStatistics {
+    std::string name;
+    double deadlineS;
+    uint64_t reports;
+    uint64_t totalIntervalUs;
+    uint64_t maxIntervalUs;
+    uint64_t stalls;
+    uint64_t longestStallUs;   // The longest a node went without progress once stalled
+    bool stalled;              // Stalled at the time of the last check
+
+    double meanIntervalUs() const { return reports > 1 ? (double)totalIntervalUs / (reports - 1) : 0; }
+};
+
+class NodeWatchdog : public ActiveNode {
+   public:
+    NodeWatchdog(MessageBus& msgBus, double checkPeriodS = WATCHDOG_CHECK_PERIOD);
+
+    bool init();
+    void start();
+    void stop();
+    void processMessage(const Message* message) {}
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Checks every watched node once, sends the NodeStalled messages and returns
+    ///         the number of nodes found stalled by this check.
+    ///----------------------------------------------------------------------------------
+    unsigned int checkProgress();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Expects progress from a node at least once per deadline, the first time
+    ///         after the grace period on top. Watching a node already watched only changes
+    ///         its deadline.
+    ///----------------------------------------------------------------------------------
+    static void watch(NodeID id, double deadlineS, double graceS = 0);
+    static void unwatch(NodeID id);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Records that a node made progress, called once per loop of the node.
+    ///----------------------------------------------------------------------------------
+    static void reportProgress(NodeID id);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief The deadline of a node looping at a period, a few periods but never less
+    ///         than WATCHDOG_MIN_DEADLINE.
+    ///----------------------------------------------------------------------------------
+    static double deadlineForPeriod(double periodS);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief The loop timings of every node which was watched or reported progress.
+    ///----------------------------------------------------------------------------------
+    static std::vector<LivenessStatistics> statistics();
+    static void logStatistics();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Forgets every node, watched or not.
+    ///----------------------------------------------------------------------------------
+    static void reset();
+
+    struct Entry;  // Defined in NodeWatchdog.cpp
+
+   private:
+    static void checkTick(ActiveNode* nodePtr);
+
+    double m_CheckPeriod;
+};
+
+#endif /* NODEWATCHDOG_HPP */
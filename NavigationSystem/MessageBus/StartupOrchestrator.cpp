@@ -0,0 +1,236 @@
+/**
+ * @file    StartupOrchestrator.cpp
+ *
+ * @brief   Initialises the nodes at startup, those which don't depend on each other at
+ *          the same time, and reports how long each of them took.
+ *
+ */
+
+#include "StartupOrchestrator.hpp"
+#include "NodeWatchdog.hpp"
+#include "../SystemServices/ClockSource.hpp"
+#include "../SystemServices/Logger.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+
+StartupOrchestrator::StartupOrchestrator()
+	:m_Remaining(0), m_StartUs(0), m_TotalUs(0)
+{
+}
+
+void StartupOrchestrator::add(Node& node, const std::string& name, NodeImportance importance,
+                              const std::vector<Node*>& dependencies)
+{
+	Entry entry;
+	entry.node = &node;
+	entry.startup = NodeStartup();
+	entry.startup.name = name;
+	entry.startup.importance = importance;
+	entry.waitingOn = 0;
+
+	size_t index = m_Entries.size();
+
+	for(Node* dependency : dependencies)
+	{
+		auto it = std::find_if(m_Entries.begin(), m_Entries.end(), [dependency](const Entry& added) {
+			return added.node == dependency;
+		});
+
+		if(it == m_Entries.end())
+		{
+			throw std::invalid_argument(name + " depends on a node which wasn't added before it");
+		}
+
+		it->dependents.push_back(index);
+		entry.waitingOn++;
+	}
+
+	m_Entries.push_back(entry);
+}
+
+bool StartupOrchestrator::initialise(unsigned int threadCount)
+{
+	if(threadCount == 0)
+	{
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	m_StartUs = ClockSource::current().steadyUs();
+	m_Remaining = m_Entries.size();
+	m_Ready.clear();
+
+	for(size_t i = 0; i < m_Entries.size(); i++)
+	{
+		if(m_Entries[i].waitingOn == 0)
+		{
+			m_Ready.push_back(i);
+		}
+	}
+
+	std::vector<std::thread> threads;
+	for(unsigned int i = 0; i < std::min<size_t>(threadCount, m_Entries.size()); i++)
+	{
+		threads.push_back(std::thread(&StartupOrchestrator::initThread, this));
+	}
+	for(std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	m_TotalUs = ClockSource::current().steadyUs() - m_StartUs;
+
+	bool success = true;
+	for(const Entry& entry : m_Entries)
+	{
+		if(not entry.startup.initialised && entry.startup.importance == NodeImportance::CRITICAL)
+		{
+			success = false;
+		}
+	}
+	return success;
+}
+
+std::vector<ActiveNode*> StartupOrchestrator::activeNodes() const
+{
+	std::vector<ActiveNode*> nodes;
+
+	for(const Entry& entry : m_Entries)
+	{
+		ActiveNode* activeNode = dynamic_cast<ActiveNode*>(entry.node);
+		if(entry.startup.initialised && activeNode != nullptr)
+		{
+			nodes.push_back(activeNode);
+		}
+	}
+	return nodes;
+}
+
+std::vector<NodeStartup> StartupOrchestrator::timings() const
+{
+	std::vector<NodeStartup> timings;
+
+	for(const Entry& entry : m_Entries)
+	{
+		timings.push_back(entry.startup);
+	}
+	return timings;
+}
+
+uint64_t StartupOrchestrator::sequentialUs() const
+{
+	uint64_t total = 0;
+
+	for(const Entry& entry : m_Entries)
+	{
+		total += entry.startup.durationUs;
+	}
+	return total;
+}
+
+void StartupOrchestrator::logTimings() const
+{
+	std::vector<NodeStartup> timings = this->timings();
+	std::stable_sort(timings.begin(), timings.end(), [](const NodeStartup& a, const NodeStartup& b) {
+		return a.durationUs > b.durationUs;
+	});
+
+	for(const NodeStartup& node : timings)
+	{
+		const char* outcome = node.initialised ? "OK" : (node.skipped ? "SKIPPED" : "FAILED");
+		Logger::info("Node: %s - init %s, started at %lu ms, took %lu ms", node.name.c_str(), outcome,
+			(unsigned long)(node.startUs / 1000), (unsigned long)(node.durationUs / 1000));
+	}
+	Logger::info("Nodes initialised in %lu ms, %lu ms one after the other", (unsigned long)(m_TotalUs / 1000),
+		(unsigned long)(sequentialUs() / 1000));
+}
+
+void StartupOrchestrator::skipDependents(size_t index, const std::string& cause)
+{
+	for(size_t dependent : m_Entries[index].dependents)
+	{
+		Entry& entry = m_Entries[dependent];
+
+		// Already skipped through another of its dependencies
+		if(entry.startup.skipped)
+		{
+			continue;
+		}
+
+		entry.startup.skipped = true;
+		m_Remaining--;
+		Logger::warning("Node: %s - init\t\t[SKIPPED], %s failed", entry.startup.name.c_str(), cause.c_str());
+		skipDependents(dependent, cause);
+	}
+}
+
+void StartupOrchestrator::initThread()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	ClockSource& clock = ClockSource::current();
+
+	while(true)
+	{
+		m_Changed.wait(lock, [this]{ return not m_Ready.empty() || m_Remaining == 0; });
+
+		if(m_Ready.empty())
+		{
+			break;
+		}
+
+		size_t index = m_Ready.front();
+		m_Ready.pop_front();
+		Entry& entry = m_Entries[index];
+
+		lock.unlock();
+
+		uint64_t startUs = clock.steadyUs();
+		bool initialised = false;
+		NodeWatchdog::watch(entry.node->nodeID(), STARTUP_INIT_DEADLINE);
+		try
+		{
+			initialised = entry.node->init();
+		}
+		catch(std::exception& e)
+		{
+			Logger::error("Node: %s - init threw: %s", entry.startup.name.c_str(), e.what());
+		}
+		NodeWatchdog::unwatch(entry.node->nodeID());
+		uint64_t endUs = clock.steadyUs();
+
+		if(initialised)
+		{
+			Logger::success("Node: %s - init\t[OK]", entry.startup.name.c_str());
+		}
+		else
+		{
+			Logger::warning("Node: %s - init\t\t[FAILED]", entry.startup.name.c_str());
+		}
+
+		lock.lock();
+
+		entry.startup.initialised = initialised;
+		entry.startup.startUs = startUs - m_StartUs;
+		entry.startup.durationUs = endUs - startUs;
+		m_Remaining--;
+
+		if(initialised)
+		{
+			for(size_t dependent : entry.dependents)
+			{
+				Entry& next = m_Entries[dependent];
+				if(--next.waitingOn == 0 && not next.startup.skipped)
+				{
+					m_Ready.push_back(dependent);
+				}
+			}
+		}
+		else
+		{
+			skipDependents(index, entry.startup.name);
+		}
+
+		m_Changed.notify_all();
+	}
+}
@@ -0,0 +1,126 @@
+/**
+ * @file    StartupOrchestrator.hpp
+ *
+ * @brief   Initialises the nodes at startup, those which don't depend on each other at
+ *          the same time, and reports how long each of them took.
+ *
+ * @details     A node is added with the nodes it depends on, it is only initialised once
+ *              they all have been successfully. The dependencies have to be added before the
+ *              node depending on them, which rules out cycles. A node whose dependency failed
+ *              isn't initialised, and counts as failed itself.
+ *
+ *              The nodes ready to be initialised are shared between a few threads, so the
+ *              startup takes about as long as the slowest chain of dependencies instead of
+ *              the sum of every init. The database handler serialises its own accesses, the
+ *              nodes reading their configuration from it are safe to initialise together.
+ *
+ *              The NodeWatchdog watches each node while it initialises, so a node blocking
+ *              in its init, on a device or a client that never comes, is reported as stalled.
+ *
+ */
+
+#ifndef STARTUPORCHESTRATOR_HPP
+#define STARTUPORCHESTRATOR_HPP
+
+#include "ActiveNode.hpp"
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define STARTUP_THREADS 4   // Most inits wait on a device or the database rather than the CPU
+#define STARTUP_INIT_DEADLINE 5.0   // seconds an init can block before the watchdog reports it
+
+enum class NodeImportance {
+    CRITICAL,
+    NOT_CRITICAL
+};
+
+///----------------------------------------------------------------------------------
+/// @brief The outcome of the init of a node, the times are from the start of the
+///         initialisation.
+///----------------------------------------------------------------------------------
+struct NodeStartup {
+    std::string name;
+    NodeImportance importance;
+    bool initialised;
+    bool skipped;           // Not initialised as a dependency failed
+    uint64_t startUs;
+    uint64_t durationUs;
+};
+
+class StartupOrchestrator {
+   public:
+    StartupOrchestrator();
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Adds a node to initialise once the nodes it depends on are.
+    ///
+    /// @param name 			A name of the node, for logging purposes.
+    /// @param importance 		If a critical node fails to initialise, initialise()
+    ///							returns false.
+    /// @param dependencies 	Nodes added already, throws std::invalid_argument otherwise.
+    ///----------------------------------------------------------------------------------
+    void add(Node& node, const std::string& name, NodeImportance importance,
+             const std::vector<Node*>& dependencies = std::vector<Node*>());
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Initialises every node added, returns false if a critical node failed.
+    ///         Nodes without a critical failure on their way are all initialised anyway.
+    ///
+    /// @param threadCount 		The number of nodes initialised at a time, 0 uses one
+    ///							per core.
+    ///----------------------------------------------------------------------------------
+    bool initialise(unsigned int threadCount = STARTUP_THREADS);
+
+    ///----------------------------------------------------------------------------------
+    /// @brief The active nodes which initialised successfully, in the order they were
+    ///         added.
+    ///----------------------------------------------------------------------------------
+    std::vector<ActiveNode*> activeNodes() const;
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Every node in the order they were added.
+    ///----------------------------------------------------------------------------------
+    std::vector<NodeStartup> timings() const;
+
+    ///----------------------------------------------------------------------------------
+    /// @brief How long the initialisation took, and how long the inits would have taken
+    ///         one after the other.
+    ///----------------------------------------------------------------------------------
+    uint64_t totalUs() const { return m_TotalUs; }
+    uint64_t sequentialUs() const;
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Logs the outcome and the time of each init, slowest first.
+    ///----------------------------------------------------------------------------------
+    void logTimings() const;
+
+   private:
+    struct Entry {
+        Node* node;
+        NodeStartup startup;
+        std::vector<size_t> dependents;
+        unsigned int waitingOn;             ///< Dependencies not initialised yet
+    };
+
+    ///----------------------------------------------------------------------------------
+    /// @brief Marks the nodes depending on a failed one as skipped, and those depending
+    ///         on them, the mutex needs to be held.
+    ///----------------------------------------------------------------------------------
+    void skipDependents(size_t index, const std::string& cause);
+
+    void initThread();
+
+    std::vector<Entry> m_Entries;
+    std::deque<size_t> m_Ready;                 ///< Nodes whose dependencies are all initialised
+    size_t m_Remaining;                         ///< Nodes neither initialised nor skipped yet
+    uint64_t m_StartUs;
+    uint64_t m_TotalUs;
+    std::mutex m_Mutex;                         ///< Guards the above while initialising
+    std::condition_variable m_Changed;
+};
+
+#endif /* STARTUPORCHESTRATOR_HPP */
@@ -0,0 +1,64 @@
+/**
+ * @file   NodeStalledMsg.hpp
+ *
+ * @brief  Sent by the watchdog when a node has made no progress for longer than its
+ *         deadline, and again once the node has recovered.
+ *
+ */
+
+#ifndef NODESTALLEDMSG_HPP
+#define NODESTALLEDMSG_HPP
+
+#include "../MessageBus/Message.hpp"
+
+class NodeStalledMsg : public Message {
+public:
+    NodeStalledMsg(NodeID destinationID, NodeID sourceID, NodeID stalledNode,
+                   uint32_t silentMs, uint32_t deadlineMs, bool recovered)
+    : Message(MessageType::NodeStalled, sourceID, destinationID),
+    m_StalledNode(stalledNode), m_SilentMs(silentMs), m_DeadlineMs(deadlineMs), m_Recovered(recovered) {}
+
+    NodeStalledMsg(NodeID stalledNode, uint32_t silentMs, uint32_t deadlineMs, bool recovered)
+    : Message(MessageType::NodeStalled, NodeID::Watchdog, NodeID::None),
+    m_StalledNode(stalledNode), m_SilentMs(silentMs), m_DeadlineMs(deadlineMs), m_Recovered(recovered) {}
+
+    NodeStalledMsg(MessageDeserialiser deserialiser) : Message(deserialiser) {
+        if (!deserialiser.readNodeID(m_StalledNode) ||
+            !deserialiser.readUint32_t(m_SilentMs) ||
+            !deserialiser.readUint32_t(m_DeadlineMs) ||
+            !deserialiser.readBool(m_Recovered)) {
+            m_valid = false;
+        }
+    }
+
+    virtual ~NodeStalledMsg() {}
+
+    ///---------------------------------------------------------------------------
+    /// @brief Serialises the message into a MessageSerialiser
+    ///---------------------------------------------------------------------------
+    virtual void Serialise(MessageSerialiser& serialiser) const {
+        Message::Serialise(serialiser);
+        serialiser.serialise(m_StalledNode);
+        serialiser.serialise(m_SilentMs);
+        serialiser.serialise(m_DeadlineMs);
+        serialiser.serialise(m_Recovered);
+    }
+
+    NodeID stalledNode() const { return m_StalledNode; }
+
+    ///---------------------------------------------------------------------------
+    /// @brief How long the node had gone without progress, when it stalled or for the
+    ///         whole stall once it has recovered.
+    ///---------------------------------------------------------------------------
+    uint32_t silentMs() const { return m_SilentMs; }
+    uint32_t deadlineMs() const { return m_DeadlineMs; }
+    bool recovered() const { return m_Recovered; }
+
+private:
+    NodeID m_StalledNode;
+    uint32_t m_SilentMs;
+    uint32_t m_DeadlineMs;
+    bool m_Recovered;
+};
+
+#endif /* NODESTALLEDMSG_HPP */
@@ -52,24 +52,24 @@ bool LineFollowNode::init()
 ///----------------------------------------------------------------------------------
 void LineFollowNode::start()
 {
-    m_Running.store(true);
-    runThread(LineFollowNodeThreadFunc);
+    runPeriodic(LineFollowNodeTick, m_LoopTime, INITIAL_SLEEP / 1000.0);
 }
 
 ///----------------------------------------------------------------------------------
 void LineFollowNode::stop()
 {
-    m_Running.store(false);
-    stopThread(this);
+    stopPeriodic();
 }
 
 ///----------------------------------------------------------------------------------
 void LineFollowNode::updateConfigsFromDB()
 {
-    m_LoopTime = m_db.retrieveCellAsDouble("config_line_follow","1","loop_time");
-    m_CloseHauledAngle = Utility::degreeToRadian(m_db.retrieveCellAsDouble("config_line_follow","1","close_hauled_angle"));
-    m_BroadReachAngle = Utility::degreeToRadian(m_db.retrieveCellAsDouble("config_line_follow","1","broad_reach_angle"));
-    m_TackingDistance = m_db.retrieveCellAsDouble("config_line_follow","1","tacking_distance");
+    std::shared_ptr<const ConfigSnapshot> configs = m_db.configs();
+    m_LoopTime = configs->getDouble("config_line_follow", "loop_time");
+    setPeriod(m_LoopTime);
+    m_CloseHauledAngle = Utility::degreeToRadian(configs->getDouble("config_line_follow", "close_hauled_angle"));
+    m_BroadReachAngle = Utility::degreeToRadian(configs->getDouble("config_line_follow", "broad_reach_angle"));
+    m_TackingDistance = configs->getDouble("config_line_follow", "tacking_distance");
 }
 
 ///----------------------------------------------------------------------------------
@@ -273,26 +273,16 @@ void LineFollowNode::ifBoatPassedOrEnteredWP_setPrevWPToBoatPos()
 }
 
 ///----------------------------------------------------------------------------------
-void LineFollowNode::LineFollowNodeThreadFunc(ActiveNode* nodePtr)
+void LineFollowNode::LineFollowNodeTick(ActiveNode* nodePtr)
 {
-    Logger::info("LineFollowNode thread has started");
     LineFollowNode* node = dynamic_cast<LineFollowNode*> (nodePtr);
-    std::this_thread::sleep_for(std::chrono::milliseconds( INITIAL_SLEEP ));
 
-    Timer timer;
-    timer.start();
-
-    while(node->m_Running.load() == true)
+    node->ifBoatPassedOrEnteredWP_setPrevWPToBoatPos();
+    double targetCourse = node->calculateTargetCourse();
+    if (targetCourse != DATA_OUT_OF_RANGE)
     {
-        node->ifBoatPassedOrEnteredWP_setPrevWPToBoatPos();
-        double targetCourse = node->calculateTargetCourse();
-        if (targetCourse != DATA_OUT_OF_RANGE)
-        {
-            bool targetTackStarboard = node->getTargetTackStarboard(targetCourse);
-            MessagePtr LocalNavMsg = std::make_unique<LocalNavigationMsg>((float) targetCourse, NO_COMMAND, node->m_BeatingMode, targetTackStarboard);
-            node->m_MsgBus.sendMessage( std::move( LocalNavMsg ) );
-        }
-        timer.sleepUntil(node->m_LoopTime);
-        timer.reset();
+        bool targetTackStarboard = node->getTargetTackStarboard(targetCourse);
+        MessagePtr LocalNavMsg = std::make_unique<LocalNavigationMsg>((float) targetCourse, NO_COMMAND, node->m_BeatingMode, targetTackStarboard);
+        node->m_MsgBus.sendMessage( std::move( LocalNavMsg ) );
     }
 }
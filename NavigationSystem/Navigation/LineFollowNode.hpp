@@ -87,13 +87,12 @@ class LineFollowNode : public ActiveNode {
     void ifBoatPassedOrEnteredWP_setPrevWPToBoatPos();
 
     ///----------------------------------------------------------------------------------
-    /// @brief Starts the LineFollowNode's thread that pumps out LocalNavigationMsg.
+    /// @brief Pumps out a LocalNavigationMsg, every loop time.
     ///----------------------------------------------------------------------------------
-    static void LineFollowNodeThreadFunc(ActiveNode* nodePtr);
+    static void LineFollowNodeTick(ActiveNode* nodePtr);
 
     DBHandler& m_db;
     std::mutex m_lock;
-    std::atomic<bool> m_Running;
 
     double m_LoopTime;  // seconds
 
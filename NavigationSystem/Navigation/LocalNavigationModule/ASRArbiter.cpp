@@ -14,6 +14,7 @@
 
 
 #include "ASRArbiter.h"
+#include "../SystemServices/Logger.hpp"
 #include <iostream>
 
 
@@ -50,7 +51,7 @@ const uint16_t ASRArbiter::getWinner() const
 
     
 
-    printf("Winning Course: %d With Votes: %d\n", highestIndex, highestValue);
+    LOG_LIMITED(LogLevel::Info, "Winning Course: %d With Votes: %d", highestIndex, highestValue);
 
     return highestIndex;
 }
@@ -14,6 +14,7 @@
 
 
 #include "LocalNavigationModule.h"
+#include "../SystemServices/ClockSource.hpp"
 #include "../Messages/LocalNavigationMsg.h"
 #include "../Messages/StateMessage.h"
 #include "../Messages/WindStateMsg.hpp"
@@ -77,7 +78,8 @@ void LocalNavigationModule::stop()
 
 ///----------------------------------------------------------------------------------
 void LocalNavigationModule::updateConfigsFromDB(){
-    m_LoopTime = m_db.retrieveCellAsDouble("config_voter_system","1","loop_time");
+    std::shared_ptr<const ConfigSnapshot> configs = m_db.configs();
+    m_LoopTime = configs->getDouble("config_voter_system", "loop_time");
 }
 
 ///----------------------------------------------------------------------------------
@@ -166,17 +168,17 @@ void LocalNavigationModule::startBallot()
         arbiter.castVote( voter->weight(), voter->vote( boatState ) );
     }
 
-    printf("[Voters] "); // Debug
+    // Debug: Prints out some voting information, as one record so the logger can fold repeats
+    std::string ballots;
     for( it = voters.begin(); it != voters.end(); it++ )
     {
         ASRVoter* voter = (*it);
         int16_t votes = 0;
         uint16_t bestCourse = voter->getBestCourse(votes);
 
-        std::string name = voter->getName();
-        printf("%s : %d %d ", name.c_str(), bestCourse, votes); // Debug: Prints out some voting information
+        ballots += voter->getName() + " : " + std::to_string(bestCourse) + " " + std::to_string(votes) + " ";
     }
-    printf("\n");
+    LOG_LIMITED(LogLevel::Info, "[Voters] %s", ballots.c_str());
 
     uint16_t targetCourse = arbiter.getWinner();
     bool targetTackStarboard = getTargetTackStarboard((double) targetCourse);
@@ -205,10 +207,11 @@ void LocalNavigationModule::WakeupThreadFunc( ActiveNode* nodePtr )
 
 	// An initial sleep, its purpose is to ensure that most if not all the sensor data arrives
 	// at the start before we send out the vessel state message.
-	std::this_thread::sleep_for( std::chrono::milliseconds( INTIAL_SLEEP ) );
+	ClockSource::current().sleepForMs(INTIAL_SLEEP);
 
-    Timer timer;
+    FixedRateTimer timer("LocalNavigation");
     timer.start();
+    node->watchLoop(node->m_LoopTime);
 
     while(node->m_Running.load() == true)
 	{
@@ -216,8 +219,8 @@ void LocalNavigationModule::WakeupThreadFunc( ActiveNode* nodePtr )
 		node->m_MsgBus.sendMessage( std::move( courseRequest ) );
 
         // Controls how often we pump out messages
-        timer.sleepUntil(node->m_LoopTime);
-        timer.reset();
+        node->reportProgress();
+        timer.sleepUntilNext(node->m_LoopTime);
 	}
 }
 
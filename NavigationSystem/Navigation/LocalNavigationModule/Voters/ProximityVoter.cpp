@@ -73,8 +73,8 @@ const ASRCourseBallot& ProximityVoter::vote( const BoatState_t& boatState )
             minBearing = i;
         }
     }
-    Logger::info("Max vote: %d Min vote: %d", maxVote, minVote);
-    Logger::info("Max bearing: %d Min bearing: %d", maxBearing, minBearing);
+    LOG_LIMITED(LogLevel::Info, "Max vote: %d Min vote: %d", maxVote, minVote);
+    LOG_LIMITED(LogLevel::Info, "Max bearing: %d Min bearing: %d", maxBearing, minBearing);
 
  
     //Logger::info("Lifetime Closest: %f Closest: %f", lifeTimeClosest, currClosest);
@@ -83,7 +83,7 @@ const ASRCourseBallot& ProximityVoter::vote( const BoatState_t& boatState )
     std::vector<float> trueWindBuffer;
     uint16_t twd = Utility::getTrueWindDirection(boatState.windDir, boatState.windSpeed,
                 boatState.speed, boatState.heading, trueWindBuffer, 1);
-    Logger::info("True wind dir: %d", twd);
+    LOG_LIMITED(LogLevel::Info, "True wind dir: %d", twd);
 
     // Set 0 to courses into the no go zone.
     for( int i = 0; i < 45; i+= ASRCourseBallot::COURSE_RESOLUTION )
@@ -114,7 +114,7 @@ void ProximityVoter::avoidOutsideVisualField( int16_t visibleFieldLowBearingLimi
     const auto outsideAvoidanceFactor = 0.1;
     auto vote = courseBallot.maxVotes();
     // less votes for courses where we don't see
-    Logger::info("less votes from %d to %d", visibleFieldHighBearingLimit, 
+    LOG_LIMITED(LogLevel::Info, "less votes from %d to %d", visibleFieldHighBearingLimit, 
         visibleFieldLowBearingLimit + 360);
     for (auto i = visibleFieldHighBearingLimit; i<visibleFieldLowBearingLimit + 360; ++i)
     {
@@ -132,7 +132,7 @@ void ProximityVoter::bearingAvoidanceSmoothed( int16_t bearing, uint16_t relativ
     auto normalizedVoteAdjust = 3.0*(100.0 - relativeFreeDistance)/(100.0 * avoidanceNormalization);
 
     if (relativeFreeDistance < 100){
-        Logger::info("Decreasing votes around bearing %d with %f", bearing, vote*normalizedVoteAdjust);
+        LOG_LIMITED(LogLevel::Info, "Decreasing votes around bearing %d with %f", bearing, vote*normalizedVoteAdjust);
     }
     courseBallot.add(bearing, -vote * normalizedVoteAdjust);
     for(uint16_t j = 1; j < avoidanceBearingRange; j++)
@@ -155,7 +155,7 @@ void ProximityVoter::bearingPreferenceSmoothed( int16_t bearing, uint16_t relati
     auto normalizedVoteAdjustPort = portAvoidanceFactor * 3.0*(100.0 - relativeFreeDistance)/(100.0 * preferenceNormalization);
 
     if (relativeFreeDistance < 100){
-        Logger::info("Increasing votes around bearing %d with %f", bearing + giveWayAngleStarboard, vote*normalizedVoteAdjustStarboard);        
+        LOG_LIMITED(LogLevel::Info, "Increasing votes around bearing %d with %f", bearing + giveWayAngleStarboard, vote*normalizedVoteAdjustStarboard);        
     }
     courseBallot.add(bearing + giveWayAngleStarboard, vote * normalizedVoteAdjustStarboard);
     courseBallot.add(bearing + giveWayAnglePort, vote * normalizedVoteAdjustPort);
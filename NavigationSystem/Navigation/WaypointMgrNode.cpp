@@ -123,8 +123,6 @@ void WaypointMgrNode::sendMessage()
         m_routeTime.stop();
         exit(EXIT_FAILURE);
     }
-
-    m_db.forceUnlock();
 }
 
 bool WaypointMgrNode::harvestWaypoint()
@@ -154,7 +154,7 @@ void TCPServer::acceptConnections() {
         eventCount = select(highestFD + 1, &tmp, NULL, NULL, &timeout);
 
         if (eventCount == -1) {
-            Logger::error("Failed to process server socket events!");
+            LOG_LIMITED(LogLevel::Error, "Failed to process server socket events!");
         }
 
         // Check the listener socket, this would be a incoming connection.
@@ -224,8 +224,7 @@ int TCPServer::readPacket(TCPPacket_t& packet, uint32_t timeout) {
 
                         return 1;
                     } else {
-                        Logger::info("invalid packet, length: %i", length);
-                        Logger::info("invalid packet, bytes read: %i", bytesRead);
+                        LOG_LIMITED(LogLevel::Info, "invalid packet, length: %i, bytes read: %i", length, bytesRead);
                     }
                 }
             }
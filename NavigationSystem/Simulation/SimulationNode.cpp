@@ -84,7 +84,7 @@ bool SimulationNode::init() {
     if (rc > 0) {
         Logger::info("Waiting for simulation client...\n");
 
-        // Block until connection, don't timeout
+        // Block until connection, don't timeout, the watchdog reports a simulator slow to connect
         server.acceptConnection(0);
 
         success = true;
@@ -374,5 +374,7 @@ void SimulationNode::SimulationThreadFunc(ActiveNode* nodePtr)
 
         node->sendWaypoint(simulatorFD);
         // node->sendMarineSensor( simulatorFD );
+
+        node->reportProgress();
     }
 }
@@ -0,0 +1,200 @@
+/**
+ * @file   ClockSource.cpp
+ * @version 1.0.0
+ * @author SailingRobots team
+ * @date   2017
+ * @brief  The clock SysClock and Timer read the time from and sleep on.
+ *
+ */
+
+#include "ClockSource.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#define MICROSECONDS_SINCE_EPOCH(clock) \
+    static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>( \
+        clock::now().time_since_epoch()).count())
+
+#define MANUAL_CLOCK_POLL_MS 1
+
+// NULL while the real clock is in use, which is then safe to read during static init
+static std::atomic<ClockSource*> currentClock(nullptr);
+
+
+ClockSource& ClockSource::current()
+{
+    ClockSource* clock = currentClock.load(std::memory_order_acquire);
+    return clock != nullptr ? *clock : real();
+}
+
+void ClockSource::use(ClockSource* clock)
+{
+    currentClock.store(clock, std::memory_order_release);
+}
+
+ClockSource& ClockSource::real()
+{
+    static RealClock realClock;
+    return realClock;
+}
+
+///////////////////// RealClock /////////////////////
+
+uint64_t RealClock::wallUs()
+{
+    return MICROSECONDS_SINCE_EPOCH(std::chrono::system_clock);
+}
+
+uint64_t RealClock::steadyUs()
+{
+    return MICROSECONDS_SINCE_EPOCH(std::chrono::steady_clock);
+}
+
+void RealClock::sleepUntilUs(uint64_t steadyDeadlineUs)
+{
+    uint64_t now = steadyUs();
+    if (steadyDeadlineUs > now)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(steadyDeadlineUs - now));
+    }
+}
+
+void RealClock::waitUntilUs(std::unique_lock<std::mutex>& lock, std::condition_variable& wake,
+                            uint64_t steadyDeadlineUs)
+{
+    std::chrono::steady_clock::time_point deadline{std::chrono::microseconds(steadyDeadlineUs)};
+    wake.wait_until(lock, deadline);
+}
+
+///////////////////// ScaledClock /////////////////////
+
+ScaledClock::ScaledClock(double factor)
+    : m_Factor(factor > 0 ? factor : 1.0)
+{
+    m_WallOriginUs = m_Real.wallUs();
+    m_SteadyOriginUs = m_Real.steadyUs();
+}
+
+uint64_t ScaledClock::wallUs()
+{
+    // The wall time moves at the same pace as the steady time
+    return m_WallOriginUs + (steadyUs() - m_SteadyOriginUs);
+}
+
+uint64_t ScaledClock::steadyUs()
+{
+    return scaled(m_SteadyOriginUs, m_Real.steadyUs());
+}
+
+void ScaledClock::sleepUntilUs(uint64_t steadyDeadlineUs)
+{
+    uint64_t now = steadyUs();
+    if (steadyDeadlineUs > now)
+    {
+        // Rounded up so that the deadline has been reached on waking up
+        uint64_t realUs = static_cast<uint64_t>((steadyDeadlineUs - now) / m_Factor) + 1;
+        m_Real.sleepForUs(realUs);
+    }
+}
+
+void ScaledClock::waitUntilUs(std::unique_lock<std::mutex>& lock, std::condition_variable& wake,
+                              uint64_t steadyDeadlineUs)
+{
+    uint64_t now = steadyUs();
+    if (steadyDeadlineUs > now)
+    {
+        uint64_t realUs = static_cast<uint64_t>((steadyDeadlineUs - now) / m_Factor) + 1;
+        wake.wait_for(lock, std::chrono::microseconds(realUs));
+    }
+}
+
+uint64_t ScaledClock::scaled(uint64_t originUs, uint64_t realUs) const
+{
+    return originUs + static_cast<uint64_t>((realUs - originUs) * m_Factor);
+}
+
+///////////////////// ManualClock /////////////////////
+
+ManualClock::ManualClock(uint64_t startWallUs)
+    : m_WallUs(startWallUs != 0 ? startWallUs : RealClock().wallUs()), m_SteadyUs(0), m_Sleepers(0)
+{
+}
+
+uint64_t ManualClock::wallUs()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_WallUs;
+}
+
+uint64_t ManualClock::steadyUs()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_SteadyUs;
+}
+
+void ManualClock::sleepUntilUs(uint64_t steadyDeadlineUs)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+
+    if (m_SteadyUs >= steadyDeadlineUs)
+    {
+        return;
+    }
+
+    m_Sleepers++;
+    m_SleepersChanged.notify_all();
+    m_Stepped.wait(lock, [this, steadyDeadlineUs]{ return m_SteadyUs >= steadyDeadlineUs; });
+    m_Sleepers--;
+    m_SleepersChanged.notify_all();
+}
+
+void ManualClock::waitUntilUs(std::unique_lock<std::mutex>& lock, std::condition_variable& wake,
+                              uint64_t steadyDeadlineUs)
+{
+    {
+        std::lock_guard<std::mutex> clockLock(m_Mutex);
+        if (m_SteadyUs >= steadyDeadlineUs)
+        {
+            return;
+        }
+        m_Sleepers++;
+        m_SleepersChanged.notify_all();
+    }
+
+    // Stepping the clock doesn't notify the waiter, poll it
+    wake.wait_for(lock, std::chrono::milliseconds(MANUAL_CLOCK_POLL_MS));
+
+    std::lock_guard<std::mutex> clockLock(m_Mutex);
+    m_Sleepers--;
+    m_SleepersChanged.notify_all();
+}
+
+void ManualClock::advanceUs(uint64_t microseconds)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_SteadyUs += microseconds;
+        m_WallUs += microseconds;
+    }
+    m_Stepped.notify_all();
+}
+
+void ManualClock::setWallUs(uint64_t wallUs)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_WallUs = wallUs;
+}
+
+unsigned int ManualClock::sleepers()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Sleepers;
+}
+
+bool ManualClock::waitForSleepers(unsigned int count, unsigned int timeoutMs)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    return m_SleepersChanged.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                                      [this, count]{ return m_Sleepers >= count; });
+}
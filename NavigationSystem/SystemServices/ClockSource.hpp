@@ -0,0 +1,165 @@
+/**
+ * @file   ClockSource.hpp
+ * @version 1.0.0
+ * @author SailingRobots team
+ * @date   2017
+ * @brief  The clock SysClock and Timer read the time from and sleep on. It is the real
+ *         clock unless a scaled clock, running faster or slower than real time, or a
+ *         manual clock, stepped by a test or a simulator, is put in its place.
+ *
+ * Developer Notes:
+ *         The clock in use is switched with ClockSource::use(), best before the nodes are
+ *         started as a thread already sleeping keeps sleeping on the clock it started on.
+ *         A clock has to outlive its use, switch back to the real clock before deleting it.
+ *
+ *         A thread sleeping on a manual clock only wakes up once the clock has been
+ *         stepped past its deadline, the clock never moves on its own. Stopping a node
+ *         which sleeps on it therefore needs the clock to be stepped as well. A wait on
+ *         a condition variable can't be woken up by the manual clock, it polls instead.
+ *
+ */
+
+#ifndef CLOCKSOURCE_HPP
+#define CLOCKSOURCE_HPP
+
+#include <stdint.h>
+#include <condition_variable>
+#include <mutex>
+
+class ClockSource {
+   public:
+    virtual ~ClockSource() {}
+
+    ///----------------------------------------------------------------------------------
+    /// Returns the wall clock time, in microseconds since the unix epoch.
+    ///----------------------------------------------------------------------------------
+    virtual uint64_t wallUs() = 0;
+
+    ///----------------------------------------------------------------------------------
+    /// Returns the monotonic time in microseconds, only meaningful as a difference.
+    ///----------------------------------------------------------------------------------
+    virtual uint64_t steadyUs() = 0;
+
+    ///----------------------------------------------------------------------------------
+    /// Blocks the calling thread until steadyUs() reaches the deadline, returns straight
+    /// away if it already has.
+    ///----------------------------------------------------------------------------------
+    virtual void sleepUntilUs(uint64_t steadyDeadlineUs) = 0;
+
+    ///----------------------------------------------------------------------------------
+    /// Waits on a condition variable until it is notified or steadyUs() reaches the
+    /// deadline, for a thread which has to be woken up before its deadline. Returns with
+    /// the lock held and, like any wait on a condition variable, possibly early.
+    ///----------------------------------------------------------------------------------
+    virtual void waitUntilUs(std::unique_lock<std::mutex>& lock, std::condition_variable& wake,
+                             uint64_t steadyDeadlineUs) = 0;
+
+    ///----------------------------------------------------------------------------------
+    /// Returns true if the clock follows the system clock, in which case SysClock keeps
+    /// setting the system time when it is given the GPS time.
+    ///----------------------------------------------------------------------------------
+    virtual bool isReal() const { return false; }
+
+    void sleepForUs(uint64_t microseconds) { sleepUntilUs(steadyUs() + microseconds); }
+    void sleepForMs(uint64_t milliseconds) { sleepForUs(milliseconds * 1000); }
+
+    ///----------------------------------------------------------------------------------
+    /// Returns the clock in use.
+    ///----------------------------------------------------------------------------------
+    static ClockSource& current();
+
+    ///----------------------------------------------------------------------------------
+    /// Puts a clock in use, NULL goes back to the real clock.
+    ///----------------------------------------------------------------------------------
+    static void use(ClockSource* clock);
+
+    static ClockSource& real();
+};
+
+///----------------------------------------------------------------------------------
+/// The system clock for the wall time and the steady clock for everything else.
+///----------------------------------------------------------------------------------
+class RealClock : public ClockSource {
+   public:
+    uint64_t wallUs() override;
+    uint64_t steadyUs() override;
+    void sleepUntilUs(uint64_t steadyDeadlineUs) override;
+    void waitUntilUs(std::unique_lock<std::mutex>& lock, std::condition_variable& wake,
+                     uint64_t steadyDeadlineUs) override;
+    bool isReal() const override { return true; }
+};
+
+///----------------------------------------------------------------------------------
+/// Runs a number of times faster than the real clock, or slower with a factor under 1.
+/// Both times carry on from the real ones at the moment the clock was created.
+///----------------------------------------------------------------------------------
+class ScaledClock : public ClockSource {
+   public:
+    ScaledClock(double factor);
+
+    uint64_t wallUs() override;
+    uint64_t steadyUs() override;
+    void sleepUntilUs(uint64_t steadyDeadlineUs) override;
+    void waitUntilUs(std::unique_lock<std::mutex>& lock, std::condition_variable& wake,
+                     uint64_t steadyDeadlineUs) override;
+
+    double factor() const { return m_Factor; }
+
+   private:
+    uint64_t scaled(uint64_t originUs, uint64_t realUs) const;
+
+    double m_Factor;
+    uint64_t m_WallOriginUs;
+    uint64_t m_SteadyOriginUs;
+    RealClock m_Real;
+};
+
+///----------------------------------------------------------------------------------
+/// Only moves when it is told to.
+///----------------------------------------------------------------------------------
+class ManualClock : public ClockSource {
+   public:
+    ///----------------------------------------------------------------------------------
+    /// @param startWallUs          The wall time the clock starts at, the real one if 0.
+    ///----------------------------------------------------------------------------------
+    ManualClock(uint64_t startWallUs = 0);
+
+    uint64_t wallUs() override;
+    uint64_t steadyUs() override;
+    void sleepUntilUs(uint64_t steadyDeadlineUs) override;
+    void waitUntilUs(std::unique_lock<std::mutex>& lock, std::condition_variable& wake,
+                     uint64_t steadyDeadlineUs) override;
+
+    ///----------------------------------------------------------------------------------
+    /// Moves both times forward and wakes the threads whose deadline has come.
+    ///----------------------------------------------------------------------------------
+    void advanceUs(uint64_t microseconds);
+    void advanceMs(uint64_t milliseconds) { advanceUs(milliseconds * 1000); }
+
+    ///----------------------------------------------------------------------------------
+    /// Sets the wall time, the steady time isn't affected.
+    ///----------------------------------------------------------------------------------
+    void setWallUs(uint64_t wallUs);
+
+    ///----------------------------------------------------------------------------------
+    /// Returns the number of threads sleeping on the clock.
+    ///----------------------------------------------------------------------------------
+    unsigned int sleepers();
+
+    ///----------------------------------------------------------------------------------
+    /// Blocks until at least a number of threads are sleeping on the clock, so that a
+    /// test can step it once they are all waiting. Gives up after a timeout in real
+    /// time and returns false.
+    ///----------------------------------------------------------------------------------
+    bool waitForSleepers(unsigned int count, unsigned int timeoutMs);
+
+   private:
+    std::mutex m_Mutex;
+    std::condition_variable m_Stepped;
+    std::condition_variable m_SleepersChanged;
+    uint64_t m_WallUs;
+    uint64_t m_SteadyUs;
+    unsigned int m_Sleepers;
+};
+
+#endif /* CLOCKSOURCE_HPP */
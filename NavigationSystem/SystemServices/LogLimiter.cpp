@@ -0,0 +1,206 @@
+/****************************************************************************************
+ *
+ * File:
+ *         LogLimiter.cpp
+ *
+ * Purpose:
+ *        Keeps log storms from hot loops in check, by rate limiting each call site and
+ *        suppressing repeated identical records, which are summarised instead.
+ *
+ ***************************************************************************************/
+
+
+#include "LogLimiter.hpp"
+#include <algorithm>
+#include <chrono>
+
+
+// Only applies to the sites which opted in. Errors and warnings are never dropped, the
+// records needed to understand a degraded situation are only folded when repeated
+static const LogLimit DEFAULT_LIMITS[LOG_LIMIT_LEVELS] = {
+    { 20, 40, true },       // Info
+    { 0, 0, true },         // Error
+    { 0, 0, true },         // Warning
+    { 20, 40, true },       // Success
+};
+
+static const uint64_t NOT_HELD = UINT64_MAX;
+static const uint64_t HAS_CONTENT = (uint64_t)1 << 32;
+
+
+LogSite::LogSite(const char* file, unsigned int line)
+    :m_File(file), m_Line(line), m_Format(nullptr), m_Level(0), m_FullUs(0), m_LastContent(0), m_Repeated(0),
+     m_Limited(0), m_HeldSinceUs(NOT_HELD), m_Registered(false), m_Next(nullptr)
+{
+}
+
+
+LogLimiter::LogLimiter()
+    :m_Sites(nullptr)
+{
+    for(int i = 0; i < LOG_LIMIT_LEVELS; i++)
+    {
+        setLimit(static_cast<LogLevel>(i), DEFAULT_LIMITS[i]);
+    }
+}
+
+LogLimiter::~LogLimiter()
+{
+    // Lets the sites register with another limiter
+    reset();
+}
+
+void LogLimiter::setLimit(LogLevel level, const LogLimit& limit)
+{
+    int index = static_cast<int>(level);
+
+    m_Rate[index].store(limit.ratePerSecond);
+    m_Burst[index].store(limit.burst);
+    m_SuppressDuplicates[index].store(limit.suppressDuplicates);
+}
+
+LogLimit LogLimiter::limit(LogLevel level) const
+{
+    int index = static_cast<int>(level);
+    LogLimit limit;
+
+    limit.ratePerSecond = m_Rate[index].load();
+    limit.burst = m_Burst[index].load();
+    limit.suppressDuplicates = m_SuppressDuplicates[index].load();
+    return limit;
+}
+
+bool LogLimiter::admit(LogSite& site, LogLevel level, const char* format, uint64_t nowUs)
+{
+    int index = static_cast<int>(level);
+    unsigned int rate = m_Rate[index].load(std::memory_order_relaxed);
+    uint64_t burst = m_Burst[index].load(std::memory_order_relaxed);
+
+    if(not site.m_Registered.load(std::memory_order_acquire) && not site.m_Registered.exchange(true))
+    {
+        site.m_Next = m_Sites.load(std::memory_order_relaxed);
+        while(not m_Sites.compare_exchange_weak(site.m_Next, &site, std::memory_order_release,
+                                                std::memory_order_relaxed)) {}
+    }
+    site.m_Format.store(format, std::memory_order_relaxed);
+    site.m_Level.store(index, std::memory_order_relaxed);
+
+    if(rate == 0)
+    {
+        return true;
+    }
+
+    uint64_t interval = 1000000 / rate;
+    uint64_t full = site.m_FullUs.load(std::memory_order_relaxed);
+    uint64_t next;
+
+    do
+    {
+        next = std::max(full, nowUs) + interval;
+        if(next - nowUs > burst * interval)
+        {
+            hold(site.m_Limited, site, nowUs);
+            return false;
+        }
+    }
+    while(not site.m_FullUs.compare_exchange_weak(full, next, std::memory_order_relaxed));
+
+    return true;
+}
+
+bool LogLimiter::check(LogSite& site, uint32_t content, uint64_t nowUs, LogSummary& summary)
+{
+    int index = site.m_Level.load(std::memory_order_relaxed);
+    unsigned int rate = m_Rate[index].load(std::memory_order_relaxed);
+    uint64_t tagged = HAS_CONTENT | content;
+
+    if(m_SuppressDuplicates[index].load(std::memory_order_relaxed) &&
+       site.m_LastContent.load(std::memory_order_relaxed) == tagged)
+    {
+        hold(site.m_Repeated, site, nowUs);
+
+        // Gives back what admit() took from the bucket, a storm of duplicates mustn't hold
+        // back the next different record
+        if(rate > 0)
+        {
+            uint64_t interval = 1000000 / rate;
+            uint64_t full = site.m_FullUs.load(std::memory_order_relaxed);
+
+            while(full > nowUs && not site.m_FullUs.compare_exchange_weak(full, std::max(full - interval, nowUs),
+                                                                          std::memory_order_relaxed)) {}
+        }
+        return false;
+    }
+
+    site.m_LastContent.store(tagged, std::memory_order_relaxed);
+    takeSummary(site, summary);
+    return true;
+}
+
+void LogLimiter::collectSummaries(uint64_t nowUs, uint64_t ageUs, std::vector<LogSummary>& summaries)
+{
+    for(LogSite* site = m_Sites.load(std::memory_order_acquire); site != nullptr; site = site->m_Next)
+    {
+        uint64_t heldSinceUs = site->m_HeldSinceUs.load();
+
+        if(heldSinceUs != NOT_HELD && nowUs >= heldSinceUs + ageUs)
+        {
+            LogSummary summary;
+            takeSummary(*site, summary);
+            if(summary.pending())
+            {
+                summaries.push_back(summary);
+            }
+
+            // Lets the next record through, so a storm shows up once per interval
+            site->m_LastContent.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void LogLimiter::reset()
+{
+    LogSite* site = m_Sites.exchange(nullptr);
+
+    while(site != nullptr)
+    {
+        LogSite* next = site->m_Next;
+
+        site->m_FullUs.store(0);
+        site->m_LastContent.store(0);
+        site->m_Repeated.store(0);
+        site->m_Limited.store(0);
+        site->m_HeldSinceUs.store(NOT_HELD);
+        site->m_Next = nullptr;
+        site->m_Registered.store(false);
+        site = next;
+    }
+}
+
+uint64_t LogLimiter::nowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void LogLimiter::hold(std::atomic<unsigned int>& count, LogSite& site, uint64_t nowUs)
+{
+    count.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t notHeld = NOT_HELD;
+    site.m_HeldSinceUs.compare_exchange_strong(notHeld, nowUs);
+}
+
+void LogLimiter::takeSummary(LogSite& site, LogSummary& summary)
+{
+    // Cleared before the counts are taken, a record held back meanwhile marks the site
+    // as holding again
+    site.m_HeldSinceUs.store(NOT_HELD);
+
+    summary.level = static_cast<LogLevel>(site.m_Level.load(std::memory_order_relaxed));
+    summary.file = site.m_File;
+    summary.line = site.m_Line;
+    summary.format = site.m_Format.load(std::memory_order_relaxed);
+    summary.repeated = site.m_Repeated.exchange(0);
+    summary.limited = site.m_Limited.exchange(0);
+}
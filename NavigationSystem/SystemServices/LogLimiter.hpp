@@ -0,0 +1,152 @@
+/****************************************************************************************
+ *
+ * File:
+ *         LogLimiter.hpp
+ *
+ * Purpose:
+ *        Keeps log storms from hot loops in check, by rate limiting each call site and
+ *        suppressing repeated identical records, which are summarised instead.
+ *
+ * Developer Notes:
+ *        Only the call sites which opt in are limited, through the LOG_LIMITED macro of
+ *        Logger.hpp. The macro keeps a static LogSite per expansion, so a site is its
+ *        __FILE__ and __LINE__ and two sites never share their counts, even with the
+ *        same format string. A site registers itself with the limiter the first time it
+ *        logs, the limiter walks the registered sites to collect their summaries.
+ *
+ *        Each site is rate limited at the rate of its level, as a virtual scheduling
+ *        token bucket: the site keeps the time at which its bucket would be full again
+ *        and a record is only logged if that time isn't more than a burst ahead. A record
+ *        with the same text as the last one logged from its site is counted rather than
+ *        logged, until the text changes or the summary interval is over. The counts then
+ *        go out as a single summary line. Duplicates don't use up the bucket of their
+ *        site.
+ *
+ *        The state of a site is made of separate atomics, logging never takes a lock.
+ *        Two threads logging from the same site at the same time may both log a record
+ *        that would have been a duplicate, the counts themselves are never lost.
+ *
+ ***************************************************************************************/
+
+
+#pragma once
+
+
+#include "LogRingBuffer.hpp"
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+#define LOG_LIMIT_LEVELS            4
+#define LOG_SUMMARY_INTERVAL_MS     10000
+#define LOG_SUMMARY_FORMAT_SIZE     48      // How much of the format a summary shows
+
+
+struct LogLimit {
+    unsigned int ratePerSecond;     // 0 for no rate limit
+    unsigned int burst;             // Records logged back to back before the rate applies
+    bool suppressDuplicates;
+};
+
+
+///----------------------------------------------------------------------------------
+/// What was held back from a call site since its last record.
+///----------------------------------------------------------------------------------
+struct LogSummary {
+    LogLevel level;
+    const char* file;
+    unsigned int line;
+    const char* format;
+    unsigned int repeated;          // Duplicates of the last record
+    unsigned int limited;           // Records over the rate limit
+
+    bool pending() const { return repeated > 0 || limited > 0; }
+};
+
+
+///----------------------------------------------------------------------------------
+/// The state of a limited call site, only meant to be a static object.
+///----------------------------------------------------------------------------------
+class LogSite {
+public:
+    LogSite(const char* file, unsigned int line);
+
+    const char* file() const { return m_File; }
+    unsigned int line() const { return m_Line; }
+
+private:
+    friend class LogLimiter;
+
+    const char*                 m_File;
+    unsigned int                m_Line;
+    std::atomic<const char*>    m_Format;
+    std::atomic<int>            m_Level;
+    std::atomic<uint64_t>       m_FullUs;           // When the bucket is full again
+    std::atomic<uint64_t>       m_LastContent;      // The hash of the last record, if flagged
+    std::atomic<unsigned int>   m_Repeated;
+    std::atomic<unsigned int>   m_Limited;
+    std::atomic<uint64_t>       m_HeldSinceUs;      // When the first record held back was
+    std::atomic<bool>           m_Registered;
+    LogSite*                    m_Next;
+};
+
+
+class LogLimiter {
+public:
+    LogLimiter();
+    ~LogLimiter();
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Sets the limits applied to the call sites logging at a level.
+    /////////////////////////////////////////////////////////////////////////////////////
+    void setLimit(LogLevel level, const LogLimit& limit);
+    LogLimit limit(LogLevel level) const;
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Checks a call against the rate limit of its site before it is formatted, returns
+    /// false if it has to be dropped.
+    ///
+    /// @param format               The format string of the site, needs to outlive it.
+    ///
+    /////////////////////////////////////////////////////////////////////////////////////
+    bool admit(LogSite& site, LogLevel level, const char* format, uint64_t nowUs);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Checks a formatted record against the last one of its site, returns false if it
+    /// is a duplicate to suppress. Once a different record comes through, summary is
+    /// filled in with what was held back before it.
+    ///
+    /// @param content              The hash of the formatted record.
+    ///
+    /////////////////////////////////////////////////////////////////////////////////////
+    bool check(LogSite& site, uint32_t content, uint64_t nowUs, LogSummary& summary);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Collects the summaries of the sites which have been holding records back for
+    /// longer than ageUs, the next record of those sites is logged again.
+    /////////////////////////////////////////////////////////////////////////////////////
+    void collectSummaries(uint64_t nowUs, uint64_t ageUs, std::vector<LogSummary>& summaries);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Forgets every call site, nothing may be logging through the limiter meanwhile.
+    /////////////////////////////////////////////////////////////////////////////////////
+    void reset();
+
+    static uint64_t nowUs();
+
+private:
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Counts a record held back by a site.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static void hold(std::atomic<unsigned int>& count, LogSite& site, uint64_t nowUs);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Moves the counts of a site into a summary.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static void takeSummary(LogSite& site, LogSummary& summary);
+
+    std::atomic<LogSite*>       m_Sites;
+    std::atomic<unsigned int>   m_Rate[LOG_LIMIT_LEVELS];
+    std::atomic<unsigned int>   m_Burst[LOG_LIMIT_LEVELS];
+    std::atomic<bool>           m_SuppressDuplicates[LOG_LIMIT_LEVELS];
+};
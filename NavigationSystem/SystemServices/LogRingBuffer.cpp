@@ -0,0 +1,118 @@
+/****************************************************************************************
+ *
+ * File:
+ *         LogRingBuffer.cpp
+ *
+ * Purpose:
+ *        A bounded lock-free queue of log records, which the logging threads push into and
+ *        the logger's writer thread pops from.
+ *
+ ***************************************************************************************/
+
+
+#include "LogRingBuffer.hpp"
+#include <cstring>
+
+
+LogRingBuffer::LogRingBuffer()
+    :m_EnqueuePos(0), m_DequeuePos(0)
+{
+    for(size_t i = 0; i < LOG_RING_SIZE; i++)
+    {
+        m_Slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+LogRingBuffer::Slot* LogRingBuffer::claim(size_t& pos)
+{
+    pos = m_EnqueuePos.load(std::memory_order_relaxed);
+
+    while(true)
+    {
+        Slot* slot = &m_Slots[pos & (LOG_RING_SIZE - 1)];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        long difference = (long)sequence - (long)pos;
+
+        if(difference == 0)
+        {
+            // The slot is free for this position, try to claim it
+            if(m_EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                return slot;
+            }
+        }
+        else if(difference < 0)
+        {
+            // The writer hasn't read the record a lap ago yet, the queue is full
+            return NULL;
+        }
+        else
+        {
+            pos = m_EnqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool LogRingBuffer::push(LogLevel level, const char* text)
+{
+    size_t pos;
+    Slot* slot = claim(pos);
+
+    if(slot == NULL)
+    {
+        return false;
+    }
+
+    size_t length = strnlen(text, LOG_RECORD_SIZE - 1);
+
+    slot->record.level = level;
+    slot->record.binary = false;
+    slot->record.length = (unsigned short)length;
+    memcpy(slot->record.text, text, length);
+    slot->record.text[length] = '\0';
+
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool LogRingBuffer::push(LogLevel level, const char* data, size_t length)
+{
+    if(length > LOG_RECORD_SIZE)
+    {
+        return false;
+    }
+
+    size_t pos;
+    Slot* slot = claim(pos);
+
+    if(slot == NULL)
+    {
+        return false;
+    }
+
+    slot->record.level = level;
+    slot->record.binary = true;
+    slot->record.length = (unsigned short)length;
+    memcpy(slot->record.text, data, length);
+
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool LogRingBuffer::pop(LogRecord& record)
+{
+    size_t pos = m_DequeuePos.load(std::memory_order_relaxed);
+    Slot& slot = m_Slots[pos & (LOG_RING_SIZE - 1)];
+
+    // Not published yet
+    if(slot.sequence.load(std::memory_order_acquire) != pos + 1)
+    {
+        return false;
+    }
+
+    record = slot.record;
+
+    slot.sequence.store(pos + LOG_RING_SIZE, std::memory_order_release);
+    m_DequeuePos.store(pos + 1, std::memory_order_release);
+    return true;
+}
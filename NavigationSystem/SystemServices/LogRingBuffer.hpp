@@ -0,0 +1,90 @@
+/****************************************************************************************
+ *
+ * File:
+ *         LogRingBuffer.hpp
+ *
+ * Purpose:
+ *        A bounded lock-free queue of log records, which the logging threads push into and
+ *        the logger's writer thread pops from.
+ *
+ * Developer Notes:
+ *        Each slot carries a sequence number telling whether it is free to be written for
+ *        a given position of the queue or holds a record ready to be read. A producer claims
+ *        a position with a compare and swap and publishes the slot by bumping its sequence,
+ *        so producers never wait on each other or on the writer. When the queue is full the
+ *        push fails straight away and the record is dropped.
+ *
+ *        Only one thread may pop.
+ *
+ ***************************************************************************************/
+
+
+#pragma once
+
+
+#include <atomic>
+#include <cstddef>
+
+#define LOG_RECORD_SIZE             256
+#define LOG_RING_SIZE               1024    // Needs to be a power of two
+
+
+enum class LogLevel { Info, Error, Warning, Success };
+
+
+struct LogRecord {
+    LogLevel level;
+    bool binary;                    // A structured record, see StructuredLog.hpp
+    unsigned short length;
+    char text[LOG_RECORD_SIZE];     // Null terminated unless binary
+};
+
+
+class LogRingBuffer {
+public:
+    LogRingBuffer();
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Copies a record into the queue, returns false if the queue is full. Safe to call
+    /// from any number of threads.
+    ///
+    /// @param level                The level of the record.
+    /// @param text                 The formatted log line, truncated to LOG_RECORD_SIZE.
+    ///
+    /////////////////////////////////////////////////////////////////////////////////////
+    bool push(LogLevel level, const char* text);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Copies a binary record into the queue, returns false if the queue is full or the
+    /// record is longer than LOG_RECORD_SIZE.
+    /////////////////////////////////////////////////////////////////////////////////////
+    bool push(LogLevel level, const char* data, size_t length);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Copies the oldest record out of the queue, returns false if there is none.
+    /////////////////////////////////////////////////////////////////////////////////////
+    bool pop(LogRecord& record);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// The number of records pushed and popped so far.
+    /////////////////////////////////////////////////////////////////////////////////////
+    size_t pushedCount() const { return m_EnqueuePos.load(std::memory_order_acquire); }
+    size_t poppedCount() const { return m_DequeuePos.load(std::memory_order_acquire); }
+
+    size_t size() const { return pushedCount() - poppedCount(); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+    };
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Claims the slot of the next position, returns NULL if the queue is full.
+    /////////////////////////////////////////////////////////////////////////////////////
+    Slot* claim(size_t& pos);
+
+    Slot                        m_Slots[LOG_RING_SIZE];
+    std::atomic<size_t>         m_EnqueuePos;
+    std::atomic<size_t>         m_DequeuePos;
+};
@@ -0,0 +1,418 @@
+/****************************************************************************************
+ *
+ * File:
+ *         LogRotator.cpp
+ *
+ * Purpose:
+ *        Rotates a log file once it gets too big or too old, compresses the rotated
+ *        segments on a low priority thread and deletes the oldest files once the total
+ *        size retained goes over a cap.
+ *
+ ***************************************************************************************/
+
+
+#include "LogRotator.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define COMPRESS_CHUNK_SIZE     (64 * 1024)
+
+
+LogRotator::LogRotator(const RotationPolicy& policy)
+    :m_Policy(policy), m_OpenedAt(0), m_NextSegment(1), m_Busy(false), m_Running(false)
+{
+}
+
+LogRotator::~LogRotator()
+{
+    stop();
+}
+
+void LogRotator::setPolicy(const RotationPolicy& policy)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Policy = policy;
+}
+
+RotationPolicy LogRotator::policy()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Policy;
+}
+
+void LogRotator::opened(const std::string& path, const std::string& family)
+{
+    std::vector<std::string> leftOver;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        m_Path = path;
+        size_t slash = path.find_last_of('/');
+        m_Directory = (slash == std::string::npos) ? "." : path.substr(0, slash);
+        m_FileName = (slash == std::string::npos) ? path : path.substr(slash + 1);
+        m_Family = family.empty() ? m_FileName : family;
+        m_OpenedAt = time(NULL);
+        m_NextSegment = 1;
+
+        for(const FileInfo& file : familyFiles())
+        {
+            std::string name = file.path.substr(file.path.find_last_of('/') + 1);
+            bool compressed;
+
+            // Carry on numbering after the segments already there
+            unsigned int number = segmentNumber(name, m_FileName, compressed);
+            if(number >= m_NextSegment)
+            {
+                m_NextSegment = number + 1;
+            }
+
+            // Segments of this family an earlier run didn't get to compress
+            std::string base = name.substr(0, name.find_last_of('.'));
+            if(segmentNumber(name, base, compressed) > 0 && not compressed && m_Policy.compress)
+            {
+                leftOver.push_back(file.path);
+            }
+        }
+    }
+
+    for(const std::string& segment : leftOver)
+    {
+        queue(segment);
+    }
+}
+
+bool LogRotator::needsRotation(uint64_t fileBytes, time_t now)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if(m_Path.empty())
+    {
+        return false;
+    }
+
+    if(m_Policy.maxFileBytes > 0 && fileBytes >= m_Policy.maxFileBytes)
+    {
+        return true;
+    }
+
+    // An empty file isn't worth a segment however old it is
+    return m_Policy.maxFileAgeS > 0 && fileBytes > 0 && now - m_OpenedAt >= (time_t)m_Policy.maxFileAgeS;
+}
+
+bool LogRotator::rotate()
+{
+    std::string segment;
+    bool compress;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        char suffix[16];
+        snprintf(suffix, sizeof(suffix), ".%0*u", LOG_SEGMENT_DIGITS, m_NextSegment);
+        segment = m_Path + suffix;
+
+        if(rename(m_Path.c_str(), segment.c_str()) != 0)
+        {
+            return false;
+        }
+
+        m_NextSegment++;
+        m_OpenedAt = time(NULL);
+        compress = m_Policy.compress;
+    }
+
+    if(compress)
+    {
+        queue(segment);
+    }
+    else
+    {
+        enforceCap();
+    }
+    return true;
+}
+
+void LogRotator::stop()
+{
+    std::lock_guard<std::mutex> workerLock(m_WorkerMutex);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Running = false;
+    }
+    m_Wake.notify_one();
+
+    if(m_Worker.joinable())
+    {
+        m_Worker.join();
+    }
+}
+
+void LogRotator::waitIdle()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Idle.wait(lock, [this]{ return (m_Pending.empty() && not m_Busy) || not m_Running; });
+}
+
+void LogRotator::enforceCap()
+{
+    std::vector<std::string> doomed;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if(m_Policy.maxTotalBytes == 0 || m_Path.empty())
+        {
+            return;
+        }
+
+        std::vector<FileInfo> files = familyFiles();
+        uint64_t total = 0;
+        for(const FileInfo& file : files)
+        {
+            total += file.size;
+        }
+
+        std::sort(files.begin(), files.end(), [](const FileInfo& a, const FileInfo& b) {
+            return a.modified < b.modified || (a.modified == b.modified && a.path < b.path);
+        });
+
+        for(const FileInfo& file : files)
+        {
+            if(total <= m_Policy.maxTotalBytes)
+            {
+                break;
+            }
+
+            // Neither the file being written nor a segment waiting to be compressed
+            if(file.path == m_Path || std::find(m_Pending.begin(), m_Pending.end(), file.path) != m_Pending.end())
+            {
+                continue;
+            }
+            doomed.push_back(file.path);
+            total -= file.size;
+        }
+    }
+
+    for(const std::string& path : doomed)
+    {
+        remove(path.c_str());
+    }
+}
+
+std::vector<std::string> LogRotator::segments()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::vector<std::pair<unsigned int, std::string>> numbered;
+
+    for(const FileInfo& file : familyFiles())
+    {
+        std::string name = file.path.substr(file.path.find_last_of('/') + 1);
+        bool compressed;
+        unsigned int number = segmentNumber(name, m_FileName, compressed);
+        if(number > 0)
+        {
+            numbered.push_back(std::make_pair(number, file.path));
+        }
+    }
+
+    std::sort(numbered.begin(), numbered.end());
+
+    std::vector<std::string> paths;
+    for(auto& segment : numbered)
+    {
+        paths.push_back(segment.second);
+    }
+    return paths;
+}
+
+bool LogRotator::compressFile(const std::string& path)
+{
+    FILE* in = fopen(path.c_str(), "rb");
+    if(in == NULL)
+    {
+        return false;
+    }
+
+    std::string target = path + LOG_COMPRESSED_EXTENSION;
+    gzFile out = gzopen(target.c_str(), "wb6");
+    if(out == NULL)
+    {
+        fclose(in);
+        return false;
+    }
+
+    std::vector<char> chunk(COMPRESS_CHUNK_SIZE);
+    bool success = true;
+    size_t read;
+
+    while((read = fread(chunk.data(), 1, chunk.size(), in)) > 0)
+    {
+        if(gzwrite(out, chunk.data(), (unsigned int)read) != (int)read)
+        {
+            success = false;
+            break;
+        }
+    }
+
+    success = success && not ferror(in);
+    fclose(in);
+    success = (gzclose(out) == Z_OK) && success;
+
+    // Keep the original rather than risk losing it
+    if(not success)
+    {
+        remove(target.c_str());
+        return false;
+    }
+
+    remove(path.c_str());
+    return true;
+}
+
+std::vector<LogRotator::FileInfo> LogRotator::familyFiles()
+{
+    std::vector<FileInfo> files;
+    DIR* directory = opendir(m_Directory.c_str());
+
+    if(directory == NULL)
+    {
+        return files;
+    }
+
+    struct dirent* entry;
+    while((entry = readdir(directory)) != NULL)
+    {
+        if(strstr(entry->d_name, m_Family.c_str()) == NULL)
+        {
+            continue;
+        }
+
+        FileInfo file;
+        file.path = m_Directory + "/" + entry->d_name;
+
+        struct stat status;
+        if(stat(file.path.c_str(), &status) != 0 || not S_ISREG(status.st_mode))
+        {
+            continue;
+        }
+        file.size = status.st_size;
+        file.modified = status.st_mtime;
+        files.push_back(file);
+    }
+
+    closedir(directory);
+    return files;
+}
+
+unsigned int LogRotator::segmentNumber(const std::string& name, const std::string& fileName, bool& compressed)
+{
+    // "<file>.NNNN" or "<file>.NNNN.gz"
+    std::string extension = LOG_COMPRESSED_EXTENSION;
+    std::string rest;
+
+    if(name.size() <= fileName.size() + 1 || name.compare(0, fileName.size(), fileName) != 0 ||
+       name[fileName.size()] != '.')
+    {
+        return 0;
+    }
+    rest = name.substr(fileName.size() + 1);
+
+    compressed = rest.size() > extension.size() &&
+                 rest.compare(rest.size() - extension.size(), extension.size(), extension) == 0;
+    if(compressed)
+    {
+        rest.erase(rest.size() - extension.size());
+    }
+
+    if(rest.size() < LOG_SEGMENT_DIGITS || rest.find_first_not_of("0123456789") != std::string::npos)
+    {
+        return 0;
+    }
+    return (unsigned int)strtoul(rest.c_str(), NULL, 10);
+}
+
+void LogRotator::queue(const std::string& path)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if(std::find(m_Pending.begin(), m_Pending.end(), path) != m_Pending.end())
+        {
+            return;
+        }
+        m_Pending.push_back(path);
+
+        if(m_Running)
+        {
+            m_Wake.notify_one();
+            return;
+        }
+    }
+
+    // Restarts the worker after a stop, the stopped one has to be joined without the
+    // mutex as it takes it to finish
+    std::lock_guard<std::mutex> workerLock(m_WorkerMutex);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if(m_Running)
+        {
+            return;
+        }
+    }
+
+    if(m_Worker.joinable())
+    {
+        m_Worker.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Running = true;
+    }
+    m_Worker = std::thread(&LogRotator::workerThread, this);
+}
+
+void LogRotator::workerThread()
+{
+#ifdef __linux__
+    // Only lowers this thread, the nice value is per thread on Linux
+    setpriority(PRIO_PROCESS, syscall(SYS_gettid), 19);
+#endif
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+
+    while(m_Running)
+    {
+        if(m_Pending.empty())
+        {
+            m_Idle.notify_all();
+            m_Wake.wait(lock, [this]{ return not m_Pending.empty() || not m_Running; });
+            continue;
+        }
+
+        std::string segment = m_Pending.front();
+        m_Busy = true;
+        lock.unlock();
+
+        compressFile(segment);
+
+        lock.lock();
+        m_Pending.pop_front();
+        lock.unlock();
+
+        enforceCap();
+
+        lock.lock();
+        m_Busy = false;
+    }
+
+    m_Idle.notify_all();
+}
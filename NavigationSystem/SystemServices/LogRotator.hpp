@@ -0,0 +1,152 @@
+/****************************************************************************************
+ *
+ * File:
+ *         LogRotator.hpp
+ *
+ * Purpose:
+ *        Rotates a log file once it gets too big or too old, compresses the rotated
+ *        segments on a low priority thread and deletes the oldest files once the total
+ *        size retained goes over a cap.
+ *
+ * Developer Notes:
+ *        The rotator doesn't own the file, the writer of the file asks needsRotation()
+ *        between writes and, when it has to, closes the file, calls rotate() and opens
+ *        the file again. rotate() only renames the file into the next segment,
+ *        "<file>.0001", "<file>.0002"... so it is cheap enough to call from a writer
+ *        thread. The segments are gzipped into "<file>.0001.gz" by the rotator's own
+ *        thread, running at the lowest priority.
+ *
+ *        The cap applies to every file of the directory whose name contains the family
+ *        name given to opened(), so the files of earlier runs count as well. The file
+ *        being written is never deleted. Segments left uncompressed when the program
+ *        stopped are compressed once a file of their family is opened again.
+ *
+ *        The rotator doesn't log, it is used by the Logger itself.
+ *
+ ***************************************************************************************/
+
+
+#pragma once
+
+
+#include <stdint.h>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define LOG_SEGMENT_DIGITS          4
+#define LOG_COMPRESSED_EXTENSION    ".gz"
+
+
+struct RotationPolicy {
+    uint64_t maxFileBytes;          // 0 for no size limit
+    unsigned int maxFileAgeS;       // 0 for no age limit
+    uint64_t maxTotalBytes;         // All the files of the family, 0 for no cap
+    bool compress;
+};
+
+
+class LogRotator {
+public:
+    LogRotator(const RotationPolicy& policy);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Waits for the segment being compressed, if any, and stops the compression thread.
+    /////////////////////////////////////////////////////////////////////////////////////
+    ~LogRotator();
+
+    void setPolicy(const RotationPolicy& policy);
+    RotationPolicy policy();
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Starts looking after a file which was just created.
+    ///
+    /// @param path                 The path of the file.
+    /// @param family               The part of the name shared by the files counting
+    ///                             towards the cap, the file name if empty.
+    ///
+    /////////////////////////////////////////////////////////////////////////////////////
+    void opened(const std::string& path, const std::string& family = "");
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Returns true if the file has to be rotated.
+    ///
+    /// @param fileBytes            The current size of the file.
+    ///
+    /////////////////////////////////////////////////////////////////////////////////////
+    bool needsRotation(uint64_t fileBytes) { return needsRotation(fileBytes, time(NULL)); }
+    bool needsRotation(uint64_t fileBytes, time_t now);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Renames the file, which needs to be closed, into the next segment and queues the
+    /// segment for compression. Returns false if the file couldn't be renamed.
+    /////////////////////////////////////////////////////////////////////////////////////
+    bool rotate();
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Stops the compression thread after the segment it is working on.
+    /////////////////////////////////////////////////////////////////////////////////////
+    void stop();
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Blocks until the queued segments have been compressed and the cap enforced.
+    /////////////////////////////////////////////////////////////////////////////////////
+    void waitIdle();
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Deletes the oldest files of the family until they fit in the cap.
+    /////////////////////////////////////////////////////////////////////////////////////
+    void enforceCap();
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Returns the rotated segments of the file, oldest first.
+    /////////////////////////////////////////////////////////////////////////////////////
+    std::vector<std::string> segments();
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Gzips a file into "<path>.gz" and removes it, returns false on failure.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static bool compressFile(const std::string& path);
+
+private:
+    struct FileInfo {
+        std::string path;
+        uint64_t size;
+        time_t modified;
+    };
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Lists the files of the family. The mutex needs to be held.
+    /////////////////////////////////////////////////////////////////////////////////////
+    std::vector<FileInfo> familyFiles();
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Returns the number of the segment a file name is, 0 if it isn't one.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static unsigned int segmentNumber(const std::string& name, const std::string& fileName, bool& compressed);
+
+    void queue(const std::string& path);
+    void workerThread();
+
+    RotationPolicy              m_Policy;
+    std::string                 m_Path;
+    std::string                 m_Directory;
+    std::string                 m_FileName;
+    std::string                 m_Family;
+    time_t                      m_OpenedAt;
+    unsigned int                m_NextSegment;
+
+    std::mutex                  m_Mutex;            ///< Guards everything above and below
+    std::condition_variable     m_Wake;
+    std::condition_variable     m_Idle;
+    std::deque<std::string>     m_Pending;          ///< Segments to compress
+    bool                        m_Busy;
+    bool                        m_Running;
+
+    std::mutex                  m_WorkerMutex;      ///< Guards the worker, never taken by it
+    std::thread                 m_Worker;
+};
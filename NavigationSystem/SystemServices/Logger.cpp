@@ -22,22 +22,43 @@
 
 
 #include "Logger.hpp"
+#include "ClockSource.hpp"
+#include "StructuredLog.hpp"
 #include "SysClock.hpp"
 #include "../Libs/termcolor/termcolor.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 #define MAX_LOG_SIZE    256*2
 #define MAX_MSG_BUFFER 100
+#define LOG_SUMMARY_CHECK_MS    1000
+
+// 10 MB files, rotated daily at least, 200 MB kept in all
+static const RotationPolicy DEFAULT_LOG_ROTATION = { 10 * 1024 * 1024, 24 * 60 * 60, 200 * 1024 * 1024, true };
 
 // Uncomment for a WRSC2017 position log file
 // #define ENABLE_WRSC_LOGGING
 
 std::string                 Logger::m_LogFilePath;
 std::ofstream                 Logger::m_LogFile;
-std::vector<std::string>     Logger::m_LogBuffer;
+std::vector<std::pair<LogLevel, std::string>> Logger::m_LogBuffer;
 #ifndef _WIN32
 std::mutex                     Logger::m_Mutex;
 #endif
+std::thread                 Logger::m_Writer;
+std::mutex                  Logger::m_WakeMutex;
+std::condition_variable     Logger::m_Wake;
+LogRingBuffer               Logger::m_Ring;
+std::atomic<bool>           Logger::m_WriterRunning(false);
+std::atomic<unsigned long>  Logger::m_Dropped(0);
+unsigned long               Logger::m_ReportedDrops = 0;
+std::atomic<bool>           Logger::m_Structured(false);
+std::map<uint32_t, std::string> Logger::m_Formats;
+std::set<uint32_t>          Logger::m_FileFormats;
+LogLimiter                  Logger::m_Limiter;
+LogRotator                  Logger::m_Rotator(DEFAULT_LOG_ROTATION);
 bool Logger::m_DisableLogging = false;
 
 #ifdef ENABLE_WRSC_LOGGING
@@ -49,14 +70,28 @@ bool Logger::init(const char* filename)
 {
     if(m_DisableLogging) { return true; }
     
-    if(not createLogFiles(filename))
+    bool created = createLogFiles(filename);
+    if(not created)
     {
         std::cout << "[" << SysClock::timeStampStr().c_str() << "] Failed to create log files\n";
-        return false;
     }
     
-    // Assumes the logger is already setup and going
-    return true;
+    // Records still go to the terminal without a log file
+    if(not m_WriterRunning.load())
+    {
+        static bool shutdownRegistered = false;
+        if(not shutdownRegistered)
+        {
+            // Joins the writer before the static thread object is destroyed
+            std::atexit(shutdown);
+            shutdownRegistered = true;
+        }
+        
+        m_WriterRunning.store(true);
+        m_Writer = std::thread(writerThread);
+    }
+    
+    return created;
 }
 
 void Logger::DisableLogging()
@@ -64,15 +99,49 @@ void Logger::DisableLogging()
     m_DisableLogging = true;
 }
 
+void Logger::setStructuredLogging(bool enabled)
+{
+    m_Structured.store(enabled);
+}
+
+void Logger::setLogLimit(LogLevel level, const LogLimit& limit)
+{
+    m_Limiter.setLimit(level, limit);
+}
+
+void Logger::setRotation(const RotationPolicy& policy)
+{
+    m_Rotator.setPolicy(policy);
+}
+
 void Logger::shutdown()
 {
     if(m_DisableLogging) { return; }
     
+    if(m_WriterRunning.load())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_WakeMutex);
+            m_WriterRunning.store(false);
+        }
+        m_Wake.notify_one();
+        m_Writer.join();
+    }
+    
+    // Records pushed while the writer was stopping
+    writeQueuedRecords();
+    
+#ifndef _WIN32
+    std::lock_guard<std::mutex> lock(m_Mutex);
+#endif
     if(m_LogFile.is_open())
     {
         m_LogFile.close();
     }
     
+    // Rotated segments not compressed yet are picked up by the next run
+    m_Rotator.stop();
+    
 #ifdef ENABLE_WRSC_LOGGING
     if(m_LogFileWRSC.is_open())
     {
@@ -81,7 +150,7 @@ void Logger::shutdown()
 #endif
 }
 
-void Logger::log(std::string message)
+void Logger::log(LogLevel level, std::string message)
 {
     if(m_DisableLogging) { return; }
     
@@ -89,25 +158,49 @@ void Logger::log(std::string message)
     m_Mutex.lock();
 #endif
     
+    writeToFile(level, message.c_str());
     if(m_LogFile.is_open())
     {
-        m_LogFile << message.c_str();
         m_LogFile.flush();
+        rotateIfNeeded();
+    }
+#ifndef _WIN32
+    m_Mutex.unlock();
+#endif
+}
+
+void Logger::writeToFile(LogLevel level, const char* text)
+{
+    if(m_LogFile.is_open())
+    {
+        if(m_Structured.load())
+        {
+            std::vector<char> record(strlen(text) + STRUCTURED_LOG_TEXT_HEADER);
+            size_t size = StructuredLog::encodeText(record.data(), record.size(), level, currentTimeMs(), text);
+            m_LogFile.write(record.data(), size);
+        }
+        else
+        {
+            m_LogFile << text;
+        }
     }
     else
     {
         if(m_LogBuffer.size() < MAX_MSG_BUFFER)
         {
-            m_LogBuffer.push_back(message);
+            m_LogBuffer.emplace_back(level, text);
         }
         else
         {
             //printf(" === NO ROOM IN BUFFER FOR MORE MESSAGES ===\n");
         }
     }
-#ifndef _WIN32
-    m_Mutex.unlock();
-#endif
+}
+
+uint64_t Logger::currentTimeMs()
+{
+    // Read at once, seconds and milliseconds taken apart from SysClock could straddle a second
+    return ClockSource::current().wallUs() / 1000;
 }
 
 void Logger::info(std::string message, ...)
@@ -116,24 +209,9 @@ void Logger::info(std::string message, ...)
     
     if(m_DisableLogging) { return; }
     
-    char logBuffer[MAX_LOG_SIZE];
-    // Put together the formatted string
     va_start(args, message);
-    vsnprintf(logBuffer, MAX_LOG_SIZE, message.c_str(), args);
+    logRecord(LogLevel::Info, message.c_str(), args);
     va_end(args);
-    
-    char buff[256];
-    int millis = SysClock::millis();
-    
-    if (millis<10)
-        snprintf(buff, 256, "[%s:00%d] <info>\t %s\n", SysClock::timeStampStr().c_str(),millis, logBuffer);
-    else if(millis<100)
-        snprintf(buff, 256, "[%s:0%d] <info>\t %s\n", SysClock::timeStampStr().c_str(),millis, logBuffer);
-    else
-        snprintf(buff, 256, "[%s:%d] <info>\t %s\n", SysClock::timeStampStr().c_str(),millis, logBuffer);
-    
-    std::cout<<buff;
-    log(buff);
 }
 
 void Logger::error(std::string message, ...)
@@ -142,18 +220,9 @@ void Logger::error(std::string message, ...)
     
     if(m_DisableLogging) { return; }
     
-    char logBuffer[MAX_LOG_SIZE];
-    // Put together the formatted string
     va_start(args, message);
-    vsnprintf(logBuffer, MAX_LOG_SIZE, message.c_str(), args);
+    logRecord(LogLevel::Error, message.c_str(), args);
     va_end(args);
-    
-    char buff[256];
-    
-    snprintf(buff, 256, "[%s:%d] <error>\t %s\n", SysClock::timeStampStr().c_str(), SysClock::millis(), logBuffer);
-    
-    std::cout<<rang::fg::red<<buff<<rang::style::reset;
-    log(buff);
 }
 
 void Logger::warning(std::string message, ...)
@@ -162,38 +231,375 @@ void Logger::warning(std::string message, ...)
     
     if(m_DisableLogging) { return; }
     
-    char logBuffer[MAX_LOG_SIZE];
-    // Put together the formatted string
     va_start(args, message);
-    vsnprintf(logBuffer, MAX_LOG_SIZE, message.c_str(), args);
+    logRecord(LogLevel::Warning, message.c_str(), args);
     va_end(args);
+}
+
+void Logger::success(std::string message, ...)
+{
+    va_list args;
     
-    char buff[256];
-    
-    snprintf(buff, 256, "[%s:%d] <warning>\t %s\n", SysClock::timeStampStr().c_str(), SysClock::millis(), logBuffer);
+    if(m_DisableLogging) { return; }
     
-    std::cout<<rang::fg::yellow<<buff<<rang::style::reset;
-    log(buff);
+    va_start(args, message);
+    logRecord(LogLevel::Success, message.c_str(), args);
+    va_end(args);
 }
 
-void Logger::success(std::string message, ...)
+void Logger::limited(LogSite& site, LogLevel level, const char* format, ...)
 {
     va_list args;
     
     if(m_DisableLogging) { return; }
     
+    va_start(args, format);
+    logRecord(level, format, args, &site);
+    va_end(args);
+}
+
+void Logger::logRecord(LogLevel level, const char* format, va_list args, LogSite* site)
+{
+    uint64_t nowUs = 0;
+    LogSummary summary;
+    
+    // Calls over the rate limit of their site aren't even formatted
+    if(site != nullptr)
+    {
+        nowUs = LogLimiter::nowUs();
+        if(not m_Limiter.admit(*site, level, format, nowUs))
+        {
+            return;
+        }
+    }
+    
+    if(m_Structured.load() && m_WriterRunning.load() && logStructured(level, site, format, nowUs, args))
+    {
+        return;
+    }
+    
     char logBuffer[MAX_LOG_SIZE];
     // Put together the formatted string
-    va_start(args, message);
-    vsnprintf(logBuffer, MAX_LOG_SIZE, message.c_str(), args);
-    va_end(args);
+    vsnprintf(logBuffer, MAX_LOG_SIZE, format, args);
+    
+    if(site != nullptr)
+    {
+        bool unique = m_Limiter.check(*site, StructuredLog::hash(logBuffer, strlen(logBuffer)), nowUs, summary);
+        logSummary(summary);
+        if(not unique)
+        {
+            return;
+        }
+    }
+    
+    const char* levelName = "info";
+    switch(level)
+    {
+        case LogLevel::Info:    levelName = "info"; break;
+        case LogLevel::Error:   levelName = "error"; break;
+        case LogLevel::Warning: levelName = "warning"; break;
+        case LogLevel::Success: levelName = "success"; break;
+    }
+    
+    char buff[LOG_RECORD_SIZE];
+    snprintf(buff, LOG_RECORD_SIZE, "[%s:%03d] <%s>\t %s\n", SysClock::timeStampStr().c_str(), SysClock::millis(), levelName, logBuffer);
+    
+    queueText(level, buff);
+}
+
+void Logger::queueText(LogLevel level, const char* text)
+{
+    if(m_WriterRunning.load())
+    {
+        if(not m_Ring.push(level, text))
+        {
+            m_Dropped++;
+        }
+        wakeWriter(level);
+    }
+    else
+    {
+        print(level, text);
+        log(level, text);
+    }
+}
+
+void Logger::logSummary(const LogSummary& summary)
+{
+    if(not summary.pending())
+    {
+        return;
+    }
+    
+    const char* levelName = "info";
+    switch(summary.level)
+    {
+        case LogLevel::Info:    levelName = "info"; break;
+        case LogLevel::Error:   levelName = "error"; break;
+        case LogLevel::Warning: levelName = "warning"; break;
+        case LogLevel::Success: levelName = "success"; break;
+    }
+    
+    char held[96];
+    if(summary.repeated > 0 && summary.limited > 0)
+    {
+        snprintf(held, sizeof(held), "repeated %u times and %u more over the rate limit", summary.repeated, summary.limited);
+    }
+    else if(summary.repeated > 0)
+    {
+        snprintf(held, sizeof(held), "repeated %u times", summary.repeated);
+    }
+    else
+    {
+        snprintf(held, sizeof(held), "%u records over the rate limit", summary.limited);
+    }
+    
+    const char* file = strrchr(summary.file, '/');
+    file = (file != nullptr) ? file + 1 : summary.file;
     
-    char buff[256];
+    char buff[LOG_RECORD_SIZE];
+    snprintf(buff, LOG_RECORD_SIZE, "[%s:%03d] <%s>\t %s:%u \"%.*s\" %s\n", SysClock::timeStampStr().c_str(),
+             SysClock::millis(), levelName, file, summary.line, LOG_SUMMARY_FORMAT_SIZE, summary.format, held);
     
-    snprintf(buff, 256, "[%s:%d] <success>\t %s\n", SysClock::timeStampStr().c_str(), SysClock::millis(), logBuffer);
+    queueText(summary.level, buff);
+}
+
+void Logger::logHeldSummaries(uint64_t ageUs)
+{
+    std::vector<LogSummary> summaries;
+    m_Limiter.collectSummaries(LogLimiter::nowUs(), ageUs, summaries);
     
-    std::cout<<rang::fg::green<<buff<<rang::style::reset;
-    log(buff);
+    for(const LogSummary& summary : summaries)
+    {
+        logSummary(summary);
+    }
+}
+
+bool Logger::logStructured(LogLevel level, LogSite* site, const char* format, uint64_t nowUs, va_list args)
+{
+    uint32_t formatId = StructuredLog::formatId(format);
+    bool announced = StructuredLog::isAnnounced(formatId);
+    
+    char record[LOG_RECORD_SIZE];
+    size_t size = StructuredLog::encode(record, sizeof(record), level, currentTimeMs(), format, args, not announced);
+    
+    // Too long or too many arguments, falls back on a text record
+    if(size == 0)
+    {
+        return false;
+    }
+    
+    if(site != nullptr)
+    {
+        LogSummary summary;
+        bool unique = m_Limiter.check(*site, StructuredLog::contentHash(record, size), nowUs, summary);
+        logSummary(summary);
+        if(not unique)
+        {
+            return true;
+        }
+    }
+    
+    if(m_Ring.push(level, record, size))
+    {
+        // Only once the record carrying the format text is sure to reach the file
+        if(not announced)
+        {
+            StructuredLog::setAnnounced(formatId);
+        }
+    }
+    else
+    {
+        m_Dropped++;
+    }
+    
+    wakeWriter(level);
+    return true;
+}
+
+void Logger::wakeWriter(LogLevel level)
+{
+    // The writer wakes up on its own every LOG_FLUSH_INTERVAL_MS, only hurry it up when
+    // the ring buffer fills up or for errors
+    if(level == LogLevel::Error || m_Ring.size() > LOG_RING_SIZE / 2)
+    {
+        m_Wake.notify_one();
+    }
+}
+
+void Logger::print(LogLevel level, const char* text)
+{
+    switch(level)
+    {
+        case LogLevel::Info:
+            std::cout<<text;
+            break;
+        case LogLevel::Error:
+            std::cout<<rang::fg::red<<text<<rang::style::reset;
+            break;
+        case LogLevel::Warning:
+            std::cout<<rang::fg::yellow<<text<<rang::style::reset;
+            break;
+        case LogLevel::Success:
+            std::cout<<rang::fg::green<<text<<rang::style::reset;
+            break;
+    }
+}
+
+void Logger::writerThread()
+{
+    uint64_t lastSummaryUs = LogLimiter::nowUs();
+    
+    while(m_WriterRunning.load())
+    {
+        // Summarises the call sites which kept on holding records back
+        if(LogLimiter::nowUs() - lastSummaryUs >= LOG_SUMMARY_CHECK_MS * 1000)
+        {
+            logHeldSummaries(LOG_SUMMARY_INTERVAL_MS * 1000);
+            lastSummaryUs = LogLimiter::nowUs();
+        }
+        
+        if(writeQueuedRecords() == 0)
+        {
+            std::unique_lock<std::mutex> lock(m_WakeMutex);
+            m_Wake.wait_for(lock, std::chrono::milliseconds(LOG_FLUSH_INTERVAL_MS));
+        }
+    }
+    
+    // Whatever was logged before the writer was stopped
+    logHeldSummaries(0);
+    writeQueuedRecords();
+}
+
+unsigned int Logger::writeQueuedRecords()
+{
+    LogRecord record;
+    unsigned int count = 0;
+    
+#ifndef _WIN32
+    std::lock_guard<std::mutex> lock(m_Mutex);
+#endif
+    
+    while(m_Ring.pop(record))
+    {
+        if(record.binary)
+        {
+            writeStructuredRecord(record);
+        }
+        else
+        {
+            // Structured logging keeps the terminal for warnings and errors
+            if(not m_Structured.load() || record.level == LogLevel::Error || record.level == LogLevel::Warning)
+            {
+                print(record.level, record.text);
+            }
+            writeToFile(record.level, record.text);
+        }
+        count++;
+    }
+    
+    unsigned long dropped = m_Dropped.load();
+    if(dropped != m_ReportedDrops)
+    {
+        char buff[LOG_RECORD_SIZE];
+        snprintf(buff, LOG_RECORD_SIZE, "[%s:%03d] <warning>\t %lu log records dropped, the log ring buffer was full\n",
+                 SysClock::timeStampStr().c_str(), SysClock::millis(), dropped - m_ReportedDrops);
+        m_ReportedDrops = dropped;
+        
+        print(LogLevel::Warning, buff);
+        writeToFile(LogLevel::Warning, buff);
+    }
+    
+    if(count > 0)
+    {
+        std::cout.flush();
+        if(m_LogFile.is_open())
+        {
+            m_LogFile.flush();
+            rotateIfNeeded();
+        }
+    }
+    return count;
+}
+
+void Logger::rotateIfNeeded()
+{
+    std::streamoff size = m_LogFile.tellp();
+    if(size < 0 || not m_Rotator.needsRotation((uint64_t)size))
+    {
+        return;
+    }
+    
+    m_LogFile.close();
+    bool rotated = m_Rotator.rotate();
+    
+    std::ios::openmode mode = std::ios::out | (rotated ? std::ios::trunc : std::ios::app);
+    if(m_Structured.load())
+    {
+        mode |= std::ios::binary;
+    }
+    m_LogFile.open(m_LogFilePath.c_str(), mode);
+    
+    // A new structured file needs its header, and every format again
+    if(rotated && m_LogFile.is_open() && m_Structured.load())
+    {
+        m_FileFormats.clear();
+        StructuredLog::startFile(m_LogFile);
+    }
+    
+    if(not m_LogFile.is_open())
+    {
+        print(LogLevel::Error, "Failed to reopen the log file after rotating it\n");
+    }
+    else if(not rotated)
+    {
+        print(LogLevel::Warning, "Failed to rotate the log file, carrying on with the same file\n");
+    }
+}
+
+void Logger::writeStructuredRecord(const LogRecord& record)
+{
+    bool terminal = (record.level == LogLevel::Error || record.level == LogLevel::Warning);
+    
+    if(m_LogFile.is_open() && not terminal)
+    {
+        StructuredLog::writeRecord(m_LogFile, record.text, record.length, m_Formats, m_FileFormats);
+        return;
+    }
+    
+    std::string text;
+    if(not StructuredLog::render(record.text, record.length, m_Formats, text))
+    {
+        return;
+    }
+    
+    if(terminal)
+    {
+        print(record.level, text.c_str());
+    }
+    
+    if(m_LogFile.is_open())
+    {
+        StructuredLog::writeRecord(m_LogFile, record.text, record.length, m_Formats, m_FileFormats);
+    }
+    else if(m_LogBuffer.size() < MAX_MSG_BUFFER)
+    {
+        // Kept as text until the file exists
+        m_LogBuffer.emplace_back(record.level, text);
+    }
+}
+
+void Logger::flush()
+{
+    if(m_DisableLogging) { return; }
+    
+    size_t target = m_Ring.pushedCount();
+    
+    while(m_WriterRunning.load() && m_Ring.poppedCount() < target)
+    {
+        m_Wake.notify_one();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
 }
 
 void Logger::logWRSC(double latitude, double longitude)
@@ -243,7 +649,20 @@ bool Logger::createLogFiles(const char* filename)
     }
     
     mkdir(FILE_PATH, S_IRWXU | S_IRWXG | S_IRWXO);
-    m_LogFile.open(fileName, std::ios::out | std::ios::trunc);
+    if(m_Structured.load())
+    {
+        strncat(fileName, STRUCTURED_LOG_EXTENSION, sizeof(fileName) - strlen(fileName) - 1);
+        m_LogFile.open(fileName, std::ios::out | std::ios::trunc | std::ios::binary);
+        if(m_LogFile.is_open())
+        {
+            m_FileFormats.clear();
+            StructuredLog::startFile(m_LogFile);
+        }
+    }
+    else
+    {
+        m_LogFile.open(fileName, std::ios::out | std::ios::trunc);
+    }
     
 #ifdef ENABLE_WRSC_LOGGING
     char wrscFileName[256];
@@ -263,6 +682,8 @@ bool Logger::createLogFiles(const char* filename)
 #else
     if(m_LogFile.is_open())
     {
+        m_LogFilePath = fileName;
+        m_Rotator.opened(m_LogFilePath, filename == 0 ? DEFAULT_LOG_NAME : filename);
         Logger::info("Log file %s has been created", fileName);
         writeBufferedLogs();
         return true;
@@ -280,9 +701,10 @@ void Logger::writeBufferedLogs()
 {
     if(m_DisableLogging) { return; }
     
-    for(std::string log : m_LogBuffer)
+    for(const std::pair<LogLevel, std::string>& log : m_LogBuffer)
     {
-        m_LogFile << log.c_str();
+        writeToFile(log.first, log.second.c_str());
     }
+    m_LogBuffer.clear();
     m_LogFile.flush();
 }
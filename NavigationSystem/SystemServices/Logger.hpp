@@ -17,18 +17,58 @@
  *            60.3456. When WRSC logging is enabled a separate log file is generated
  *            containing only this data and is located alongside the program.
  *
+ *        Asynchronous logging:
+ *            Once init() has been called the log records are handed to a writer thread
+ *            through a lock-free ring buffer, see LogRingBuffer.hpp. The writer prints
+ *            them to the terminal and the log file in batches and flushes the file once
+ *            per batch, so the logging threads never wait on terminal or disk I/O. If the
+ *            ring buffer is full the record is dropped and counted, the writer logs how
+ *            many records were dropped.
+ *
+ *            Before init() and after shutdown() records are written synchronously.
+ *
+ *        Structured logging:
+ *            With setStructuredLogging() the calling threads don't format the records,
+ *            they encode the identity of the format string and the raw arguments into a
+ *            binary .slog file, see StructuredLog.hpp. The file is turned into text with
+ *            setup/decode_log.py. Only warnings and errors are formatted, by the writer
+ *            thread, for the terminal.
+ *
+ *        Log storms:
+ *            Call sites in hot loops log through LOG_LIMITED instead, which rate limits
+ *            the site and suppresses its duplicate records, see LogLimiter.hpp. What was
+ *            held back is logged as a "repeated N times" summary when the site logs
+ *            something different, or by the writer thread after LOG_SUMMARY_INTERVAL_MS.
+ *            The limits are set per level with setLogLimit(). The other calls are never
+ *            limited.
+ *
+ *        Rotation:
+ *            The log file is rotated by size and age, the segments are compressed in the
+ *            background and the oldest log files are deleted to stay under a total size,
+ *            see LogRotator.hpp and setRotation().
+ *
  ***************************************************************************************/
 
 
 #pragma once
 
 
+#include "LogLimiter.hpp"
+#include "LogRingBuffer.hpp"
+#include "LogRotator.hpp"
+#include <stdint.h>
+#include <map>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
+#include <atomic>
+#include <condition_variable>
 #include <cstdarg>
 #ifndef _WIN32
 #include <mutex>
 #endif
+#include <thread>
 #include <iostream>
 #include <fstream>
 #include <sys/stat.h>
@@ -36,13 +76,18 @@
 #define DEFAULT_LOG_NAME            "sailing-log.log"
 #define DEFAULT_LOG_NAME_WRSC        "wrsc-log.log"
 #define FILE_PATH                         "../logs/"
+#define LOG_FLUSH_INTERVAL_MS       50
+
+// Logs like Logger::info() and co, rate limited and with its duplicates folded
+#define LOG_LIMITED(level, ...) \
+    do { static LogSite logSite(__FILE__, __LINE__); Logger::limited(logSite, level, __VA_ARGS__); } while(0)
 
 
 class Logger {
 public:
     /////////////////////////////////////////////////////////////////////////////////////
-    /// Initialises the singleton logger system, returns false if it is unable to
-    /// generate a log file.
+    /// Initialises the singleton logger system and starts the writer thread, returns
+    /// false if it is unable to generate a log file.
     ///
     /// @param filename             The type of log message, if this paramter is not
     ///                                provided then a default name is used.
@@ -53,7 +98,37 @@ public:
     /// SHOULD ONLY BE USED FOR UNIT TESTS!
     static void DisableLogging();
     
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Writes the records still queued, stops the writer thread and closes the log
+    /// files.
+    /////////////////////////////////////////////////////////////////////////////////////
     static void shutdown();
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Switches to binary structured log files, needs to be called before init().
+    /////////////////////////////////////////////////////////////////////////////////////
+    static void setStructuredLogging(bool enabled);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Sets the rate limit and duplicate suppression of the LOG_LIMITED call sites
+    /// logging at a level, a rate of 0 lifts the rate limit.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static void setLogLimit(LogLevel level, const LogLimit& limit);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Sets when the log file is rotated and how much of the logs is kept.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static void setRotation(const RotationPolicy& policy);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Waits until the writer thread has written every record logged before the call.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static void flush();
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Returns the number of records dropped because the ring buffer was full.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static unsigned long droppedCount() { return m_Dropped.load(); }
     
     /////////////////////////////////////////////////////////////////////////////////////
     /// A globally accessable function to log messages to that works exactly like printf.
@@ -67,10 +142,76 @@ public:
     static void warning(std::string message, ...);
     static void success(std::string message, ...);
 
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Logs through the limits of a call site, use the LOG_LIMITED macro rather than
+    /// calling it.
+    ///
+    /// @params format              A string literal, the site keeps hold of it.
+    ///
+    /////////////////////////////////////////////////////////////////////////////////////
+    static void limited(LogSite& site, LogLevel level, const char* format, ...);
+
     static void logWRSC(double latitude, double longitude);
     
 private:
-    static void log(std::string message);
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Formats a record and queues it for the writer thread, or writes it straight away
+    /// when the writer isn't running.
+    ///
+    /// @param site                 The limited call site, or null.
+    ///
+    /////////////////////////////////////////////////////////////////////////////////////
+    static void logRecord(LogLevel level, const char* format, va_list args, LogSite* site = nullptr);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Queues a structured record, returns false if the call has to be logged as text
+    /// instead.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static bool logStructured(LogLevel level, LogSite* site, const char* format, uint64_t nowUs, va_list args);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Queues a formatted line for the writer thread, or writes it straight away when
+    /// the writer isn't running.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static void queueText(LogLevel level, const char* text);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Logs what a call site held back, if anything.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static void logSummary(const LogSummary& summary);
+
+    static void logHeldSummaries(uint64_t ageUs);
+
+    static void wakeWriter(LogLevel level);
+
+    static uint64_t currentTimeMs();
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Prints a record on the terminal in the colour of its level.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static void print(LogLevel level, const char* text);
+
+    static void log(LogLevel level, std::string message);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Writes a text line into the log file, as a text record in structured mode, or
+    /// buffers it until the file is created. The mutex needs to be held.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static void writeToFile(LogLevel level, const char* text);
+
+    static void writeStructuredRecord(const LogRecord& record);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Rotates the log file if it got too big or too old. The mutex needs to be held.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static void rotateIfNeeded();
+
+    static void writerThread();
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Writes the queued records, returns the number of records written.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static unsigned int writeQueuedRecords();
     
     static bool createLogFiles(const char* filename = 0);
     
@@ -78,10 +219,22 @@ private:
     
     static std::string                 m_LogFilePath;
     static std::ofstream             m_LogFile;
-    static std::vector<std::string> m_LogBuffer;
+    static std::vector<std::pair<LogLevel, std::string>> m_LogBuffer;   ///< Lines logged before the file was created
 #ifndef _WIN32
     static std::mutex                 m_Mutex;
 #endif
+    static std::thread              m_Writer;
+    static std::mutex               m_WakeMutex;
+    static std::condition_variable  m_Wake;
+    static LogRingBuffer            m_Ring;
+    static std::atomic<bool>        m_WriterRunning;
+    static std::atomic<unsigned long> m_Dropped;
+    static unsigned long            m_ReportedDrops;    ///< Only used by the writer
+    static std::atomic<bool>        m_Structured;
+    static std::map<uint32_t, std::string> m_Formats;   ///< Format dictionary of the writer
+    static std::set<uint32_t>       m_FileFormats;      ///< Formats written into the current file
+    static LogLimiter               m_Limiter;
+    static LogRotator               m_Rotator;
     static bool                        m_DisableLogging;
     
 #ifdef ENABLE_WRSC_LOGGING
@@ -0,0 +1,654 @@
+/****************************************************************************************
+ *
+ * File:
+ *         StructuredLog.cpp
+ *
+ * Purpose:
+ *        Encodes log calls into binary records holding the identity of the format string
+ *        and the raw arguments, so the text only gets formatted offline by the decoder,
+ *        setup/decode_log.py.
+ *
+ ***************************************************************************************/
+
+
+#include "StructuredLog.hpp"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <stddef.h>
+#include <unordered_set>
+
+
+namespace {
+
+///----------------------------------------------------------------------------------
+/// A conversion specification of a format string, e.g. "%-8.3lf".
+///----------------------------------------------------------------------------------
+struct Conversion {
+    std::string flags;      // Flags, width and precision, as written
+    std::string length;     // Length modifier
+    char conversion;
+    int stars;              // Number of '*' in the width and precision
+};
+
+///----------------------------------------------------------------------------------
+/// Reads the next conversion specification, returns false at the end of the format.
+/// The text in front of it is appended to literal, with "%%" turned into '%'.
+///----------------------------------------------------------------------------------
+bool nextConversion(const char*& p, Conversion& spec, std::string* literal = NULL)
+{
+    while(*p != '\0')
+    {
+        if(*p != '%')
+        {
+            if(literal != NULL) { *literal += *p; }
+            p++;
+            continue;
+        }
+        p++;
+        if(*p == '%')
+        {
+            if(literal != NULL) { *literal += '%'; }
+            p++;
+            continue;
+        }
+
+        spec.flags.clear();
+        spec.length.clear();
+        spec.stars = 0;
+
+        while(*p != '\0' && strchr("-+ #0", *p) != NULL)
+        {
+            spec.flags += *p++;
+        }
+        while(*p == '*' || (*p >= '0' && *p <= '9') || *p == '.')
+        {
+            if(*p == '*')
+            {
+                spec.stars++;
+            }
+            spec.flags += *p++;
+        }
+        while(*p != '\0' && strchr("hlzjtLq", *p) != NULL)
+        {
+            spec.length += *p++;
+        }
+
+        spec.conversion = *p;
+        if(*p != '\0')
+        {
+            p++;
+        }
+        return true;
+    }
+    return false;
+}
+
+class Writer {
+public:
+    Writer(char* buffer, size_t size) : m_Buffer(buffer), m_Size(size), m_Pos(0), m_Overflow(false) {}
+
+    void u8(uint8_t value) { bytes(&value, 1); }
+
+    void u16(uint16_t value)
+    {
+        uint8_t data[2] = { (uint8_t)value, (uint8_t)(value >> 8) };
+        bytes(data, 2);
+    }
+
+    void u32(uint32_t value)
+    {
+        for(int i = 0; i < 4; i++) { u8((uint8_t)(value >> (i * 8))); }
+    }
+
+    void u64(uint64_t value)
+    {
+        for(int i = 0; i < 8; i++) { u8((uint8_t)(value >> (i * 8))); }
+    }
+
+    void bytes(const void* data, size_t size)
+    {
+        if(m_Pos + size > m_Size)
+        {
+            m_Overflow = true;
+            return;
+        }
+        memcpy(m_Buffer + m_Pos, data, size);
+        m_Pos += size;
+    }
+
+    size_t size() const { return m_Overflow ? 0 : m_Pos; }
+
+private:
+    char*   m_Buffer;
+    size_t  m_Size;
+    size_t  m_Pos;
+    bool    m_Overflow;
+};
+
+class Reader {
+public:
+    Reader(const char* data, size_t size) : m_Data(data), m_Size(size), m_Pos(0) {}
+
+    bool atEnd() const { return m_Pos >= m_Size; }
+
+    bool u8(uint8_t& value) { return bytes(&value, 1); }
+
+    bool u16(uint16_t& value)
+    {
+        uint8_t data[2];
+        if(not bytes(data, 2)) { return false; }
+        value = data[0] | (data[1] << 8);
+        return true;
+    }
+
+    bool u32(uint32_t& value)
+    {
+        uint64_t wide;
+        if(not read(wide, 4)) { return false; }
+        value = (uint32_t)wide;
+        return true;
+    }
+
+    bool u64(uint64_t& value) { return read(value, 8); }
+
+    bool bytes(void* data, size_t size)
+    {
+        if(m_Pos + size > m_Size) { return false; }
+        memcpy(data, m_Data + m_Pos, size);
+        m_Pos += size;
+        return true;
+    }
+
+private:
+    bool read(uint64_t& value, int size)
+    {
+        uint8_t data[8];
+        if(not bytes(data, size)) { return false; }
+        value = 0;
+        for(int i = 0; i < size; i++) { value |= (uint64_t)data[i] << (i * 8); }
+        return true;
+    }
+
+    const char* m_Data;
+    size_t      m_Size;
+    size_t      m_Pos;
+};
+
+const char* levelName(uint8_t level)
+{
+    switch(static_cast<LogLevel>(level))
+    {
+        case LogLevel::Info:    return "info";
+        case LogLevel::Error:   return "error";
+        case LogLevel::Warning: return "warning";
+        case LogLevel::Success: return "success";
+    }
+    return "unknown";
+}
+
+void timeStamp(uint64_t timeMs, char* buffer, size_t size)
+{
+    time_t seconds = (time_t)(timeMs / 1000);
+    tm time;
+    char date[24];
+
+    gmtime_r(&seconds, &time);
+    strftime(date, sizeof(date), "%F %T", &time);
+    snprintf(buffer, size, "%s:%03d", date, (int)(timeMs % 1000));
+}
+
+///----------------------------------------------------------------------------------
+/// Formats one argument with its conversion specification, the '*' of which have been
+/// replaced by their values.
+///----------------------------------------------------------------------------------
+bool renderArgument(Reader& reader, const std::string& flags, char conversion, std::string& out)
+{
+    uint8_t tag;
+    char buffer[512];
+
+    if(not reader.u8(tag))
+    {
+        return false;
+    }
+
+    std::string spec = "%" + flags;
+
+    switch(tag)
+    {
+        case 'i':
+        case 'u':
+        {
+            uint64_t value;
+            if(not reader.u64(value)) { return false; }
+
+            if(conversion == 'c')
+            {
+                snprintf(buffer, sizeof(buffer), (spec + "c").c_str(), (int)value);
+            }
+            else if(conversion == 'p')
+            {
+                snprintf(buffer, sizeof(buffer), (spec + "llx").c_str(), (unsigned long long)value);
+                out += "0x";
+            }
+            else if(tag == 'i')
+            {
+                snprintf(buffer, sizeof(buffer), (spec + "ll" + conversion).c_str(), (long long)value);
+            }
+            else
+            {
+                snprintf(buffer, sizeof(buffer), (spec + "ll" + conversion).c_str(), (unsigned long long)value);
+            }
+            break;
+        }
+        case 'f':
+        {
+            uint64_t bits;
+            double value;
+            if(not reader.u64(bits)) { return false; }
+            memcpy(&value, &bits, sizeof(value));
+            snprintf(buffer, sizeof(buffer), (spec + conversion).c_str(), value);
+            break;
+        }
+        case 's':
+        {
+            uint8_t size;
+            char text[STRUCTURED_LOG_MAX_STRING + 1];
+            if(not reader.u8(size) || size > STRUCTURED_LOG_MAX_STRING || not reader.bytes(text, size)) { return false; }
+            text[size] = '\0';
+            snprintf(buffer, sizeof(buffer), (spec + "s").c_str(), text);
+            break;
+        }
+        default:
+            return false;
+    }
+
+    out += buffer;
+    return true;
+}
+
+bool renderRecord(Reader& reader, const std::map<uint32_t, std::string>& formats, std::string& text)
+{
+    uint32_t id;
+    uint8_t level;
+    uint64_t timeMs;
+    uint8_t count;
+
+    if(not reader.u32(id) || not reader.u8(level) || not reader.u64(timeMs) || not reader.u8(count))
+    {
+        return false;
+    }
+
+    char stamp[40];
+    timeStamp(timeMs, stamp, sizeof(stamp));
+    text += std::string("[") + stamp + "] <" + levelName(level) + ">\t ";
+
+    auto it = formats.find(id);
+    if(it == formats.end())
+    {
+        char unknown[32];
+        snprintf(unknown, sizeof(unknown), "<unknown format %08x>\n", id);
+        text += unknown;
+
+        // Skip the arguments without the format
+        for(int i = 0; i < count; i++)
+        {
+            uint8_t tag, size;
+            uint64_t value;
+            if(not reader.u8(tag)) { return false; }
+            if(tag == 's')
+            {
+                char skipped[STRUCTURED_LOG_MAX_STRING];
+                if(not reader.u8(size) || size > STRUCTURED_LOG_MAX_STRING || not reader.bytes(skipped, size)) { return false; }
+            }
+            else if(not reader.u64(value)) { return false; }
+        }
+        return true;
+    }
+
+    const char* p = it->second.c_str();
+    std::string literal;
+    Conversion spec;
+
+    while(nextConversion(p, spec, &literal))
+    {
+        text += literal;
+        literal.clear();
+
+        // Replace the '*' by the values passed for them
+        std::string flags;
+        for(char c : spec.flags)
+        {
+            if(c != '*')
+            {
+                flags += c;
+                continue;
+            }
+            uint8_t tag;
+            uint64_t value;
+            if(not reader.u8(tag) || not reader.u64(value)) { return false; }
+            flags += std::to_string((long long)value);
+        }
+
+        if(not renderArgument(reader, flags, spec.conversion, text))
+        {
+            return false;
+        }
+    }
+
+    text += literal;
+
+    // Log lines are terminated by the logger rather than the format
+    text += "\n";
+    return true;
+}
+
+}
+
+
+uint32_t StructuredLog::formatId(const char* format)
+{
+    return hash(format, strlen(format));
+}
+
+uint32_t StructuredLog::hash(const char* data, size_t length)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for(size_t i = 0; i < length; i++)
+    {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+uint32_t StructuredLog::contentHash(const char* data, size_t length)
+{
+    // 'R', id and level, then the time and the rest
+    const size_t headerSize = 1 + 4 + 1;
+    const size_t timeSize = 8;
+    size_t start = 0;
+
+    // Skip the dictionary entries
+    while(start + 7 <= length && data[start] == 'F')
+    {
+        uint16_t size = (uint8_t)data[start + 5] | ((uint8_t)data[start + 6] << 8);
+        start += 7 + size;
+    }
+
+    if(start + headerSize + timeSize > length)
+    {
+        return hash(data, length);
+    }
+
+    uint32_t header = hash(data + start, headerSize);
+    uint32_t rest = hash(data + start + headerSize + timeSize, length - start - headerSize - timeSize);
+    return header ^ (rest * 16777619u);
+}
+
+size_t StructuredLog::encode(char* buffer, size_t size, LogLevel level, uint64_t timeMs,
+                             const char* format, va_list args, bool withFormat)
+{
+    Writer writer(buffer, size);
+    uint32_t id = formatId(format);
+
+    if(withFormat)
+    {
+        size_t length = strlen(format);
+        if(length > UINT16_MAX)
+        {
+            return 0;
+        }
+        writer.u8('F');
+        writer.u32(id);
+        writer.u16((uint16_t)length);
+        writer.bytes(format, length);
+    }
+
+    writer.u8('R');
+    writer.u32(id);
+    writer.u8(static_cast<uint8_t>(level));
+    writer.u64(timeMs);
+
+    // The argument count is only known once the format has been walked
+    char arguments[LOG_RECORD_SIZE];
+    Writer argWriter(arguments, sizeof(arguments));
+    int count = 0;
+
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+
+    const char* p = format;
+    Conversion spec;
+    bool valid = true;
+
+    while(valid && nextConversion(p, spec))
+    {
+        for(int i = 0; i < spec.stars; i++)
+        {
+            argWriter.u8('i');
+            argWriter.u64((uint64_t)(int64_t)va_arg(argsCopy, int));
+            count++;
+        }
+
+        const std::string& length = spec.length;
+        switch(spec.conversion)
+        {
+            case 'd':
+            case 'i':
+            {
+                int64_t value;
+                if(length == "l")       { value = va_arg(argsCopy, long); }
+                else if(length == "ll" || length == "q") { value = va_arg(argsCopy, long long); }
+                else if(length == "z")  { value = va_arg(argsCopy, ptrdiff_t); }
+                else if(length == "j")  { value = va_arg(argsCopy, intmax_t); }
+                else if(length == "t")  { value = va_arg(argsCopy, ptrdiff_t); }
+                else                    { value = va_arg(argsCopy, int); }
+                argWriter.u8('i');
+                argWriter.u64((uint64_t)value);
+                break;
+            }
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X':
+            case 'c':
+            {
+                uint64_t value;
+                if(length == "l")       { value = va_arg(argsCopy, unsigned long); }
+                else if(length == "ll" || length == "q") { value = va_arg(argsCopy, unsigned long long); }
+                else if(length == "z")  { value = va_arg(argsCopy, size_t); }
+                else if(length == "j")  { value = va_arg(argsCopy, uintmax_t); }
+                else if(length == "t")  { value = va_arg(argsCopy, ptrdiff_t); }
+                else                    { value = va_arg(argsCopy, unsigned int); }
+                argWriter.u8('u');
+                argWriter.u64(value);
+                break;
+            }
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+            {
+                double value = (length == "L") ? (double)va_arg(argsCopy, long double) : va_arg(argsCopy, double);
+                uint64_t bits;
+                memcpy(&bits, &value, sizeof(bits));
+                argWriter.u8('f');
+                argWriter.u64(bits);
+                break;
+            }
+            case 's':
+            {
+                const char* value = va_arg(argsCopy, const char*);
+                if(value == NULL)
+                {
+                    value = "(null)";
+                }
+                // Too long to be kept whole, leave it to the text path
+                size_t stringSize = strnlen(value, STRUCTURED_LOG_MAX_STRING + 1);
+                if(stringSize > STRUCTURED_LOG_MAX_STRING)
+                {
+                    valid = false;
+                    break;
+                }
+                argWriter.u8('s');
+                argWriter.u8((uint8_t)stringSize);
+                argWriter.bytes(value, stringSize);
+                break;
+            }
+            case 'p':
+                argWriter.u8('u');
+                argWriter.u64((uint64_t)(uintptr_t)va_arg(argsCopy, void*));
+                break;
+            default:
+                // %n or a malformed specification, leave it to the text path
+                valid = false;
+                break;
+        }
+        count++;
+    }
+    va_end(argsCopy);
+
+    if(not valid || count > STRUCTURED_LOG_MAX_ARGS || (argWriter.size() == 0 && count > 0))
+    {
+        return 0;
+    }
+
+    writer.u8((uint8_t)count);
+    writer.bytes(arguments, argWriter.size());
+    return writer.size();
+}
+
+size_t StructuredLog::encodeText(char* buffer, size_t size, LogLevel level, uint64_t timeMs,
+                                 const char* text)
+{
+    Writer writer(buffer, size);
+    size_t length = strlen(text);
+
+    if(length > UINT16_MAX)
+    {
+        length = UINT16_MAX;
+    }
+
+    writer.u8('T');
+    writer.u8(static_cast<uint8_t>(level));
+    writer.u64(timeMs);
+    writer.u16((uint16_t)length);
+    writer.bytes(text, length);
+    return writer.size();
+}
+
+bool StructuredLog::render(const char* data, size_t length, std::map<uint32_t, std::string>& formats,
+                           std::string& text)
+{
+    Reader reader(data, length);
+
+    while(not reader.atEnd())
+    {
+        uint8_t type;
+        if(not reader.u8(type)) { return false; }
+
+        switch(type)
+        {
+            case 'F':
+            {
+                uint32_t id;
+                uint16_t size;
+                if(not reader.u32(id) || not reader.u16(size)) { return false; }
+                std::string format(size, '\0');
+                if(not reader.bytes(&format[0], size)) { return false; }
+                formats[id] = format;
+                break;
+            }
+            case 'R':
+                if(not renderRecord(reader, formats, text)) { return false; }
+                break;
+            case 'T':
+            {
+                uint8_t level;
+                uint64_t timeMs;
+                uint16_t size;
+                if(not reader.u8(level) || not reader.u64(timeMs) || not reader.u16(size)) { return false; }
+                std::string line(size, '\0');
+                if(not reader.bytes(&line[0], size)) { return false; }
+                text += line;
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+void StructuredLog::writeRecord(std::ostream& out, const char* data, size_t length,
+                                std::map<uint32_t, std::string>& formats, std::set<uint32_t>& fileFormats)
+{
+    Reader reader(data, length);
+    size_t start = 0;
+    uint8_t type = 0;
+
+    while(reader.u8(type) && type == 'F')
+    {
+        uint32_t id;
+        uint16_t size;
+        if(not reader.u32(id) || not reader.u16(size)) { return; }
+        std::string format(size, '\0');
+        if(not reader.bytes(&format[0], size)) { return; }
+        formats[id] = format;
+        start += 7 + size;
+    }
+
+    uint32_t id;
+    if(type == 'R' && reader.u32(id) && fileFormats.count(id) == 0)
+    {
+        auto it = formats.find(id);
+        if(it != formats.end())
+        {
+            char entry[7];
+            Writer writer(entry, sizeof(entry));
+            writer.u8('F');
+            writer.u32(id);
+            writer.u16((uint16_t)it->second.size());
+
+            out.write(entry, sizeof(entry));
+            out.write(it->second.data(), it->second.size());
+            fileFormats.insert(id);
+        }
+    }
+
+    out.write(data + start, length - start);
+}
+
+namespace {
+
+///----------------------------------------------------------------------------------
+/// The formats the calling thread handed to the writer.
+///----------------------------------------------------------------------------------
+std::unordered_set<uint32_t>& announcedFormats()
+{
+    static thread_local std::unordered_set<uint32_t> s_Announced;
+    return s_Announced;
+}
+
+}
+
+bool StructuredLog::isAnnounced(uint32_t id)
+{
+    return announcedFormats().count(id) > 0;
+}
+
+void StructuredLog::setAnnounced(uint32_t id)
+{
+    announcedFormats().insert(id);
+}
+
+void StructuredLog::startFile(std::ostream& out)
+{
+    out.write(STRUCTURED_LOG_MAGIC, STRUCTURED_LOG_MAGIC_SIZE);
+}
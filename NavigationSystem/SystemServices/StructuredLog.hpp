@@ -0,0 +1,115 @@
+/****************************************************************************************
+ *
+ * File:
+ *         StructuredLog.hpp
+ *
+ * Purpose:
+ *        Encodes log calls into binary records holding the identity of the format string
+ *        and the raw arguments, so the text only gets formatted offline by the decoder,
+ *        setup/decode_log.py.
+ *
+ * Developer Notes:
+ *        File format, all values little endian:
+ *
+ *            "SWL1"                                      magic
+ *            'F' u32 id, u16 length, format              format dictionary entry
+ *            'R' u32 id, u8 level, u64 time, u8 count,   log record, time in unix
+ *                count x (tag, value)                    milliseconds
+ *            'T' u8 level, u64 time, u16 length, text    already formatted text
+ *
+ *        Argument tags: 'i' i64, 'u' u64, 'f' f64, 's' u8 length followed by the bytes.
+ *
+ *        A format string is identified by a hash of its text, so it doesn't matter
+ *        whether it is a literal or a std::string built on the fly. Each thread hands
+ *        the text of a format to the writer in an 'F' entry the first time it logs with
+ *        it, which keeps the logging threads from sharing a dictionary. The writer keeps
+ *        the formats it was handed and writes the entry of a format into a file in front
+ *        of the first record using it, see writeRecord(), so every file of a rotated log
+ *        holds the formats of its own records, whichever thread logged them and whenever.
+ *
+ ***************************************************************************************/
+
+
+#pragma once
+
+
+#include "LogRingBuffer.hpp"
+#include <stdint.h>
+#include <cstdarg>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+
+#define STRUCTURED_LOG_MAGIC            "SWL1"
+#define STRUCTURED_LOG_MAGIC_SIZE       4
+#define STRUCTURED_LOG_EXTENSION        ".slog"
+#define STRUCTURED_LOG_MAX_STRING       64      // Longer string arguments are logged as text
+#define STRUCTURED_LOG_MAX_ARGS         16
+#define STRUCTURED_LOG_TEXT_HEADER      12      // Size of a 'T' record without its text
+
+
+class StructuredLog {
+public:
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Returns the id of a format string, a hash of its text.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static uint32_t formatId(const char* format);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Returns the hash of a block of data, the same one as formatId() uses.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static uint32_t hash(const char* data, size_t length);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Returns a hash of the format and arguments of an encoded record, leaving out the
+    /// time and dictionary entries, so the same call with the same values hashes the same.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static uint32_t contentHash(const char* data, size_t length);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Encodes a printf style log call, returns the size of the record or 0 if it
+    /// doesn't fit in the buffer or uses more than STRUCTURED_LOG_MAX_ARGS arguments.
+    ///
+    /// @param withFormat           Puts the dictionary entry of the format in front of
+    ///                             the record.
+    ///
+    /////////////////////////////////////////////////////////////////////////////////////
+    static size_t encode(char* buffer, size_t size, LogLevel level, uint64_t timeMs,
+                         const char* format, va_list args, bool withFormat);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Encodes a 'T' record holding text which was already formatted.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static size_t encodeText(char* buffer, size_t size, LogLevel level, uint64_t timeMs,
+                             const char* text);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Renders the records of an encoded buffer as log lines, adding the dictionary
+    /// entries it contains to formats. Returns false if the buffer is malformed.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static bool render(const char* data, size_t length, std::map<uint32_t, std::string>& formats,
+                       std::string& text);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Writes an encoded record into a file. The dictionary entries it carries are added
+    /// to formats rather than written, the entry of its format is written in front of it
+    /// if the file doesn't hold it yet.
+    ///
+    /// @param fileFormats          The formats written into the file so far.
+    ///
+    /////////////////////////////////////////////////////////////////////////////////////
+    static void writeRecord(std::ostream& out, const char* data, size_t length,
+                            std::map<uint32_t, std::string>& formats, std::set<uint32_t>& fileFormats);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Tracks the formats the calling thread has handed to the writer.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static bool isAnnounced(uint32_t id);
+    static void setAnnounced(uint32_t id);
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /// Starts a new file, writing its header.
+    /////////////////////////////////////////////////////////////////////////////////////
+    static void startFile(std::ostream& out);
+};
@@ -9,11 +9,12 @@
  */
 
 #include "SysClock.hpp"
+#include "ClockSource.hpp"
 #include <stdio.h>
 #include <ctime>
 #include <sys/time.h>
 
-#define GET_UNIX_TIME() static_cast<long int>(std::time(nullptr))
+#define GET_UNIX_TIME() static_cast<long int>(ClockSource::current().wallUs() / 1000000)
 
 unsigned long	SysClock::m_LastUpdated = NEVER_UPDATED;
 unsigned long 	SysClock::m_LastTimeStamp = 0;
@@ -26,6 +27,12 @@ void SysClock::setTime(unsigned long unixTime)
 	m_LastTimeStamp = unixTime;
 	m_LastClockTime = GET_UNIX_TIME();
     
+    // A simulated clock keeps its time to itself
+    if(not ClockSource::current().isReal())
+    {
+        return;
+    }
+
     struct timeval tv;
     tv.tv_sec = unixTime; //seconds since 1 jan 1970;
     tv.tv_usec = 0; /* microseconds */
@@ -56,17 +63,7 @@ unsigned long SysClock::unixTime()
 unsigned int SysClock::millis()
 {
 	// Get Milliseconds
-    timeval curTime;
-    
-    gettimeofday(&curTime, NULL);
-    
-    /**
-     *  @todo check
-    if(gettimeofday(&curTime, NULL) != 0)
-        throw std::runtime_error{"failed to get system time"};
-     */
-    
-	return curTime.tv_usec / 1000;
+	return (ClockSource::current().wallUs() / 1000) % 1000;
 }
 
 std::string SysClock::timeStampStr()
@@ -76,7 +73,10 @@ std::string SysClock::timeStampStr()
 	unsigned long seconds = unixTime();
 
 	time_t unix_time = (time_t)seconds;
-	strftime(buff, sizeof(buff), "%F %T", gmtime(&unix_time));
+	// Called by every logging thread, gmtime's static struct isn't safe to share
+	tm time;
+	gmtime_r(&unix_time, &time);
+	strftime(buff, sizeof(buff), "%F %T", &time);
 
 	return std::string(buff);
 }
@@ -0,0 +1,213 @@
+/**
+ * @file   ThreadConfig.cpp
+ * @version 1.0.0
+ * @author SailingRobots team
+ * @date   2017
+ * @brief  The CPU affinity, scheduling policy and name of the threads of the system.
+ *
+ */
+
+#include "ThreadConfig.hpp"
+#include "Logger.hpp"
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+#define THREAD_NAME_MAX_LENGTH 15   // Without the terminating null
+#define NICE_MIN -20
+#define NICE_MAX 19
+
+static std::mutex settingsMutex;
+static std::map<std::string, ThreadSettings> threadSettings;
+
+
+///----------------------------------------------------------------------------------
+/// Reads the settings of one thread, throws if they are invalid.
+///----------------------------------------------------------------------------------
+static ThreadSettings parseSettings(const nlohmann::json& entry)
+{
+    ThreadSettings settings;
+
+    if (not entry.is_object())
+    {
+        throw std::invalid_argument("expected an object");
+    }
+
+    settings.name = entry.value("name", std::string());
+    if (entry.count("cpus") > 0)
+    {
+        settings.cpus = entry.at("cpus").get<std::vector<int>>();
+    }
+
+    std::string policy = entry.value("policy", std::string("default"));
+    if (policy == "fifo")
+    {
+        settings.policy = ThreadPolicy::Fifo;
+    }
+    else if (policy != "default")
+    {
+        throw std::invalid_argument("unknown policy " + policy);
+    }
+
+    settings.priority = entry.value("priority", 0);
+    settings.nice = entry.value("nice", 0);
+    if (settings.nice < NICE_MIN || settings.nice > NICE_MAX)
+    {
+        throw std::invalid_argument("nice value out of range");
+    }
+
+    for (int cpu : settings.cpus)
+    {
+        if (cpu < 0 || cpu >= CPU_SETSIZE)
+        {
+            throw std::invalid_argument("invalid cpu " + std::to_string(cpu));
+        }
+    }
+    return settings;
+}
+
+bool ThreadConfig::load(const std::string& filePath)
+{
+    std::ifstream file(filePath);
+    if (not file.is_open())
+    {
+        return false;
+    }
+
+    nlohmann::json config;
+    try
+    {
+        file >> config;
+    }
+    catch (std::exception& e)
+    {
+        Logger::error("%s: could not parse %s: %s", __PRETTY_FUNCTION__, filePath.c_str(), e.what());
+        return false;
+    }
+    return loadJson(config);
+}
+
+bool ThreadConfig::loadJson(const nlohmann::json& config)
+{
+    if (not config.is_object())
+    {
+        Logger::error("%s: the thread settings are not an object", __PRETTY_FUNCTION__);
+        return false;
+    }
+
+    bool valid = true;
+    for (auto it = config.begin(); it != config.end(); ++it)
+    {
+        try
+        {
+            set(it.key(), parseSettings(it.value()));
+        }
+        catch (std::exception& e)
+        {
+            Logger::error("%s: invalid settings for %s: %s", __PRETTY_FUNCTION__, it.key().c_str(), e.what());
+            valid = false;
+        }
+    }
+    return valid;
+}
+
+void ThreadConfig::set(const std::string& thread, const ThreadSettings& settings)
+{
+    std::lock_guard<std::mutex> lock(settingsMutex);
+    threadSettings[thread] = settings;
+}
+
+bool ThreadConfig::get(const std::string& thread, ThreadSettings& settings)
+{
+    std::lock_guard<std::mutex> lock(settingsMutex);
+    auto it = threadSettings.find(thread);
+
+    if (it == threadSettings.end())
+    {
+        return false;
+    }
+    settings = it->second;
+    return true;
+}
+
+void ThreadConfig::clear()
+{
+    std::lock_guard<std::mutex> lock(settingsMutex);
+    threadSettings.clear();
+}
+
+bool ThreadConfig::apply(const std::string& thread)
+{
+    ThreadSettings settings;
+    get(thread, settings);
+    return apply(thread, settings);
+}
+
+bool ThreadConfig::apply(const std::string& thread, const ThreadSettings& settings)
+{
+    bool applied = true;
+    pthread_t self = pthread_self();
+
+    std::string name = settings.name.empty() ? thread : settings.name;
+    name = name.substr(0, THREAD_NAME_MAX_LENGTH);
+    int error = pthread_setname_np(self, name.c_str());
+    if (error != 0)
+    {
+        Logger::warning("%s: could not name the thread %s: %s", __PRETTY_FUNCTION__, thread.c_str(), strerror(error));
+        applied = false;
+    }
+
+    if (not settings.cpus.empty())
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (int cpu : settings.cpus)
+        {
+            CPU_SET(cpu, &cpus);
+        }
+
+        error = pthread_setaffinity_np(self, sizeof(cpus), &cpus);
+        if (error != 0)
+        {
+            Logger::warning("%s: could not pin %s to its CPUs: %s", __PRETTY_FUNCTION__, thread.c_str(), strerror(error));
+            applied = false;
+        }
+    }
+
+    if (settings.policy == ThreadPolicy::Fifo)
+    {
+        sched_param param;
+        param.sched_priority = std::max(sched_get_priority_min(SCHED_FIFO),
+                                        std::min(settings.priority, sched_get_priority_max(SCHED_FIFO)));
+
+        error = pthread_setschedparam(self, SCHED_FIFO, &param);
+        if (error != 0)
+        {
+            Logger::warning("%s: could not run %s at the real-time priority %d: %s", __PRETTY_FUNCTION__,
+                            thread.c_str(), param.sched_priority, strerror(error));
+            applied = false;
+        }
+    }
+    else if (settings.nice != 0)
+    {
+        // On Linux the nice value is per thread, given its thread ID
+        pid_t tid = (pid_t)syscall(SYS_gettid);
+        if (setpriority(PRIO_PROCESS, tid, settings.nice) != 0)
+        {
+            Logger::warning("%s: could not set the nice value of %s to %d: %s", __PRETTY_FUNCTION__, thread.c_str(),
+                            settings.nice, strerror(errno));
+            applied = false;
+        }
+    }
+
+    return applied;
+}
@@ -0,0 +1,80 @@
+/**
+ * @file   ThreadConfig.hpp
+ * @version 1.0.0
+ * @author SailingRobots team
+ * @date   2017
+ * @brief  The CPU affinity, scheduling policy and name of the threads of the system, so
+ *         that the control loops keep cores of their own while the bulk work (logging,
+ *         syncing, camera processing) runs on the others.
+ *
+ * Developer Notes:
+ *         The settings are looked up by the name of a thread: the node name for the
+ *         thread of an active node, "MessageBus" for the dispatch loop, "DeliveryPool"
+ *         for its workers in parallel delivery, "Scheduler" and "SchedulerTimer" for the
+ *         threads of the shared scheduler, "CANService" and "DBLoggerWriter". They are read
+ *         from a JSON file, next to the database, of the form
+ *
+ *             { "CourseRegulatorNode": { "cpus": [3], "policy": "fifo", "priority": 50 },
+ *               "DBLoggerNode": { "cpus": [0, 1, 2], "nice": 10, "name": "dblogger" } }
+ *
+ *         Other keys of an entry, such as a "comment", are ignored.
+ *
+ *         The periodic nodes running on the shared scheduler take the settings of its
+ *         workers instead of their own.
+ *
+ *         A thread applies its settings itself, once it is running. A thread without
+ *         settings is only named. SCHED_FIFO, and a nice value under 0, need root or
+ *         CAP_SYS_NICE, without it the thread carries on with the default scheduling.
+ *
+ */
+
+#ifndef THREADCONFIG_HPP
+#define THREADCONFIG_HPP
+
+#include "../Libs/json/include/nlohmann/json.hpp"
+#include <string>
+#include <vector>
+
+enum class ThreadPolicy {
+    Default,    ///< SCHED_OTHER, weighted by the nice value
+    Fifo        ///< SCHED_FIFO at a real-time priority
+};
+
+struct ThreadSettings {
+    ThreadSettings() : policy(ThreadPolicy::Default), priority(0), nice(0) {}
+
+    std::string name;           ///< Thread name, at most 15 characters, the key if empty
+    std::vector<int> cpus;      ///< CPUs the thread may run on, any of them if empty
+    ThreadPolicy policy;
+    int priority;               ///< Real-time priority, for the FIFO policy only
+    int nice;                   ///< For the default policy only
+};
+
+class ThreadConfig {
+   public:
+    ///----------------------------------------------------------------------------------
+    /// Reads the settings from a JSON file, in addition to those already set. Returns
+    /// false if the file can't be read, or if one of the entries is invalid in which
+    /// case the valid ones are kept.
+    ///----------------------------------------------------------------------------------
+    static bool load(const std::string& filePath);
+    static bool loadJson(const nlohmann::json& config);
+
+    static void set(const std::string& thread, const ThreadSettings& settings);
+
+    ///----------------------------------------------------------------------------------
+    /// Returns true and fills in the settings if the thread has any.
+    ///----------------------------------------------------------------------------------
+    static bool get(const std::string& thread, ThreadSettings& settings);
+
+    static void clear();
+
+    ///----------------------------------------------------------------------------------
+    /// Applies the settings of a thread to the calling thread, which is named after the
+    /// thread if it has none. Returns false if one of them couldn't be applied.
+    ///----------------------------------------------------------------------------------
+    static bool apply(const std::string& thread);
+    static bool apply(const std::string& thread, const ThreadSettings& settings);
+};
+
+#endif /* THREADCONFIG_HPP */
@@ -6,14 +6,16 @@
  * @brief  Keep track of time passing
  */
 
-#include <thread>
 #include "Timer.hpp"
+#include "ClockSource.hpp"
+#include "Logger.hpp"
+#include <map>
+#include <mutex>
 
 ///////////////////// Class Functions Definition /////////////////////
 
-#define STEADY_CLOCK std::chrono::steady_clock
-#define DURATION_CAST std::chrono::duration_cast
-#define DURATION std::chrono::duration
+#define NOW_US() ClockSource::current().steadyUs()
+#define MICRO_PER_SECOND 1000000.0
 
 /**
  *   @brief  Timer object constructor
@@ -21,7 +23,7 @@
  */
 Timer::Timer()
 {
-    m_start = STEADY_CLOCK::now();
+    m_start = NOW_US();
     m_running = false;
     m_timePassed = 0;
 }
@@ -34,7 +36,7 @@ void Timer::start()
 {
     if (!m_running)
     {
-        m_start = STEADY_CLOCK::now();
+        m_start = NOW_US();
         m_running = true;
     }
 }
@@ -45,7 +47,7 @@ void Timer::start()
  */
 void Timer::reset()
 {
-    m_start = STEADY_CLOCK::now();
+    m_start = NOW_US();
     m_running = true;
 }
 
@@ -68,13 +70,9 @@ double Timer::timePassed()
 {
     if(m_running)
     {
-        STEADY_CLOCK::time_point end;
-        DURATION<double> time_span;
-        
         // the time to count the difference is not included
-        end = STEADY_CLOCK::now();
-        time_span = DURATION_CAST<DURATION<double>>(end - m_start);
-        return time_span.count();
+        uint64_t end = NOW_US();
+        return (end - m_start) / MICRO_PER_SECOND;
     }
     else
     {
@@ -97,11 +95,20 @@ double Timer::timeUntil(double unixTime)
  */
 void Timer::sleepUntil(double seconds)
 {
-    long int microseconds;
-    int toMicro = 1000*1000; // microseconds (us) = 10⁻⁶ s
-    
-    microseconds = timeUntil(seconds) * toMicro;
-    std::this_thread::sleep_for(std::chrono::microseconds(microseconds));
+    if (seconds <= 0)
+    {
+        return;
+    }
+
+    if (m_running)
+    {
+        // From the start rather than from now, so that a loop doesn't drift
+        ClockSource::current().sleepUntilUs(m_start + (uint64_t)(seconds * MICRO_PER_SECOND));
+    }
+    else if (timeUntil(seconds) > 0)
+    {
+        ClockSource::current().sleepForUs((uint64_t)(timeUntil(seconds) * MICRO_PER_SECOND));
+    }
 }
 
 /**
@@ -117,3 +124,153 @@ bool Timer::timeReached(double seconds)
     }
     return false;
 }
+
+///////////////////// FixedRateTimer /////////////////////
+
+struct FixedRateTimer::Record {
+    std::mutex mutex;
+    LoopStatistics statistics;
+};
+
+static std::mutex registryMutex;
+
+/**
+ *   @brief  The statistics of every loop by name, guarded by registryMutex
+ */
+static std::map<std::string, std::shared_ptr<FixedRateTimer::Record>>& registry()
+{
+    static std::map<std::string, std::shared_ptr<FixedRateTimer::Record>> records;
+    return records;
+}
+
+FixedRateTimer::FixedRateTimer(const std::string& name)
+    : m_periodUs(0), m_lastDeadline(0), m_lastWake(0), m_running(false)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    std::shared_ptr<Record>& record = registry()[name];
+    if (not record)
+    {
+        record = std::make_shared<Record>();
+        record->statistics = LoopStatistics();
+        record->statistics.name = name;
+    }
+    m_record = record;
+}
+
+/**
+ *   @brief  Starts the loop
+ *   @detail The deadlines are counted from now on
+ */
+void FixedRateTimer::start()
+{
+    m_lastDeadline = NOW_US();
+    m_lastWake = m_lastDeadline;
+    m_running = true;
+}
+
+/**
+ *   @brief  Sleeps until the next deadline and records how late it woke up
+ */
+void FixedRateTimer::sleepUntilNext(double periodS)
+{
+    ClockSource& clock = ClockSource::current();
+
+    if (not m_running)
+    {
+        start();
+    }
+
+    m_periodUs = (periodS > 0) ? (uint64_t)(periodS * MICRO_PER_SECOND) : 1;
+
+    uint64_t now = clock.steadyUs();
+    uint64_t busy = now - m_lastWake;
+    uint64_t deadline = m_lastDeadline + m_periodUs;
+    uint64_t skipped = 0;
+    bool overrun = false;
+    uint64_t wake;
+
+    if (now > deadline)
+    {
+        // Carry on from the last deadline which went by rather than catching up
+        overrun = true;
+        skipped = (now - deadline) / m_periodUs;
+        deadline += skipped * m_periodUs;
+        wake = now;
+    }
+    else
+    {
+        clock.sleepUntilUs(deadline);
+        wake = clock.steadyUs();
+    }
+
+    uint64_t lateness = wake - deadline;
+    m_lastDeadline = deadline;
+    m_lastWake = wake;
+
+    std::lock_guard<std::mutex> lock(m_record->mutex);
+    LoopStatistics& statistics = m_record->statistics;
+
+    statistics.periodS = periodS;
+    statistics.loops++;
+    statistics.overruns += overrun;
+    statistics.skipped += skipped;
+    statistics.totalLatenessUs += lateness;
+    statistics.totalBusyUs += busy;
+    if (lateness > statistics.maxLatenessUs)
+    {
+        statistics.maxLatenessUs = lateness;
+    }
+    if (busy > statistics.maxBusyUs)
+    {
+        statistics.maxBusyUs = busy;
+    }
+}
+
+LoopStatistics FixedRateTimer::statistics() const
+{
+    std::lock_guard<std::mutex> lock(m_record->mutex);
+    return m_record->statistics;
+}
+
+std::vector<LoopStatistics> FixedRateTimer::allStatistics()
+{
+    std::vector<LoopStatistics> statistics;
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    for (auto& entry : registry())
+    {
+        std::lock_guard<std::mutex> recordLock(entry.second->mutex);
+        statistics.push_back(entry.second->statistics);
+    }
+    return statistics;
+}
+
+void FixedRateTimer::resetStatistics()
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    for (auto& entry : registry())
+    {
+        std::lock_guard<std::mutex> recordLock(entry.second->mutex);
+        entry.second->statistics = LoopStatistics();
+        entry.second->statistics.name = entry.first;
+    }
+}
+
+/**
+ *   @brief  Logs how well each loop kept to its period
+ */
+void FixedRateTimer::logStatistics()
+{
+    for (const LoopStatistics& loop : allStatistics())
+    {
+        if (loop.loops > 0)
+        {
+            Logger::info("%s loop: period %.0f ms, %lu loops, %lu overruns, %lu periods skipped, lateness mean %.0f us max %lu us, busy mean %.0f us max %lu us",
+                loop.name.c_str(), loop.periodS * 1000, (unsigned long)loop.loops, (unsigned long)loop.overruns,
+                (unsigned long)loop.skipped, loop.meanLatenessUs(), (unsigned long)loop.maxLatenessUs,
+                loop.meanBusyUs(), (unsigned long)loop.maxBusyUs);
+        }
+    }
+}
@@ -3,13 +3,16 @@
  * @version 1.0.0
  * @author SailingRobots team
  * @date   2017
- * @brief  Keep track of time passing
+ * @brief  Keep track of time passing, on the clock given by ClockSource::current()
  */
 
 #ifndef TIMER_HPP
 #define TIMER_HPP
 
-#include <chrono>
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
 
 class Timer {
    public:
@@ -54,9 +57,72 @@ class Timer {
     bool started() { return m_running; }
 
    private:
-    std::chrono::steady_clock::time_point m_start;
+    uint64_t m_start;          // Steady time in microseconds
     bool m_running;
     double m_timePassed;
 };
 
+///----------------------------------------------------------------------------------
+/// How well a fixed rate loop kept to its period. The lateness is how long after its
+/// deadline a loop woke up, the busy time how long the body of the loop took.
+///----------------------------------------------------------------------------------
+struct LoopStatistics {
+    std::string name;
+    double periodS;
+    uint64_t loops;
+    uint64_t overruns;         // Bodies which went past the next deadline
+    uint64_t skipped;          // Whole periods missed by those
+    uint64_t totalLatenessUs;
+    uint64_t maxLatenessUs;
+    uint64_t totalBusyUs;
+    uint64_t maxBusyUs;
+
+    double meanLatenessUs() const { return loops > 0 ? (double)totalLatenessUs / loops : 0; }
+    double meanBusyUs() const { return loops > 0 ? (double)totalBusyUs / loops : 0; }
+};
+
+///----------------------------------------------------------------------------------
+/// Paces the loop of an active node. The deadlines are multiples of the period from
+/// the start, so the time the body takes doesn't push the next iterations back. A body
+/// running past the next deadline is an overrun, the loop carries on straight away and
+/// any period missed entirely is skipped so the loop stays in phase.
+///
+/// The statistics are kept by name and outlive the timer, a node restarting its thread
+/// carries on with the same ones.
+///----------------------------------------------------------------------------------
+class FixedRateTimer {
+   public:
+    FixedRateTimer(const std::string& name);
+
+    /*
+     * sets the phase of the loop to the current time
+     */
+    void start();
+
+    /*
+     * sleeps until the next deadline of a loop with the provided period in seconds,
+     * a new period applies from the last deadline
+     */
+    void sleepUntilNext(double periodS);
+
+    LoopStatistics statistics() const;
+
+    /*
+     * returns the statistics of every fixed rate loop which ran
+     */
+    static std::vector<LoopStatistics> allStatistics();
+    static void resetStatistics();
+    static void logStatistics();
+
+    struct Record;  // Defined in Timer.cpp
+
+   private:
+
+    std::shared_ptr<Record> m_record;
+    uint64_t m_periodUs;
+    uint64_t m_lastDeadline;
+    uint64_t m_lastWake;
+    bool m_running;
+};
+
 #endif /* TIMER_HPP */
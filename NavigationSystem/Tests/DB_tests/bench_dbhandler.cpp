@@ -0,0 +1,294 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		bench_dbhandler.cpp
+ *
+ * Purpose:
+ *		Measures the queries per second of the DBHandler, against opening and closing
+ *		the database around every query as it used to, then the data log inserts and the
+ *		time a log reader and the inserts hold each other up in each journal mode, and
+ *		whether the inserts get slower as the log tables grow.
+ *
+ * Usage:
+ *		./db_bench [createtables.sql] [queries]
+ *
+ ***************************************************************************************/
+
+#include "Database/DBHandler.hpp"
+#include "SystemServices/Logger.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BENCH_DB_FILE       "benchdb.db"
+#define BENCH_THREADS       4
+#define DEFAULT_QUERIES     2000
+#define LOG_BATCHES         300
+#define LOG_BATCH_SIZE      5   // About what the DB logger writes at a time
+#define GROWTH_BATCHES      4000
+#define GROWTH_SAMPLE       200
+
+static std::mutex reopenLock;
+
+typedef std::chrono::steady_clock BenchClock;
+
+static double secondsSince(BenchClock::time_point start) {
+    return std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+static bool createDatabase(const std::string& schemaPath) {
+    std::ifstream schemaFile(schemaPath);
+    if (not schemaFile.is_open()) {
+        std::cerr << "Could not read " << schemaPath << std::endl;
+        return false;
+    }
+    std::stringstream schema;
+    schema << schemaFile.rdbuf();
+
+    std::remove(BENCH_DB_FILE);
+    std::remove(BENCH_DB_FILE "-wal");
+    std::remove(BENCH_DB_FILE "-shm");
+    sqlite3* db = NULL;
+    sqlite3_open(BENCH_DB_FILE, &db);
+    char* error = NULL;
+    sqlite3_exec(db, schema.str().c_str(), NULL, NULL, &error);
+    if (error != NULL) {
+        std::cerr << "Could not create the database: " << error << std::endl;
+        sqlite3_free(error);
+        sqlite3_close(db);
+        return false;
+    }
+    sqlite3_close(db);
+    return true;
+}
+
+///----------------------------------------------------------------------------------
+/// One config read the way DBHandler did it before keeping its connections open
+///----------------------------------------------------------------------------------
+static double reopenedQuery() {
+    std::lock_guard<std::mutex> lock(reopenLock);
+
+    FILE* dbFile = fopen(BENCH_DB_FILE, "r");
+    fclose(dbFile);
+
+    sqlite3* db = NULL;
+    sqlite3_open(BENCH_DB_FILE, &db);
+    sqlite3_busy_timeout(db, 10);
+
+    sqlite3_stmt* statement = NULL;
+    double value = 0;
+    sqlite3_prepare_v2(db, "SELECT loop_time FROM config_dblogger WHERE id=1;", -1, &statement, NULL);
+    if (sqlite3_step(statement) == SQLITE_ROW) {
+        value = sqlite3_column_double(statement, 0);
+    }
+    sqlite3_finalize(statement);
+
+    sqlite3_close(db);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return value;
+}
+
+///----------------------------------------------------------------------------------
+/// Runs the queries spread over a number of threads, returns the queries per second
+///----------------------------------------------------------------------------------
+template <typename Query>
+static double queriesPerSecond(int queries, int threadCount, Query query) {
+    std::vector<std::thread> threads;
+    BenchClock::time_point start = BenchClock::now();
+
+    for (int i = 0; i < threadCount; i++) {
+        threads.push_back(std::thread([=] {
+            for (int j = 0; j < queries / threadCount; j++) {
+                query();
+            }
+        }));
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return (queries / threadCount) * threadCount / secondsSince(start);
+}
+
+static void report(const std::string& what, double reopened, double pooled) {
+    printf("%-34s %10.0f q/s %10.0f q/s %8.1fx\n", what.c_str(), reopened, pooled, pooled / reopened);
+}
+
+///----------------------------------------------------------------------------------
+/// The longest and the mean time of the calls
+///----------------------------------------------------------------------------------
+struct Latency {
+    Latency() : calls(0), total(0), longest(0) {}
+
+    void add(double seconds) {
+        calls++;
+        total += seconds;
+        longest = std::max(longest, seconds);
+    }
+    double meanMs() const { return calls > 0 ? total / calls * 1000 : 0; }
+    double longestMs() const { return longest * 1000; }
+
+    int calls;
+    double total;
+    double longest;
+};
+
+///----------------------------------------------------------------------------------
+/// Inserts batches of data logs while another thread keeps reading all of them back,
+/// as the HTTP sync does when it pushes the logs
+///----------------------------------------------------------------------------------
+static void benchDataLogs(const std::string& schemaPath, const std::string& what, const DBSettings& settings) {
+    if (not createDatabase(schemaPath)) {
+        return;
+    }
+    DBHandler dbHandler(BENCH_DB_FILE, settings);
+    if (not dbHandler.initialise()) {
+        std::cerr << "Could not open " << BENCH_DB_FILE << std::endl;
+        return;
+    }
+
+    std::vector<LogItem> batch(LOG_BATCH_SIZE, LogItem());
+    for (LogItem& item : batch) {
+        item.m_element_str = "compass";
+        item.m_timestamp_str = "2018-05-30 12:00:00.000";
+    }
+
+    Latency inserts;
+    Latency reads;
+    std::atomic<bool> writing(true);
+
+    std::thread reader([&] {
+        while (writing.load()) {
+            BenchClock::time_point start = BenchClock::now();
+            dbHandler.getLogs(false);
+            reads.add(secondsSince(start));
+        }
+    });
+
+    BenchClock::time_point start = BenchClock::now();
+    for (int i = 0; i < LOG_BATCHES; i++) {
+        BenchClock::time_point insertStart = BenchClock::now();
+        dbHandler.insertDataLogs(batch);
+        inserts.add(secondsSince(insertStart));
+    }
+    double elapsed = secondsSince(start);
+    writing.store(false);
+    reader.join();
+
+    std::string count = dbHandler.getIdFromTable("dataLogs_system", true);
+    printf("%-24s %8.0f logs/s %7.2f %7.2f ms %7.2f %7.2f ms %6d %6s\n", what.c_str(),
+           LOG_BATCHES * LOG_BATCH_SIZE / elapsed, inserts.meanMs(), inserts.longestMs(),
+           reads.meanMs(), reads.longestMs(), reads.calls, count.c_str());
+
+    dbHandler.close();
+}
+
+///----------------------------------------------------------------------------------
+/// Compares the time of the first batches of logs with the last ones, once the tables
+/// hold all the others. Without waiting for the disk, the time is that of the queries.
+///----------------------------------------------------------------------------------
+static void benchDataLogGrowth(const std::string& schemaPath) {
+    if (not createDatabase(schemaPath)) {
+        return;
+    }
+    DBSettings settings;
+    settings.synchronous = 0;
+    DBHandler dbHandler(BENCH_DB_FILE, settings);
+    if (not dbHandler.initialise()) {
+        std::cerr << "Could not open " << BENCH_DB_FILE << std::endl;
+        return;
+    }
+
+    std::vector<LogItem> batch(LOG_BATCH_SIZE, LogItem());
+    for (LogItem& item : batch) {
+        item.m_element_str = "compass";
+        item.m_timestamp_str = "2018-05-30 12:00:00.000";
+    }
+
+    Latency first;
+    Latency last;
+    for (int i = 0; i < GROWTH_BATCHES; i++) {
+        BenchClock::time_point start = BenchClock::now();
+        dbHandler.insertDataLogs(batch);
+        if (i < GROWTH_SAMPLE) {
+            first.add(secondsSince(start));
+        } else if (i >= GROWTH_BATCHES - GROWTH_SAMPLE) {
+            last.add(secondsSince(start));
+        }
+    }
+
+    printf("\nBatch of %d logs, first %d batches %.3f ms, last %d batches %.3f ms, %s rows\n",
+           LOG_BATCH_SIZE, GROWTH_SAMPLE, first.meanMs(), GROWTH_SAMPLE, last.meanMs(),
+           dbHandler.getIdFromTable("dataLogs_system", true).c_str());
+
+    dbHandler.close();
+}
+
+int main(int argc, char* argv[]) {
+    std::string schemaPath = (argc > 1) ? argv[1] : "../../../setup/createtables.sql";
+    int queries = (argc > 2) ? atoi(argv[2]) : DEFAULT_QUERIES;
+
+    Logger::DisableLogging();
+    if (not createDatabase(schemaPath)) {
+        return EXIT_FAILURE;
+    }
+
+    DBHandler dbHandler(BENCH_DB_FILE);
+    if (not dbHandler.initialise()) {
+        std::cerr << "Could not open " << BENCH_DB_FILE << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto reopenedRead = [] { reopenedQuery(); };
+    auto pooledRead = [&dbHandler] { dbHandler.retrieveCellAsDouble("config_dblogger", "1", "loop_time"); };
+    auto pooledWrite = [&dbHandler] { dbHandler.changeOneValue("config_dblogger", "1", "0.5", "loop_time"); };
+    auto snapshotRead = [&dbHandler] { dbHandler.configs()->getDouble("config_dblogger", "loop_time"); };
+
+    printf("%d queries per run\n", queries);
+    printf("%-34s %14s %14s %9s\n", "", "open per query", "pooled", "gain");
+    report("Config reads, 1 thread", queriesPerSecond(queries, 1, reopenedRead),
+           queriesPerSecond(queries, 1, pooledRead));
+    report("Config reads, " + std::to_string(BENCH_THREADS) + " threads",
+           queriesPerSecond(queries, BENCH_THREADS, reopenedRead),
+           queriesPerSecond(queries, BENCH_THREADS, pooledRead));
+    printf("%-34s %14s %10.0f q/s\n", "Config writes, 1 thread", "",
+           queriesPerSecond(queries / 10, 1, pooledWrite));
+    printf("%-34s %14s %10.0f q/s\n", "Config snapshot reads, 1 thread", "",
+           queriesPerSecond(queries * 10, 1, snapshotRead));
+
+    BenchClock::time_point reloadStart = BenchClock::now();
+    dbHandler.loadConfigs();
+    printf("Every config table reloaded in %.2f ms\n", secondsSince(reloadStart) * 1000);
+    printf("Connections opened: %u\n", dbHandler.openConnections());
+
+    dbHandler.close();
+
+    DBSettings rollbackFull;
+    rollbackFull.journal = DBJournal::Rollback;
+    rollbackFull.synchronous = 2;
+    DBSettings walFull;
+    walFull.synchronous = 2;
+    DBSettings walNormal;
+    walNormal.synchronous = 1;
+
+    printf("\n%d batches of %d logs, read back meanwhile\n", LOG_BATCHES, LOG_BATCH_SIZE);
+    printf("%-24s %15s %18s %18s %6s %6s\n", "", "inserts", "insert mean/max", "read mean/max",
+           "reads", "rows");
+    benchDataLogs(schemaPath, "Rollback, FULL", rollbackFull);
+    benchDataLogs(schemaPath, "WAL, FULL", walFull);
+    benchDataLogs(schemaPath, "WAL, NORMAL", walNormal);
+
+    benchDataLogGrowth(schemaPath);
+
+    std::remove(BENCH_DB_FILE);
+    std::remove(BENCH_DB_FILE "-wal");
+    std::remove(BENCH_DB_FILE "-shm");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		ClockSourceSuite.h
+ *
+ * Purpose:
+ *		Tests SysClock and Timer running on scaled and manually stepped clocks.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../SystemServices/ClockSource.hpp"
+#include "../SystemServices/SysClock.hpp"
+#include "../SystemServices/Timer.hpp"
+#include "../cxxtest/cxxtest/TestSuite.h"
+
+#include <atomic>
+#include <thread>
+
+#define CLOCK_TEST_START_US 1500000000000000ULL  // 2017-07-14 02:40:00
+#define CLOCK_TEST_TIMEOUT_MS 2000
+
+class ClockSourceSuite : public CxxTest::TestSuite {
+   public:
+    ManualClock* clock;
+
+    void setUp() {
+        clock = new ManualClock(CLOCK_TEST_START_US);
+        ClockSource::use(clock);
+    }
+
+    void tearDown() {
+        ClockSource::use(NULL);
+        delete clock;
+    }
+
+    void test_SysClockFollowsTheClock() {
+        TS_ASSERT_EQUALS(SysClock::unixTime(), CLOCK_TEST_START_US / 1000000);
+        TS_ASSERT_EQUALS(SysClock::millis(), 0);
+        TS_ASSERT_EQUALS(SysClock::timeStampStr(), "2017-07-14 02:40:00");
+
+        clock->advanceMs(3600 * 1000 + 250);
+        TS_ASSERT_EQUALS(SysClock::unixTime(), CLOCK_TEST_START_US / 1000000 + 3600);
+        TS_ASSERT_EQUALS(SysClock::millis(), 250);
+        TS_ASSERT_EQUALS(SysClock::hh_mm_ss_ms(), "03:40:00.250");
+    }
+
+    void test_TimerFollowsTheClock() {
+        Timer timer;
+        timer.start();
+        TS_ASSERT_EQUALS(timer.timePassed(), 0);
+
+        clock->advanceMs(1500);
+        TS_ASSERT_DELTA(timer.timePassed(), 1.5, 1e-9);
+        TS_ASSERT(timer.timeReached(1.0));
+        TS_ASSERT(not timer.timeReached(2.0));
+
+        // Nothing to wait for once the time has passed
+        timer.sleepUntil(1.0);
+    }
+
+    void test_SleepersWakeWhenSteppedPastTheirDeadline() {
+        std::atomic<int> loops(0);
+
+        // A node loop of 100ms, five times
+        std::thread loop([&loops] {
+            Timer timer;
+            timer.start();
+            for (int i = 0; i < 5; i++) {
+                timer.sleepUntil(0.1);
+                timer.reset();
+                loops++;
+            }
+        });
+
+        for (int i = 1; i <= 5; i++) {
+            TS_ASSERT(clock->waitForSleepers(1, CLOCK_TEST_TIMEOUT_MS));
+            TS_ASSERT_EQUALS(loops.load(), i - 1);
+
+            // Short of the deadline, the loop keeps sleeping
+            clock->advanceMs(99);
+            TS_ASSERT_EQUALS(clock->sleepers(), 1);
+
+            clock->advanceMs(1);
+            while (loops.load() < i) {
+                std::this_thread::yield();
+            }
+        }
+
+        loop.join();
+        TS_ASSERT_EQUALS(loops.load(), 5);
+        TS_ASSERT_EQUALS(clock->sleepers(), 0);
+    }
+
+    void test_ScaledClockRunsFaster() {
+        ScaledClock fast(100);
+        ClockSource::use(&fast);
+
+        uint64_t steadyStart = ClockSource::real().steadyUs();
+        uint64_t wallStart = SysClock::unixTime();
+
+        // A simulated second takes about 10ms
+        Timer timer;
+        timer.start();
+        timer.sleepUntil(1.0);
+
+        uint64_t realUs = ClockSource::real().steadyUs() - steadyStart;
+        TS_ASSERT(timer.timePassed() >= 1.0);
+        TS_ASSERT(realUs < 500000);
+        TS_ASSERT(SysClock::unixTime() >= wallStart + 1);
+
+        ClockSource::use(clock);
+    }
+
+    void test_OnlyTheRealClockIsReal() {
+        TS_ASSERT(ClockSource::real().isReal());
+        TS_ASSERT(not clock->isReal());
+        TS_ASSERT(not ScaledClock(2).isReal());
+    }
+};
@@ -0,0 +1,133 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		DBHandlerSuite.h
+ *
+ * Purpose:
+ *		Tests the database handler against a database created from setup/createtables.sql,
+ *		run from the NavigationSystem directory.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../Database/DBHandler.hpp"
+#include "../SystemServices/Logger.hpp"
+#include "../cxxtest/cxxtest/TestSuite.h"
+
+#include <sqlite3.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define DBHANDLER_TEST_SCHEMA   "../setup/createtables.sql"
+#define DBHANDLER_TEST_DB       "/tmp/dbhandler_suite.db"
+
+class DBHandlerSuite : public CxxTest::TestSuite {
+   public:
+    void setUp() {
+        Logger::DisableLogging();
+        removeDatabase();
+
+        std::ifstream schemaFile(DBHANDLER_TEST_SCHEMA);
+        TS_ASSERT(schemaFile.is_open());
+        std::stringstream schema;
+        schema << schemaFile.rdbuf();
+
+        sqlite3* db = NULL;
+        sqlite3_open(DBHANDLER_TEST_DB, &db);
+        TS_ASSERT_EQUALS(sqlite3_exec(db, schema.str().c_str(), NULL, NULL, NULL), SQLITE_OK);
+        sqlite3_close(db);
+    }
+
+    void tearDown() { removeDatabase(); }
+
+    void test_ConfigWriteBeforeAnyRead() {
+        // Neither initialised nor read from, the write loads the snapshot
+        DBHandler dbHandler(DBHANDLER_TEST_DB);
+        dbHandler.changeOneValue("config_ais", "1", "0.7", "loop_time");
+
+        TS_ASSERT_DELTA(dbHandler.configs()->getDouble("config_ais", "loop_time"), 0.7, 1e-9);
+    }
+
+    void test_ConfigWriteUpdatesSnapshot() {
+        DBHandler dbHandler(DBHANDLER_TEST_DB);
+        TS_ASSERT(dbHandler.initialise());
+        TS_ASSERT_DELTA(dbHandler.configs()->getDouble("config_ais", "loop_time"), 0.5, 1e-9);
+
+        dbHandler.changeOneValue("config_ais", "1", "0.9", "loop_time");
+        TS_ASSERT_DELTA(dbHandler.configs()->getDouble("config_ais", "loop_time"), 0.9, 1e-9);
+    }
+
+    void test_RetrieveCellBindsTheId() {
+        DBHandler dbHandler(DBHANDLER_TEST_DB);
+
+        TS_ASSERT_EQUALS(dbHandler.retrieveCell("config_ais", "1", "loop_time"), "0.5");
+        // The id is bound as a value, not spliced into the query
+        TS_ASSERT_EQUALS(dbHandler.retrieveCell("config_ais", "1 OR 1=1", "loop_time"), "");
+        TS_ASSERT_EQUALS(dbHandler.retrieveCell("config_ais", "2", "loop_time"), "");
+    }
+
+    void test_RetrieveCellRefusesInvalidNames() {
+        DBHandler dbHandler(DBHANDLER_TEST_DB);
+
+        TS_ASSERT_EQUALS(dbHandler.retrieveCell("config_ais; DELETE FROM config_ais", "1", "loop_time"), "");
+        TS_ASSERT_EQUALS(dbHandler.retrieveCell("config_ais", "1", "loop_time FROM config_ais --"), "");
+        TS_ASSERT_EQUALS(dbHandler.getIdFromTable("config_ais WHERE 1=1", true), "");
+
+        // Nothing was deleted
+        TS_ASSERT_EQUALS(dbHandler.retrieveCell("config_ais", "1", "loop_time"), "0.5");
+        TS_ASSERT_EQUALS(dbHandler.getIdFromTable("config_ais", true), "1");
+    }
+
+    void test_DataLogIdsAfterClearingTheLogs() {
+        DBHandler dbHandler(DBHANDLER_TEST_DB);
+        TS_ASSERT(dbHandler.initialise());
+        std::vector<LogItem> logs = dataLogs();
+
+        dbHandler.insertDataLogs(logs);
+        dbHandler.clearLogs();
+        dbHandler.insertDataLogs(logs);
+
+        // The system row refers to the rows of its batch, not to the ids given before the clear
+        std::string systemId = dbHandler.getIdFromTable("dataLogs_system", true);
+        TS_ASSERT_EQUALS(dbHandler.retrieveCell("dataLogs_system", systemId, "gps_id"),
+                         dbHandler.getIdFromTable("dataLogs_gps", true));
+        TS_ASSERT_EQUALS(dbHandler.retrieveCell("dataLogs_system", systemId, "windsensor_id"),
+                         dbHandler.getIdFromTable("dataLogs_windsensor", true));
+    }
+
+    void test_DataLogIdsCarryOnInAnotherHandler() {
+        {
+            DBHandler dbHandler(DBHANDLER_TEST_DB);
+            std::vector<LogItem> logs = dataLogs();
+            dbHandler.insertDataLogs(logs);
+        }
+
+        DBHandler dbHandler(DBHANDLER_TEST_DB);
+        TS_ASSERT(dbHandler.initialise());
+        std::vector<LogItem> logs = dataLogs();
+        dbHandler.insertDataLogs(logs);
+
+        TS_ASSERT_EQUALS(dbHandler.getIdFromTable("dataLogs_system", true), "4");
+        TS_ASSERT_EQUALS(dbHandler.retrieveCell("dataLogs_system", "4", "attitude_id"), "4");
+    }
+
+   private:
+    static std::vector<LogItem> dataLogs() {
+        std::vector<LogItem> logs(2, LogItem());
+        for (LogItem& log : logs) {
+            log.m_element_str = "compass";
+            log.m_timestamp_str = "2018-05-30 12:00:00.000";
+        }
+        return logs;
+    }
+
+    static void removeDatabase() {
+        std::remove(DBHANDLER_TEST_DB);
+        std::remove(DBHANDLER_TEST_DB "-wal");
+        std::remove(DBHANDLER_TEST_DB "-shm");
+    }
+};
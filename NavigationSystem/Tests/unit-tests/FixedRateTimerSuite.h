@@ -0,0 +1,130 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		FixedRateTimerSuite.h
+ *
+ * Purpose:
+ *		Tests the phase keeping and the overrun accounting of fixed rate loops, on a
+ *		manually stepped clock.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../SystemServices/ClockSource.hpp"
+#include "../SystemServices/Timer.hpp"
+#include "../cxxtest/cxxtest/TestSuite.h"
+
+#include <thread>
+
+#define LOOP_TEST_TIMEOUT_MS 2000
+
+class FixedRateTimerSuite : public CxxTest::TestSuite {
+   public:
+    ManualClock* clock;
+
+    void setUp() {
+        clock = new ManualClock();
+        ClockSource::use(clock);
+        FixedRateTimer::resetStatistics();
+    }
+
+    void tearDown() {
+        ClockSource::use(NULL);
+        delete clock;
+    }
+
+    // Steps the clock once the loop is asleep, as a simulator would
+    void sleepThrough(FixedRateTimer& timer, double periodS, uint64_t stepMs) {
+        std::thread stepper([this, stepMs] {
+            TS_ASSERT(clock->waitForSleepers(1, LOOP_TEST_TIMEOUT_MS));
+            clock->advanceMs(stepMs);
+        });
+        timer.sleepUntilNext(periodS);
+        stepper.join();
+    }
+
+    void test_PhaseIsKept() {
+        FixedRateTimer timer("PhaseLoop");
+        timer.start();
+
+        // Body of 30ms, woken up 5ms late
+        clock->advanceMs(30);
+        sleepThrough(timer, 0.1, 75);
+        TS_ASSERT_EQUALS(clock->steadyUs(), 105000);
+
+        // The next deadline is still 200ms from the start
+        clock->advanceMs(20);
+        sleepThrough(timer, 0.1, 75);
+        TS_ASSERT_EQUALS(clock->steadyUs(), 200000);
+
+        LoopStatistics stats = timer.statistics();
+        TS_ASSERT_EQUALS(stats.loops, 2);
+        TS_ASSERT_EQUALS(stats.overruns, 0);
+        TS_ASSERT_EQUALS(stats.maxLatenessUs, 5000);
+        TS_ASSERT_EQUALS(stats.totalLatenessUs, 5000);
+        TS_ASSERT_EQUALS(stats.maxBusyUs, 30000);
+        TS_ASSERT_EQUALS(stats.totalBusyUs, 50000);
+    }
+
+    void test_OverrunsSkipMissedPeriods() {
+        FixedRateTimer timer("OverrunLoop");
+        timer.start();
+
+        // A body of 250ms misses the deadlines at 100 and 200ms, the loop carries on at once
+        clock->advanceMs(250);
+        timer.sleepUntilNext(0.1);
+        TS_ASSERT_EQUALS(clock->steadyUs(), 250000);
+
+        LoopStatistics stats = timer.statistics();
+        TS_ASSERT_EQUALS(stats.overruns, 1);
+        TS_ASSERT_EQUALS(stats.skipped, 1);
+        TS_ASSERT_EQUALS(stats.maxLatenessUs, 50000);
+
+        // Back in phase, the next deadline is at 300ms
+        clock->advanceMs(10);
+        sleepThrough(timer, 0.1, 40);
+
+        stats = timer.statistics();
+        TS_ASSERT_EQUALS(stats.loops, 2);
+        TS_ASSERT_EQUALS(stats.overruns, 1);
+        TS_ASSERT_EQUALS(stats.totalLatenessUs, 50000);
+    }
+
+    void test_NewPeriodAppliesFromLastDeadline() {
+        FixedRateTimer timer("PeriodLoop");
+        timer.start();
+
+        sleepThrough(timer, 0.1, 100);
+        clock->advanceMs(10);
+        sleepThrough(timer, 0.5, 490);
+
+        LoopStatistics stats = timer.statistics();
+        TS_ASSERT_EQUALS(stats.totalLatenessUs, 0);
+        TS_ASSERT_EQUALS(stats.periodS, 0.5);
+    }
+
+    void test_StatisticsOutliveTheTimer() {
+        {
+            FixedRateTimer timer("RestartedLoop");
+            timer.start();
+            clock->advanceMs(200);
+            timer.sleepUntilNext(0.1);
+        }
+
+        FixedRateTimer restarted("RestartedLoop");
+        restarted.start();
+        clock->advanceMs(200);
+        restarted.sleepUntilNext(0.1);
+
+        bool found = false;
+        for (const LoopStatistics& stats : FixedRateTimer::allStatistics()) {
+            if (stats.name == "RestartedLoop") {
+                found = true;
+                TS_ASSERT_EQUALS(stats.loops, 2);
+                TS_ASSERT_EQUALS(stats.overruns, 2);
+            }
+        }
+        TS_ASSERT(found);
+    }
+};
@@ -0,0 +1,144 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		LogLimiterSuite.h
+ *
+ * Purpose:
+ *		Tests the rate limiting and duplicate suppression of log call sites.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../SystemServices/LogLimiter.hpp"
+#include "../cxxtest/cxxtest/TestSuite.h"
+
+#include <cstring>
+#include <vector>
+
+class LogLimiterSuite : public CxxTest::TestSuite {
+   public:
+    LogLimiter* limiter;
+    LogSite* site;
+    LogSite* otherSite;
+    LogSummary summary;
+
+    void setUp() {
+        limiter = new LogLimiter();
+        site = new LogSite("Tests/site.cpp", 10);
+        otherSite = new LogSite("Tests/site.cpp", 20);
+        LogLimit limit = {10, 5, true};
+        limiter->setLimit(LogLevel::Info, limit);
+    }
+
+    void tearDown() {
+        delete limiter;
+        delete site;
+        delete otherSite;
+    }
+
+    // Runs a record through both checks like the logger does
+    bool logged(LogSite& logSite, uint32_t content, uint64_t nowUs, const char* format = "site %d",
+                LogLevel level = LogLevel::Info) {
+        if (not limiter->admit(logSite, level, format, nowUs)) {
+            return false;
+        }
+        return limiter->check(logSite, content, nowUs, summary);
+    }
+
+    void test_BurstThenRate() {
+        int count = 0;
+        for (int i = 0; i < 20; i++) {
+            count += logged(*site, i, 0);
+        }
+        TS_ASSERT_EQUALS(count, 5);
+
+        // 10 per second, a tenth of a second gives one more record
+        TS_ASSERT(logged(*site, 100, 100000));
+        TS_ASSERT_EQUALS(summary.limited, 15);
+        TS_ASSERT(not logged(*site, 101, 100000));
+
+        // The bucket never holds more than the burst
+        count = 0;
+        for (int i = 0; i < 20; i++) {
+            count += logged(*site, 200 + i, 60000000);
+        }
+        TS_ASSERT_EQUALS(count, 5);
+    }
+
+    void test_SitesHaveTheirOwnBucket() {
+        for (int i = 0; i < 5; i++) {
+            TS_ASSERT(logged(*site, i, 0));
+        }
+        TS_ASSERT(not logged(*site, 10, 0));
+        TS_ASSERT(logged(*otherSite, 10, 0));
+    }
+
+    void test_DuplicatesAreSummarised() {
+        TS_ASSERT(logged(*site, 7, 0));
+        for (int i = 0; i < 100; i++) {
+            TS_ASSERT(not logged(*site, 7, i));
+        }
+
+        // Duplicates don't use up the bucket, the next different record goes through
+        TS_ASSERT(logged(*site, 8, 200));
+        TS_ASSERT(summary.pending());
+        TS_ASSERT_EQUALS(summary.repeated, 100);
+        TS_ASSERT_EQUALS(summary.limited, 0);
+        TS_ASSERT_EQUALS(strcmp(summary.format, "site %d"), 0);
+
+        TS_ASSERT(logged(*site, 9, 300));
+        TS_ASSERT(not summary.pending());
+    }
+
+    void test_DuplicatesCanBeAllowed() {
+        LogLimit limit = {0, 0, false};
+        limiter->setLimit(LogLevel::Info, limit);
+
+        for (int i = 0; i < 1000; i++) {
+            TS_ASSERT(logged(*site, 7, 0));
+        }
+    }
+
+    void test_HeldRecordsAreCollectedAfterAWhile() {
+        std::vector<LogSummary> summaries;
+
+        TS_ASSERT(logged(*site, 7, 0));
+        TS_ASSERT(not logged(*site, 7, 1000));
+        TS_ASSERT(not logged(*site, 7, 2000));
+
+        limiter->collectSummaries(500000, 1000000, summaries);
+        TS_ASSERT_EQUALS(summaries.size(), 0);
+
+        limiter->collectSummaries(1001000, 1000000, summaries);
+        TS_ASSERT_EQUALS(summaries.size(), 1);
+        TS_ASSERT_EQUALS(summaries[0].repeated, 2);
+        TS_ASSERT_EQUALS(summaries[0].level, LogLevel::Info);
+
+        // A storm shows up again once per interval
+        TS_ASSERT(logged(*site, 7, 1002000));
+        TS_ASSERT(not summary.pending());
+    }
+
+    void test_SitesWithTheSameFormatAreApart() {
+        TS_ASSERT(logged(*site, 7, 0));
+        TS_ASSERT(logged(*otherSite, 7, 0));
+        TS_ASSERT(not logged(*site, 7, 0));
+
+        TS_ASSERT(logged(*otherSite, 8, 0));
+        TS_ASSERT(not summary.pending());
+
+        TS_ASSERT(logged(*site, 8, 0));
+        TS_ASSERT_EQUALS(summary.repeated, 1);
+        TS_ASSERT_EQUALS(summary.line, 10);
+    }
+
+    void test_ErrorsAreOnlyFoldedByDefault() {
+        int count = 0;
+        for (int i = 0; i < 1000; i++) {
+            count += logged(*site, i, 0, "error %d", LogLevel::Error);
+        }
+        TS_ASSERT_EQUALS(count, 1000);
+        TS_ASSERT(not logged(*site, 999, 0, "error %d", LogLevel::Error));
+    }
+};
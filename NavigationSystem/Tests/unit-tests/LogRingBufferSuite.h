@@ -0,0 +1,118 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		LogRingBufferSuite.h
+ *
+ * Purpose:
+ *		Tests the lock-free ring buffer the Logger hands its records to the writer thread
+ *		through.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../SystemServices/LogRingBuffer.hpp"
+#include "../cxxtest/cxxtest/TestSuite.h"
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#define RING_PRODUCER_COUNT 4
+#define RING_RECORDS_PER_PRODUCER 20000
+
+class LogRingBufferSuite : public CxxTest::TestSuite {
+   public:
+    void test_RecordsComeOutInOrder() {
+        LogRingBuffer ring;
+        LogRecord record;
+
+        TS_ASSERT(not ring.pop(record));
+
+        TS_ASSERT(ring.push(LogLevel::Info, "first"));
+        TS_ASSERT(ring.push(LogLevel::Error, "second"));
+        TS_ASSERT_EQUALS(ring.size(), 2);
+
+        TS_ASSERT(ring.pop(record));
+        TS_ASSERT_EQUALS(record.level, LogLevel::Info);
+        TS_ASSERT_EQUALS(strcmp(record.text, "first"), 0);
+
+        TS_ASSERT(ring.pop(record));
+        TS_ASSERT_EQUALS(record.level, LogLevel::Error);
+        TS_ASSERT_EQUALS(strcmp(record.text, "second"), 0);
+
+        TS_ASSERT(not ring.pop(record));
+        TS_ASSERT_EQUALS(ring.size(), 0);
+    }
+
+    void test_FullRingRejectsRecords() {
+        LogRingBuffer ring;
+        LogRecord record;
+
+        for (int i = 0; i < LOG_RING_SIZE; i++) {
+            TS_ASSERT(ring.push(LogLevel::Info, "record"));
+        }
+        TS_ASSERT(not ring.push(LogLevel::Info, "one too many"));
+
+        // Room is made by popping, the slots are reused on the next lap
+        TS_ASSERT(ring.pop(record));
+        TS_ASSERT(ring.push(LogLevel::Warning, "reused"));
+        TS_ASSERT_EQUALS(ring.size(), LOG_RING_SIZE);
+    }
+
+    void test_LongRecordsAreTruncated() {
+        LogRingBuffer ring;
+        LogRecord record;
+        std::string text(LOG_RECORD_SIZE * 2, 'x');
+
+        TS_ASSERT(ring.push(LogLevel::Info, text.c_str()));
+        TS_ASSERT(ring.pop(record));
+        TS_ASSERT_EQUALS(strlen(record.text), LOG_RECORD_SIZE - 1);
+    }
+
+    void test_ConcurrentProducers() {
+        LogRingBuffer ring;
+        std::vector<std::thread> producers;
+
+        for (int p = 0; p < RING_PRODUCER_COUNT; p++) {
+            producers.emplace_back([&ring, p] {
+                char text[32];
+                for (int i = 0; i < RING_RECORDS_PER_PRODUCER; i++) {
+                    snprintf(text, sizeof(text), "%d %d", p, i);
+                    while (not ring.push(LogLevel::Info, text)) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        // Each producer's records must come out complete and in the order it pushed them
+        int next[RING_PRODUCER_COUNT] = {0};
+        int received = 0;
+        bool inOrder = true;
+        LogRecord record;
+
+        while (received < RING_PRODUCER_COUNT * RING_RECORDS_PER_PRODUCER) {
+            if (ring.pop(record)) {
+                int p, i;
+                if (sscanf(record.text, "%d %d", &p, &i) != 2 || p < 0 ||
+                    p >= RING_PRODUCER_COUNT || i != next[p]) {
+                    inOrder = false;
+                    break;
+                }
+                next[p]++;
+                received++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+
+        for (auto& producer : producers) {
+            producer.join();
+        }
+
+        TS_ASSERT(inOrder);
+        TS_ASSERT_EQUALS(received, RING_PRODUCER_COUNT * RING_RECORDS_PER_PRODUCER);
+    }
+};
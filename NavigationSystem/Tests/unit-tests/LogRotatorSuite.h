@@ -0,0 +1,181 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		LogRotatorSuite.h
+ *
+ * Purpose:
+ *		Tests the rotation of log files by size and age, the compression of the rotated
+ *		segments and the cap on the total size of the logs kept.
+ *
+ * Developer Notes:
+ *		The files are written into a directory of the working directory which is removed
+ *		afterwards.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../SystemServices/LogRotator.hpp"
+#include "../cxxtest/cxxtest/TestSuite.h"
+
+#include <cstdio>
+#include <dirent.h>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <utime.h>
+#include <zlib.h>
+
+#define ROTATOR_TEST_DIR "./LogRotatorSuite"
+#define ROTATOR_TEST_FILE ROTATOR_TEST_DIR "/test.log"
+
+class LogRotatorSuite : public CxxTest::TestSuite {
+   public:
+    void setUp() { mkdir(ROTATOR_TEST_DIR, S_IRWXU); }
+
+    void tearDown() {
+        DIR* directory = opendir(ROTATOR_TEST_DIR);
+        struct dirent* entry;
+        while (directory != NULL && (entry = readdir(directory)) != NULL) {
+            std::remove((std::string(ROTATOR_TEST_DIR "/") + entry->d_name).c_str());
+        }
+        if (directory != NULL) {
+            closedir(directory);
+        }
+        rmdir(ROTATOR_TEST_DIR);
+    }
+
+    void test_RotatesBySize() {
+        RotationPolicy policy = {100, 0, 0, false};
+        LogRotator rotator(policy);
+
+        writeFile(ROTATOR_TEST_FILE, 50);
+        rotator.opened(ROTATOR_TEST_FILE);
+        TS_ASSERT(not rotator.needsRotation(50));
+        TS_ASSERT(rotator.needsRotation(100));
+
+        TS_ASSERT(rotator.rotate());
+        TS_ASSERT(not exists(ROTATOR_TEST_FILE));
+        TS_ASSERT(exists(ROTATOR_TEST_FILE ".0001"));
+
+        writeFile(ROTATOR_TEST_FILE, 50);
+        TS_ASSERT(rotator.rotate());
+        TS_ASSERT_EQUALS(rotator.segments().size(), 2);
+        TS_ASSERT_EQUALS(rotator.segments()[1], ROTATOR_TEST_FILE ".0002");
+    }
+
+    void test_RotatesByAge() {
+        RotationPolicy policy = {0, 60, 0, false};
+        LogRotator rotator(policy);
+
+        writeFile(ROTATOR_TEST_FILE, 10);
+        rotator.opened(ROTATOR_TEST_FILE);
+        time_t now = time(NULL);
+
+        TS_ASSERT(not rotator.needsRotation(10, now + 30));
+        TS_ASSERT(rotator.needsRotation(10, now + 60));
+        TS_ASSERT(not rotator.needsRotation(0, now + 60));
+    }
+
+    void test_SegmentsAreCompressed() {
+        RotationPolicy policy = {100, 0, 0, true};
+        LogRotator rotator(policy);
+
+        writeFile(ROTATOR_TEST_FILE, 1000);
+        rotator.opened(ROTATOR_TEST_FILE);
+        TS_ASSERT(rotator.rotate());
+        rotator.waitIdle();
+
+        TS_ASSERT(not exists(ROTATOR_TEST_FILE ".0001"));
+        TS_ASSERT(exists(ROTATOR_TEST_FILE ".0001.gz"));
+
+        char buffer[2000];
+        gzFile file = gzopen(ROTATOR_TEST_FILE ".0001.gz", "rb");
+        TS_ASSERT(file != NULL);
+        TS_ASSERT_EQUALS(gzread(file, buffer, sizeof(buffer)), 1000);
+        TS_ASSERT_EQUALS(buffer[999], 'x');
+        gzclose(file);
+    }
+
+    void test_NumberingCarriesOnAfterEarlierSegments() {
+        RotationPolicy policy = {100, 0, 0, true};
+        LogRotator rotator(policy);
+
+        writeFile(ROTATOR_TEST_FILE ".0003.gz", 10);
+        writeFile(ROTATOR_TEST_FILE ".0004", 10);
+        writeFile(ROTATOR_TEST_FILE, 10);
+
+        // The segment left uncompressed is picked up
+        rotator.opened(ROTATOR_TEST_FILE);
+        rotator.waitIdle();
+        TS_ASSERT(exists(ROTATOR_TEST_FILE ".0004.gz"));
+
+        TS_ASSERT(rotator.rotate());
+        rotator.waitIdle();
+        TS_ASSERT(exists(ROTATOR_TEST_FILE ".0005.gz"));
+    }
+
+    void test_CompressionRestartsAfterStop() {
+        RotationPolicy policy = {100, 0, 0, true};
+        LogRotator rotator(policy);
+
+        writeFile(ROTATOR_TEST_FILE, 1000);
+        rotator.opened(ROTATOR_TEST_FILE);
+        TS_ASSERT(rotator.rotate());
+        rotator.stop();
+
+        // Stopping while a rotation restarts the worker
+        writeFile(ROTATOR_TEST_FILE, 1000);
+        std::thread stopper([&rotator] { rotator.stop(); });
+        TS_ASSERT(rotator.rotate());
+        stopper.join();
+
+        // The segments left pending by the stops are picked up
+        writeFile(ROTATOR_TEST_FILE, 1000);
+        TS_ASSERT(rotator.rotate());
+        rotator.waitIdle();
+        TS_ASSERT(exists(ROTATOR_TEST_FILE ".0001.gz"));
+        TS_ASSERT(exists(ROTATOR_TEST_FILE ".0002.gz"));
+        TS_ASSERT(exists(ROTATOR_TEST_FILE ".0003.gz"));
+    }
+
+    void test_OldestFilesGoOverTheCap() {
+        RotationPolicy policy = {100, 0, 250, false};
+        LogRotator rotator(policy);
+
+        writeFile(ROTATOR_TEST_DIR "/earlier-test.log", 100);
+        writeFile(ROTATOR_TEST_DIR "/unrelated.txt", 1000);
+        writeFile(ROTATOR_TEST_FILE, 100);
+        rotator.opened(ROTATOR_TEST_FILE, "test.log");
+
+        // Makes the file of the earlier run the oldest
+        struct utimbuf times = {1000, 1000};
+        utime(ROTATOR_TEST_DIR "/earlier-test.log", &times);
+
+        TS_ASSERT(rotator.rotate());
+        writeFile(ROTATOR_TEST_FILE, 100);
+        TS_ASSERT(rotator.rotate());
+        writeFile(ROTATOR_TEST_FILE, 100);
+
+        // 400 bytes of the family, the earlier run and the first segment have to go
+        rotator.enforceCap();
+        TS_ASSERT(not exists(ROTATOR_TEST_DIR "/earlier-test.log"));
+        TS_ASSERT(not exists(ROTATOR_TEST_FILE ".0001"));
+        TS_ASSERT(exists(ROTATOR_TEST_FILE ".0002"));
+        TS_ASSERT(exists(ROTATOR_TEST_FILE));
+        TS_ASSERT(exists(ROTATOR_TEST_DIR "/unrelated.txt"));
+    }
+
+   private:
+    void writeFile(const char* path, int size) {
+        std::ofstream file(path, std::ios::trunc);
+        file << std::string(size, 'x');
+    }
+
+    bool exists(const char* path) {
+        struct stat status;
+        return stat(path, &status) == 0;
+    }
+};
@@ -0,0 +1,314 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		MessageBusBackpressureSuite.h
+ *
+ * Purpose:
+ *		Tests the bounded lanes of the message bus, the drop oldest, drop newest and block
+ *		overflow policies, which messages a drop oldest message may take the place of, and
+ *		the queue depth and drop statistics.
+ *
+ * Developer Notes:
+ *		Messages sent before the message bus runs pile up in the lanes, which is used to
+ *		fill them up deterministically. Blocking senders only wait on a running message bus.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../MessageBus/MessageBus.hpp"
+#include "../Messages/AISDataMsg.hpp"
+#include "../Messages/MarineSensorDataMsg.h"
+#include "../Messages/ServerConfigsReceivedMsg.hpp"
+#include "../Messages/WindDataMsg.hpp"
+#include "../SystemServices/Logger.hpp"
+#include "../cxxtest/cxxtest/TestSuite.h"
+#include "MessageBusTestHelper.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define BACKPRESSURE_CAPACITY 10
+#define BACKPRESSURE_OVERFLOW 5
+#define BACKPRESSURE_SLOW_NODE_DELAY_MS 2
+#define BACKPRESSURE_WAIT_TIME_MS 2000
+
+class BoundedNode : public Node {
+   public:
+    BoundedNode(MessageBus& msgBus, int delayMs = 0)
+        : Node(NodeID::MessageLogger, msgBus), m_DelayMs(delayMs), m_Count(0) {
+        msgBus.registerNode(*this, MessageType::WindData);
+    }
+
+    bool init() { return true; }
+
+    void processMessage(const Message* message) {
+        if (m_DelayMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(m_DelayMs));
+        }
+
+        const WindDataMsg* windMsg = static_cast<const WindDataMsg*>(message);
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Received.push_back((int)windMsg->windDirection());
+        m_Count++;
+    }
+
+    bool waitFor(int count) {
+        auto start = std::chrono::steady_clock::now();
+        while (m_Count.load() < count) {
+            if (std::chrono::steady_clock::now() - start >
+                std::chrono::milliseconds(BACKPRESSURE_WAIT_TIME_MS)) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    int m_DelayMs;
+    std::atomic<int> m_Count;
+    std::mutex m_Mutex;
+    std::vector<int> m_Received;
+};
+
+class BulkNode : public Node {
+   public:
+    BulkNode(MessageBus& msgBus) : Node(NodeID::MessageLogger, msgBus), m_Count(0), m_Hold(false) {
+        msgBus.registerNode(*this, MessageType::AISData);
+        msgBus.registerNode(*this, MessageType::MarineSensorData);
+        msgBus.registerNode(*this, MessageType::ServerConfigsReceived);
+    }
+
+    bool init() { return true; }
+
+    void processMessage(const Message* message) {
+        while (m_Hold.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Types.push_back(message->messageType());
+        if (message->messageType() == MessageType::AISData) {
+            m_AISPositions.push_back((int)static_cast<const AISDataMsg*>(message)->posLat());
+        }
+        m_Count++;
+    }
+
+    bool waitFor(int count) {
+        auto start = std::chrono::steady_clock::now();
+        while (m_Count.load() < count) {
+            if (std::chrono::steady_clock::now() - start >
+                std::chrono::milliseconds(BACKPRESSURE_WAIT_TIME_MS)) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    std::atomic<int> m_Count;
+    std::atomic<bool> m_Hold;  // Holds up the dispatch loop in the first message
+    std::mutex m_Mutex;
+    std::vector<MessageType> m_Types;
+    std::vector<int> m_AISPositions;
+};
+
+class MessageBusBackpressureSuite : public CxxTest::TestSuite {
+   public:
+    void setUp() { Logger::DisableLogging(); }
+
+    void test_DropNewestKeepsTheFirstMessages() {
+        MessageBus messageBus;
+        BoundedNode node(messageBus);
+        messageBus.setLaneCapacity(MessageLane::Normal, BACKPRESSURE_CAPACITY);
+        messageBus.setOverflowPolicy(MessageType::WindData, OverflowPolicy::DropNewest);
+
+        sendMessages(messageBus, BACKPRESSURE_CAPACITY + BACKPRESSURE_OVERFLOW);
+
+        MessageBus::LaneStatistics stats = messageBus.laneStatistics(MessageLane::Normal);
+        TS_ASSERT_EQUALS(stats.depth, BACKPRESSURE_CAPACITY);
+        TS_ASSERT_EQUALS(stats.peakDepth, BACKPRESSURE_CAPACITY);
+        TS_ASSERT_EQUALS(stats.dropped, BACKPRESSURE_OVERFLOW);
+        TS_ASSERT_EQUALS(messageBus.droppedCount(MessageType::WindData), BACKPRESSURE_OVERFLOW);
+
+        MessageBusTestHelper helper(messageBus);
+        TS_ASSERT(node.waitFor(BACKPRESSURE_CAPACITY));
+
+        std::lock_guard<std::mutex> lock(node.m_Mutex);
+        TS_ASSERT_EQUALS(node.m_Received.front(), 0);
+        TS_ASSERT_EQUALS(node.m_Received.back(), BACKPRESSURE_CAPACITY - 1);
+    }
+
+    void test_DropOldestKeepsTheLatestMessages() {
+        MessageBus messageBus;
+        BoundedNode node(messageBus);
+        messageBus.setLaneCapacity(MessageLane::Normal, BACKPRESSURE_CAPACITY);
+        messageBus.setOverflowPolicy(MessageType::WindData, OverflowPolicy::DropOldest);
+
+        sendMessages(messageBus, BACKPRESSURE_CAPACITY + BACKPRESSURE_OVERFLOW);
+        TS_ASSERT_EQUALS(messageBus.laneStatistics(MessageLane::Normal).dropped,
+                         BACKPRESSURE_OVERFLOW);
+
+        MessageBusTestHelper helper(messageBus);
+        TS_ASSERT(node.waitFor(BACKPRESSURE_CAPACITY));
+
+        std::lock_guard<std::mutex> lock(node.m_Mutex);
+        TS_ASSERT_EQUALS(node.m_Received.front(), BACKPRESSURE_OVERFLOW);
+        TS_ASSERT_EQUALS(node.m_Received.back(), BACKPRESSURE_CAPACITY + BACKPRESSURE_OVERFLOW - 1);
+    }
+
+    void test_BlockWaitsForRoom() {
+        MessageBus messageBus;
+        BoundedNode node(messageBus, BACKPRESSURE_SLOW_NODE_DELAY_MS);
+        messageBus.setLaneCapacity(MessageLane::Normal, BACKPRESSURE_CAPACITY);
+        messageBus.setOverflowPolicy(MessageType::WindData, OverflowPolicy::Block);
+        MessageBusTestHelper helper(messageBus);
+
+        // A blocking sender only waits once the message bus is running
+        messageBus.sendMessage(std::make_unique<WindDataMsg>(0, 0, 0));
+        TS_ASSERT(node.waitFor(1));
+
+        const int messageCount = BACKPRESSURE_CAPACITY * 4;
+        sendMessages(messageBus, messageCount);
+        TS_ASSERT(node.waitFor(messageCount + 1));
+
+        MessageBus::LaneStatistics stats = messageBus.laneStatistics(MessageLane::Normal);
+        TS_ASSERT_EQUALS(stats.dropped, 0);
+        TS_ASSERT(stats.blocked > 0);
+        TS_ASSERT(stats.peakDepth <= BACKPRESSURE_CAPACITY);
+        TS_ASSERT_EQUALS(stats.depth, 0);
+    }
+
+    void test_UnboundedLane() {
+        MessageBus messageBus;
+        messageBus.setLaneCapacity(MessageLane::Normal, 0);
+
+        sendMessages(messageBus, DEFAULT_LANE_CAPACITY + BACKPRESSURE_OVERFLOW);
+
+        MessageBus::LaneStatistics stats = messageBus.laneStatistics(MessageLane::Normal);
+        TS_ASSERT_EQUALS(stats.depth, DEFAULT_LANE_CAPACITY + BACKPRESSURE_OVERFLOW);
+        TS_ASSERT_EQUALS(stats.dropped, 0);
+    }
+
+    void test_DropOldestKeepsMessagesThatMustNotBeLost() {
+        MessageBus messageBus;
+        BulkNode node(messageBus);
+        messageBus.setLaneCapacity(MessageLane::Bulk, BACKPRESSURE_CAPACITY);
+
+        // The configs wait at the head of the lane while the AIS data floods in behind them
+        messageBus.sendMessage(std::make_unique<ServerConfigsReceivedMsg>());
+        sendAISData(messageBus, BACKPRESSURE_CAPACITY + BACKPRESSURE_OVERFLOW);
+
+        TS_ASSERT_EQUALS(messageBus.droppedCount(MessageType::ServerConfigsReceived), 0);
+        TS_ASSERT_EQUALS(messageBus.droppedCount(MessageType::AISData), BACKPRESSURE_OVERFLOW + 1);
+
+        MessageBusTestHelper helper(messageBus);
+        TS_ASSERT(node.waitFor(BACKPRESSURE_CAPACITY));
+
+        std::lock_guard<std::mutex> lock(node.m_Mutex);
+        TS_ASSERT_EQUALS(node.m_Types.front(), MessageType::ServerConfigsReceived);
+        TS_ASSERT_EQUALS(node.m_AISPositions.front(), BACKPRESSURE_OVERFLOW + 1);
+        TS_ASSERT_EQUALS(node.m_AISPositions.back(), BACKPRESSURE_CAPACITY + BACKPRESSURE_OVERFLOW - 1);
+    }
+
+    void test_DropOldestPrefersItsOwnType() {
+        MessageBus messageBus;
+        BulkNode node(messageBus);
+        messageBus.setLaneCapacity(MessageLane::Bulk, BACKPRESSURE_CAPACITY);
+
+        messageBus.sendMessage(std::make_unique<MarineSensorDataMsg>(0, 0, 0, 0));
+        sendAISData(messageBus, BACKPRESSURE_CAPACITY);
+
+        // The oldest AIS data goes, not the older marine sensor data
+        TS_ASSERT_EQUALS(messageBus.droppedCount(MessageType::MarineSensorData), 0);
+        TS_ASSERT_EQUALS(messageBus.droppedCount(MessageType::AISData), 1);
+
+        MessageBusTestHelper helper(messageBus);
+        TS_ASSERT(node.waitFor(BACKPRESSURE_CAPACITY));
+
+        std::lock_guard<std::mutex> lock(node.m_Mutex);
+        TS_ASSERT_EQUALS(node.m_Types.front(), MessageType::MarineSensorData);
+        TS_ASSERT_EQUALS(node.m_AISPositions.front(), 1);
+    }
+
+    void test_DropOldestLeavesOtherTypesAlone() {
+        MessageBus messageBus;
+        BulkNode node(messageBus);
+        messageBus.setLaneCapacity(MessageLane::Bulk, BACKPRESSURE_CAPACITY);
+
+        for (int i = 0; i < BACKPRESSURE_CAPACITY; i++) {
+            messageBus.sendMessage(std::make_unique<MarineSensorDataMsg>(0, 0, 0, 0));
+        }
+        sendAISData(messageBus, BACKPRESSURE_OVERFLOW);
+
+        // The marine sensor data may be dropped too, but not to make room for AIS data
+        TS_ASSERT_EQUALS(messageBus.droppedCount(MessageType::MarineSensorData), 0);
+        TS_ASSERT_EQUALS(messageBus.droppedCount(MessageType::AISData), BACKPRESSURE_OVERFLOW);
+    }
+
+    void test_DropOldestLooksInTheWholeLane() {
+        MessageBus messageBus;
+        BulkNode node(messageBus);
+        messageBus.setLaneCapacity(MessageLane::Bulk, BACKPRESSURE_CAPACITY);
+        node.m_Hold.store(true);
+
+        // The dispatch loop takes the whole lane and holds on to the first message
+        sendAISData(messageBus, BACKPRESSURE_CAPACITY);
+        MessageBusTestHelper helper(messageBus);
+        auto start = std::chrono::steady_clock::now();
+        while (messageBus.laneStatistics(MessageLane::Bulk).depth == BACKPRESSURE_CAPACITY &&
+               std::chrono::steady_clock::now() - start < std::chrono::milliseconds(BACKPRESSURE_WAIT_TIME_MS)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        // Fills the lane up again, then gives up the oldest waiting message which is in the
+        // back queue rather than the newer one in the front queue
+        for (int i = BACKPRESSURE_CAPACITY; i < BACKPRESSURE_CAPACITY + 2; i++) {
+            messageBus.sendMessage(std::make_unique<AISDataMsg>(
+                std::vector<AISVessel>(), std::vector<AISVesselInfo>(), i, 0));
+        }
+        TS_ASSERT_EQUALS(messageBus.droppedCount(MessageType::AISData), 1);
+
+        node.m_Hold.store(false);
+        TS_ASSERT(node.waitFor(BACKPRESSURE_CAPACITY + 1));
+
+        std::lock_guard<std::mutex> lock(node.m_Mutex);
+        TS_ASSERT_EQUALS(node.m_AISPositions.size(), BACKPRESSURE_CAPACITY + 1);
+        TS_ASSERT_EQUALS(node.m_AISPositions[0], 0);
+        TS_ASSERT_EQUALS(node.m_AISPositions[1], 2);
+        TS_ASSERT_EQUALS(node.m_AISPositions.back(), BACKPRESSURE_CAPACITY + 1);
+    }
+
+    void test_DropOldestWithNothingToGiveUp() {
+        MessageBus messageBus;
+        BulkNode node(messageBus);
+        messageBus.setLaneCapacity(MessageLane::Bulk, BACKPRESSURE_CAPACITY);
+
+        for (int i = 0; i < BACKPRESSURE_CAPACITY; i++) {
+            messageBus.sendMessage(std::make_unique<ServerConfigsReceivedMsg>());
+        }
+        sendAISData(messageBus, 1);
+
+        // Only the AIS data itself may be lost
+        TS_ASSERT_EQUALS(messageBus.droppedCount(MessageType::ServerConfigsReceived), 0);
+        TS_ASSERT_EQUALS(messageBus.droppedCount(MessageType::AISData), 1);
+        TS_ASSERT_EQUALS(messageBus.laneStatistics(MessageLane::Bulk).depth, BACKPRESSURE_CAPACITY);
+    }
+
+   private:
+    void sendAISData(MessageBus& messageBus, int count) {
+        for (int i = 0; i < count; i++) {
+            messageBus.sendMessage(std::make_unique<AISDataMsg>(
+                std::vector<AISVessel>(), std::vector<AISVesselInfo>(), i, 0));
+        }
+    }
+
+    void sendMessages(MessageBus& messageBus, int count) {
+        for (int i = 0; i < count; i++) {
+            messageBus.sendMessage(std::make_unique<WindDataMsg>(i, 0, 0));
+        }
+    }
+};
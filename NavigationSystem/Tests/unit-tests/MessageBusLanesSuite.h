@@ -0,0 +1,140 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		MessageBusLanesSuite.h
+ *
+ * Purpose:
+ *		Tests that control messages are distributed ahead of a flood of bulk messages,
+ *		and that the per lane queue delay statistics show it.
+ *
+ * Developer Notes:
+ *		The queue delays of each lane are printed so runs can be compared.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../MessageBus/MessageBus.hpp"
+#include "../MessageBus/MessageLanes.hpp"
+#include "../Messages/AISDataMsg.hpp"
+#include "../Messages/RudderCommandMsg.hpp"
+#include "../SystemServices/Logger.hpp"
+#include "../cxxtest/cxxtest/TestSuite.h"
+#include "MessageBusTestHelper.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#define LANES_AIS_FLOOD 1000
+#define LANES_RUDDER_INTERVAL 100
+#define LANES_AIS_PROCESS_US 100
+#define LANES_WAIT_TIME_MS 5000
+#define LANES_MAX_CONTROL_DELAY_US 10000
+
+// Takes a while over every AIS message, like the AIS processing does with a busy sea
+class FloodedNode : public Node {
+   public:
+    FloodedNode(MessageBus& msgBus)
+        : Node(NodeID::MessageLogger, msgBus), m_AISCount(0), m_RudderCount(0), m_AISBeforeRudder(-1) {
+        msgBus.registerNode(*this, MessageType::AISData);
+        msgBus.registerNode(*this, MessageType::RudderCommand);
+    }
+
+    bool init() { return true; }
+
+    void processMessage(const Message* message) {
+        if (message->messageType() == MessageType::AISData) {
+            std::this_thread::sleep_for(std::chrono::microseconds(LANES_AIS_PROCESS_US));
+            m_AISCount++;
+        } else if (message->messageType() == MessageType::RudderCommand) {
+            if (m_RudderCount.load() == 0) {
+                m_AISBeforeRudder.store(m_AISCount.load());
+            }
+            m_RudderCount++;
+        }
+    }
+
+    bool waitFor(int aisCount, int rudderCount) {
+        auto start = std::chrono::steady_clock::now();
+        while (m_AISCount.load() < aisCount || m_RudderCount.load() < rudderCount) {
+            if (std::chrono::steady_clock::now() - start >
+                std::chrono::milliseconds(LANES_WAIT_TIME_MS)) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    std::atomic<int> m_AISCount;
+    std::atomic<int> m_RudderCount;
+    std::atomic<int> m_AISBeforeRudder;
+};
+
+class MessageBusLanesSuite : public CxxTest::TestSuite {
+   public:
+    void setUp() { Logger::DisableLogging(); }
+
+    void test_MessageLaneClassification() {
+        TS_ASSERT_EQUALS(messageLane(MessageType::RudderCommand), MessageLane::Control);
+        TS_ASSERT_EQUALS(messageLane(MessageType::WingSailCommand), MessageLane::Control);
+        TS_ASSERT_EQUALS(messageLane(MessageType::LocalNavigation), MessageLane::Control);
+        TS_ASSERT_EQUALS(messageLane(MessageType::WindData), MessageLane::Normal);
+        TS_ASSERT_EQUALS(messageLane(MessageType::AISData), MessageLane::Bulk);
+        TS_ASSERT_EQUALS(messageLane(MessageType::DataRequest), MessageLane::Bulk);
+    }
+
+    void test_ControlOvertakesBulkFlood() {
+        MessageBus messageBus;
+        FloodedNode node(messageBus);
+        MessageBusTestHelper helper(messageBus);
+
+        sendAISFlood(messageBus, LANES_AIS_FLOOD);
+        messageBus.sendMessage(std::make_unique<RudderCommandMsg>(10));
+
+        TS_ASSERT(node.waitFor(LANES_AIS_FLOOD, 1));
+        TS_ASSERT_LESS_THAN(node.m_AISBeforeRudder.load(), LANES_AIS_FLOOD / 2);
+    }
+
+    void test_ControlDelayStaysFlatUnderFlood() {
+        MessageBus messageBus;
+        FloodedNode node(messageBus);
+        MessageBusTestHelper helper(messageBus);
+
+        int rudderCount = 0;
+        for (int i = 0; i < LANES_AIS_FLOOD; i += LANES_RUDDER_INTERVAL) {
+            sendAISFlood(messageBus, LANES_RUDDER_INTERVAL);
+            messageBus.sendMessage(std::make_unique<RudderCommandMsg>(i));
+            rudderCount++;
+        }
+
+        TS_ASSERT(node.waitFor(LANES_AIS_FLOOD, rudderCount));
+
+        MessageBus::LaneStatistics control = messageBus.laneStatistics(MessageLane::Control);
+        MessageBus::LaneStatistics bulk = messageBus.laneStatistics(MessageLane::Bulk);
+
+        std::cout << std::endl
+                  << "Queue delay under an AIS flood: control mean " << control.meanDelayUs()
+                  << " us, max " << control.maxDelayUs << " us; bulk mean "
+                  << bulk.meanDelayUs() << " us, max " << bulk.maxDelayUs << " us" << std::endl;
+
+        TS_ASSERT_EQUALS(control.messageCount, (unsigned long)rudderCount);
+        TS_ASSERT_EQUALS(bulk.messageCount, (unsigned long)LANES_AIS_FLOOD);
+        TS_ASSERT_LESS_THAN(control.maxDelayUs, LANES_MAX_CONTROL_DELAY_US);
+        TS_ASSERT_LESS_THAN(control.meanDelayUs(), bulk.meanDelayUs());
+
+        messageBus.resetLaneStatistics();
+        TS_ASSERT_EQUALS(messageBus.laneStatistics(MessageLane::Bulk).messageCount, 0);
+    }
+
+   private:
+    void sendAISFlood(MessageBus& messageBus, int count) {
+        for (int i = 0; i < count; i++) {
+            messageBus.sendMessage(std::make_unique<AISDataMsg>(
+                std::vector<AISVessel>(), std::vector<AISVesselInfo>(), 0.f, 0.f));
+        }
+    }
+};
@@ -0,0 +1,105 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		MessageBusLatencySuite.h
+ *
+ * Purpose:
+ *		Benchmarks the time it takes for a message to travel from
+ *		MessageBus::sendMessage() to Node::processMessage() on an otherwise idle bus.
+ *
+ * Developer Notes:
+ *		The mean and worst case latencies are printed so runs before and after a change
+ *		to the dispatch loop can be compared. With the old fixed 50 ms polling sleep the
+ *		mean latency was around 48 ms: each message is sent as soon as the previous one
+ *		was processed, just after the dispatch loop went back to sleep.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../MessageBus/MessageBus.hpp"
+#include "../Messages/WindDataMsg.hpp"
+#include "../SystemServices/Logger.hpp"
+#include "../cxxtest/cxxtest/TestSuite.h"
+#include "MessageBusTestHelper.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#define LATENCY_SAMPLES 200
+#define LATENCY_TIMEOUT_MS 1000
+#define LATENCY_MAX_MEAN_US 5000
+
+class LatencyProbeNode : public Node {
+   public:
+    LatencyProbeNode(MessageBus& msgBus) : Node(NodeID::MessageVerifier, msgBus), m_Received(false) {
+        msgBus.registerNode(*this, MessageType::WindData);
+    }
+
+    bool init() { return true; }
+
+    void processMessage(const Message* message) {
+        if (message->messageType() == MessageType::WindData) {
+            m_ReceivedAt = std::chrono::steady_clock::now();
+            m_Received.store(true);
+        }
+    }
+
+    std::atomic<bool> m_Received;
+    std::chrono::steady_clock::time_point m_ReceivedAt;
+};
+
+class MessageBusLatencySuite : public CxxTest::TestSuite {
+   public:
+    void setUp() { Logger::DisableLogging(); }
+
+    void test_SendToProcessLatency() {
+        MessageBus messageBus;
+        LatencyProbeNode probe(messageBus);
+        MessageBusTestHelper helper(messageBus);
+
+        // Give the dispatch loop time to start
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        long long totalUs = 0;
+        long long maxUs = 0;
+        int samples = 0;
+
+        for (int i = 0; i < LATENCY_SAMPLES; i++) {
+            probe.m_Received.store(false);
+            auto sentAt = std::chrono::steady_clock::now();
+            messageBus.sendMessage(std::make_unique<WindDataMsg>(0, 0, 0));
+
+            while (not probe.m_Received.load()) {
+                if (std::chrono::steady_clock::now() - sentAt >
+                    std::chrono::milliseconds(LATENCY_TIMEOUT_MS)) {
+                    break;
+                }
+                std::this_thread::yield();
+            }
+            TS_ASSERT(probe.m_Received.load());
+            if (not probe.m_Received.load()) {
+                return;
+            }
+
+            long long us =
+                std::chrono::duration_cast<std::chrono::microseconds>(probe.m_ReceivedAt - sentAt)
+                    .count();
+            totalUs += us;
+            maxUs = std::max(maxUs, us);
+            samples++;
+
+            // Let the bus go idle again between samples
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+
+        long long meanUs = totalUs / samples;
+        std::cout << std::endl
+                  << "MessageBus latency over " << samples << " messages: mean " << meanUs
+                  << " us, max " << maxUs << " us" << std::endl;
+
+        TS_ASSERT_LESS_THAN(meanUs, LATENCY_MAX_MEAN_US);
+    }
+};
@@ -0,0 +1,154 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		MessageBusParallelSuite.h
+ *
+ * Purpose:
+ *		Tests the parallel delivery mode of the message bus, where every node has a
+ *		bounded mailbox processed by a pool of worker threads.
+ *
+ * Developer Notes:
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../MessageBus/MessageBus.hpp"
+#include "../Messages/WindDataMsg.hpp"
+#include "../SystemServices/Logger.hpp"
+#include "../cxxtest/cxxtest/TestSuite.h"
+#include "MessageBusTestHelper.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define PARALLEL_MESSAGE_COUNT 500
+#define PARALLEL_SLOW_NODE_DELAY_MS 50
+#define PARALLEL_WAIT_TIME_MS 2000
+#define PARALLEL_MAILBOX_CAPACITY 5
+#define PARALLEL_MAILBOX_DELAY_MS 10
+
+// Records the wind direction of every WindData message, optionally taking a while over it
+class RecordingNode : public Node {
+   public:
+    RecordingNode(NodeID id, MessageBus& msgBus, int delayMs)
+        : Node(id, msgBus), m_DelayMs(delayMs), m_Count(0) {
+        msgBus.registerNode(*this, MessageType::WindData);
+    }
+
+    bool init() { return true; }
+
+    void processMessage(const Message* message) {
+        if (m_DelayMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(m_DelayMs));
+        }
+
+        const WindDataMsg* windMsg = static_cast<const WindDataMsg*>(message);
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Received.push_back((int)windMsg->windDirection());
+        m_Count++;
+    }
+
+    bool waitFor(int count, int timeoutMs) {
+        auto start = std::chrono::steady_clock::now();
+        while (m_Count.load() < count) {
+            if (std::chrono::steady_clock::now() - start > std::chrono::milliseconds(timeoutMs)) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    int m_DelayMs;
+    std::atomic<int> m_Count;
+    std::mutex m_Mutex;
+    std::vector<int> m_Received;
+};
+
+class MessageBusParallelSuite : public CxxTest::TestSuite {
+   public:
+    void setUp() { Logger::DisableLogging(); }
+
+    void test_PerNodeOrderIsPreserved() {
+        MessageBus messageBus;
+        messageBus.enableParallelDelivery(4);
+        RecordingNode nodeA(NodeID::MessageLogger, messageBus, 0);
+        RecordingNode nodeB(NodeID::MessageVerifier, messageBus, 0);
+        MessageBusTestHelper helper(messageBus);
+
+        for (int i = 0; i < PARALLEL_MESSAGE_COUNT; i++) {
+            messageBus.sendMessage(std::make_unique<WindDataMsg>(i, 0, 0));
+        }
+
+        TS_ASSERT(nodeA.waitFor(PARALLEL_MESSAGE_COUNT, PARALLEL_WAIT_TIME_MS));
+        TS_ASSERT(nodeB.waitFor(PARALLEL_MESSAGE_COUNT, PARALLEL_WAIT_TIME_MS));
+
+        std::lock_guard<std::mutex> lockA(nodeA.m_Mutex);
+        std::lock_guard<std::mutex> lockB(nodeB.m_Mutex);
+        TS_ASSERT_EQUALS(nodeA.m_Received.size(), PARALLEL_MESSAGE_COUNT);
+        TS_ASSERT_EQUALS(nodeB.m_Received.size(), PARALLEL_MESSAGE_COUNT);
+        for (unsigned int i = 0; i < nodeA.m_Received.size() && i < nodeB.m_Received.size(); i++) {
+            TS_ASSERT_EQUALS(nodeA.m_Received[i], (int)i);
+            TS_ASSERT_EQUALS(nodeB.m_Received[i], (int)i);
+        }
+    }
+
+    void test_SlowNodeDoesNotBlockOthers() {
+        MessageBus messageBus;
+        messageBus.enableParallelDelivery(2);
+        RecordingNode slowNode(NodeID::MessageLogger, messageBus, PARALLEL_SLOW_NODE_DELAY_MS);
+        RecordingNode fastNode(NodeID::MessageVerifier, messageBus, 0);
+        MessageBusTestHelper helper(messageBus);
+
+        const int messageCount = 10;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < messageCount; i++) {
+            messageBus.sendMessage(std::make_unique<WindDataMsg>(i, 0, 0));
+        }
+
+        // The fast node gets all its messages long before the slow node is done
+        TS_ASSERT(fastNode.waitFor(messageCount, PARALLEL_WAIT_TIME_MS));
+        auto fastDone = std::chrono::steady_clock::now() - start;
+        TS_ASSERT_LESS_THAN(
+            std::chrono::duration_cast<std::chrono::milliseconds>(fastDone).count(),
+            PARALLEL_SLOW_NODE_DELAY_MS * 2);
+        TS_ASSERT(slowNode.m_Count.load() < messageCount);
+
+        TS_ASSERT(slowNode.waitFor(messageCount, PARALLEL_WAIT_TIME_MS));
+    }
+
+    void test_MailboxIsBounded() {
+        MessageBus messageBus;
+        messageBus.enableParallelDelivery(2);
+        messageBus.setMailboxCapacity(PARALLEL_MAILBOX_CAPACITY);
+        RecordingNode slowNode(NodeID::MessageLogger, messageBus, PARALLEL_MAILBOX_DELAY_MS);
+        MessageBusTestHelper helper(messageBus);
+
+        const int messageCount = PARALLEL_MAILBOX_CAPACITY * 4;
+        for (int i = 0; i < messageCount; i++) {
+            messageBus.sendMessage(std::make_unique<WindDataMsg>(i, 0, 0));
+        }
+
+        // Every message is either processed or dropped, the oldest first
+        auto start = std::chrono::steady_clock::now();
+        while (slowNode.m_Count.load() + (int)messageBus.droppedCount(MessageType::WindData) < messageCount &&
+               std::chrono::steady_clock::now() - start < std::chrono::milliseconds(PARALLEL_WAIT_TIME_MS)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        DeliveryPool::MailboxStatistics stats = messageBus.mailboxStatistics();
+        TS_ASSERT_EQUALS(stats.capacity, PARALLEL_MAILBOX_CAPACITY);
+        TS_ASSERT(stats.peakDepth <= PARALLEL_MAILBOX_CAPACITY);
+        TS_ASSERT(stats.dropped > 0);
+        TS_ASSERT_EQUALS(stats.dropped, messageBus.droppedCount(MessageType::WindData));
+        TS_ASSERT_EQUALS(slowNode.m_Count.load() + (int)stats.dropped, messageCount);
+        TS_ASSERT_EQUALS(stats.depth, 0);
+
+        std::lock_guard<std::mutex> lock(slowNode.m_Mutex);
+        TS_ASSERT_EQUALS(slowNode.m_Received.back(), messageCount - 1);
+    }
+};
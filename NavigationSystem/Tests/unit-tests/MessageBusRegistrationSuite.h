@@ -0,0 +1,208 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		MessageBusRegistrationSuite.h
+ *
+ * Purpose:
+ *		Tests that nodes can be registered onto and removed from a running message bus,
+ *		with and without parallel delivery, and that they only receive the message types
+ *		they registered for.
+ *
+ * Developer Notes:
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../MessageBus/MessageBus.hpp"
+#include "../Messages/RudderCommandMsg.hpp"
+#include "../Messages/WindDataMsg.hpp"
+#include "../SystemServices/Logger.hpp"
+#include "../cxxtest/cxxtest/TestSuite.h"
+#include "MessageBusTestHelper.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#define REGISTRATION_MESSAGES 20
+#define REGISTRATION_SLOW_NODE_DELAY_MS 10
+#define REGISTRATION_WAIT_TIME_MS 2000
+
+class AttachedNode : public Node {
+   public:
+    AttachedNode(NodeID id, MessageBus& msgBus, int delayMs = 0, bool leaveAfterFirst = false)
+        : Node(id, msgBus),
+          m_DelayMs(delayMs),
+          m_LeaveAfterFirst(leaveAfterFirst),
+          m_Count(0),
+          m_Registered(msgBus.registerNode(*this, MessageType::WindData)) {}
+
+    bool init() { return true; }
+
+    void processMessage(const Message* message) {
+        if (m_DelayMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(m_DelayMs));
+        }
+        m_Count++;
+
+        if (m_LeaveAfterFirst && m_Count.load() == 1) {
+            m_MsgBus.unregisterNode(*this);
+        }
+    }
+
+    bool waitFor(int count) {
+        auto start = std::chrono::steady_clock::now();
+        while (m_Count.load() < count) {
+            if (std::chrono::steady_clock::now() - start >
+                std::chrono::milliseconds(REGISTRATION_WAIT_TIME_MS)) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    int m_DelayMs;
+    bool m_LeaveAfterFirst;
+    std::atomic<int> m_Count;
+    bool m_Registered;
+};
+
+class RoutedNode : public Node {
+   public:
+    RoutedNode(NodeID id, MessageBus& msgBus, MessageType msgType)
+        : Node(id, msgBus), m_WindCount(0), m_RudderCount(0) {
+        msgBus.registerNode(*this, msgType);
+    }
+
+    bool init() { return true; }
+
+    void processMessage(const Message* message) {
+        if (message->messageType() == MessageType::WindData) {
+            m_WindCount++;
+        } else if (message->messageType() == MessageType::RudderCommand) {
+            m_RudderCount++;
+        }
+    }
+
+    bool waitFor(std::atomic<int>& counter, int count) {
+        auto start = std::chrono::steady_clock::now();
+        while (counter.load() < count) {
+            if (std::chrono::steady_clock::now() - start >
+                std::chrono::milliseconds(REGISTRATION_WAIT_TIME_MS)) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    std::atomic<int> m_WindCount;
+    std::atomic<int> m_RudderCount;
+};
+
+class MessageBusRegistrationSuite : public CxxTest::TestSuite {
+   public:
+    void setUp() { Logger::DisableLogging(); }
+
+    void test_RegisterOnRunningBus() {
+        MessageBus messageBus;
+        MessageBusTestHelper helper(messageBus);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        AttachedNode node(NodeID::MessageLogger, messageBus);
+        TS_ASSERT(node.m_Registered);
+
+        sendMessages(messageBus, REGISTRATION_MESSAGES);
+        TS_ASSERT(node.waitFor(REGISTRATION_MESSAGES));
+    }
+
+    void test_UnregisteredNodeReceivesNothing() {
+        MessageBus messageBus;
+        AttachedNode leaving(NodeID::MessageLogger, messageBus);
+        AttachedNode staying(NodeID::MessageVerifier, messageBus);
+        MessageBusTestHelper helper(messageBus);
+
+        sendMessages(messageBus, REGISTRATION_MESSAGES);
+        TS_ASSERT(leaving.waitFor(REGISTRATION_MESSAGES));
+
+        TS_ASSERT(messageBus.unregisterNode(leaving));
+        TS_ASSERT(not messageBus.unregisterNode(leaving));
+
+        sendMessages(messageBus, REGISTRATION_MESSAGES);
+        TS_ASSERT(staying.waitFor(REGISTRATION_MESSAGES * 2));
+        TS_ASSERT_EQUALS(leaving.m_Count.load(), REGISTRATION_MESSAGES);
+    }
+
+    void test_NodeUnregistersItselfWhileProcessing() {
+        MessageBus messageBus;
+        AttachedNode leaving(NodeID::MessageLogger, messageBus, 0, true);
+        AttachedNode staying(NodeID::MessageVerifier, messageBus);
+        MessageBusTestHelper helper(messageBus);
+
+        sendMessages(messageBus, REGISTRATION_MESSAGES);
+        TS_ASSERT(staying.waitFor(REGISTRATION_MESSAGES));
+        TS_ASSERT_EQUALS(leaving.m_Count.load(), 1);
+    }
+
+    void test_UnregisterWithParallelDelivery() {
+        MessageBus messageBus;
+        messageBus.enableParallelDelivery(2);
+        AttachedNode slowNode(NodeID::MessageLogger, messageBus, REGISTRATION_SLOW_NODE_DELAY_MS);
+        MessageBusTestHelper helper(messageBus);
+
+        sendMessages(messageBus, REGISTRATION_MESSAGES);
+        TS_ASSERT(slowNode.waitFor(1));
+
+        // The messages still waiting in the mailbox are dropped
+        TS_ASSERT(messageBus.unregisterNode(slowNode));
+        int count = slowNode.m_Count.load();
+        TS_ASSERT_LESS_THAN(count, REGISTRATION_MESSAGES);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(REGISTRATION_SLOW_NODE_DELAY_MS * 3));
+        TS_ASSERT_EQUALS(slowNode.m_Count.load(), count);
+    }
+
+    void test_NodesOnlyReceiveTheirRegisteredTypes() {
+        MessageBus messageBus;
+        RoutedNode windNode(NodeID::MessageLogger, messageBus, MessageType::WindData);
+        RoutedNode rudderNode(NodeID::MessageVerifier, messageBus, MessageType::RudderCommand);
+        MessageBusTestHelper helper(messageBus);
+
+        sendMessages(messageBus, REGISTRATION_MESSAGES);
+        sendRudderMessages(messageBus, REGISTRATION_MESSAGES);
+        TS_ASSERT(windNode.waitFor(windNode.m_WindCount, REGISTRATION_MESSAGES));
+        TS_ASSERT(rudderNode.waitFor(rudderNode.m_RudderCount, REGISTRATION_MESSAGES));
+        TS_ASSERT_EQUALS(windNode.m_RudderCount.load(), 0);
+        TS_ASSERT_EQUALS(rudderNode.m_WindCount.load(), 0);
+
+        // A type added to a registered node is routed to it from then on, and only to it
+        TS_ASSERT(messageBus.registerNode(windNode, MessageType::RudderCommand));
+
+        sendMessages(messageBus, REGISTRATION_MESSAGES);
+        sendRudderMessages(messageBus, REGISTRATION_MESSAGES);
+        TS_ASSERT(windNode.waitFor(windNode.m_WindCount, REGISTRATION_MESSAGES * 2));
+        TS_ASSERT(windNode.waitFor(windNode.m_RudderCount, REGISTRATION_MESSAGES));
+        TS_ASSERT(rudderNode.waitFor(rudderNode.m_RudderCount, REGISTRATION_MESSAGES * 2));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(REGISTRATION_SLOW_NODE_DELAY_MS));
+        TS_ASSERT_EQUALS(windNode.m_WindCount.load(), REGISTRATION_MESSAGES * 2);
+        TS_ASSERT_EQUALS(windNode.m_RudderCount.load(), REGISTRATION_MESSAGES);
+        TS_ASSERT_EQUALS(rudderNode.m_RudderCount.load(), REGISTRATION_MESSAGES * 2);
+        TS_ASSERT_EQUALS(rudderNode.m_WindCount.load(), 0);
+    }
+
+   private:
+    void sendRudderMessages(MessageBus& messageBus, int count) {
+        for (int i = 0; i < count; i++) {
+            messageBus.sendMessage(std::make_unique<RudderCommandMsg>(i));
+        }
+    }
+
+    void sendMessages(MessageBus& messageBus, int count) {
+        for (int i = 0; i < count; i++) {
+            messageBus.sendMessage(std::make_unique<WindDataMsg>(i, 0, 0));
+        }
+    }
+};
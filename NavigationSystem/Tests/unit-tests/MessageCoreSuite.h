@@ -20,7 +20,6 @@
  *									logMessageReceived
  *									logMessage
  *									logMessageConsumer
- *									messageTimeStamp
  *
  ***************************************************************************************/
 
@@ -92,11 +91,11 @@ class MessageCoreSuite : public CxxTest::TestSuite {
         TS_ASSERT(registered);
     }
 
-    void test_FailedNodeRegisterAfterStart() {
+    void test_NodeRegisterAfterStart() {
         bool didRegister = false;
         MockNode nodeTwo(messageBus, didRegister);
 
-        TS_ASSERT(!didRegister);
+        TS_ASSERT(didRegister);
     }
 
     void test_MessageReceived() {
@@ -0,0 +1,175 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		MessageJournalSuite.h
+ *
+ * Purpose:
+ *		Tests that the message journal records messages in binary form, that it can be
+ *		switched off, and that it drops messages rather than blocking when its buffer is
+ *		full.
+ *
+ * Developer Notes:
+ *		The journal is written into the working directory and removed afterwards.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../MessageBus/MessageBus.hpp"
+#include "../MessageBus/MessageJournal.hpp"
+#include "../Messages/WindDataMsg.hpp"
+#include "../SystemServices/Logger.hpp"
+#include "../cxxtest/cxxtest/TestSuite.h"
+#include "MessageBusTestHelper.h"
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#define JOURNAL_TEST_FILE "./MessageJournalSuite.journal"
+#define JOURNAL_TEST_MESSAGES 100
+#define JOURNAL_WAIT_TIME_MS 2000
+
+class JournalTestNode : public Node {
+   public:
+    JournalTestNode(MessageBus& msgBus) : Node(NodeID::MessageLogger, msgBus), m_Count(0) {
+        msgBus.registerNode(*this, MessageType::WindData);
+    }
+
+    bool init() { return true; }
+
+    void processMessage(const Message* message) { m_Count++; }
+
+    bool waitFor(int count) {
+        auto start = std::chrono::steady_clock::now();
+        while (m_Count.load() < count) {
+            if (std::chrono::steady_clock::now() - start >
+                std::chrono::milliseconds(JOURNAL_WAIT_TIME_MS)) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    std::atomic<int> m_Count;
+};
+
+class MessageJournalSuite : public CxxTest::TestSuite {
+   public:
+    void setUp() { Logger::DisableLogging(); }
+
+    void tearDown() {
+        std::remove(JOURNAL_TEST_FILE);
+        std::remove(JOURNAL_TEST_FILE ".0001");
+    }
+
+    void test_RecordsSerialisedMessages() {
+        MessageJournal journal;
+        TS_ASSERT(journal.open(JOURNAL_TEST_FILE));
+
+        journal.record(WindDataMsg(10, 20, 30));
+        journal.record(WindDataMsg(40, 50, 60));
+        journal.flush();
+
+        std::vector<uint8_t> data = readJournal();
+        TS_ASSERT_EQUALS(data.size(), journal.bytesWritten() + JOURNAL_MAGIC_SIZE);
+        TS_ASSERT_EQUALS(std::string(data.begin(), data.begin() + JOURNAL_MAGIC_SIZE),
+                         JOURNAL_MAGIC);
+
+        // Walk the records and deserialise the second message
+        unsigned int offset = JOURNAL_MAGIC_SIZE;
+        int records = 0;
+        while (offset + JOURNAL_RECORD_HEADER_SIZE <= data.size()) {
+            uint8_t size = data[offset + JOURNAL_RECORD_HEADER_SIZE - 1];
+            uint8_t* payload = &data[offset + JOURNAL_RECORD_HEADER_SIZE];
+            records++;
+
+            if (records == 2) {
+                MessageDeserialiser deserialiser(payload, size);
+                WindDataMsg msg(deserialiser);
+                TS_ASSERT(msg.isValid());
+                TS_ASSERT_EQUALS(msg.windDirection(), 40);
+                TS_ASSERT_EQUALS(msg.windSpeed(), 50);
+                TS_ASSERT_EQUALS(msg.windTemp(), 60);
+            }
+            offset += JOURNAL_RECORD_HEADER_SIZE + size;
+        }
+
+        TS_ASSERT_EQUALS(records, 2);
+        TS_ASSERT_EQUALS(offset, data.size());
+    }
+
+    void test_DisabledJournalRecordsNothing() {
+        MessageJournal journal;
+        TS_ASSERT(journal.open(JOURNAL_TEST_FILE));
+
+        journal.setEnabled(false);
+        journal.record(WindDataMsg(10, 20, 30));
+        journal.setEnabled(true);
+        journal.record(WindDataMsg(10, 20, 30));
+
+        TS_ASSERT_EQUALS(journal.recordedCount(), 1);
+    }
+
+    void test_FullBufferDropsMessages() {
+        // Only room for a couple of records at a time
+        MessageJournal journal(64);
+        TS_ASSERT(journal.open(JOURNAL_TEST_FILE));
+
+        for (int i = 0; i < JOURNAL_TEST_MESSAGES; i++) {
+            journal.record(WindDataMsg(i, 0, 0));
+        }
+        journal.flush();
+
+        TS_ASSERT(journal.droppedCount() > 0);
+        TS_ASSERT_EQUALS(journal.recordedCount() + journal.droppedCount(), JOURNAL_TEST_MESSAGES);
+    }
+
+    void test_JournalRotatesBetweenBatches() {
+        MessageJournal journal;
+        RotationPolicy policy = {JOURNAL_MAGIC_SIZE + 1, 0, 0, false};
+        journal.setRotation(policy);
+        TS_ASSERT(journal.open(JOURNAL_TEST_FILE));
+
+        journal.record(WindDataMsg(10, 20, 30));
+        journal.record(WindDataMsg(40, 50, 60));
+        journal.flush();
+        journal.close();
+
+        // The whole batch went into the segment, which is a journal on its own
+        std::ifstream segment(JOURNAL_TEST_FILE ".0001", std::ios::binary);
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(segment)),
+                                  std::istreambuf_iterator<char>());
+        TS_ASSERT_EQUALS(data.size(), journal.bytesWritten() + JOURNAL_MAGIC_SIZE);
+        TS_ASSERT_EQUALS(readJournal().size(), JOURNAL_MAGIC_SIZE);
+    }
+
+    void test_BusRecordsDistributedMessages() {
+        MessageBus messageBus;
+        JournalTestNode node(messageBus);
+        TS_ASSERT(messageBus.journal().open(JOURNAL_TEST_FILE));
+        MessageBusTestHelper helper(messageBus);
+
+        for (int i = 0; i < JOURNAL_TEST_MESSAGES; i++) {
+            messageBus.sendMessage(std::make_unique<WindDataMsg>(i, 0, 0));
+        }
+
+        TS_ASSERT(node.waitFor(JOURNAL_TEST_MESSAGES));
+        messageBus.journal().flush();
+        TS_ASSERT_EQUALS(messageBus.journal().recordedCount(), JOURNAL_TEST_MESSAGES);
+        TS_ASSERT_EQUALS(messageBus.journal().droppedCount(), 0);
+    }
+
+   private:
+    std::vector<uint8_t> readJournal() {
+        std::ifstream file(JOURNAL_TEST_FILE, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(file),
+                                    std::istreambuf_iterator<char>());
+    }
+};
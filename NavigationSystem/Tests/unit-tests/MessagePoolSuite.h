@@ -0,0 +1,191 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		MessagePoolSuite.h
+ *
+ * Purpose:
+ *		Tests that message memory is recycled by the MessagePool, and that once warmed up
+ *		sending messages through the message bus makes no more heap allocations for them.
+ *
+ * Developer Notes:
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../MessageBus/MessageBus.hpp"
+#include "../MessageBus/MessagePool.hpp"
+#include "../Messages/CompassDataMsg.h"
+#include "../Messages/GPSDataMsg.hpp"
+#include "../Messages/WindDataMsg.hpp"
+#include "../SystemServices/Logger.hpp"
+#include "../cxxtest/cxxtest/TestSuite.h"
+#include "MessageBusTestHelper.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#define POOL_MESSAGE_COUNT 1000
+#define POOL_WAIT_TIME_MS 2000
+#define POOL_ROUND_MESSAGES 300
+#define POOL_ROUNDS 10
+#define POOL_WARM_UP_ROUNDS 2
+
+class CountingNode : public Node {
+   public:
+    CountingNode(MessageBus& msgBus)
+        : Node(NodeID::MessageLogger, msgBus), m_Count(0), m_Hold(false), m_Holding(false) {
+        msgBus.registerNode(*this, MessageType::WindData);
+        msgBus.registerNode(*this, MessageType::CompassData);
+        msgBus.registerNode(*this, MessageType::GPSData);
+    }
+
+    bool init() { return true; }
+
+    void processMessage(const Message* message) {
+        m_Count++;
+        while (m_Hold.load()) {
+            m_Holding = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    bool waitFor(int count) {
+        auto start = std::chrono::steady_clock::now();
+        while (m_Count.load() < count) {
+            if (std::chrono::steady_clock::now() - start >
+                std::chrono::milliseconds(POOL_WAIT_TIME_MS)) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    std::atomic<int> m_Count;
+    std::atomic<bool> m_Hold;  ///< Holds the message being processed until cleared
+    std::atomic<bool> m_Holding;
+};
+
+class MessagePoolSuite : public CxxTest::TestSuite {
+   public:
+    void setUp() { Logger::DisableLogging(); }
+
+    void test_ReleasedMemoryIsReused() {
+        MessagePtr first = std::make_unique<WindDataMsg>(0, 0, 0);
+        Message* firstAddress = first.get();
+        first.reset();
+
+        unsigned long heapAllocations = MessagePool::heapAllocations();
+        MessagePtr second = std::make_unique<WindDataMsg>(1, 1, 1);
+
+        TS_ASSERT_EQUALS(second.get(), firstAddress);
+        TS_ASSERT_EQUALS(MessagePool::heapAllocations(), heapAllocations);
+    }
+
+    void test_ReserveAvoidsHeapAllocations() {
+        MessagePool::reserve(sizeof(GPSDataMsg), 10);
+        unsigned long heapAllocations = MessagePool::heapAllocations();
+
+        std::vector<MessagePtr> messages;
+        for (int i = 0; i < 10; i++) {
+            messages.push_back(std::make_unique<GPSDataMsg>(true, true, 0, 0, 0, 0, 0, 0,
+                                                            GPSMode::NoUpdate));
+        }
+
+        TS_ASSERT_EQUALS(MessagePool::heapAllocations(), heapAllocations);
+    }
+
+    void test_SteadyStateMessagingUsesNoHeap() {
+        MessageBus messageBus;
+        CountingNode node(messageBus);
+        MessageBusTestHelper helper(messageBus);
+
+        // Warm up the pool with enough blocks for every message to be in flight at once
+        MessagePool::reserve(sizeof(WindDataMsg), POOL_MESSAGE_COUNT);
+        MessagePool::reserve(sizeof(CompassDataMsg), POOL_MESSAGE_COUNT);
+        MessagePool::reserve(sizeof(GPSDataMsg), POOL_MESSAGE_COUNT);
+
+        unsigned long heapAllocations = MessagePool::heapAllocations();
+        unsigned long pooledAllocations = MessagePool::pooledAllocations();
+
+        sendMessages(messageBus);
+        TS_ASSERT(node.waitFor(POOL_MESSAGE_COUNT * 3));
+
+        TS_ASSERT_EQUALS(MessagePool::heapAllocations(), heapAllocations);
+        TS_ASSERT_EQUALS(MessagePool::pooledAllocations() - pooledAllocations,
+                         POOL_MESSAGE_COUNT * 3);
+    }
+
+    void test_AllocationsStayFlatAfterWarmUp() {
+        checkFlatAllocations(false);
+    }
+
+    void test_ParallelDeliveryAllocationsStayFlatAfterWarmUp() {
+        checkFlatAllocations(true);
+    }
+
+   private:
+    // Sends rounds of messages through the message bus, the pool only grows while warming up
+    void checkFlatAllocations(bool parallel) {
+        MessageBus messageBus;
+        if (parallel) {
+            messageBus.enableParallelDelivery(2);
+        }
+        CountingNode node(messageBus);
+        MessageBusTestHelper helper(messageBus);
+
+        int sent = 0;
+        for (int i = 0; i < POOL_WARM_UP_ROUNDS; i++) {
+            sent += sendRound(messageBus, node, parallel);
+            TS_ASSERT(node.waitFor(sent));
+        }
+
+        unsigned long heapAllocations = MessagePool::heapAllocations();
+        unsigned long pooledAllocations = MessagePool::pooledAllocations();
+
+        for (int i = 0; i < POOL_ROUNDS; i++) {
+            sent += sendRound(messageBus, node, parallel);
+            TS_ASSERT(node.waitFor(sent));
+        }
+
+        TS_ASSERT_EQUALS(MessagePool::heapAllocations(), heapAllocations);
+
+        // Messages shared between the nodes take a control block from the pool as well
+        unsigned long perMessage = parallel ? 2 : 1;
+        TS_ASSERT_LESS_THAN_EQUALS(POOL_ROUNDS * POOL_ROUND_MESSAGES * perMessage,
+                                   MessagePool::pooledAllocations() - pooledAllocations);
+    }
+
+    // The node holds on to the first message of the round, so that the whole round is in flight
+    // at once and every round takes as much memory as the others. In parallel delivery the
+    // round is held until it is all in the mailbox, and shares its messages.
+    int sendRound(MessageBus& messageBus, CountingNode& node, bool parallel) {
+        unsigned long distributed = messageBus.distributedCount();
+        node.m_Hold = true;
+        node.m_Holding = false;
+        messageBus.sendMessage(std::make_unique<WindDataMsg>(0, 0, 0));
+        while (not node.m_Holding.load()) {
+            std::this_thread::yield();
+        }
+
+        for (int i = 1; i < POOL_ROUND_MESSAGES; i++) {
+            messageBus.sendMessage(std::make_unique<WindDataMsg>(i, 0, 0));
+        }
+        while (parallel && messageBus.distributedCount() - distributed < POOL_ROUND_MESSAGES) {
+            std::this_thread::yield();
+        }
+        node.m_Hold = false;
+        return POOL_ROUND_MESSAGES;
+    }
+
+    void sendMessages(MessageBus& messageBus) {
+        for (int i = 0; i < POOL_MESSAGE_COUNT; i++) {
+            messageBus.sendMessage(std::make_unique<WindDataMsg>(i, 0, 0));
+            messageBus.sendMessage(std::make_unique<CompassDataMsg>(i, 0, 0));
+            messageBus.sendMessage(std::make_unique<GPSDataMsg>(true, true, 0, 0, 0, 0, 0, 0,
+                                                                GPSMode::NoUpdate));
+        }
+    }
+};
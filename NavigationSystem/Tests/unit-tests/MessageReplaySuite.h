@@ -0,0 +1,234 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		MessageReplaySuite.h
+ *
+ * Purpose:
+ *		Tests that messages recorded by the message journal are replayed onto a message
+ *		bus in order, with their original timing or sped up.
+ *
+ * Developer Notes:
+ *		The journal is written into the working directory and removed afterwards.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../MessageBus/MessageBus.hpp"
+#include "../MessageBus/MessageJournal.hpp"
+#include "../MessageBus/MessageReplay.hpp"
+#include "../Messages/CompassDataMsg.h"
+#include "../Messages/RudderCommandMsg.hpp"
+#include "../Messages/WindDataMsg.hpp"
+#include "../SystemServices/Logger.hpp"
+#include "../cxxtest/cxxtest/TestSuite.h"
+#include "MessageBusTestHelper.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define REPLAY_TEST_FILE "./MessageReplaySuite.journal"
+#define REPLAY_TEST_MESSAGES 50
+#define REPLAY_TEST_GAP_MS 100
+
+class ReplayNode : public Node {
+   public:
+    ReplayNode(MessageBus& msgBus) : Node(NodeID::MessageLogger, msgBus), m_RudderCommands(0) {
+        msgBus.registerNode(*this, MessageType::WindData);
+        msgBus.registerNode(*this, MessageType::RudderCommand);
+    }
+
+    bool init() { return true; }
+
+    void processMessage(const Message* message) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (message->messageType() == MessageType::RudderCommand) {
+            m_RudderCommands++;
+            return;
+        }
+        const WindDataMsg* windMsg = static_cast<const WindDataMsg*>(message);
+        m_Received.push_back((int)windMsg->windDirection());
+    }
+
+    std::mutex m_Mutex;
+    std::vector<int> m_Received;
+    int m_RudderCommands;
+};
+
+// Sends a rudder command for every wind data, as the course regulator does, taking its time
+class DerivingNode : public Node {
+   public:
+    DerivingNode(MessageBus& msgBus) : Node(NodeID::CourseRegulatorNode, msgBus), m_Received(0) {
+        msgBus.registerNode(*this, MessageType::WindData);
+    }
+
+    bool init() { return true; }
+
+    void processMessage(const Message* message) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        m_Received++;
+        m_MsgBus.sendMessage(std::make_unique<RudderCommandMsg>(0));
+    }
+
+    std::atomic<int> m_Received;
+};
+
+class MessageReplaySuite : public CxxTest::TestSuite {
+   public:
+    void setUp() { Logger::DisableLogging(); }
+
+    void tearDown() { std::remove(REPLAY_TEST_FILE); }
+
+    void test_CreateMessageFromSerialisedData() {
+        MessageSerialiser serialiser;
+        CompassDataMsg(120, 5, -5).Serialise(serialiser);
+
+        MessagePtr msg = MessageReplay::createMessage(serialiser.data(), serialiser.size());
+        TS_ASSERT(msg != NULL);
+        TS_ASSERT_EQUALS(msg->messageType(), MessageType::CompassData);
+
+        CompassDataMsg* compassMsg = static_cast<CompassDataMsg*>(msg.get());
+        TS_ASSERT_EQUALS(compassMsg->heading(), 120);
+        TS_ASSERT_EQUALS(compassMsg->pitch(), 5);
+        TS_ASSERT_EQUALS(compassMsg->roll(), -5);
+
+        // Truncated data is rejected
+        TS_ASSERT(MessageReplay::createMessage(serialiser.data(), 4) == NULL);
+    }
+
+    void test_ReplaysMessagesInOrder() {
+        MessageJournal journal;
+        TS_ASSERT(journal.open(REPLAY_TEST_FILE));
+        for (int i = 0; i < REPLAY_TEST_MESSAGES; i++) {
+            journal.record(WindDataMsg(i, 0, 0));
+        }
+        journal.close();
+
+        MessageBus messageBus;
+        ReplayNode node(messageBus);
+        MessageBusTestHelper helper(messageBus);
+
+        MessageReplay replay(messageBus);
+        TS_ASSERT(replay.open(REPLAY_TEST_FILE));
+        TS_ASSERT_EQUALS(replay.run(REPLAY_AS_FAST_AS_POSSIBLE), REPLAY_TEST_MESSAGES);
+        TS_ASSERT_EQUALS(replay.skippedCount(), 0);
+        TS_ASSERT(replay.messagesPerSecond() > 0);
+
+        std::lock_guard<std::mutex> lock(node.m_Mutex);
+        TS_ASSERT_EQUALS(node.m_Received.size(), REPLAY_TEST_MESSAGES);
+        for (unsigned int i = 0; i < node.m_Received.size(); i++) {
+            TS_ASSERT_EQUALS(node.m_Received[i], (int)i);
+        }
+    }
+
+    void test_ReplayKeepsScaledTiming() {
+        MessageJournal journal;
+        TS_ASSERT(journal.open(REPLAY_TEST_FILE));
+        journal.record(WindDataMsg(0, 0, 0));
+        std::this_thread::sleep_for(std::chrono::milliseconds(REPLAY_TEST_GAP_MS));
+        journal.record(WindDataMsg(1, 0, 0));
+        journal.close();
+
+        MessageBus messageBus;
+        ReplayNode node(messageBus);
+        MessageBusTestHelper helper(messageBus);
+
+        MessageReplay replay(messageBus);
+        TS_ASSERT(replay.open(REPLAY_TEST_FILE));
+
+        replay.run(1.0);
+        TS_ASSERT(replay.elapsedSeconds() >= REPLAY_TEST_GAP_MS / 1000.0);
+
+        replay.run(4.0);
+        TS_ASSERT(replay.elapsedSeconds() >= REPLAY_TEST_GAP_MS / 4000.0);
+        TS_ASSERT(replay.elapsedSeconds() < REPLAY_TEST_GAP_MS / 1000.0);
+
+        replay.run(REPLAY_AS_FAST_AS_POSSIBLE);
+        TS_ASSERT(replay.elapsedSeconds() < REPLAY_TEST_GAP_MS / 4000.0);
+        TS_ASSERT_EQUALS(replay.replayedCount(), 2);
+    }
+
+    void test_DerivedMessagesAreFilteredByDefault() {
+        MessageJournal journal;
+        TS_ASSERT(journal.open(REPLAY_TEST_FILE));
+        for (int i = 0; i < 10; i++) {
+            journal.record(WindDataMsg(i, 0, 0));
+            journal.record(RudderCommandMsg(i));
+        }
+        journal.close();
+
+        MessageBus messageBus;
+        ReplayNode node(messageBus);
+        MessageBusTestHelper helper(messageBus);
+
+        // The nodes which sent the rudder commands send them again from the wind data
+        MessageReplay replay(messageBus);
+        TS_ASSERT(replay.open(REPLAY_TEST_FILE));
+        TS_ASSERT(not replay.isTypeReplayed(MessageType::RudderCommand));
+        TS_ASSERT_EQUALS(replay.run(REPLAY_AS_FAST_AS_POSSIBLE), 10);
+        TS_ASSERT_EQUALS(replay.filteredCount(), 10);
+        {
+            std::lock_guard<std::mutex> lock(node.m_Mutex);
+            TS_ASSERT_EQUALS(node.m_Received.size(), 10);
+            TS_ASSERT_EQUALS(node.m_RudderCommands, 0);
+        }
+
+        replay.replayAllTypes();
+        TS_ASSERT_EQUALS(replay.run(REPLAY_AS_FAST_AS_POSSIBLE), 20);
+        TS_ASSERT_EQUALS(replay.filteredCount(), 0);
+        std::lock_guard<std::mutex> lock(node.m_Mutex);
+        TS_ASSERT_EQUALS(node.m_RudderCommands, 10);
+    }
+
+    void test_WaitsForTheReplayedMessagesOnly() {
+        MessageJournal journal;
+        TS_ASSERT(journal.open(REPLAY_TEST_FILE));
+        for (int i = 0; i < REPLAY_TEST_MESSAGES; i++) {
+            journal.record(WindDataMsg(i, 0, 0));
+        }
+        journal.close();
+
+        MessageBus messageBus;
+        DerivingNode node(messageBus);
+        MessageBusTestHelper helper(messageBus);
+
+        // The rudder commands go ahead of the wind data left in the queues, they mustn't be
+        // taken for replayed messages
+        MessageReplay replay(messageBus);
+        TS_ASSERT(replay.open(REPLAY_TEST_FILE));
+        TS_ASSERT_EQUALS(replay.run(REPLAY_AS_FAST_AS_POSSIBLE), REPLAY_TEST_MESSAGES);
+        TS_ASSERT_EQUALS(node.m_Received.load(), REPLAY_TEST_MESSAGES);
+    }
+
+    void test_DroppedReplayedMessagesAreHandled() {
+        MessageBus messageBus;
+        messageBus.setLaneCapacity(MessageLane::Normal, 1);
+        messageBus.setOverflowPolicy(MessageType::WindData, OverflowPolicy::DropNewest);
+
+        MessagePtr msg = std::make_unique<WindDataMsg>(0, 0, 0);
+        msg->markReplayed();
+        messageBus.sendMessage(std::move(msg));
+        TS_ASSERT_EQUALS(messageBus.replayedHandledCount(), 0);
+
+        msg = std::make_unique<WindDataMsg>(1, 0, 0);
+        msg->markReplayed();
+        messageBus.sendMessage(std::move(msg));
+        TS_ASSERT_EQUALS(messageBus.replayedHandledCount(), 1);
+
+        // The message given up to make room counts too
+        messageBus.setOverflowPolicy(MessageType::WindData, OverflowPolicy::DropOldest);
+        msg = std::make_unique<WindDataMsg>(2, 0, 0);
+        msg->markReplayed();
+        messageBus.sendMessage(std::move(msg));
+        TS_ASSERT_EQUALS(messageBus.replayedHandledCount(), 2);
+
+        // Messages of the nodes are left out
+        messageBus.setOverflowPolicy(MessageType::WindData, OverflowPolicy::DropNewest);
+        messageBus.sendMessage(std::make_unique<WindDataMsg>(3, 0, 0));
+        TS_ASSERT_EQUALS(messageBus.replayedHandledCount(), 2);
+    }
+};
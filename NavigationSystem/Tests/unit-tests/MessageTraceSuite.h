@@ -0,0 +1,208 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		MessageTraceSuite.h
+ *
+ * Purpose:
+ *		Tests the trace information of the messages, the linking of a message to the
+ *		message which caused it, and the latency histograms of the LatencyTracer.
+ *
+ * Developer Notes:
+ *		The relay node turns wind data into rudder commands, either straight from
+ *		processMessage() or from its own thread, like the control loop nodes do.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../MessageBus/LatencyTracer.hpp"
+#include "../MessageBus/MessageBus.hpp"
+#include "../Messages/RudderCommandMsg.hpp"
+#include "../Messages/WindDataMsg.hpp"
+#include "../SystemServices/Logger.hpp"
+#include "../cxxtest/cxxtest/TestSuite.h"
+#include "MessageBusTestHelper.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#define TRACE_WAIT_TIME_MS 1000
+#define TRACE_PROCESSING_DELAY_MS 5
+
+class TraceRelayNode : public Node {
+   public:
+    TraceRelayNode(MessageBus& msgBus, bool relayFromProcess)
+        : Node(NodeID::WindStateNode, msgBus), m_RelayFromProcess(relayFromProcess) {
+        msgBus.registerNode(*this, MessageType::WindData);
+    }
+
+    bool init() { return true; }
+
+    void processMessage(const Message* message) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(TRACE_PROCESSING_DELAY_MS));
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_WindTrace = message->trace();
+
+        if (m_RelayFromProcess) {
+            m_MsgBus.sendMessage(std::make_unique<RudderCommandMsg>(1.0f));
+        }
+    }
+
+    // Sends a rudder command the way a node does from its thread loop
+    void relayFromLoop() {
+        MessagePtr msg = std::make_unique<RudderCommandMsg>(1.0f);
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            msg->setParent(m_WindTrace);
+        }
+        m_MsgBus.sendMessage(std::move(msg));
+    }
+
+    bool m_RelayFromProcess;
+    std::mutex m_Mutex;
+    MessageTrace m_WindTrace;
+};
+
+class TraceSinkNode : public Node {
+   public:
+    TraceSinkNode(MessageBus& msgBus) : Node(NodeID::RudderActuator, msgBus), m_Count(0) {
+        msgBus.registerNode(*this, MessageType::RudderCommand);
+    }
+
+    bool init() { return true; }
+
+    void processMessage(const Message* message) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_RudderTrace = message->trace();
+        m_Count++;
+    }
+
+    bool waitFor(int count) {
+        auto start = std::chrono::steady_clock::now();
+        while (m_Count.load() < count) {
+            if (std::chrono::steady_clock::now() - start >
+                std::chrono::milliseconds(TRACE_WAIT_TIME_MS)) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    std::mutex m_Mutex;
+    std::atomic<int> m_Count;
+    MessageTrace m_RudderTrace;
+};
+
+class MessageTraceSuite : public CxxTest::TestSuite {
+   public:
+    void setUp() { Logger::DisableLogging(); }
+
+    void test_NewMessagesAreRoots() {
+        WindDataMsg first(0, 0, 0);
+        WindDataMsg second(0, 0, 0);
+
+        TS_ASSERT(first.trace().id != 0);
+        TS_ASSERT(second.trace().id > first.trace().id);
+        TS_ASSERT_EQUALS(first.trace().parentId, 0);
+        TS_ASSERT_EQUALS(first.trace().originUs, first.trace().createdUs);
+        TS_ASSERT_EQUALS(first.trace().sentUs, 0);
+    }
+
+    void test_MessageCreatedWhileProcessingIsLinked() {
+        MessageBus messageBus;
+        TraceRelayNode relay(messageBus, true);
+        TraceSinkNode sink(messageBus);
+        MessageBusTestHelper helper(messageBus);
+
+        MessagePtr wind = std::make_unique<WindDataMsg>(0, 0, 0);
+        MessageTrace windTrace = wind->trace();
+        messageBus.sendMessage(std::move(wind));
+        TS_ASSERT(sink.waitFor(1));
+
+        std::lock_guard<std::mutex> lock(sink.m_Mutex);
+        const MessageTrace& rudderTrace = sink.m_RudderTrace;
+        TS_ASSERT_EQUALS(rudderTrace.parentId, windTrace.id);
+        TS_ASSERT_EQUALS(rudderTrace.originUs, windTrace.originUs);
+        TS_ASSERT(rudderTrace.createdUs > rudderTrace.originUs);
+        TS_ASSERT(rudderTrace.sentUs >= rudderTrace.createdUs);
+        TS_ASSERT(rudderTrace.dispatchedUs >= rudderTrace.sentUs);
+    }
+
+    void test_ChainLatencyFromThreadLoop() {
+        MessageBus messageBus;
+        TraceRelayNode relay(messageBus, false);
+        TraceSinkNode sink(messageBus);
+        MessageBusTestHelper helper(messageBus);
+
+        MessagePtr wind = std::make_unique<WindDataMsg>(0, 0, 0);
+        uint64_t windId = wind->trace().id;
+        messageBus.sendMessage(std::move(wind));
+
+        auto start = std::chrono::steady_clock::now();
+        while (messageBus.tracer().processingTime(NodeID::WindStateNode).count() == 0 &&
+               std::chrono::steady_clock::now() - start <
+                   std::chrono::milliseconds(TRACE_WAIT_TIME_MS)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        relay.relayFromLoop();
+        TS_ASSERT(sink.waitFor(1));
+
+        {
+            std::lock_guard<std::mutex> lock(sink.m_Mutex);
+            TS_ASSERT_EQUALS(sink.m_RudderTrace.parentId, windId);
+        }
+
+        // The wind data was processed for at least the delay of the relay before the rudder
+        // command left, so the whole chain took longer than that
+        LatencyTracer& tracer = messageBus.tracer();
+        TS_ASSERT_EQUALS(tracer.chainLatency(MessageType::RudderCommand).count(), 1);
+        TS_ASSERT(tracer.chainLatency(MessageType::RudderCommand).maxUs() >=
+                  TRACE_PROCESSING_DELAY_MS * 1000);
+        TS_ASSERT_EQUALS(tracer.queueLatency(MessageType::WindData).count(), 1);
+        TS_ASSERT_EQUALS(tracer.deliveryLatency(NodeID::RudderActuator).count(), 1);
+        TS_ASSERT(tracer.processingTime(NodeID::WindStateNode).maxUs() >=
+                  TRACE_PROCESSING_DELAY_MS * 1000);
+    }
+
+    void test_DisabledTracerRecordsNothing() {
+        MessageBus messageBus;
+        TraceRelayNode relay(messageBus, true);
+        TraceSinkNode sink(messageBus);
+        messageBus.tracer().setEnabled(false);
+        MessageBusTestHelper helper(messageBus);
+
+        messageBus.sendMessage(std::make_unique<WindDataMsg>(0, 0, 0));
+        TS_ASSERT(sink.waitFor(1));
+
+        TS_ASSERT_EQUALS(messageBus.tracer().chainLatency(MessageType::RudderCommand).count(), 0);
+        TS_ASSERT_EQUALS(messageBus.tracer().processingTime(NodeID::RudderActuator).count(), 0);
+
+        // Messages are still linked
+        std::lock_guard<std::mutex> lock(sink.m_Mutex);
+        TS_ASSERT(sink.m_RudderTrace.parentId != 0);
+    }
+
+    void test_HistogramPercentiles() {
+        LatencyHistogram histogram;
+
+        for (int i = 0; i < 99; i++) {
+            histogram.record(100);
+        }
+        histogram.record(5000);
+
+        TS_ASSERT_EQUALS(histogram.count(), 100);
+        TS_ASSERT_EQUALS(histogram.maxUs(), 5000);
+        TS_ASSERT_DELTA(histogram.meanUs(), 149, 0.01);
+        TS_ASSERT_EQUALS(histogram.percentileUs(50), 128);
+        TS_ASSERT_EQUALS(histogram.percentileUs(99), 128);
+        TS_ASSERT_EQUALS(histogram.percentileUs(100), 5000);
+
+        histogram.reset();
+        TS_ASSERT_EQUALS(histogram.count(), 0);
+        TS_ASSERT_EQUALS(histogram.percentileUs(50), 0);
+    }
+};
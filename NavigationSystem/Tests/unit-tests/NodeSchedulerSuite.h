@@ -0,0 +1,203 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		NodeSchedulerSuite.h
+ *
+ * Purpose:
+ *		Tests the shared scheduler running the periodic work of active nodes, on a
+ *		manually stepped clock.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../MessageBus/ActiveNode.hpp"
+#include "../MessageBus/MessageBus.hpp"
+#include "../MessageBus/NodeScheduler.hpp"
+#include "../SystemServices/ClockSource.hpp"
+#include "../cxxtest/cxxtest/TestSuite.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#define SCHEDULER_TEST_TIMEOUT_MS 2000
+
+class TickingNode : public ActiveNode {
+   public:
+    TickingNode(MessageBus& msgBus) : ActiveNode(NodeID::MessageVerifier, msgBus), ticks(0) {}
+
+    bool init() { return true; }
+    void start() { runPeriodic(tick, 0.02); }
+    void stop() { stopPeriodic(); }
+    void processMessage(const Message* msg) {}
+
+    std::atomic<int> ticks;
+
+   private:
+    static void tick(ActiveNode* nodePtr) { static_cast<TickingNode*>(nodePtr)->ticks++; }
+};
+
+// Slows down from its first tick, as the nodes adapting their rate do
+class SlowingNode : public TickingNode {
+   public:
+    SlowingNode(MessageBus& msgBus) : TickingNode(msgBus) {}
+
+    void start() { runPeriodic(tick, 0.02); }
+
+   private:
+    static void tick(ActiveNode* nodePtr) {
+        SlowingNode* node = static_cast<SlowingNode*>(nodePtr);
+        node->setPeriod(0.05);
+        node->ticks++;
+    }
+};
+
+class NodeSchedulerSuite : public CxxTest::TestSuite {
+   public:
+    ManualClock* clock;
+    NodeScheduler* scheduler;
+
+    void setUp() {
+        clock = new ManualClock();
+        ClockSource::use(clock);
+        scheduler = new NodeScheduler();
+    }
+
+    void tearDown() {
+        delete scheduler;
+        ClockSource::use(NULL);
+        delete clock;
+    }
+
+    // Waits in real time for the workers to catch up with the clock
+    bool reaches(std::atomic<int>& counter, int value) {
+        auto start = std::chrono::steady_clock::now();
+        while (counter.load() < value) {
+            if (std::chrono::steady_clock::now() - start > std::chrono::milliseconds(SCHEDULER_TEST_TIMEOUT_MS)) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        // Long enough for an extra run to show up
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return counter.load() == value;
+    }
+
+    void test_TasksRunAtTheirRates() {
+        std::atomic<int> fast(0), slow(0);
+        scheduler->schedule("Fast", 0.01, [&fast] { fast++; });
+        scheduler->schedule("Slow", 0.05, [&slow] { slow++; });
+        scheduler->start(2);
+
+        TS_ASSERT_EQUALS(scheduler->threadCount(), 3);
+        TS_ASSERT(reaches(fast, 1));
+        TS_ASSERT(reaches(slow, 1));
+
+        for (int i = 1; i <= 10; i++) {
+            clock->advanceMs(10);
+            TS_ASSERT(reaches(fast, 1 + i));
+            TS_ASSERT(reaches(slow, 1 + i / 5));
+        }
+
+        scheduler->stop();
+        for (const LoopStatistics& stats : scheduler->statistics()) {
+            TS_ASSERT_EQUALS(stats.overruns, 0);
+            TS_ASSERT_EQUALS(stats.maxLatenessUs, 0);
+        }
+    }
+
+    void test_OverrunsSkipMissedPeriods() {
+        std::atomic<int> runs(0);
+        ManualClock* stepped = clock;
+
+        // The first run takes 35ms of a 10ms period
+        scheduler->schedule("Overrun", 0.01, [&runs, stepped] {
+            if (runs.load() == 0) {
+                stepped->advanceMs(35);
+            }
+            runs++;
+        });
+        scheduler->start(1);
+
+        // Due again at 30ms, which has gone by already, so it runs straight after
+        TS_ASSERT(reaches(runs, 2));
+        scheduler->stop();
+
+        LoopStatistics stats = scheduler->statistics()[0];
+        TS_ASSERT_EQUALS(stats.loops, 2);
+        TS_ASSERT_EQUALS(stats.overruns, 1);
+        TS_ASSERT_EQUALS(stats.skipped, 2);
+        TS_ASSERT_EQUALS(stats.maxLatenessUs, 5000);
+    }
+
+    void test_CancelledTasksStopRunning() {
+        std::atomic<int> runs(0);
+        TaskID id = scheduler->schedule("Cancelled", 0.01, [&runs] { runs++; });
+        scheduler->start(1);
+        TS_ASSERT(reaches(runs, 1));
+
+        scheduler->cancel(id);
+        TS_ASSERT_EQUALS(scheduler->taskCount(), 0);
+
+        clock->advanceMs(50);
+        TS_ASSERT(reaches(runs, 1));
+
+        // The statistics are kept
+        TS_ASSERT_EQUALS(scheduler->statistics().size(), 1);
+    }
+
+    void test_TasksCanCancelThemselves() {
+        std::atomic<int> runs(0);
+        TaskID id = NO_TASK;
+        NodeScheduler* shared = scheduler;
+
+        id = scheduler->schedule("SelfCancelled", 0.01, [&runs, &id, shared] {
+            runs++;
+            shared->cancel(id);
+        });
+        scheduler->start(1);
+
+        TS_ASSERT(reaches(runs, 1));
+        clock->advanceMs(50);
+        TS_ASSERT(reaches(runs, 1));
+    }
+
+    void test_NodesTickOnTheScheduler() {
+        MessageBus msgBus;
+        TickingNode node(msgBus);
+
+        scheduler->start(1);
+        ActiveNode::useScheduler(scheduler);
+        node.start();
+        ActiveNode::useScheduler(NULL);
+
+        TS_ASSERT_EQUALS(scheduler->taskCount(), 1);
+        TS_ASSERT(reaches(node.ticks, 1));
+
+        clock->advanceMs(20);
+        TS_ASSERT(reaches(node.ticks, 2));
+
+        node.stop();
+        TS_ASSERT_EQUALS(scheduler->taskCount(), 0);
+    }
+
+    void test_NodesChangeTheirPeriodFromTheirTick() {
+        MessageBus msgBus;
+        SlowingNode node(msgBus);
+
+        scheduler->start(1);
+        ActiveNode::useScheduler(scheduler);
+        node.start();
+        ActiveNode::useScheduler(NULL);
+
+        TS_ASSERT(reaches(node.ticks, 1));
+        TS_ASSERT_EQUALS(scheduler->statistics().size(), 1);
+        TS_ASSERT_EQUALS(scheduler->statistics()[0].periodS, 0.05);
+
+        // Stopping waits for a tick changing the period without deadlocking
+        clock->advanceMs(100);
+        node.stop();
+        TS_ASSERT_EQUALS(scheduler->taskCount(), 0);
+    }
+};
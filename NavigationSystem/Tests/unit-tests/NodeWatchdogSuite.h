@@ -0,0 +1,200 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		NodeWatchdogSuite.h
+ *
+ * Purpose:
+ *		Tests the detection of stalled nodes, the NodeStalled messages and the loop
+ *		timings kept by the watchdog, on a manually stepped clock.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../MessageBus/MessageBus.hpp"
+#include "../MessageBus/NodeScheduler.hpp"
+#include "../MessageBus/NodeWatchdog.hpp"
+#include "../Messages/NodeStalledMsg.hpp"
+#include "../SystemServices/ClockSource.hpp"
+#include "../SystemServices/Logger.hpp"
+#include "../cxxtest/cxxtest/TestSuite.h"
+#include "MessageBusTestHelper.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define WATCHDOG_TEST_TIMEOUT_MS 2000
+
+class StallListenerNode : public Node {
+   public:
+    StallListenerNode(MessageBus& msgBus) : Node(NodeID::MessageLogger, msgBus), m_Count(0) {
+        msgBus.registerNode(*this, MessageType::NodeStalled);
+    }
+
+    bool init() { return true; }
+
+    void processMessage(const Message* message) {
+        const NodeStalledMsg* stalledMsg = static_cast<const NodeStalledMsg*>(message);
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Received.push_back(*stalledMsg);
+        m_Count++;
+    }
+
+    bool waitFor(int count) {
+        auto start = std::chrono::steady_clock::now();
+        while (m_Count.load() < count) {
+            if (std::chrono::steady_clock::now() - start >
+                std::chrono::milliseconds(WATCHDOG_TEST_TIMEOUT_MS)) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    std::atomic<int> m_Count;
+    std::mutex m_Mutex;
+    std::vector<NodeStalledMsg> m_Received;
+};
+
+class WatchedNode : public ActiveNode {
+   public:
+    WatchedNode(MessageBus& msgBus) : ActiveNode(NodeID::StateEstimation, msgBus), ticks(0) {}
+
+    bool init() { return true; }
+    void start() { runPeriodic(tick, 0.5); }
+    void stop() { stopPeriodic(); }
+    void processMessage(const Message* msg) {}
+
+    std::atomic<int> ticks;
+
+   private:
+    static void tick(ActiveNode* nodePtr) { static_cast<WatchedNode*>(nodePtr)->ticks++; }
+};
+
+class NodeWatchdogSuite : public CxxTest::TestSuite {
+   public:
+    ManualClock* clock;
+
+    void setUp() {
+        Logger::DisableLogging();
+        clock = new ManualClock();
+        ClockSource::use(clock);
+        NodeWatchdog::reset();
+    }
+
+    void tearDown() {
+        NodeWatchdog::reset();
+        ClockSource::use(NULL);
+        delete clock;
+    }
+
+    LivenessStatistics statisticsOf(NodeID id) {
+        for (const LivenessStatistics& stats : NodeWatchdog::statistics()) {
+            if (stats.name == nodeToString(id)) {
+                return stats;
+            }
+        }
+        return LivenessStatistics();
+    }
+
+    void test_SilentNodeIsReportedOnce() {
+        MessageBus msgBus;
+        NodeWatchdog watchdog(msgBus);
+
+        NodeWatchdog::watch(NodeID::Compass, 1.0);
+        clock->advanceMs(500);
+        TS_ASSERT_EQUALS(watchdog.checkProgress(), 0);
+
+        clock->advanceMs(600);
+        TS_ASSERT_EQUALS(watchdog.checkProgress(), 1);
+        clock->advanceMs(1000);
+        TS_ASSERT_EQUALS(watchdog.checkProgress(), 0);
+
+        LivenessStatistics stats = statisticsOf(NodeID::Compass);
+        TS_ASSERT(stats.stalled);
+        TS_ASSERT_EQUALS(stats.stalls, 1);
+    }
+
+    void test_StallAndRecoveryArePublished() {
+        MessageBus msgBus;
+        StallListenerNode listener(msgBus);
+        NodeWatchdog watchdog(msgBus);
+        MessageBusTestHelper helper(msgBus);
+
+        NodeWatchdog::watch(NodeID::GPS, 1.0);
+        clock->advanceMs(1200);
+        TS_ASSERT_EQUALS(watchdog.checkProgress(), 1);
+
+        clock->advanceMs(300);
+        NodeWatchdog::reportProgress(NodeID::GPS);
+        TS_ASSERT_EQUALS(watchdog.checkProgress(), 0);
+
+        TS_ASSERT(listener.waitFor(2));
+        std::lock_guard<std::mutex> lock(listener.m_Mutex);
+        TS_ASSERT_EQUALS(listener.m_Received[0].stalledNode(), NodeID::GPS);
+        TS_ASSERT_EQUALS(listener.m_Received[0].silentMs(), 1200);
+        TS_ASSERT_EQUALS(listener.m_Received[0].deadlineMs(), 1000);
+        TS_ASSERT(not listener.m_Received[0].recovered());
+        TS_ASSERT(listener.m_Received[1].recovered());
+        TS_ASSERT_EQUALS(listener.m_Received[1].silentMs(), 1500);
+        TS_ASSERT_EQUALS(statisticsOf(NodeID::GPS).longestStallUs, 1500000);
+    }
+
+    void test_GracePeriodDelaysTheFirstDeadline() {
+        MessageBus msgBus;
+        NodeWatchdog watchdog(msgBus);
+
+        NodeWatchdog::watch(NodeID::WindSensor, 1.0, 2.0);
+        clock->advanceMs(2500);
+        TS_ASSERT_EQUALS(watchdog.checkProgress(), 0);
+        clock->advanceMs(600);
+        TS_ASSERT_EQUALS(watchdog.checkProgress(), 1);
+    }
+
+    void test_LoopTimingsAreKept() {
+        NodeWatchdog::watch(NodeID::Arduino, 1.0);
+
+        for (int i = 0; i < 4; i++) {
+            clock->advanceMs(i == 3 ? 400 : 100);
+            NodeWatchdog::reportProgress(NodeID::Arduino);
+        }
+
+        LivenessStatistics stats = statisticsOf(NodeID::Arduino);
+        TS_ASSERT_EQUALS(stats.reports, 4);
+        TS_ASSERT_EQUALS(stats.maxIntervalUs, 400000);
+        TS_ASSERT_EQUALS(stats.meanIntervalUs(), 200000);
+        TS_ASSERT_EQUALS(stats.stalls, 0);
+    }
+
+    void test_PeriodicNodesAreWatchedUntilStopped() {
+        MessageBus msgBus;
+        NodeWatchdog watchdog(msgBus);
+        NodeScheduler scheduler;
+        WatchedNode node(msgBus);
+
+        scheduler.start(1);
+        ActiveNode::useScheduler(&scheduler);
+        node.start();
+        ActiveNode::useScheduler(NULL);
+
+        auto start = std::chrono::steady_clock::now();
+        while (statisticsOf(NodeID::StateEstimation).reports < 1 &&
+               std::chrono::steady_clock::now() - start < std::chrono::milliseconds(WATCHDOG_TEST_TIMEOUT_MS)) {
+            std::this_thread::yield();
+        }
+
+        // Given a few periods to report in
+        LivenessStatistics stats = statisticsOf(NodeID::StateEstimation);
+        TS_ASSERT_EQUALS(stats.reports, 1);
+        TS_ASSERT_EQUALS(stats.deadlineS, WATCHDOG_MISSED_PERIODS * 0.5);
+
+        node.stop();
+        clock->advanceMs(10000);
+        TS_ASSERT_EQUALS(watchdog.checkProgress(), 0);
+        scheduler.stop();
+    }
+};
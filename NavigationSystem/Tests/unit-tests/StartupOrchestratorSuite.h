@@ -0,0 +1,201 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		StartupOrchestratorSuite.h
+ *
+ * Purpose:
+ *		Tests the concurrent initialisation of the nodes, the order their dependencies
+ *		impose and the handling of the nodes which fail to initialise.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../MessageBus/MessageBus.hpp"
+#include "../MessageBus/NodeWatchdog.hpp"
+#include "../MessageBus/StartupOrchestrator.hpp"
+#include "../SystemServices/ClockSource.hpp"
+#include "../SystemServices/Logger.hpp"
+#include "../cxxtest/cxxtest/TestSuite.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#define STARTUP_INIT_TIME_MS 50
+
+class StartupTestNode : public ActiveNode {
+   public:
+    StartupTestNode(MessageBus& msgBus, std::vector<StartupTestNode*>& order, std::mutex& orderMutex,
+                    bool succeeds = true)
+        : ActiveNode(NodeID::MessageVerifier, msgBus), initialised(false), m_Order(order),
+          m_OrderMutex(orderMutex), m_Succeeds(succeeds) {}
+
+    bool init() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(STARTUP_INIT_TIME_MS));
+        initialised = true;
+        std::lock_guard<std::mutex> lock(m_OrderMutex);
+        m_Order.push_back(this);
+        return m_Succeeds;
+    }
+
+    void start() {}
+    void stop() {}
+    void processMessage(const Message* msg) {}
+
+    std::atomic<bool> initialised;
+
+   private:
+    std::vector<StartupTestNode*>& m_Order;
+    std::mutex& m_OrderMutex;
+    bool m_Succeeds;
+};
+
+// Blocks in its init until released, as the simulation node waiting for its client
+class BlockingNode : public ActiveNode {
+   public:
+    BlockingNode(MessageBus& msgBus) : ActiveNode(NodeID::Simulator, msgBus), entered(false), released(false) {}
+
+    bool init() {
+        entered = true;
+        while (not released.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    void start() {}
+    void stop() {}
+    void processMessage(const Message* msg) {}
+
+    std::atomic<bool> entered;
+    std::atomic<bool> released;
+};
+
+class StartupOrchestratorSuite : public CxxTest::TestSuite {
+   public:
+    MessageBus* msgBus;
+    std::vector<StartupTestNode*> order;
+    std::mutex orderMutex;
+
+    void setUp() {
+        Logger::DisableLogging();
+        msgBus = new MessageBus();
+        order.clear();
+    }
+
+    void tearDown() { delete msgBus; }
+
+    int positionOf(StartupTestNode* node) {
+        for (size_t i = 0; i < order.size(); i++) {
+            if (order[i] == node) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    void test_IndependentNodesInitialiseTogether() {
+        StartupTestNode a(*msgBus, order, orderMutex), b(*msgBus, order, orderMutex),
+            c(*msgBus, order, orderMutex), d(*msgBus, order, orderMutex);
+        StartupOrchestrator startup;
+        startup.add(a, "A", NodeImportance::CRITICAL);
+        startup.add(b, "B", NodeImportance::CRITICAL);
+        startup.add(c, "C", NodeImportance::CRITICAL);
+        startup.add(d, "D", NodeImportance::CRITICAL);
+
+        TS_ASSERT(startup.initialise(4));
+        TS_ASSERT_EQUALS(order.size(), 4);
+        TS_ASSERT_LESS_THAN(startup.totalUs(), 3 * STARTUP_INIT_TIME_MS * 1000);
+        TS_ASSERT_LESS_THAN_EQUALS(4 * STARTUP_INIT_TIME_MS * 1000, startup.sequentialUs());
+        TS_ASSERT_EQUALS(startup.activeNodes().size(), 4);
+    }
+
+    void test_DependenciesInitialiseFirst() {
+        StartupTestNode a(*msgBus, order, orderMutex), b(*msgBus, order, orderMutex),
+            c(*msgBus, order, orderMutex);
+        StartupOrchestrator startup;
+        startup.add(a, "A", NodeImportance::CRITICAL);
+        startup.add(b, "B", NodeImportance::CRITICAL, {&a});
+        startup.add(c, "C", NodeImportance::CRITICAL, {&a, &b});
+
+        TS_ASSERT(startup.initialise(4));
+        TS_ASSERT_LESS_THAN(positionOf(&a), positionOf(&b));
+        TS_ASSERT_LESS_THAN(positionOf(&b), positionOf(&c));
+
+        std::vector<NodeStartup> timings = startup.timings();
+        TS_ASSERT_EQUALS(timings[2].name, "C");
+        TS_ASSERT_LESS_THAN_EQUALS(timings[1].startUs + timings[1].durationUs, timings[2].startUs);
+    }
+
+    void test_FailedDependencySkipsItsDependents() {
+        StartupTestNode a(*msgBus, order, orderMutex, false), b(*msgBus, order, orderMutex),
+            c(*msgBus, order, orderMutex), d(*msgBus, order, orderMutex);
+        StartupOrchestrator startup;
+        startup.add(a, "A", NodeImportance::NOT_CRITICAL);
+        startup.add(b, "B", NodeImportance::NOT_CRITICAL, {&a});
+        startup.add(c, "C", NodeImportance::NOT_CRITICAL, {&b});
+        startup.add(d, "D", NodeImportance::NOT_CRITICAL);
+
+        // Nothing critical failed
+        TS_ASSERT(startup.initialise(2));
+        TS_ASSERT(not b.initialised);
+        TS_ASSERT(not c.initialised);
+        TS_ASSERT(d.initialised);
+
+        std::vector<NodeStartup> timings = startup.timings();
+        TS_ASSERT(not timings[0].skipped);
+        TS_ASSERT(timings[1].skipped);
+        TS_ASSERT(timings[2].skipped);
+
+        std::vector<ActiveNode*> active = startup.activeNodes();
+        TS_ASSERT_EQUALS(active.size(), 1);
+        TS_ASSERT_EQUALS(active[0], &d);
+    }
+
+    void test_CriticalFailureIsReported() {
+        StartupTestNode a(*msgBus, order, orderMutex), b(*msgBus, order, orderMutex, false);
+        StartupOrchestrator startup;
+        startup.add(a, "A", NodeImportance::NOT_CRITICAL);
+        startup.add(b, "B", NodeImportance::CRITICAL);
+
+        TS_ASSERT(not startup.initialise(1));
+        TS_ASSERT(a.initialised);
+    }
+
+    void test_UnknownDependencyThrows() {
+        StartupTestNode a(*msgBus, order, orderMutex), b(*msgBus, order, orderMutex);
+        StartupOrchestrator startup;
+        TS_ASSERT_THROWS_ANYTHING(startup.add(b, "B", NodeImportance::CRITICAL, {&a}));
+    }
+
+    void test_BlockedInitIsReportedByTheWatchdog() {
+        ManualClock clock;
+        ClockSource::use(&clock);
+        NodeWatchdog::reset();
+        NodeWatchdog watchdog(*msgBus);
+
+        BlockingNode node(*msgBus);
+        StartupOrchestrator startup;
+        startup.add(node, "Blocking", NodeImportance::CRITICAL);
+        std::thread initialiser([&startup] { startup.initialise(1); });
+        while (not node.entered.load()) {
+            std::this_thread::yield();
+        }
+
+        clock.advanceMs(STARTUP_INIT_DEADLINE * 1000 + 100);
+        TS_ASSERT_EQUALS(watchdog.checkProgress(), 1);
+
+        // No longer watched once initialised
+        node.released = true;
+        initialiser.join();
+        clock.advanceMs(STARTUP_INIT_DEADLINE * 1000 + 100);
+        TS_ASSERT_EQUALS(watchdog.checkProgress(), 0);
+
+        NodeWatchdog::reset();
+        ClockSource::use(NULL);
+    }
+};
@@ -0,0 +1,145 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		StructuredLogSuite.h
+ *
+ * Purpose:
+ *		Tests the encoding of log calls into binary structured records and rendering them
+ *		back into text.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../SystemServices/StructuredLog.hpp"
+#include "../cxxtest/cxxtest/TestSuite.h"
+
+#include <cstdarg>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+
+// 2017-06-01 12:30:15.250 UTC
+#define STRUCTURED_TEST_TIME 1496320215250ULL
+#define STRUCTURED_TEST_STAMP "[2017-06-01 12:30:15:250] "
+
+static size_t encodeRecord(char* buffer, size_t size, bool withFormat, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    size_t length = StructuredLog::encode(buffer, size, LogLevel::Info, STRUCTURED_TEST_TIME,
+                                          format, args, withFormat);
+    va_end(args);
+    return length;
+}
+
+class StructuredLogSuite : public CxxTest::TestSuite {
+   public:
+    std::string renderRecord(const char* format, ...) {
+        char buffer[LOG_RECORD_SIZE];
+        va_list args;
+        va_start(args, format);
+        size_t length = StructuredLog::encode(buffer, sizeof(buffer), LogLevel::Info,
+                                              STRUCTURED_TEST_TIME, format, args, true);
+        va_end(args);
+
+        std::map<uint32_t, std::string> formats;
+        std::string text;
+        TS_ASSERT(length > 0);
+        TS_ASSERT(StructuredLog::render(buffer, length, formats, text));
+        return text;
+    }
+
+    void test_RecordsRenderLikePrintf() {
+        std::string prefix = STRUCTURED_TEST_STAMP "<info>\t ";
+
+        TS_ASSERT_EQUALS(renderRecord("plain text"), prefix + "plain text\n");
+        TS_ASSERT_EQUALS(renderRecord("%d %i %u", -12, 7, 4000000000u), prefix + "-12 7 4000000000\n");
+        TS_ASSERT_EQUALS(renderRecord("%lu %lld %zu", 123456789012UL, -5LL, (size_t)42),
+                         prefix + "123456789012 -5 42\n");
+        TS_ASSERT_EQUALS(renderRecord("%.2f %e %g", 3.14159, 1500.0, 0.5f),
+                         prefix + "3.14 1.500000e+03 0.5\n");
+        TS_ASSERT_EQUALS(renderRecord("%s/%-4s|%5s", "abc", "de", "f"), prefix + "abc/de  |    f\n");
+        TS_ASSERT_EQUALS(renderRecord("%x %X %o %c", 255, 255, 8, 'q'), prefix + "ff FF 10 q\n");
+        TS_ASSERT_EQUALS(renderRecord("100%% %*d|%.*f", 5, 42, 1, 2.25), prefix + "100%    42|2.2\n");
+    }
+
+    void test_LongStringsAreLeftToTheTextPath() {
+        std::string argument(STRUCTURED_LOG_MAX_STRING, 'x');
+        TS_ASSERT_EQUALS(renderRecord("%s", argument.c_str()),
+                         STRUCTURED_TEST_STAMP "<info>\t " + argument + "\n");
+
+        char buffer[LOG_RECORD_SIZE];
+        argument += 'x';
+        TS_ASSERT_EQUALS(encodeRecord(buffer, sizeof(buffer), true, "%s", argument.c_str()), 0);
+    }
+
+    void test_UnsupportedCallsAreLeftToTheTextPath() {
+        char buffer[LOG_RECORD_SIZE];
+        int written = 0;
+
+        TS_ASSERT_EQUALS(encodeRecord(buffer, sizeof(buffer), true, "%d%n", 1, &written), 0);
+        TS_ASSERT_EQUALS(encodeRecord(buffer, 16, true, "too long for the buffer %d", 1), 0);
+        TS_ASSERT_EQUALS(encodeRecord(buffer, sizeof(buffer), true,
+                                      "%d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d",
+                                      1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17), 0);
+    }
+
+    void test_FormatsAreSentOnce() {
+        char first[LOG_RECORD_SIZE];
+        char second[LOG_RECORD_SIZE];
+        const char* format = "heading %d";
+
+        size_t firstLength = encodeRecord(first, sizeof(first), true, format, 90);
+        size_t secondLength = encodeRecord(second, sizeof(second), false, format, 180);
+        TS_ASSERT(secondLength < firstLength);
+
+        // A record without its format can't be rendered until the dictionary entry is seen
+        std::map<uint32_t, std::string> formats;
+        std::string text;
+        TS_ASSERT(StructuredLog::render(second, secondLength, formats, text));
+        TS_ASSERT(text.find("unknown format") != std::string::npos);
+
+        text.clear();
+        TS_ASSERT(StructuredLog::render(first, firstLength, formats, text));
+        TS_ASSERT(StructuredLog::render(second, secondLength, formats, text));
+        TS_ASSERT_EQUALS(text, STRUCTURED_TEST_STAMP "<info>\t heading 90\n" STRUCTURED_TEST_STAMP
+                                                     "<info>\t heading 180\n");
+    }
+
+    void test_EveryFileHoldsTheFormatsOfItsRecords() {
+        char first[LOG_RECORD_SIZE];
+        char second[LOG_RECORD_SIZE];
+        size_t firstLength = encodeRecord(first, sizeof(first), true, "rotated %d", 1);
+        size_t secondLength = encodeRecord(second, sizeof(second), false, "rotated %d", 2);
+        std::map<uint32_t, std::string> formats;
+        std::set<uint32_t> fileFormats;
+
+        // The format goes into the first file once
+        std::ostringstream firstFile;
+        StructuredLog::writeRecord(firstFile, first, firstLength, formats, fileFormats);
+        StructuredLog::writeRecord(firstFile, second, secondLength, formats, fileFormats);
+        TS_ASSERT_EQUALS(firstFile.str().size(), firstLength + secondLength);
+
+        // The thread which logged has already announced the format, the writer still puts
+        // it into the file the record lands in after a rotation
+        std::ostringstream secondFile;
+        fileFormats.clear();
+        StructuredLog::writeRecord(secondFile, second, secondLength, formats, fileFormats);
+
+        std::map<uint32_t, std::string> decoderFormats;
+        std::string text;
+        TS_ASSERT(StructuredLog::render(secondFile.str().data(), secondFile.str().size(), decoderFormats, text));
+        TS_ASSERT_EQUALS(text, STRUCTURED_TEST_STAMP "<info>\t rotated 2\n");
+    }
+
+    void test_MalformedBuffersAreRejected() {
+        char buffer[LOG_RECORD_SIZE];
+        size_t length = encodeRecord(buffer, sizeof(buffer), true, "value %d", 3);
+        std::map<uint32_t, std::string> formats;
+        std::string text;
+
+        TS_ASSERT(not StructuredLog::render(buffer, length - 1, formats, text));
+        TS_ASSERT(not StructuredLog::render("X", 1, formats, text));
+    }
+};
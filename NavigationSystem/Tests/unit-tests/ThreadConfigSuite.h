@@ -0,0 +1,198 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		ThreadConfigSuite.h
+ *
+ * Purpose:
+ *		Tests the reading of the thread settings and their application to the thread
+ *		of an active node.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../MessageBus/ActiveNode.hpp"
+#include "../MessageBus/MessageBus.hpp"
+#include "../Messages/WindDataMsg.hpp"
+#include "../SystemServices/Logger.hpp"
+#include "../SystemServices/ThreadConfig.hpp"
+#include "../cxxtest/cxxtest/TestSuite.h"
+#include "MessageBusTestHelper.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#define THREAD_NAME_BUFFER 16
+#define THREAD_WAIT_TIME_MS 2000
+
+class PinnedNode : public ActiveNode {
+   public:
+    PinnedNode(MessageBus& msgBus) : ActiveNode(NodeID::CourseRegulatorNode, msgBus), cpuCount(0) {}
+
+    bool init() { return true; }
+    void start() { runThread(record); }
+    void stop() { stopThread(this); }
+    void processMessage(const Message* msg) {}
+
+    std::string name;
+    int cpuCount;
+
+   private:
+    static void record(ActiveNode* nodePtr) {
+        PinnedNode* node = static_cast<PinnedNode*>(nodePtr);
+        char name[THREAD_NAME_BUFFER] = {};
+        pthread_getname_np(pthread_self(), name, sizeof(name));
+        node->name = name;
+
+        cpu_set_t cpus;
+        pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        node->cpuCount = CPU_COUNT(&cpus);
+    }
+};
+
+// Records the thread it is delivered a message on
+class DeliveredNode : public Node {
+   public:
+    DeliveredNode(MessageBus& msgBus) : Node(NodeID::MessageLogger, msgBus), cpuCount(0), delivered(false) {
+        msgBus.registerNode(*this, MessageType::WindData);
+    }
+
+    bool init() { return true; }
+
+    void processMessage(const Message* msg) {
+        char threadName[THREAD_NAME_BUFFER] = {};
+        pthread_getname_np(pthread_self(), threadName, sizeof(threadName));
+        name = threadName;
+
+        cpu_set_t cpus;
+        pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        cpuCount = CPU_COUNT(&cpus);
+        delivered.store(true);
+    }
+
+    std::string name;
+    int cpuCount;
+    std::atomic<bool> delivered;
+};
+
+class ThreadConfigSuite : public CxxTest::TestSuite {
+   public:
+    void setUp() {
+        Logger::DisableLogging();
+        ThreadConfig::clear();
+    }
+
+    void tearDown() { ThreadConfig::clear(); }
+
+    void test_SettingsAreRead() {
+        nlohmann::json config = {
+            {"CourseRegulatorNode", {{"cpus", {3}}, {"policy", "fifo"}, {"priority", 50}}},
+            {"DBLoggerNode", {{"cpus", {0, 1, 2}}, {"nice", 10}, {"name", "dblogger"}}}};
+        TS_ASSERT(ThreadConfig::loadJson(config));
+
+        ThreadSettings settings;
+        TS_ASSERT(ThreadConfig::get("CourseRegulatorNode", settings));
+        TS_ASSERT(settings.policy == ThreadPolicy::Fifo);
+        TS_ASSERT_EQUALS(settings.priority, 50);
+        TS_ASSERT_EQUALS(settings.cpus.size(), 1);
+
+        TS_ASSERT(ThreadConfig::get("DBLoggerNode", settings));
+        TS_ASSERT(settings.policy == ThreadPolicy::Default);
+        TS_ASSERT_EQUALS(settings.nice, 10);
+        TS_ASSERT_EQUALS(settings.name, "dblogger");
+
+        TS_ASSERT(not ThreadConfig::get("HTTPSync", settings));
+    }
+
+    void test_InvalidEntriesAreSkipped() {
+        nlohmann::json config = {{"MessageBus", {{"policy", "round-robin"}}},
+                                 {"HTTPSync", {{"nice", 40}}},
+                                 {"CANService", {{"cpus", {-1}}}},
+                                 {"WingSailControlNode", {{"cpus", {0}}}}};
+        TS_ASSERT(not ThreadConfig::loadJson(config));
+
+        ThreadSettings settings;
+        TS_ASSERT(not ThreadConfig::get("MessageBus", settings));
+        TS_ASSERT(not ThreadConfig::get("HTTPSync", settings));
+        TS_ASSERT(not ThreadConfig::get("CANService", settings));
+        TS_ASSERT(ThreadConfig::get("WingSailControlNode", settings));
+    }
+
+    void test_MissingFileIsReported() { TS_ASSERT(not ThreadConfig::load("/nonexistent/threads.json")); }
+
+    void test_NodeThreadIsNamedAndPinned() {
+        cpu_set_t allowed;
+        sched_getaffinity(0, sizeof(allowed), &allowed);
+        int cpu = 0;
+        while (not CPU_ISSET(cpu, &allowed)) {
+            cpu++;
+        }
+
+        ThreadSettings settings;
+        settings.cpus.push_back(cpu);
+        ThreadConfig::set("CourseRegulatorNode", settings);
+
+        MessageBus msgBus;
+        PinnedNode node(msgBus);
+        node.start();
+        node.stop();
+
+        TS_ASSERT_EQUALS(node.name, "CourseRegulator");
+        TS_ASSERT_EQUALS(node.cpuCount, 1);
+    }
+
+    void test_NiceValueIsPerThread() {
+        ThreadSettings settings;
+        settings.nice = 5;
+        int applied = -1, threadNice = 0;
+        int mainNice = getpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid));
+
+        std::thread thread([&] {
+            int before = getpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid));
+            applied = ThreadConfig::apply("Lowered", settings);
+            threadNice = getpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid)) - before;
+        });
+        thread.join();
+
+        TS_ASSERT_EQUALS(applied, 1);
+        TS_ASSERT_EQUALS(threadNice, 5);
+        TS_ASSERT_EQUALS(getpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid)), mainNice);
+    }
+
+    void test_DeliveryWorkersHaveSettingsOfTheirOwn() {
+        cpu_set_t allowed;
+        sched_getaffinity(0, sizeof(allowed), &allowed);
+        int cpu = 0;
+        while (not CPU_ISSET(cpu, &allowed)) {
+            cpu++;
+        }
+
+        ThreadSettings settings;
+        settings.cpus.push_back(cpu);
+        ThreadConfig::set("MessageBus", settings);
+
+        MessageBus msgBus;
+        msgBus.enableParallelDelivery(1);
+        DeliveredNode node(msgBus);
+        MessageBusTestHelper helper(msgBus);
+        msgBus.sendMessage(std::make_unique<WindDataMsg>(0, 0, 0));
+
+        auto start = std::chrono::steady_clock::now();
+        while (not node.delivered.load() &&
+               std::chrono::steady_clock::now() - start < std::chrono::milliseconds(THREAD_WAIT_TIME_MS)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        // Not pinned along with the dispatch loop
+        TS_ASSERT(node.delivered.load());
+        TS_ASSERT_EQUALS(node.name, "DeliveryPool");
+        TS_ASSERT_EQUALS(node.cpuCount, CPU_COUNT(&allowed));
+    }
+};
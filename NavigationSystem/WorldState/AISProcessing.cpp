@@ -7,6 +7,7 @@
  */
 
 #include "AISProcessing.hpp"
+#include "../SystemServices/ClockSource.hpp"
 
 AISProcessing::AISProcessing(MessageBus& msgBus, DBHandler& dbhandler, CollidableMgr* collidableMgr)
 : ActiveNode(NodeID::AISProcessing, msgBus), m_LoopTime(0.5), m_Radius(300e6), m_MMSI(230082790),
@@ -20,9 +21,10 @@ AISProcessing::~AISProcessing() {
 }
 
 void AISProcessing::updateConfigsFromDB(){
-    m_LoopTime = m_db.retrieveCellAsDouble("config_ais_processing","1","loop_time");
-    m_Radius = m_db.retrieveCellAsInt("config_ais_processing","1","radius");
-    m_MMSI = m_db.retrieveCellAsInt("config_ais_processing","1","mmsi_aspire");
+    std::shared_ptr<const ConfigSnapshot> configs = m_db.configs();
+    m_LoopTime = configs->getDouble("config_ais_processing", "loop_time");
+    m_Radius = configs->getInt("config_ais_processing", "radius");
+    m_MMSI = configs->getInt("config_ais_processing", "mmsi_aspire");
 }
 
 bool AISProcessing::init() {
@@ -102,16 +104,17 @@ void AISProcessing::AISProcessingThreadFunc(ActiveNode* nodePtr)
 {
     Logger::info("AISProcessing thread has started");
     AISProcessing* node = dynamic_cast<AISProcessing*> (nodePtr);
-    std::this_thread::sleep_for(std::chrono::milliseconds(INITIAL_SLEEP));
+    ClockSource::current().sleepForMs(INITIAL_SLEEP);
 
-    Timer timer;
+    FixedRateTimer timer("AISProcessing");
     timer.start();
+    node->watchLoop(node->m_LoopTime);
     
     while(node->m_running) {
         node->m_lock.lock();
         node->addAISDataToCollidableMgr();
         node->m_lock.unlock();
-        timer.sleepUntil(node->m_LoopTime);
-        timer.reset();
+        node->reportProgress();
+        timer.sleepUntilNext(node->m_LoopTime);
     }
 }
@@ -12,6 +12,7 @@
  */
 
 #include "../SystemServices/SysClock.hpp"
+#include "../SystemServices/ClockSource.hpp"
 #include "../SystemServices/Timer.hpp"
 #include "../Database/DBHandler.hpp"
 #include "../SystemServices/Logger.hpp"
@@ -129,10 +130,11 @@ void CameraProcessingUtility::CameraProcessingUtilityThreadFunc(ActiveNode* node
 {
     Logger::info("CameraProcessingUtility thread has started");
     CameraProcessingUtility* node = dynamic_cast<CameraProcessingUtility*> (nodePtr);
-    std::this_thread::sleep_for(std::chrono::milliseconds(INITIAL_SLEEP));
+    ClockSource::current().sleepForMs(INITIAL_SLEEP);
     
-    Timer timer;
+    FixedRateTimer timer("CameraProcessing");
     timer.start();
+    node->watchLoop(0.25);
     
     std::chrono::duration<double> elapsed_seconds;
     
@@ -158,8 +160,8 @@ void CameraProcessingUtility::CameraProcessingUtilityThreadFunc(ActiveNode* node
         node->computeRelDistances();
         node->addCameraDataToCollidableMgr();
         
-        timer.sleepUntil(0.25); // pause when thread is restarted
-        timer.reset();
+        node->reportProgress();
+        timer.sleepUntilNext(0.25); // pause when thread is restarted
     }
 }
 
@@ -21,6 +21,7 @@
  ***************************************************************************************/
 
 #include "CollidableMgr.h"
+#include "../../SystemServices/ClockSource.hpp"
 #include "../../SystemServices/SysClock.hpp"
 #include "../../SystemServices/Logger.hpp"
 #include "../../Math/Utility.hpp"
@@ -233,7 +234,7 @@ void CollidableMgr::ContactGC(CollidableMgr* ptr)
 {
     while(ptr->m_Running.load() == true)
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        ClockSource::current().sleepForMs(1000);
         ptr->removeOldAISContacts();
         ptr->removeOldVisualField();
     }
@@ -14,6 +14,7 @@
  ***************************************************************************************/
 
 #include "PowerTrackNode.hpp"
+#include "../SystemServices/ClockSource.hpp"
 #include "../Messages/PowerTrackMsg.hpp"
 #include "../Math/CourseMath.hpp"
 #include "../SystemServices/Logger.hpp"
@@ -98,20 +99,20 @@ void PowerTrackNode::PowerTrackThreadFunc(ActiveNode* nodePtr)
     PowerTrackNode* node = dynamic_cast<PowerTrackNode*> (nodePtr);
     
     // Initial sleep time in order for enough data to be transmitted on the first message
-    std::this_thread::sleep_for(std::chrono::milliseconds(INITIAL_SLEEP));
+    ClockSource::current().sleepForMs(INITIAL_SLEEP);
     
-    Timer timer;
+    FixedRateTimer timer("PowerTrack");
     timer.start();
+    node->watchLoop(node->m_Looptime);
     while(true)
     {
         //Regulate the rate at whcih the messages are sent
-        timer.sleepUntil(node->m_Looptime);
+        node->reportProgress();
+        timer.sleepUntilNext(node->m_Looptime);
         
         // For testing only (to be removed soon/or shift to debug mode)
         Logger::info("PowerTrackInfo: %f,%f,%f,%f,%d", (float)node->m_CurrentSensorDataCurrent,
                       (float)node->m_CurrentSensorDataVoltage, (float)node->m_PowerBalance, (float)node->m_Power,
                       (uint8_t)node->m_CurrentSensorDataElement);
-        
-        timer.reset();
     }
 }
@@ -14,7 +14,7 @@
 
 ///----------------------------------------------------------------------------------
 StateEstimationNode::StateEstimationNode(MessageBus& msgBus, DBHandler& dbhandler):
-ActiveNode(NodeID::StateEstimation, msgBus), m_dbHandler(dbhandler), m_Running(false),
+ActiveNode(NodeID::StateEstimation, msgBus), m_dbHandler(dbhandler),
 m_LoopTime(0.5), m_CompassHeading(DATA_OUT_OF_RANGE), m_GpsOnline(false),
 m_GPSLat(DATA_OUT_OF_RANGE), m_GPSLon(DATA_OUT_OF_RANGE), m_GPSSpeed(DATA_OUT_OF_RANGE), m_GPSCourse(DATA_OUT_OF_RANGE),
 m_WaypointDeclination(DATA_OUT_OF_RANGE), m_speed_1(0), m_speed_2(1), m_VesselHeading(DATA_OUT_OF_RANGE),
@@ -40,23 +40,23 @@ bool StateEstimationNode::init()
 ///----------------------------------------------------------------------------------
 void StateEstimationNode::start()
 {
-    m_Running.store(true);
-    runThread(StateEstimationNodeThreadFunc);
+    runPeriodic(StateEstimationNodeTick, m_LoopTime, INITIAL_SLEEP / 1000.0);
 }
 
 ///----------------------------------------------------------------------------------
 void StateEstimationNode::stop()
 {
-    m_Running.store(false);
-    stopThread(this);
+    stopPeriodic();
 }
 
 ///----------------------------------------------------------------------------------
 void StateEstimationNode::updateConfigsFromDB()
 {
-    m_LoopTime = m_dbHandler.retrieveCellAsDouble("config_vessel_state","1","loop_time");
-    m_speed_1 = m_dbHandler.retrieveCellAsDouble("config_vessel_state","1","course_config_speed_1");
-    m_speed_2 = m_dbHandler.retrieveCellAsDouble("config_vessel_state","1","course_config_speed_2");
+    std::shared_ptr<const ConfigSnapshot> configs = m_dbHandler.configs();
+    m_LoopTime = configs->getDouble("config_vessel_state", "loop_time");
+    setPeriod(m_LoopTime);
+    m_speed_1 = configs->getDouble("config_vessel_state", "course_config_speed_1");
+    m_speed_2 = configs->getDouble("config_vessel_state", "course_config_speed_2");
 }
 
 ///----------------------------------------------------------------------------------
@@ -87,6 +87,7 @@ void StateEstimationNode::processCompassMessage(const CompassDataMsg* msg)
 {
     std::lock_guard<std::mutex> lock_guard(m_lock);
     m_CompassHeading = msg->heading();
+    m_SensorTrace = msg->trace();
 }
 
 ///----------------------------------------------------------------------------------
@@ -98,6 +99,7 @@ void StateEstimationNode::processGPSMessage(const GPSDataMsg* msg)
     m_GPSLon = msg->longitude();
     m_GPSSpeed = msg->speed();
     m_GPSCourse = msg->course();
+    m_SensorTrace = msg->trace();
 }
 
 ///----------------------------------------------------------------------------------
@@ -158,24 +160,18 @@ float StateEstimationNode::estimateVesselCourse()
 }
 
 ///----------------------------------------------------------------------------------
-void StateEstimationNode::StateEstimationNodeThreadFunc(ActiveNode* nodePtr)
+void StateEstimationNode::StateEstimationNodeTick(ActiveNode* nodePtr)
 {
-    Logger::info("StateEstimationNode thread has started");
     StateEstimationNode* node = dynamic_cast<StateEstimationNode*> (nodePtr);
-    std::this_thread::sleep_for(std::chrono::milliseconds(INITIAL_SLEEP));
 
-    Timer timer;
-    timer.start();
-
-    while(node->m_Running.load() == true)
+    if(node->estimateVesselState())
     {
-        if(node->estimateVesselState())
+        MessagePtr stateMessage = std::make_unique<StateMessage>(node->m_VesselHeading, node->m_VesselLat,
+            node->m_VesselLon, node->m_VesselSpeed, node->m_VesselCourse);
         {
-            MessagePtr stateMessage = std::make_unique<StateMessage>(node->m_VesselHeading, node->m_VesselLat,
-                node->m_VesselLon, node->m_VesselSpeed, node->m_VesselCourse);
-            node->m_MsgBus.sendMessage(std::move(stateMessage));
+            std::lock_guard<std::mutex> lock_guard(node->m_lock);
+            stateMessage->setParent(node->m_SensorTrace);
         }
-        timer.sleepUntil(node->m_LoopTime);
-        timer.reset();
+        node->m_MsgBus.sendMessage(std::move(stateMessage));
     }
 }
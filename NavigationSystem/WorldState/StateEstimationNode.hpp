@@ -76,14 +76,13 @@ class StateEstimationNode : public ActiveNode {
     float estimateVesselCourse();
 
     ///----------------------------------------------------------------------------------
-    /// @brief Starts the StateEstimationNode's thread that pumps out VesselStateMsg corresponding
-    /// at the estimated state of the vessel.
+    /// @brief Pumps out a VesselStateMsg corresponding at the estimated state of the vessel,
+    /// every loop time.
     ///----------------------------------------------------------------------------------
-    static void StateEstimationNodeThreadFunc(ActiveNode* nodePtr);
+    static void StateEstimationNodeTick(ActiveNode* nodePtr);
 
     DBHandler& m_dbHandler;
     std::mutex m_lock;
-    std::atomic<bool> m_Running;
 
     double m_LoopTime;  // second
 
@@ -94,6 +93,7 @@ class StateEstimationNode : public ActiveNode {
     double m_GPSSpeed;            // m/s
     double m_GPSCourse;           // degree [0, 360[ in North-East reference frame (clockwise)
     float m_WaypointDeclination;  // degree
+    MessageTrace m_SensorTrace;   // Latest compass or GPS reading, the parent of the state messages
 
     double m_speed_1;  // m/s
     double m_speed_2;  // m/s
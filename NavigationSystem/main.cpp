@@ -13,7 +13,12 @@
 #include "Database/DBLoggerNode.hpp"
 #include "HTTPSync/HTTPSyncNode.hpp"
 #include "MessageBus/MessageBus.hpp"
+#include "MessageBus/NodeScheduler.hpp"
+#include "MessageBus/NodeWatchdog.hpp"
+#include "MessageBus/StartupOrchestrator.hpp"
 #include "SystemServices/Logger.hpp"
+#include "SystemServices/ThreadConfig.hpp"
+#include "SystemServices/Timer.hpp"
 #include "WorldState/StateEstimationNode.hpp"
 #include "WorldState/WindStateNode.hpp"
 #include "WorldState/AISProcessing.hpp"
@@ -60,43 +65,11 @@
 #include <map>
 
 
-enum class NodeImportance {
-	CRITICAL,
-	NOT_CRITICAL
-};
-
 MessageBus messageBus;
-std::vector<ActiveNode*> nodeList; // store each node and whether was correctly initialised or not
-
-///----------------------------------------------------------------------------------
-/// @brief Initialises a node and shutsdown the program if a critical node fails.
-///
-/// @param node 			A pointer to the node to initialise
-/// @param nodeName 		A string name of the node, for logging purposes.
-/// @param importance 		Whether the node is a critcal node or not critical. If a
-///							critical node fails to initialise the program will
-///							shutdown.
-///
-///----------------------------------------------------------------------------------
-void initialiseNode(Node& node, const char* nodeName, NodeImportance importance)
-{
-	if(node.init())
-	{
-		Logger::success("Node: %s - init\t[OK]", nodeName);
-        if(node.isActiveNode())
-            nodeList.push_back(&dynamic_cast<ActiveNode&>(node));
-	}
-	else
-	{
-		Logger::warning("Node: %s - init\t\t[FAILED]", nodeName);
-
-		if(importance == NodeImportance::CRITICAL)
-		{
-			Logger::error("Critical node failed to initialise, shutting down");
-			exit(EXIT_FAILURE);
-		}
-	}
-}
+#if SHARED_SCHEDULER == 1
+NodeScheduler nodeScheduler;
+#endif
+std::vector<ActiveNode*> nodeList; // the active nodes which were correctly initialised, stopped at exit
 
 void atexit_handler()
 {
@@ -109,8 +82,15 @@ void atexit_handler()
         (*it)->stop();
         Logger::success("Node: %s - stopped\t[OK]", (*it)->nodeName().c_str());
     }
+    FixedRateTimer::logStatistics();
+    NodeWatchdog::logStatistics();
+#if SHARED_SCHEDULER == 1
+    nodeScheduler.logStatistics();
+    nodeScheduler.stop();
+#endif
     Logger::info("Disabling messageBus");
     messageBus.stop();
+    messageBus.logStatistics();
 }
 
 ///----------------------------------------------------------------------------------
@@ -139,6 +119,11 @@ int main(int argc, char *argv[])
     
     // Install custom signal handlers
     install_sig_traps();
+    // Start the logger before setting the exit terminator, so that it is shut down after it
+#if STRUCTURED_LOGGING == 1
+    Logger::setStructuredLogging(true);
+#endif
+    bool loggerStarted = Logger::init();
     // Set exit terminator
     std::atexit(atexit_handler);
     
@@ -170,7 +155,14 @@ int main(int argc, char *argv[])
 	DBHandler dbHandler(db_path);
 
 	// Logger start
-	Logger::success("Logger init\t\t[OK]");
+	if(loggerStarted)
+	{
+		Logger::success("Logger init\t\t[OK]");
+	}
+	else
+	{
+		Logger::warning("Logger init\t\t[FAILED], logging to the terminal only");
+	}
 
 	// Initialise DBHandler
 	if(dbHandler.initialise())
@@ -183,6 +175,17 @@ int main(int argc, char *argv[])
 		exit(EXIT_FAILURE);
 	}
 
+	// Thread affinity and priorities, kept next to the database
+	std::string threadConfigPath = db_path.substr(0, db_path.find_last_of('/') + 1) + "threads.json";
+	if(ThreadConfig::load(threadConfigPath))
+	{
+		Logger::success("Thread settings init\t\t[OK]");
+	}
+	else
+	{
+		Logger::warning("Thread settings init\t\t[FAILED], %s missing or invalid, default scheduling", threadConfigPath.c_str());
+	}
+
     // Autopilot interface
     AutopilotInterface autopilot;
     autopilot.open();
@@ -195,57 +198,82 @@ int main(int argc, char *argv[])
     //-------------------------------------------------------------------------------
     std::cout<<rang::style::bold<<rang::fg::blue<<std::endl<<std::endl<<"2. Initialising active nodes........."<<std::endl<<std::endl<<rang::style::reset;
    
-    // Hardware interfaces
+    // Started first, the startup orchestrator has it watch the nodes blocking in their init
+    NodeWatchdog watchdog(messageBus);
+    watchdog.start();
+
+    // The nodes are initialised together once the nodes they depend on are
+    StartupOrchestrator startup;
+
+    // Hardware interfaces, sharing the link to the autopilot
     AutopilotReadNode autopilotRead(messageBus, dbHandler, autopilot);
-    initialiseNode(autopilotRead, "AutopilotReadNode", NodeImportance::CRITICAL);
-    autopilotRead.start();
+    startup.add(autopilotRead, "AutopilotReadNode", NodeImportance::CRITICAL);
     
     AutopilotWriteNode autopilotWrite(messageBus, autopilot);
-    initialiseNode(autopilotWrite, "AutopilotWriteNode", NodeImportance::CRITICAL);
+    startup.add(autopilotWrite, "AutopilotWriteNode", NodeImportance::CRITICAL, { &autopilotRead });
     
     // Passive nodes
     WindStateNode windStateNode(messageBus);
-    initialiseNode(windStateNode,"WindStateNode",NodeImportance::CRITICAL);
+    startup.add(windStateNode, "WindStateNode", NodeImportance::CRITICAL);
     
     WaypointMgrNode waypointMgr(messageBus, dbHandler);
-    initialiseNode(waypointMgr, "WaypointMgrNode", NodeImportance::CRITICAL);
+    startup.add(waypointMgr, "WaypointMgrNode", NodeImportance::CRITICAL);
 
     // Active nodes
     int dbLoggerQueueSize = 5; // how many messages to log to the database at a time
     DBLoggerNode dbLoggerNode(messageBus, dbHandler, dbLoggerQueueSize);
-    initialiseNode(dbLoggerNode, "DBLoggerNode", NodeImportance::CRITICAL);
+    startup.add(dbLoggerNode, "DBLoggerNode", NodeImportance::CRITICAL);
 
     LineFollowNode sailingLogic(messageBus, dbHandler);
-    initialiseNode(sailingLogic, "LineFollowNode", NodeImportance::CRITICAL);
+    startup.add(sailingLogic, "LineFollowNode", NodeImportance::CRITICAL);
     
     StateEstimationNode stateEstimationNode(messageBus, dbHandler);
-    initialiseNode(stateEstimationNode,"StateEstimationNode",NodeImportance::CRITICAL);
+    startup.add(stateEstimationNode, "StateEstimationNode", NodeImportance::CRITICAL);
 
     WingSailControlNode wingSailControlNode(messageBus, dbHandler);
-    initialiseNode(wingSailControlNode, "WingSailControlNode", NodeImportance::CRITICAL);
+    startup.add(wingSailControlNode, "WingSailControlNode", NodeImportance::CRITICAL);
 
     CourseRegulatorNode courseRegulatorNode(messageBus, dbHandler);
-    initialiseNode(courseRegulatorNode, "CourseRegulatorNode", NodeImportance::CRITICAL);
+    startup.add(courseRegulatorNode, "CourseRegulatorNode", NodeImportance::CRITICAL);
     
     HTTPSyncNode httpsync(messageBus, dbHandler);
-    initialiseNode(httpsync, "HTTPSyncNode", NodeImportance::NOT_CRITICAL); // This node is not critical during the developement phase.
+    startup.add(httpsync, "HTTPSyncNode", NodeImportance::NOT_CRITICAL); // This node is not critical during the developement phase.
 
     AISProcessing aisProcessing(messageBus, dbHandler, &collidableMgr);
-    initialiseNode(aisProcessing, "AISProcessing", NodeImportance::CRITICAL);
+    startup.add(aisProcessing, "AISProcessing", NodeImportance::CRITICAL);
     
     //CameraProcessingUtility cameraProcessing(messageBus, dbHandler, &collidableMgr);
-    //initialiseNode(cameraProcessing, "CameraProcessingUtility", NodeImportance::NOT_CRITICAL);
+    //startup.add(cameraProcessing, "CameraProcessingUtility", NodeImportance::NOT_CRITICAL);
     
-    // Simulator
+    // Simulator, its init waits for the simulator to connect while the others carry on
 #if SIMULATION == 1
     SimulationNode simulator(messageBus, 1, &collidableMgr);
-    initialiseNode(simulator,"SimulationNode",NodeImportance::CRITICAL);
+    startup.add(simulator, "SimulationNode", NodeImportance::CRITICAL);
 #endif
+
+    bool startupSucceeded = startup.initialise(STARTUP_THREADS);
+    startup.logTimings();
+
+    nodeList = startup.activeNodes();
+    nodeList.push_back(&watchdog);
+
+    if(not startupSucceeded)
+    {
+        Logger::error("Critical node failed to initialise, shutting down");
+        exit(EXIT_FAILURE);
+    }
     
     // Start active nodes
     //-------------------------------------------------------------------------------
     std::cout<<rang::style::bold<<rang::fg::blue<<std::endl<<std::endl<<"3. Enabling active nodes........."<<std::endl<<std::endl<<rang::style::reset;
 
+#if SHARED_SCHEDULER == 1
+    // The periodic nodes share a couple of workers rather than a thread each
+    nodeScheduler.start(SCHEDULER_WORKERS);
+    ActiveNode::useScheduler(&nodeScheduler);
+#endif
+
+    autopilotRead.start();
     dbLoggerNode.start();
     sailingLogic.start();
     stateEstimationNode.start();
@@ -264,12 +292,13 @@ int main(int argc, char *argv[])
   	#if LOCAL_NAVIGATION_MODULE == 1
 		LocalNavigationModule lnm	( messageBus, dbHandler );
 
-		const int16_t MAX_VOTES = dbHandler.retrieveCellAsInt("config_voter_system","1","max_vote");
-		WaypointVoter waypointVoter( MAX_VOTES, dbHandler.retrieveCellAsDouble("config_voter_system","1","waypoint_voter_weight")); // weight = 1
-		WindVoter windVoter( MAX_VOTES, dbHandler.retrieveCellAsDouble("config_voter_system","1","wind_voter_weight")); // weight = 1
-		ChannelVoter channelVoter( MAX_VOTES, dbHandler.retrieveCellAsDouble("config_voter_system","1","channel_voter_weight")); // weight = 1
-		MidRangeVoter midRangeVoter( MAX_VOTES, dbHandler.retrieveCellAsDouble("config_voter_system","1","midrange_voter_weight"), collidableMgr );
-		ProximityVoter proximityVoter( MAX_VOTES, dbHandler.retrieveCellAsDouble("config_voter_system","1","proximity_voter_weight"), collidableMgr);
+		std::shared_ptr<const ConfigSnapshot> configs = dbHandler.configs();
+		const int16_t MAX_VOTES = configs->getInt("config_voter_system", "max_vote");
+		WaypointVoter waypointVoter( MAX_VOTES, configs->getDouble("config_voter_system", "waypoint_voter_weight")); // weight = 1
+		WindVoter windVoter( MAX_VOTES, configs->getDouble("config_voter_system", "wind_voter_weight")); // weight = 1
+		ChannelVoter channelVoter( MAX_VOTES, configs->getDouble("config_voter_system", "channel_voter_weight")); // weight = 1
+		MidRangeVoter midRangeVoter( MAX_VOTES, configs->getDouble("config_voter_system", "midrange_voter_weight"), collidableMgr );
+		ProximityVoter proximityVoter( MAX_VOTES, configs->getDouble("config_voter_system", "proximity_voter_weight"), collidableMgr);
 
 		lnm.registerVoter( &waypointVoter );
 		lnm.registerVoter( &windVoter );
@@ -353,6 +382,9 @@ int main(int argc, char *argv[])
 	//-------------------------------------------------------------------------------
     std::cout<<rang::style::bold<<rang::fg::blue<<std::endl<<std::endl<<"4. Starting MessageBus........."<<std::endl<<std::endl<<rang::style::reset;
 
+    // Record the bus traffic, the journal is written out in the background
+    messageBus.journal().open("./Messages.journal");
+
     try {
         messageBus.run();
         std::cout<<"OK"<<std::endl;
@@ -0,0 +1,120 @@
+#!/usr/bin/python3
+
+# Turns a structured log file (.slog) written by the Logger back into text,
+# see NavigationSystem/SystemServices/StructuredLog.hpp for the format.
+# Rotated segments compressed with gzip can be given as they are.
+
+import gzip
+import re
+import struct
+import sys
+import time
+
+MAGIC = b'SWL1'
+LEVELS = ['info', 'error', 'warning', 'success']
+CONVERSION = re.compile(r'%([-+ #0]*)([0-9*]*(?:\.[0-9*]*)?)(?:hh|h|ll|l|q|j|z|t|L)?([a-zA-Z%])')
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def at_end(self):
+        return self.pos >= len(self.data)
+
+    def unpack(self, fmt):
+        size = struct.calcsize(fmt)
+        if self.pos + size > len(self.data):
+            raise EOFError()
+        values = struct.unpack_from(fmt, self.data, self.pos)
+        self.pos += size
+        return values[0] if len(values) == 1 else values
+
+    def bytes(self, size):
+        if self.pos + size > len(self.data):
+            raise EOFError()
+        value = self.data[self.pos:self.pos + size]
+        self.pos += size
+        return value
+
+    def argument(self):
+        tag = chr(self.unpack('<B'))
+        if tag == 'i':
+            return self.unpack('<q')
+        if tag == 'u':
+            return self.unpack('<Q')
+        if tag == 'f':
+            return self.unpack('<d')
+        if tag == 's':
+            return self.bytes(self.unpack('<B')).decode('utf-8', 'replace')
+        raise ValueError('unknown argument tag ' + tag)
+
+
+def stamp(time_ms, level):
+    seconds = time.strftime('%Y-%m-%d %H:%M:%S', time.gmtime(time_ms // 1000))
+    return '[%s:%03d] <%s>\t ' % (seconds, time_ms % 1000, LEVELS[level] if level < len(LEVELS) else 'unknown')
+
+
+def render(fmt, args):
+    args = list(args)
+
+    def convert(match):
+        flags, width, conversion = match.groups()
+        if conversion == '%':
+            return '%'
+        while '*' in width:
+            width = width.replace('*', str(args.pop(0)), 1)
+        value = args.pop(0)
+        if conversion == 'p':
+            return '0x' + ('%' + flags + width + 'x') % value
+        if conversion in 'ui':
+            conversion = 'd'
+        return ('%' + flags + width + conversion) % value
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def decode(data, out):
+    if data[:len(MAGIC)] != MAGIC:
+        sys.exit('Not a structured log file')
+
+    reader = Reader(data)
+    reader.pos = len(MAGIC)
+    formats = {}
+
+    while not reader.at_end():
+        kind = chr(reader.unpack('<B'))
+        if kind == 'F':
+            format_id, size = reader.unpack('<IH')
+            formats[format_id] = reader.bytes(size).decode('utf-8', 'replace')
+        elif kind == 'R':
+            format_id, level, time_ms, count = reader.unpack('<IBQB')
+            args = [reader.argument() for i in range(count)]
+            if format_id in formats:
+                text = render(formats[format_id], args)
+            else:
+                text = '<unknown format %08x> %s' % (format_id, args)
+            out.write(stamp(time_ms, level) + text + '\n')
+        elif kind == 'T':
+            level, time_ms, size = reader.unpack('<BQH')
+            out.write(reader.bytes(size).decode('utf-8', 'replace'))
+        else:
+            raise ValueError('unknown record type %s at offset %d' % (kind, reader.pos - 1))
+
+
+if len(sys.argv) > 1:
+    filepath = str(sys.argv[1])
+else:
+    sys.exit('Please enter as argument the path of a .slog file')
+
+try:
+    with (gzip.open if filepath.endswith('.gz') else open)(filepath, 'rb') as logfile:
+        content = logfile.read()
+except IOError:
+    sys.exit('Error to open the file ' + filepath)
+
+try:
+    decode(content, sys.stdout)
+except EOFError:
+    sys.exit('The file ends in the middle of a record')